@@ -67,7 +67,7 @@ class Adc {
     AdcConvert::set();
   }
   static inline void Wait() {
-    while (AdcConvert::value());
+    while (AdcConvert::value()) { BusyWait(); }
   }
   static inline int16_t ReadOut() {
     uint8_t low = ADCL;
@@ -51,7 +51,10 @@ class AudioOutput {
     OutputPort::Init();
   }
   
-  static inline void Write(Value v) { while (!writable()); Overwrite(v); }
+  static inline void Write(Value v) {
+    while (!writable()) { BusyWait(); }
+    Overwrite(v);
+  }
   static inline void Overwrite(Value v) { OutputBuffer::Overwrite(v); }
   
   static inline uint8_t writable() { return OutputBuffer::writable(); }
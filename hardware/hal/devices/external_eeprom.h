@@ -21,6 +21,10 @@
 // multiple chips. For example, if four 16k chips (AT24C128) are connected on the
 // bus, R/W to addresses 0x0000 - 0x4000 will be addressed to chip 1, 
 // R/W to addresses 0x4000 - 0x8000 will be addressed to chip 2, etc.
+//
+// The Read/Write functions block until the transfer is complete. The Begin*
+// functions only start a transfer and return immediately, so that a task can
+// stream data to or from the eeprom without waiting for the bus.
 
 #ifndef HARDWARE_HAL_DEVICES_EXTERNAL_EEPROM_H_
 #define HARDWARE_HAL_DEVICES_EXTERNAL_EEPROM_H_
@@ -124,8 +128,62 @@ class ExternalEeprom {
 
   static uint8_t Write(uint16_t address, uint8_t byte) {
     uint8_t data = byte;
-    return Write(&data, 1);
+    return Write(address, &data, 1);
   }
+  
+  // Starts setting the address of the next read. Returns 0 if the bus is
+  // busy.
+  static uint8_t BeginSetAddress(uint16_t address) {
+    if (Bus::busy()) {
+      return 0;
+    }
+    if (auto_banking) {
+      bank_ = (address / eeprom_size);
+      address %= eeprom_size;
+    }
+    Bus::FlushInputBuffer();
+    Bus::FlushOutputBuffer();
+    Bus::Overwrite(address >> 8);
+    Bus::Overwrite(address & 0xff);
+    return Bus::Send((base_address + bank_) | 0x50) ? 1 : 0;
+  }
+  
+  // Starts writing size bytes, which must not cross a page boundary. Returns
+  // 0 if the bus is busy. Whether the chip has accepted the data is known
+  // from error(), once the bus is no longer busy.
+  static uint8_t BeginWrite(uint16_t address, const uint8_t* data,
+                            uint8_t size) {
+    if (Bus::busy() || size + 2 >= Bus::Output::capacity()) {
+      return 0;
+    }
+    if (auto_banking) {
+      bank_ = (address / eeprom_size);
+      address %= eeprom_size;
+    }
+    Bus::FlushOutputBuffer();
+    Bus::Overwrite(address >> 8);
+    Bus::Overwrite(address & 0xff);
+    for (uint8_t i = 0; i < size; ++i) {
+      Bus::Overwrite(data[i]);
+    }
+    return Bus::Send((base_address + bank_) | 0x50) ? size : 0;
+  }
+  
+  // Starts reading up to size bytes from the current address. Returns the
+  // number of bytes requested (0 if the bus is busy). The bytes are
+  // retrieved with readable() and ImmediateRead() as they arrive.
+  static uint8_t BeginRead(uint8_t size) {
+    if (Bus::busy()) {
+      return 0;
+    }
+    return Bus::Request((base_address + bank_) | 0x50, size);
+  }
+  
+  static inline uint8_t busy() { return Bus::busy(); }
+  // Outcome of the last transfer, once the bus is no longer busy.
+  static inline uint8_t error() { return Bus::error(); }
+  static inline uint8_t readable() { return Bus::readable(); }
+  static inline uint8_t ImmediateRead() { return Bus::ImmediateRead(); }
    
  private:
   static uint8_t Write(const uint8_t* header, uint8_t header_size, 
@@ -135,7 +193,7 @@ class ExternalEeprom {
       return 0;  // Hopeless, it won't fit in one write.
     }
     // Wait until the buffer is flushed, and write to the buffer.
-    while (Bus::writable() < size) { }
+    while (Bus::writable() < size) { BusyWait(); }
     for (uint8_t i = 0; i < header_size; ++i) {
       Bus::Output::Overwrite(header[i]);
     }
@@ -149,12 +207,13 @@ class ExternalEeprom {
       uint8_t error = Bus::Wait();
       if (error == I2C_ERROR_NONE) {
         return size;
-      } else {
-        return 0;
       }
-    } else {
-      return 0;
     }
+    // The chip did not acknowledge (for example because it is still busy
+    // with a previous write cycle). Drop the data, so that it does not
+    // prevent further writes.
+    Bus::FlushOutputBuffer();
+    return 0;
   }
   
   static uint8_t bank_;
@@ -16,6 +16,14 @@
 // -----------------------------------------------------------------------------
 //
 // Driver for a MCP492x DAC (SPI single/dual 12-bits DAC).
+//
+// StreamingDac is a 12-bits version of Dac for audio output, which can be
+// written to from an interrupt handler without waiting for the transmission:
+// only the first byte of the word is sent by Write(), the second one is sent
+// from the SPI interrupt. The DAC only latches a word when its slave select
+// line is raised, which is done by the next call to Write(). The output is
+// thus delayed by one sample, and is held if no new sample is written. The
+// DAC must be the only device on the SPI bus.
 
 #ifndef HARDWARE_HAL_DEVICES_MCP492X_H_
 #define HARDWARE_HAL_DEVICES_MCP492X_H_
@@ -60,19 +68,67 @@ class Dac {
     if (channel) {
       command |= 0x80;
     }
-    if (voltage_reference == BUFFERED) {
+    if (voltage_reference == BUFFERED_REFERENCE) {
+      command |= 0x40;
+    }
+    if (gain == 1) {
+      command |= 0x20;
+    }
+    DacInterface::WriteWord(command, value & 0xf0);
+  }
+
+ private:
+  typedef Spi<slave_select_pin, MSB_FIRST, kDacSpeed> DacInterface;
+};
+
+template<uint8_t slave_select_pin,
+         DacVoltageReference voltage_reference = UNBUFFERED_REFERENCE,
+         uint8_t gain = 1>
+class StreamingDac {
+ public:
+  enum {
+    buffer_size = 0,
+    data_size = 12,
+  };
+  StreamingDac() { }
+
+  static void Init() {
+    DacInterface::Init();
+  }
+
+  static inline void Write(uint16_t value) {
+    uint8_t command = 0x10 | ((value >> 8) & 0x0f);
+    if (voltage_reference == BUFFERED_REFERENCE) {
       command |= 0x40;
     }
     if (gain == 1) {
       command |= 0x20;
     }
-    DacInterface::Write(command, value & 0xf0);
+    // Latches the previous word.
+    DacInterface::End();
+    lsb_ = value & 0xff;
+    DacInterface::Begin();
+    DacInterface::Send(command);
+    DacInterface::EnableInterrupt();
+  }
+
+  // To be called from the "transfer complete" interrupt.
+  static inline void OnTransferComplete() {
+    DacInterface::DisableInterrupt();
+    DacInterface::Send(lsb_);
   }
 
  private:
   typedef Spi<slave_select_pin, MSB_FIRST, kDacSpeed> DacInterface;
+
+  static uint8_t lsb_;
 };
 
+/* static */
+template<uint8_t slave_select_pin, DacVoltageReference voltage_reference,
+         uint8_t gain>
+uint8_t StreamingDac<slave_select_pin, voltage_reference, gain>::lsb_;
+
 }  // namespace hardware_hal
 
 #endif   // HARDWARE_HAL_DEVICES_MCP492X_H_
@@ -30,6 +30,8 @@
 #ifndef HARDWARE_HAL_DEVICES_OUTPUT_ARRAY_H_
 #define HARDWARE_HAL_DEVICES_OUTPUT_ARRAY_H_
 
+#include <string.h>
+
 #include "hardware/hal/devices/shift_register.h"
 #include "hardware/hal/size_to_type.h"
 
@@ -62,7 +64,9 @@ class OutputArray {
   }
   static inline Value value(Index output_index) {
     if (safe) {
-      ARGUMENT_CHECK_LT(output_index, size);
+      if (output_index >= size) {
+        return 0;
+      }
     }
     return values_[output_index];
   }
@@ -132,7 +136,9 @@ class OutputArray<Latch, Clock, Data, size, 4, order, safe> {
   }
   static inline Value value(Index output_index) {
     if (safe) {
-      ARGUMENT_CHECK_LT(output_index, size);
+      if (output_index >= size) {
+        return 0;
+      }
     }
     if (output_index & 1) {
       return values_[output_index >> 1] >> 4;
@@ -214,7 +220,9 @@ class OutputArray<Latch, Clock, Data, size, 1, order, safe> {
   }
   static inline uint8_t value(uint8_t output_index) {
     if (safe) {
-      ARGUMENT_CHECK_LT(output_index, size);
+      if (output_index >= size) {
+        return 0;
+      }
     }
     T mask = T(1) << output_index;
     return T(bits_ & mask) ? 1 : 0;
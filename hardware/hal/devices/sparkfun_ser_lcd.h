@@ -80,13 +80,7 @@ class Display {
 
   Display() { }
   static void Init() {
-    for (uint8_t i = 0; i < lcd_buffer_size; ++i) {
-      local_[i] = ' ';
-      remote_[i] = '?';
-    }
-    scan_position_last_write_ = 255;
-    blink_ = 0;
-    cursor_position_ = 255;
+    Reset();
     // It is assumed, at initialization, that the display is wrongly in 9600
     // bauds mode. Send this message to switch to the target baud rate.
     // At worst, if the baud rate is already set, this will display glitchy
@@ -111,6 +105,14 @@ class Display {
     }
     DisplaySerialOutput::Init();
   }
+
+  // Same as Init, but assumes that the display is already configured at the
+  // target baud rate (the LCD remembers this setting), and thus returns
+  // immediately. If the display shows garbage, Init() has to be called.
+  static void FastInit() {
+    Reset();
+    DisplaySerialOutput::Init();
+  }
   
   static void Print(uint8_t line, const char* text) {
     if (line == 0) {
@@ -141,22 +143,16 @@ class Display {
     DisplaySerialOutput::Write(128 + brightness);
   }
 
+  // Does not block: the character definitions are transmitted by Update(),
+  // before any text. Each definition is followed by a "clear display" command,
+  // so the whole screen is redrawn afterwards.
   static void SetCustomCharMap(const uint8_t* characters,
                                uint8_t num_characters) {
-    DisplaySerialOutput::Write(0xfe);
-    DisplaySerialOutput::Write(0x01);
-    for (uint8_t i = 0; i < num_characters; ++i) {
-      DisplaySerialOutput::Write(0xfe);
-      DisplaySerialOutput::Write(0x40 + i * 8);
-      for (uint8_t j = 0; j < 8; ++j) {
-        // The 6th bit is not used, so it is set to prevent character definition
-        // data to be misunderstood with special commands.
-        DisplaySerialOutput::Write(0x20 |
-            SimpleResourcesManager::Lookup<uint8_t, uint8_t>(
-                characters, i * 8 + j));
-     }
-     DisplaySerialOutput::Write(0xfe);
-     DisplaySerialOutput::Write(0x01);
+    custom_characters_ = characters;
+    custom_characters_size_ = 2 + num_characters * 12;
+    custom_characters_position_ = 0;
+    for (uint8_t i = 0; i < lcd_buffer_size; ++i) {
+      remote_[i] = '?';
     }
   }
 
@@ -189,6 +185,16 @@ class Display {
     // It is now safe to assume that all writes of 3 bytes to the display buffer
     // will not block.
     
+    if (custom_characters_position_ < custom_characters_size_) {
+      while (DisplaySerialOutput::writable() &&
+             custom_characters_position_ < custom_characters_size_) {
+        DisplaySerialOutput::Overwrite(CustomCharMapByte(
+            custom_characters_position_));
+        ++custom_characters_position_;
+      }
+      return;
+    }
+
     // Blink the cursor and clears the status character.
     blink_clock_ = (blink_clock_ + 1) & kLcdCursorBlinkRate;
     if (blink_clock_ == 0) {
@@ -243,6 +249,41 @@ class Display {
   }
 
  private:
+  static void Reset() {
+    for (uint8_t i = 0; i < lcd_buffer_size; ++i) {
+      local_[i] = ' ';
+      remote_[i] = '?';
+    }
+    scan_position_last_write_ = 255;
+    blink_ = 0;
+    cursor_position_ = 255;
+    custom_characters_size_ = 0;
+  }
+
+  // Byte at a given position of the stream of commands defining the custom
+  // characters: a "clear display" command, and, for each character, a "set
+  // CGRAM address" command, 8 rows, and a "clear display" command.
+  static uint8_t CustomCharMapByte(uint8_t position) {
+    if (position < 2) {
+      return position ? 0x01 : 0xfe;
+    }
+    position -= 2;
+    uint8_t i = position / 12;
+    uint8_t j = position - i * 12;
+    if (j == 0 || j == 10) {
+      return 0xfe;
+    } else if (j == 1) {
+      return 0x40 + i * 8;
+    } else if (j == 11) {
+      return 0x01;
+    } else {
+      // The 6th bit is not used, so it is set to prevent character definition
+      // data to be misunderstood with special commands.
+      return 0x20 | SimpleResourcesManager::Lookup<uint8_t, uint8_t>(
+          custom_characters_, i * 8 + j - 2);
+    }
+  }
+
   // Character pages storing what the display currently shows (remote), and
   // what it ought to show (local).
   static uint8_t local_[width * height];
@@ -256,6 +297,11 @@ class Display {
   static uint8_t cursor_position_;
   static uint8_t status_;
 
+  // Custom characters definitions, and how much of them has been transmitted.
+  static const uint8_t* custom_characters_;
+  static uint8_t custom_characters_size_;
+  static uint8_t custom_characters_position_;
+
   DISALLOW_COPY_AND_ASSIGN(Display);
 };
 
@@ -296,6 +342,21 @@ template<typename TxPin, uint16_t main_timer_rate, uint16_t baud_rate,
          uint8_t width, uint8_t height>
 uint8_t Display<TxPin, main_timer_rate, baud_rate, width, height>::status_;
 
+template<typename TxPin, uint16_t main_timer_rate, uint16_t baud_rate,
+         uint8_t width, uint8_t height>
+const uint8_t* Display<TxPin, main_timer_rate, baud_rate, width,
+                       height>::custom_characters_;
+
+template<typename TxPin, uint16_t main_timer_rate, uint16_t baud_rate,
+         uint8_t width, uint8_t height>
+uint8_t Display<TxPin, main_timer_rate, baud_rate, width,
+                height>::custom_characters_size_;
+
+template<typename TxPin, uint16_t main_timer_rate, uint16_t baud_rate,
+         uint8_t width, uint8_t height>
+uint8_t Display<TxPin, main_timer_rate, baud_rate, width,
+                height>::custom_characters_position_;
+
 }  // namespace hardware_hal
 
 #endif   // HARDWARE_HAL_DEVICES_SPARKFUN_SER_LCD_H_
@@ -40,19 +40,46 @@ enum DigitalValue {
 
 static const uint16_t kEepromSize = 1024;
 
+#ifdef __AVR__
+typedef volatile uint8_t* RegisterPointer;
+#else
+// On the desktop build, the registers are accessed through a proxy which lets
+// the simulated peripherals observe the reads and writes (see
+// hardware/hal/host/avr/io.h).
+typedef HostRegisterPointer RegisterPointer;
+#endif  // __AVR__
+
+// Body of the polling loops. On the desktop build, this lets the simulated time
+// advance - and the interrupts fire - while the firmware is waiting.
+static inline void BusyWait() {
+#ifndef __AVR__
+  HostDelay(16);
+#endif  // __AVR__
+}
+
 // <avr/io.h> is full of useful defines, but they cannot be used as template
 // arguments because they are of the form: (*(volatile uint8_t *)(0x80))
 // The following define wraps this reference into a class to make it easier to
 // pass it as a template argument.
 #define IORegister(reg) struct reg##Register { \
-  static volatile uint8_t* ptr() { return &reg; } \
-  reg##Register& operator=(const uint8_t& value) { *ptr() = value; } \
+  static hardware_hal::RegisterPointer ptr() { \
+    return hardware_hal::RegisterPointer(&reg); \
+  } \
+  reg##Register& operator=(const uint8_t& value) { \
+    *ptr() = value; \
+    return *this; \
+  } \
   uint8_t operator()(const uint8_t& value) { return *ptr(); } \
 };
 
 #define SpecialFunctionRegister(reg) struct reg##Register { \
-  static volatile uint8_t* ptr() { return &_SFR_BYTE(reg); } \
-  reg##Register& operator=(const uint8_t& value) { *ptr() = value; } \
+  static hardware_hal::RegisterPointer ptr() { \
+    return hardware_hal::RegisterPointer(&_SFR_BYTE(reg)); \
+  } \
+  reg##Register& operator=(const uint8_t& value) { \
+    *ptr() = value; \
+    return *this; \
+  } \
   uint8_t operator()(const uint8_t& value) { return *ptr(); } \
 };
 
@@ -60,7 +87,7 @@ static const uint16_t kEepromSize = 1024;
 template<typename Register, uint8_t bit>
 struct BitInRegister {
   static void clear() {
-    *Register::ptr() &= ~_BV(bit);
+    *Register::ptr() &= static_cast<uint8_t>(~_BV(bit));
   }
   static void set() {
     *Register::ptr() |= _BV(bit);
@@ -80,7 +107,10 @@ struct Input {
   typedef uint8_t Value;
   
   // Blocking!
-  static inline Value Read() { while (!readable()); return ImmediateRead(); }  
+  static inline Value Read() {
+    while (!readable()) { BusyWait(); }
+    return ImmediateRead();
+  }  
   
   // Number of bytes available for read.
   static inline uint8_t readable() { return 1; }
@@ -103,7 +133,10 @@ struct Output {
   typedef uint8_t Value;
   
   // Blocking!
-  static inline void Write(Value v) { while (!writable()); Overwrite(v); }
+  static inline void Write(Value v) {
+    while (!writable()) { BusyWait(); }
+    Overwrite(v);
+  }
   
   // Number of bytes that can be fed.
   static inline uint8_t writable() { return 1; }
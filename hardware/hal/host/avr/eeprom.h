@@ -0,0 +1,39 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Desktop stand-in for <avr/eeprom.h>, backed by an array in memory.
+
+#ifndef HARDWARE_HAL_HOST_AVR_EEPROM_H_
+#define HARDWARE_HAL_HOST_AVR_EEPROM_H_
+
+#include <avr/io.h>
+#include <inttypes.h>
+#include <string.h>
+
+extern uint8_t host_eeprom[1024];
+
+static inline uint8_t eeprom_read_byte(const uint8_t* address) {
+  return host_eeprom[(uintptr_t)(address) & 0x3ff];
+}
+
+static inline void eeprom_write_byte(uint8_t* address, uint8_t value) {
+  host_eeprom[(uintptr_t)(address) & 0x3ff] = value;
+  // A write takes 3.3ms, during which the CPU waits.
+  HostDelay(F_CPU / 1000 * 33 / 10);
+}
+
+#endif  // HARDWARE_HAL_HOST_AVR_EEPROM_H_
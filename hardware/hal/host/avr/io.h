@@ -0,0 +1,217 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Desktop stand-in for <avr/io.h>. The I/O and extended I/O registers of the
+// ATmega328p are mapped, at their data memory address, to a plain array, so
+// that the HAL templates compile unmodified and that the host code can
+// inspect (or poke) the value of any register.
+
+#ifndef HARDWARE_HAL_HOST_AVR_IO_H_
+#define HARDWARE_HAL_HOST_AVR_IO_H_
+
+#include <inttypes.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif  // F_CPU
+
+extern volatile uint8_t host_registers[0x100];
+
+#define _SFR_MEM8(address) (host_registers[address])
+#define _SFR_MEM16(address) (*(volatile uint16_t*)(host_registers + (address)))
+#define _SFR_BYTE(sfr) (*(volatile uint8_t*)(&(sfr)))
+#define _SFR_IO_ADDR(sfr) ((volatile uint8_t*)(&(sfr)) - host_registers - 0x20)
+#define _BV(bit) (1 << (bit))
+
+#define PINB _SFR_MEM8(0x23)
+#define DDRB _SFR_MEM8(0x24)
+#define PORTB _SFR_MEM8(0x25)
+#define PINC _SFR_MEM8(0x26)
+#define DDRC _SFR_MEM8(0x27)
+#define PORTC _SFR_MEM8(0x28)
+#define PIND _SFR_MEM8(0x29)
+#define DDRD _SFR_MEM8(0x2a)
+#define PORTD _SFR_MEM8(0x2b)
+
+#define TIFR0 _SFR_MEM8(0x35)
+#define TIFR1 _SFR_MEM8(0x36)
+#define TIFR2 _SFR_MEM8(0x37)
+#define TOV0 0
+#define TOV1 0
+#define TOV2 0
+
+#define EECR _SFR_MEM8(0x3f)
+#define EEDR _SFR_MEM8(0x40)
+#define EEARL _SFR_MEM8(0x41)
+#define EEARH _SFR_MEM8(0x42)
+
+#define TCCR0A _SFR_MEM8(0x44)
+#define TCCR0B _SFR_MEM8(0x45)
+#define TCNT0 _SFR_MEM8(0x46)
+#define OCR0A _SFR_MEM8(0x47)
+#define OCR0B _SFR_MEM8(0x48)
+#define COM0B1 5
+#define COM0A1 7
+
+#define SPCR _SFR_MEM8(0x4c)
+#define SPR0 0
+#define SPR1 1
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIE 7
+#define SPSR _SFR_MEM8(0x4d)
+#define SPI2X 0
+#define SPIF 7
+#define SPDR _SFR_MEM8(0x4e)
+
+#define MCUSR _SFR_MEM8(0x54)
+#define WDRF 3
+#define SREG _SFR_MEM8(0x5f)
+
+#define WDTCSR _SFR_MEM8(0x60)
+#define WDE 3
+#define WDCE 4
+
+#define TIMSK0 _SFR_MEM8(0x6e)
+#define TIMSK1 _SFR_MEM8(0x6f)
+#define TIMSK2 _SFR_MEM8(0x70)
+#define TOIE0 0
+#define TOIE1 0
+#define TOIE2 0
+
+#define ADCL _SFR_MEM8(0x78)
+#define ADCH _SFR_MEM8(0x79)
+#define ADCSRA _SFR_MEM8(0x7a)
+#define ADIF 4
+#define ADIE 3
+#define ADSC 6
+#define ADEN 7
+#define ADMUX _SFR_MEM8(0x7c)
+
+#define TCCR1A _SFR_MEM8(0x80)
+#define TCCR1B _SFR_MEM8(0x81)
+#define TCNT1 _SFR_MEM16(0x84)
+#define OCR1A _SFR_MEM16(0x88)
+#define OCR1B _SFR_MEM16(0x8a)
+#define COM1B1 5
+#define COM1A1 7
+
+#define TCCR2A _SFR_MEM8(0xb0)
+#define TCCR2B _SFR_MEM8(0xb1)
+#define TCNT2 _SFR_MEM8(0xb2)
+#define OCR2A _SFR_MEM8(0xb3)
+#define OCR2B _SFR_MEM8(0xb4)
+#define COM2B1 5
+#define COM2A1 7
+
+#define TWBR _SFR_MEM8(0xb8)
+#define TWSR _SFR_MEM8(0xb9)
+#define TWPS0 0
+#define TWPS1 1
+#define TWAR _SFR_MEM8(0xba)
+#define TWDR _SFR_MEM8(0xbb)
+#define TWCR _SFR_MEM8(0xbc)
+#define TWIE 0
+#define TWEN 2
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+#define UCSR0A _SFR_MEM8(0xc0)
+#define U2X0 1
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define UCSR0B _SFR_MEM8(0xc1)
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCSR0C _SFR_MEM8(0xc2)
+#define UBRR0L _SFR_MEM8(0xc4)
+#define UBRR0H _SFR_MEM8(0xc5)
+#define UDR0 _SFR_MEM8(0xc6)
+
+// The HAL accesses the registers through the following proxy (see IORegister
+// in hardware/hal/hal.h), so that simulated peripherals can react to reads and
+// writes - for example by clearing the "data received" flag of the UART when
+// its data register is read. The hooks are NULL when nothing is simulated, in
+// which case the registers behave as plain memory.
+extern void (*host_register_read_hook)(uint8_t address);
+extern void (*host_register_write_hook)(uint8_t address, uint8_t previous);
+
+// Called whenever the firmware waits, with the approximate number of CPU
+// cycles spent, so that the simulated time can advance.
+extern void (*host_delay_hook)(uint16_t num_cycles);
+
+static inline void HostDelay(uint16_t num_cycles) {
+  if (host_delay_hook) {
+    host_delay_hook(num_cycles);
+  }
+}
+
+class HostRegisterReference {
+ public:
+  explicit HostRegisterReference(uint8_t address) : address_(address) { }
+
+  operator uint8_t() const {
+    if (host_register_read_hook) {
+      host_register_read_hook(address_);
+    }
+    return host_registers[address_];
+  }
+
+  HostRegisterReference& operator=(uint8_t value) {
+    uint8_t previous = host_registers[address_];
+    host_registers[address_] = value;
+    if (host_register_write_hook) {
+      host_register_write_hook(address_, previous);
+    }
+    return *this;
+  }
+
+  HostRegisterReference& operator&=(uint8_t mask) {
+    return *this = host_registers[address_] & mask;
+  }
+
+  HostRegisterReference& operator|=(uint8_t mask) {
+    return *this = host_registers[address_] | mask;
+  }
+
+ private:
+  uint8_t address_;
+};
+
+class HostRegisterPointer {
+ public:
+  explicit HostRegisterPointer(volatile uint8_t* reg)
+      : address_(reg - host_registers) { }
+
+  HostRegisterReference operator*() const {
+    return HostRegisterReference(address_);
+  }
+
+ private:
+  uint8_t address_;
+};
+
+#endif  // HARDWARE_HAL_HOST_AVR_IO_H_
@@ -0,0 +1,49 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Desktop stand-in for <avr/pgmspace.h>. On the host, "program memory" is
+// ordinary memory, so all the pgm_read_* functions are plain dereferences.
+// pgm_read_word is also used by the resources manager to read pointers from
+// tables ; on the host the dereference preserves the type of the table entry,
+// so that 64-bit pointers are not truncated.
+
+#ifndef HARDWARE_HAL_HOST_AVR_PGMSPACE_H_
+#define HARDWARE_HAL_HOST_AVR_PGMSPACE_H_
+
+#include <avr/io.h>
+#include <inttypes.h>
+#include <string.h>
+
+#define PROGMEM
+
+typedef char prog_char;
+typedef uint8_t prog_uint8_t;
+typedef int8_t prog_int8_t;
+typedef uint16_t prog_uint16_t;
+typedef int16_t prog_int16_t;
+typedef uint32_t prog_uint32_t;
+
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+
+#define memcpy_P memcpy
+#define strncpy_P strncpy
+
+#endif  // HARDWARE_HAL_HOST_AVR_PGMSPACE_H_
@@ -0,0 +1,735 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Simulated peripherals for the desktop simulation of the firmware.
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/twi.h>
+
+#include "hardware/hal/host/peripherals.h"
+#include "hardware/hal/host/virtual_clock.h"
+
+// Interrupt handler possibly defined by the simulated program.
+extern "C" {
+void USART_RX_vect() __attribute__((weak));
+void USART_UDRE_vect() __attribute__((weak));
+void TWI_vect() __attribute__((weak));
+void SPI_STC_vect() __attribute__((weak));
+}
+
+namespace hardware_hal {
+
+static const uint8_t kIdle = 0xff;
+
+static inline uint8_t Address(volatile uint8_t& reg) {
+  return &reg - host_registers;
+}
+
+// Returns the port register (PORTx) to which a pin belongs, and the bit of the
+// pin in this register.
+static uint8_t PortOfPin(uint8_t pin, uint8_t* bit) {
+  if (pin < 8) {
+    *bit = pin;
+    return Address(PORTD);
+  } else if (pin < 14) {
+    *bit = pin - 8;
+    return Address(PORTB);
+  } else {
+    *bit = pin - 14;
+    return Address(PORTC);
+  }
+}
+
+// Returns the number of the first pin of a port, given one of its registers.
+static uint8_t FirstPinOfPort(uint8_t address) {
+  if (address >= Address(PIND) && address <= Address(PORTD)) {
+    return 0;
+  } else if (address >= Address(PINB) && address <= Address(PORTB)) {
+    return 8;
+  } else {
+    return 14;
+  }
+}
+
+/* <static> */
+uint8_t SimulatedGpio::input_[kNumSimulatedPins];
+SimulatedShiftRegister* SimulatedGpio::shift_registers_[kMaxShiftRegisters];
+uint8_t SimulatedGpio::num_shift_registers_;
+/* </static> */
+
+/* static */
+void SimulatedGpio::Init() {
+  memset((void*)host_registers, 0, sizeof(host_registers));
+  // Unconnected inputs read as high - as if the pull-up resistors were on.
+  memset(input_, 1, sizeof(input_));
+  num_shift_registers_ = 0;
+  host_register_read_hook = &OnRead;
+  host_register_write_hook = &OnWrite;
+  SimulatedUart::Init();
+  SimulatedAdc::Init();
+  SimulatedSerialLcd::Init();
+  SimulatedI2cEeprom::Init();
+  SimulatedSpiDac::Init(kIdle);
+}
+
+/* static */
+uint8_t SimulatedGpio::output(uint8_t pin) {
+  uint8_t bit;
+  uint8_t port = PortOfPin(pin, &bit);
+  return host_registers[port] & _BV(bit) ? 1 : 0;
+}
+
+/* static */
+void SimulatedGpio::set_input(uint8_t pin, uint8_t value) {
+  input_[pin] = value ? 1 : 0;
+}
+
+/* static */
+void SimulatedGpio::Attach(SimulatedShiftRegister* shift_register) {
+  if (num_shift_registers_ < kMaxShiftRegisters) {
+    shift_registers_[num_shift_registers_++] = shift_register;
+  }
+}
+
+/* static */
+void SimulatedGpio::OnRead(uint8_t address) {
+  if (address == Address(PINB) || address == Address(PINC) ||
+      address == Address(PIND)) {
+    // The pins configured as outputs read back the level driven by the
+    // firmware ; the others, the level applied by the outside world.
+    uint8_t first_pin = FirstPinOfPort(address);
+    uint8_t mode = host_registers[address + 1];
+    uint8_t output = host_registers[address + 2];
+    uint8_t value = 0;
+    for (uint8_t bit = 0; bit < 8 && first_pin + bit < kNumSimulatedPins;
+         ++bit) {
+      uint8_t level = (mode & _BV(bit)) ? (output & _BV(bit)) :
+          input_[first_pin + bit];
+      if (level) {
+        value |= _BV(bit);
+      }
+    }
+    host_registers[address] = value;
+  } else if (address == Address(UDR0)) {
+    SimulatedUart::OnDataRead();
+  } else if (address == Address(TCNT0)) {
+    // Timer 0 counts at F_CPU / 64, and overflows at multiples of 256 counts
+    // (see VirtualClock).
+    host_registers[address] = (VirtualClock::cycles() >> 6) & 0xff;
+  }
+}
+
+/* static */
+void SimulatedGpio::OnWrite(uint8_t address, uint8_t previous) {
+  uint8_t value = host_registers[address];
+  if (address == Address(PORTB) || address == Address(PORTC) ||
+      address == Address(PORTD)) {
+    uint8_t changed = value ^ previous;
+    uint8_t first_pin = FirstPinOfPort(address);
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      if (!(changed & _BV(bit))) {
+        continue;
+      }
+      for (uint8_t i = 0; i < num_shift_registers_; ++i) {
+        shift_registers_[i]->PinChanged(first_pin + bit,
+                                        value & _BV(bit) ? 1 : 0);
+      }
+      SimulatedSpiDac::PinChanged(first_pin + bit, value & _BV(bit) ? 1 : 0);
+    }
+  } else if (address == Address(UDR0)) {
+    SimulatedUart::OnDataWrite(value);
+  } else if (address == Address(UCSR0B)) {
+    SimulatedUart::RequestDataRegisterEmptyInterrupt();
+  } else if (address == Address(ADCSRA)) {
+    if ((value & _BV(ADSC)) && !(previous & _BV(ADSC))) {
+      SimulatedAdc::OnStartConversion();
+    }
+  } else if (address == Address(TWCR)) {
+    SimulatedI2cEeprom::OnControlWrite();
+  } else if (address == Address(SPDR)) {
+    SimulatedSpiDac::OnDataWrite();
+  }
+}
+
+void SimulatedShiftRegister::Init(uint8_t clock_pin, uint8_t data_pin,
+                                  uint8_t latch_pin,
+                                  WordCallback latch_callback) {
+  clock_pin_ = clock_pin;
+  data_pin_ = data_pin;
+  latch_pin_ = latch_pin;
+  latch_callback_ = latch_callback;
+  shifted_ = 0;
+  value_ = 0;
+  SimulatedGpio::Attach(this);
+}
+
+void SimulatedShiftRegister::PinChanged(uint8_t pin, uint8_t value) {
+  // Data is shifted on the rising edge of the clock, and transferred to the
+  // outputs on the rising edge of the latch.
+  if (!value) {
+    return;
+  }
+  if (pin == clock_pin_) {
+    shifted_ = (shifted_ << 1) | SimulatedGpio::output(data_pin_);
+  } else if (pin == latch_pin_) {
+    value_ = shifted_;
+    if (latch_callback_) {
+      (*latch_callback_)(value_);
+    }
+  }
+}
+
+/* <static> */
+uint8_t SimulatedUart::pending_[kUartQueueSize];
+uint16_t SimulatedUart::pending_read_ptr_;
+uint16_t SimulatedUart::num_pending_;
+uint8_t SimulatedUart::receiving_;
+uint8_t SimulatedUart::fifo_[2];
+uint8_t SimulatedUart::fifo_size_;
+uint32_t SimulatedUart::num_overruns_;
+uint8_t SimulatedUart::shifter_;
+uint8_t SimulatedUart::transmitting_;
+uint8_t SimulatedUart::tx_buffer_;
+uint8_t SimulatedUart::tx_buffer_full_;
+uint8_t SimulatedUart::data_register_empty_pending_;
+ByteCallback SimulatedUart::transmit_callback_;
+/* </static> */
+
+/* static */
+void SimulatedUart::Init() {
+  pending_read_ptr_ = 0;
+  num_pending_ = 0;
+  receiving_ = 0;
+  fifo_size_ = 0;
+  num_overruns_ = 0;
+  transmitting_ = 0;
+  tx_buffer_full_ = 0;
+  data_register_empty_pending_ = 0;
+  UCSR0A = _BV(UDRE0);
+}
+
+/* static */
+uint32_t SimulatedUart::byte_duration() {
+  uint32_t prescaler = ((UBRR0H << 8) | UBRR0L) + 1;
+  return 10 * prescaler * (UCSR0A & _BV(U2X0) ? 8 : 16);
+}
+
+/* static */
+void SimulatedUart::Receive(uint8_t value) {
+  if (num_pending_ == kUartQueueSize) {
+    return;
+  }
+  pending_[(pending_read_ptr_ + num_pending_) % kUartQueueSize] = value;
+  ++num_pending_;
+  if (!receiving_) {
+    receiving_ = 1;
+    VirtualClock::Schedule(byte_duration(), &EndOfReception);
+  }
+}
+
+/* static */
+void SimulatedUart::EndOfReception() {
+  uint8_t value = pending_[pending_read_ptr_];
+  pending_read_ptr_ = (pending_read_ptr_ + 1) % kUartQueueSize;
+  --num_pending_;
+  if (UCSR0B & _BV(RXEN0)) {
+    if (fifo_size_ == 2) {
+      ++num_overruns_;
+    } else {
+      fifo_[fifo_size_++] = value;
+      UCSR0A |= _BV(RXC0);
+      if (USART_RX_vect && (UCSR0B & _BV(RXCIE0))) {
+        VirtualClock::Interrupt(&USART_RX_vect);
+      }
+    }
+  }
+  if (num_pending_) {
+    VirtualClock::Schedule(byte_duration(), &EndOfReception);
+  } else {
+    receiving_ = 0;
+  }
+}
+
+/* static */
+void SimulatedUart::OnDataRead() {
+  if (!fifo_size_) {
+    return;
+  }
+  UDR0 = fifo_[0];
+  fifo_[0] = fifo_[1];
+  --fifo_size_;
+  if (!fifo_size_) {
+    UCSR0A &= ~_BV(RXC0);
+  }
+}
+
+/* static */
+void SimulatedUart::OnDataWrite(uint8_t value) {
+  if (!(UCSR0B & _BV(TXEN0))) {
+    return;
+  }
+  if (!transmitting_) {
+    shifter_ = value;
+    transmitting_ = 1;
+    VirtualClock::Schedule(byte_duration(), &EndOfTransmission);
+    // The transmission buffer is still empty.
+    RequestDataRegisterEmptyInterrupt();
+  } else {
+    tx_buffer_ = value;
+    tx_buffer_full_ = 1;
+    UCSR0A &= ~_BV(UDRE0);
+  }
+}
+
+/* static */
+void SimulatedUart::EndOfTransmission() {
+  if (transmit_callback_) {
+    (*transmit_callback_)(shifter_);
+  }
+  if (tx_buffer_full_) {
+    shifter_ = tx_buffer_;
+    tx_buffer_full_ = 0;
+    UCSR0A |= _BV(UDRE0);
+    VirtualClock::Schedule(byte_duration(), &EndOfTransmission);
+    RequestDataRegisterEmptyInterrupt();
+  } else {
+    transmitting_ = 0;
+  }
+}
+
+/* static */
+void SimulatedUart::RequestDataRegisterEmptyInterrupt() {
+  // The interrupt is raised for as long as the transmission buffer is empty
+  // and the interrupt is enabled. Its handler is called right after the
+  // current task or interrupt handler.
+  if (!data_register_empty_pending_ && USART_UDRE_vect &&
+      (UCSR0B & _BV(UDRIE0)) && (UCSR0A & _BV(UDRE0))) {
+    data_register_empty_pending_ = 1;
+    VirtualClock::Schedule(0, &DataRegisterEmpty);
+  }
+}
+
+/* static */
+void SimulatedUart::DataRegisterEmpty() {
+  data_register_empty_pending_ = 0;
+  if ((UCSR0B & _BV(UDRIE0)) && (UCSR0A & _BV(UDRE0))) {
+    VirtualClock::Interrupt(&USART_UDRE_vect);
+  }
+}
+
+/* <static> */
+uint16_t SimulatedAdc::value_[kNumAdcChannels];
+uint16_t SimulatedAdc::sample_;
+/* </static> */
+
+/* static */
+void SimulatedAdc::Init() {
+  memset(value_, 0, sizeof(value_));
+}
+
+/* static */
+void SimulatedAdc::OnStartConversion() {
+  // The input is sampled at the beginning of the conversion, which takes 13
+  // cycles of the ADC clock.
+  sample_ = value_[ADMUX & (kNumAdcChannels - 1)];
+  uint8_t prescaler = ADCSRA & 0x07;
+  VirtualClock::Schedule(13 << (prescaler ? prescaler : 1), &EndOfConversion);
+}
+
+/* static */
+void SimulatedAdc::EndOfConversion() {
+  ADCL = sample_ & 0xff;
+  ADCH = sample_ >> 8;
+  ADCSRA = (ADCSRA & ~_BV(ADSC)) | _BV(ADIF);
+}
+
+void SoftwareSerialReceiver::Init(uint8_t pin, uint8_t ticks_per_bit,
+                                  ByteCallback callback) {
+  pin_ = pin;
+  ticks_per_bit_ = ticks_per_bit;
+  callback_ = callback;
+  bit_ = kIdle;
+}
+
+void SoftwareSerialReceiver::Tick() {
+  uint8_t level = SimulatedGpio::output(pin_);
+  if (bit_ == kIdle) {
+    // Wait for the falling edge of a start bit, and sample the next bits in
+    // their middle.
+    if (!level) {
+      bit_ = 0;
+      value_ = 0;
+      counter_ = ticks_per_bit_ + ticks_per_bit_ / 2;
+    }
+    return;
+  }
+  --counter_;
+  if (counter_) {
+    return;
+  }
+  counter_ = ticks_per_bit_;
+  if (bit_ < 8) {
+    value_ |= level << bit_;
+    ++bit_;
+  } else {
+    // Characters with a framing error (no stop bit) are dropped.
+    if (level && callback_) {
+      (*callback_)(value_);
+    }
+    bit_ = kIdle;
+  }
+}
+
+/* <static> */
+uint8_t SimulatedSerialLcd::text_[kSerialLcdHeight][kSerialLcdWidth];
+uint8_t SimulatedSerialLcd::custom_characters_[64];
+uint8_t SimulatedSerialLcd::address_;
+uint8_t SimulatedSerialLcd::writing_custom_characters_;
+uint8_t SimulatedSerialLcd::command_;
+uint8_t SimulatedSerialLcd::brightness_;
+uint32_t SimulatedSerialLcd::num_characters_;
+/* </static> */
+
+/* static */
+void SimulatedSerialLcd::Init() {
+  memset(text_, ' ', sizeof(text_));
+  memset(custom_characters_, 0, sizeof(custom_characters_));
+  address_ = 0;
+  writing_custom_characters_ = 0;
+  command_ = 0;
+  brightness_ = 29;
+  num_characters_ = 0;
+}
+
+/* static */
+void SimulatedSerialLcd::Receive(uint8_t value) {
+  if (command_ == 0xfe) {
+    // Commands of the HD44780 controller.
+    command_ = 0;
+    if (value == 0x01) {
+      memset(text_, ' ', sizeof(text_));
+      address_ = 0;
+      writing_custom_characters_ = 0;
+    } else if (value & 0x80) {
+      address_ = value & 0x7f;
+      writing_custom_characters_ = 0;
+    } else if (value & 0x40) {
+      address_ = value & 0x3f;
+      writing_custom_characters_ = 1;
+    }
+    return;
+  } else if (command_ == 0x7c) {
+    // Commands of the serial backpack: brightness, baud rate, splash screen.
+    command_ = 0;
+    if (value >= 128 && value < 158) {
+      brightness_ = value - 128;
+    }
+    return;
+  }
+  if (value == 0xfe || value == 0x7c) {
+    command_ = value;
+    return;
+  }
+  if (writing_custom_characters_) {
+    custom_characters_[address_] = value;
+    address_ = (address_ + 1) & 0x3f;
+    return;
+  }
+  uint8_t line = address_ >= 0x40 ? 1 : 0;
+  uint8_t column = address_ & 0x3f;
+  if (column < kSerialLcdWidth) {
+    text_[line][column] = value;
+  }
+  ++num_characters_;
+  ++address_;
+  if (address_ == 0x28) {
+    address_ = 0x40;
+  } else if (address_ == 0x68) {
+    address_ = 0x00;
+  }
+}
+
+/* static */
+void SimulatedSerialLcd::Print(FILE* fp) {
+  fprintf(fp, "+----------------+\n");
+  for (uint8_t line = 0; line < kSerialLcdHeight; ++line) {
+    fputc('|', fp);
+    for (uint8_t column = 0; column < kSerialLcdWidth; ++column) {
+      uint8_t character = text_[line][column];
+      if (character < 8) {
+        character += '0';
+      } else if (character == 0xff) {
+        character = '#';
+      } else if (character < 32 || character >= 127) {
+        character = '?';
+      }
+      fputc(character, fp);
+    }
+    fprintf(fp, "|\n");
+  }
+  fprintf(fp, "+----------------+\n");
+}
+
+/* static */
+void SimulatedEeprom::Erase() {
+  memset(host_eeprom, 0xff, sizeof(host_eeprom));
+}
+
+/* static */
+uint8_t SimulatedEeprom::Load(const char* file_name) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  uint16_t size = fread(host_eeprom, 1, sizeof(host_eeprom), fp);
+  fclose(fp);
+  return size == sizeof(host_eeprom);
+}
+
+/* static */
+uint8_t SimulatedEeprom::Save(const char* file_name) {
+  FILE* fp = fopen(file_name, "wb");
+  if (!fp) {
+    return 0;
+  }
+  uint16_t size = fwrite(host_eeprom, 1, sizeof(host_eeprom), fp);
+  fclose(fp);
+  return size == sizeof(host_eeprom);
+}
+
+enum I2cEepromPhase {
+  I2C_EEPROM_IDLE,
+  I2C_EEPROM_START,
+  I2C_EEPROM_ADDRESS,
+  I2C_EEPROM_WRITING,
+  I2C_EEPROM_READING,
+};
+
+static const uint8_t kI2cEepromAddress = 0x50;
+static const uint8_t kI2cEepromPageSize = 32;
+
+/* <static> */
+uint8_t SimulatedI2cEeprom::memory_[kI2cEepromSize];
+uint16_t SimulatedI2cEeprom::address_;
+uint8_t SimulatedI2cEeprom::phase_;
+uint8_t SimulatedI2cEeprom::num_address_bytes_;
+uint8_t SimulatedI2cEeprom::acknowledge_;
+uint8_t SimulatedI2cEeprom::written_;
+uint64_t SimulatedI2cEeprom::busy_until_;
+/* </static> */
+
+/* static */
+void SimulatedI2cEeprom::Init() {
+  memset(memory_, 0xff, sizeof(memory_));
+  address_ = 0;
+  phase_ = I2C_EEPROM_IDLE;
+  busy_until_ = 0;
+}
+
+/* static */
+uint8_t SimulatedI2cEeprom::Load(const char* file_name) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  uint16_t size = fread(memory_, 1, sizeof(memory_), fp);
+  fclose(fp);
+  return size == sizeof(memory_);
+}
+
+/* static */
+uint8_t SimulatedI2cEeprom::Save(const char* file_name) {
+  FILE* fp = fopen(file_name, "wb");
+  if (!fp) {
+    return 0;
+  }
+  uint16_t size = fwrite(memory_, 1, sizeof(memory_), fp);
+  fclose(fp);
+  return size == sizeof(memory_);
+}
+
+/* static */
+uint32_t SimulatedI2cEeprom::byte_duration() {
+  // 8 data bits and the acknowledgment bit, at the SCL frequency. The
+  // prescaler is assumed to be 1.
+  return 9 * (16 + 2 * static_cast<uint32_t>(TWBR));
+}
+
+/* static */
+void SimulatedI2cEeprom::OnControlWrite() {
+  uint8_t control = TWCR;
+  if (!(control & _BV(TWEN))) {
+    return;
+  }
+  if (control & _BV(TWSTO)) {
+    // The stop condition is immediate. A write cycle starts if data has been
+    // written.
+    TWCR = control & ~(_BV(TWSTO) | _BV(TWINT));
+    if (phase_ == I2C_EEPROM_WRITING && written_) {
+      busy_until_ = VirtualClock::cycles() + F_CPU / 200;
+    }
+    phase_ = I2C_EEPROM_IDLE;
+  } else if (control & _BV(TWSTA)) {
+    phase_ = I2C_EEPROM_START;
+    VirtualClock::Schedule(byte_duration() / 9, &EndOfTransfer);
+  }
+}
+
+/* static */
+void SimulatedI2cEeprom::EndOfTransfer() {
+  switch (phase_) {
+    case I2C_EEPROM_START:
+      phase_ = I2C_EEPROM_ADDRESS;
+      RaiseInterrupt(TW_START);
+      break;
+
+    case I2C_EEPROM_ADDRESS:
+      {
+        uint8_t slarw = TWDR;
+        uint8_t read = slarw & TW_READ;
+        // No acknowledgment during a write cycle.
+        if ((slarw >> 1) != kI2cEepromAddress ||
+            VirtualClock::cycles() < busy_until_) {
+          phase_ = I2C_EEPROM_IDLE;
+          RaiseInterrupt(read ? TW_MR_SLA_NACK : TW_MT_SLA_NACK);
+        } else if (read) {
+          phase_ = I2C_EEPROM_READING;
+          RaiseInterrupt(TW_MR_SLA_ACK);
+        } else {
+          phase_ = I2C_EEPROM_WRITING;
+          num_address_bytes_ = 0;
+          written_ = 0;
+          RaiseInterrupt(TW_MT_SLA_ACK);
+        }
+      }
+      break;
+
+    case I2C_EEPROM_WRITING:
+      if (num_address_bytes_ < 2) {
+        address_ = ((address_ << 8) | TWDR) & (kI2cEepromSize - 1);
+        ++num_address_bytes_;
+      } else {
+        // The address rolls over within the page.
+        memory_[address_] = TWDR;
+        address_ = (address_ & ~(kI2cEepromPageSize - 1)) |
+            ((address_ + 1) & (kI2cEepromPageSize - 1));
+        written_ = 1;
+      }
+      RaiseInterrupt(TW_MT_DATA_ACK);
+      break;
+
+    case I2C_EEPROM_READING:
+      TWDR = memory_[address_];
+      address_ = (address_ + 1) & (kI2cEepromSize - 1);
+      RaiseInterrupt(acknowledge_ ? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+      break;
+  }
+}
+
+/* static */
+void SimulatedI2cEeprom::RaiseInterrupt(uint8_t status) {
+  TWSR = (TWSR & ~TW_STATUS_MASK) | status;
+  if (!TWI_vect || !(TWCR & _BV(TWIE))) {
+    return;
+  }
+  // The handler acknowledges the interrupt by writing TWINT, directly to the
+  // register - then the next byte is transferred. If it sends a stop
+  // condition instead, the transaction is over.
+  TWCR = TWCR & ~(_BV(TWINT) | _BV(TWSTA));
+  VirtualClock::Interrupt(&TWI_vect);
+  if (phase_ != I2C_EEPROM_IDLE && (TWCR & _BV(TWINT))) {
+    acknowledge_ = TWCR & _BV(TWEA) ? 1 : 0;
+    VirtualClock::Schedule(byte_duration(), &EndOfTransfer);
+  }
+}
+
+/* <static> */
+uint8_t SimulatedSpiDac::slave_select_pin_;
+uint8_t SimulatedSpiDac::selected_;
+uint8_t SimulatedSpiDac::data_;
+uint16_t SimulatedSpiDac::shifted_;
+uint8_t SimulatedSpiDac::num_shifted_bytes_;
+uint16_t SimulatedSpiDac::value_;
+/* </static> */
+
+/* static */
+void SimulatedSpiDac::Init(uint8_t slave_select_pin) {
+  slave_select_pin_ = slave_select_pin;
+  selected_ = 0;
+  value_ = 2048;
+}
+
+/* static */
+uint32_t SimulatedSpiDac::byte_duration() {
+  static const uint8_t dividers[] = { 4, 16, 64, 128 };
+  uint32_t divider = dividers[SPCR & (_BV(SPR0) | _BV(SPR1))];
+  if (SPSR & _BV(SPI2X)) {
+    divider >>= 1;
+  }
+  return 8 * divider;
+}
+
+/* static */
+void SimulatedSpiDac::OnDataWrite() {
+  if (!(SPCR & _BV(SPE))) {
+    return;
+  }
+  // The firmware reads SPSR before writing SPDR, which clears the flag.
+  SPSR &= ~_BV(SPIF);
+  data_ = SPDR;
+  VirtualClock::Schedule(byte_duration(), &EndOfTransfer);
+}
+
+/* static */
+void SimulatedSpiDac::EndOfTransfer() {
+  if (selected_) {
+    shifted_ = (shifted_ << 8) | data_;
+    ++num_shifted_bytes_;
+  }
+  SPSR |= _BV(SPIF);
+  if (!SPI_STC_vect || !(SPCR & _BV(SPIE))) {
+    return;
+  }
+  // The flag is cleared when the handler is called.
+  SPSR &= ~_BV(SPIF);
+  VirtualClock::Interrupt(&SPI_STC_vect);
+}
+
+/* static */
+void SimulatedSpiDac::PinChanged(uint8_t pin, uint8_t value) {
+  if (pin != slave_select_pin_) {
+    return;
+  }
+  if (!value) {
+    selected_ = 1;
+    shifted_ = 0;
+    num_shifted_bytes_ = 0;
+  } else {
+    // Only the writes to the first channel, with the output enabled, are
+    // taken into account.
+    if (selected_ && num_shifted_bytes_ == 2 && !(shifted_ & 0x8000) &&
+        (shifted_ & 0x1000)) {
+      value_ = shifted_ & 0x0fff;
+    }
+    selected_ = 0;
+  }
+}
+
+}  // namespace hardware_hal
@@ -0,0 +1,315 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Simulated peripherals of the ATmega328p, and of the devices wired to it, for
+// the desktop simulation of the firmware. They observe the register accesses
+// done by the HAL through the hooks declared in hardware/hal/host/avr/io.h,
+// and are driven by the VirtualClock.
+//
+// - SimulatedGpio: levels of the digital pins, as driven by the firmware
+// (PORTx registers) or by the outside world (PINx registers). Also keeps the
+// counter of timer 0 (TCNT0) in sync with the VirtualClock.
+// - SimulatedShiftRegister: one or two chained 74HC595 on three pins, which
+// call back whenever a new value is latched on their outputs.
+// - SimulatedUart: the onboard UART, with its 2 bytes reception FIFO and its
+// transmission buffer. Bytes are received and sent at the configured rate,
+// and the "byte received" and "data register empty" interrupts are raised.
+// - SimulatedAdc: the onboard ADC, with conversions taking 13 ADC cycles.
+// - SoftwareSerialReceiver: decodes the bits banged by the firmware on a pin,
+// sampled at the main timer rate.
+// - SimulatedSerialLcd: a Sparkfun serial LCD, fed by the bytes decoded by a
+// SoftwareSerialReceiver.
+// - SimulatedEeprom: load/save of the EEPROM contents.
+// - SimulatedI2cEeprom: a 24LC64 on the I2C bus, driven by the TWI
+// peripheral in master mode, with its 5ms write cycle during which it does not
+// acknowledge its address.
+// - SimulatedSpiDac: a MCP4921 on the SPI bus, driven by the SPI peripheral in
+// master mode, which latches the 16 bits shifted in when its slave select pin
+// is raised.
+
+#ifndef HARDWARE_HAL_HOST_PERIPHERALS_H_
+#define HARDWARE_HAL_HOST_PERIPHERALS_H_
+
+#include <stdio.h>
+
+#include "hardware/base/base.h"
+
+namespace hardware_hal {
+
+static const uint8_t kNumSimulatedPins = 20;
+static const uint8_t kMaxShiftRegisters = 4;
+static const uint8_t kNumAdcChannels = 8;
+static const uint16_t kUartQueueSize = 4096;
+static const uint16_t kI2cEepromSize = 8192;
+
+class SimulatedShiftRegister;
+
+typedef void (*ByteCallback)(uint8_t value);
+typedef void (*WordCallback)(uint16_t value);
+
+class SimulatedGpio {
+ public:
+  SimulatedGpio() { }
+
+  // Installs the register hooks, and initializes all the simulated
+  // peripherals.
+  static void Init();
+
+  // Level driven by the firmware on a pin.
+  static uint8_t output(uint8_t pin);
+
+  // Level applied by the outside world on a pin, as read by the firmware.
+  static void set_input(uint8_t pin, uint8_t value);
+
+  // The shift register will be notified of the changes on its pins.
+  static void Attach(SimulatedShiftRegister* shift_register);
+
+ private:
+  static void OnRead(uint8_t address);
+  static void OnWrite(uint8_t address, uint8_t previous);
+
+  static uint8_t input_[kNumSimulatedPins];
+  static SimulatedShiftRegister* shift_registers_[kMaxShiftRegisters];
+  static uint8_t num_shift_registers_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedGpio);
+};
+
+class SimulatedShiftRegister {
+ public:
+  SimulatedShiftRegister() { }
+
+  void Init(uint8_t clock_pin, uint8_t data_pin, uint8_t latch_pin,
+            WordCallback latch_callback);
+  void PinChanged(uint8_t pin, uint8_t value);
+  uint16_t value() const { return value_; }
+
+ private:
+  uint8_t clock_pin_;
+  uint8_t data_pin_;
+  uint8_t latch_pin_;
+  uint16_t shifted_;
+  uint16_t value_;
+  WordCallback latch_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedShiftRegister);
+};
+
+class SimulatedUart {
+ public:
+  SimulatedUart() { }
+
+  static void Init();
+
+  // Queues a byte, to be received once the previous ones have been.
+  static void Receive(uint8_t value);
+
+  // Called whenever a byte has been completely transmitted.
+  static void set_transmit_callback(ByteCallback callback) {
+    transmit_callback_ = callback;
+  }
+
+  // Duration of the transmission of a byte (start, 8 data bits, stop), in CPU
+  // cycles, at the current baud rate.
+  static uint32_t byte_duration();
+
+  static uint16_t num_pending() { return num_pending_; }
+  static uint32_t num_overruns() { return num_overruns_; }
+
+  // Register hooks.
+  static void OnDataRead();
+  static void OnDataWrite(uint8_t value);
+  static void RequestDataRegisterEmptyInterrupt();
+
+ private:
+  static void EndOfReception();
+  static void EndOfTransmission();
+  static void DataRegisterEmpty();
+
+  static uint8_t pending_[kUartQueueSize];
+  static uint16_t pending_read_ptr_;
+  static uint16_t num_pending_;
+  static uint8_t receiving_;
+
+  static uint8_t fifo_[2];
+  static uint8_t fifo_size_;
+  static uint32_t num_overruns_;
+
+  static uint8_t shifter_;
+  static uint8_t transmitting_;
+  static uint8_t tx_buffer_;
+  static uint8_t tx_buffer_full_;
+  static uint8_t data_register_empty_pending_;
+  static ByteCallback transmit_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedUart);
+};
+
+class SimulatedAdc {
+ public:
+  SimulatedAdc() { }
+
+  static void Init();
+
+  // Value, between 0 and 1023, applied on an analog input.
+  static void set_value(uint8_t channel, uint16_t value) {
+    value_[channel] = value;
+  }
+
+  // Register hook.
+  static void OnStartConversion();
+
+ private:
+  static void EndOfConversion();
+
+  static uint16_t value_[kNumAdcChannels];
+  static uint16_t sample_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedAdc);
+};
+
+class SoftwareSerialReceiver {
+ public:
+  SoftwareSerialReceiver() { }
+
+  // Bits last ticks_per_bit calls to Tick().
+  void Init(uint8_t pin, uint8_t ticks_per_bit, ByteCallback callback);
+
+  // To be called at the rate of the timer driving the transmitter, after the
+  // interrupt handler.
+  void Tick();
+
+ private:
+  uint8_t pin_;
+  uint8_t ticks_per_bit_;
+  ByteCallback callback_;
+  uint8_t counter_;
+  uint8_t bit_;
+  uint8_t value_;
+
+  DISALLOW_COPY_AND_ASSIGN(SoftwareSerialReceiver);
+};
+
+static const uint8_t kSerialLcdWidth = 16;
+static const uint8_t kSerialLcdHeight = 2;
+
+class SimulatedSerialLcd {
+ public:
+  SimulatedSerialLcd() { }
+
+  static void Init();
+  static void Receive(uint8_t value);
+
+  // Character shown at a given position - 0 to 7 for the custom characters.
+  static uint8_t character(uint8_t line, uint8_t column) {
+    return text_[line][column];
+  }
+  static uint8_t brightness() { return brightness_; }
+  static uint32_t num_characters() { return num_characters_; }
+
+  // Prints the content of the screen, with the custom characters shown as
+  // digits.
+  static void Print(FILE* fp);
+
+ private:
+  static uint8_t text_[kSerialLcdHeight][kSerialLcdWidth];
+  static uint8_t custom_characters_[64];
+  static uint8_t address_;
+  static uint8_t writing_custom_characters_;
+  static uint8_t command_;
+  static uint8_t brightness_;
+  static uint32_t num_characters_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedSerialLcd);
+};
+
+class SimulatedEeprom {
+ public:
+  SimulatedEeprom() { }
+
+  // Fills the EEPROM with 0xff, as on a new chip.
+  static void Erase();
+  static uint8_t Load(const char* file_name);
+  static uint8_t Save(const char* file_name);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SimulatedEeprom);
+};
+
+class SimulatedI2cEeprom {
+ public:
+  SimulatedI2cEeprom() { }
+
+  // Fills the EEPROM with 0xff.
+  static void Init();
+  static uint8_t Load(const char* file_name);
+  static uint8_t Save(const char* file_name);
+
+  // Register hook, for the writes to TWCR done outside of the interrupt
+  // handler (start and stop conditions).
+  static void OnControlWrite();
+
+ private:
+  // Duration of the transmission of a byte and its acknowledgment, in CPU
+  // cycles.
+  static uint32_t byte_duration();
+  static void EndOfTransfer();
+  static void RaiseInterrupt(uint8_t status);
+
+  static uint8_t memory_[kI2cEepromSize];
+  static uint16_t address_;
+  static uint8_t phase_;
+  static uint8_t num_address_bytes_;
+  static uint8_t acknowledge_;
+  static uint8_t written_;
+  static uint64_t busy_until_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedI2cEeprom);
+};
+
+class SimulatedSpiDac {
+ public:
+  SimulatedSpiDac() { }
+
+  // The DAC is not connected until it is given a slave select pin.
+  static void Init(uint8_t slave_select_pin);
+
+  // Last word latched on the output, on 12 bits.
+  static uint16_t value() { return value_; }
+
+  // Register and pin hooks.
+  static void OnDataWrite();
+  static void PinChanged(uint8_t pin, uint8_t value);
+
+ private:
+  // Duration of the transmission of a byte, in CPU cycles.
+  static uint32_t byte_duration();
+  static void EndOfTransfer();
+
+  static uint8_t slave_select_pin_;
+  static uint8_t selected_;
+  static uint8_t data_;
+  static uint16_t shifted_;
+  static uint8_t num_shifted_bytes_;
+  static uint16_t value_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedSpiDac);
+};
+
+}  // namespace hardware_hal
+
+#endif  // HARDWARE_HAL_HOST_PERIPHERALS_H_
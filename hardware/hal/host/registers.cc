@@ -0,0 +1,38 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Storage for the simulated registers and EEPROM of the desktop build, and for
+// the hooks through which simulated peripherals observe them.
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stddef.h>
+
+/* extern */
+volatile uint8_t host_registers[0x100];
+
+/* extern */
+uint8_t host_eeprom[1024];
+
+/* extern */
+void (*host_register_read_hook)(uint8_t address) = NULL;
+
+/* extern */
+void (*host_register_write_hook)(uint8_t address, uint8_t previous) = NULL;
+
+/* extern */
+void (*host_delay_hook)(uint16_t num_cycles) = NULL;
@@ -0,0 +1,155 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Deterministic virtual clock for the desktop simulation of the firmware.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hardware/hal/host/virtual_clock.h"
+
+// Interrupt handlers possibly defined by the simulated program.
+extern "C" {
+void TIMER0_OVF_vect() __attribute__((weak));
+void TIMER2_OVF_vect() __attribute__((weak));
+}
+
+namespace hardware_hal {
+
+// Timer 0 runs in fast PWM mode with a /64 prescaler (see InitClock()).
+static const uint16_t kTimer0Period = 64 * 256;
+
+// Timer 2 runs at the main timer rate.
+static const uint16_t kTimer2Period = F_CPU / 31250;
+
+/* <static> */
+uint64_t VirtualClock::cycles_;
+uint32_t VirtualClock::num_ticks_;
+uint16_t VirtualClock::interrupt_cost_ = 60;
+uint32_t VirtualClock::stolen_cycles_;
+uint8_t VirtualClock::in_interrupt_;
+VirtualClockCallback VirtualClock::tick_callback_;
+ScheduledEvent VirtualClock::events_[kMaxScheduledEvents];
+uint8_t VirtualClock::num_events_;
+uint64_t VirtualClock::next_overflow_[2];
+/* </static> */
+
+/* static */
+void VirtualClock::Init() {
+  cycles_ = 0;
+  num_ticks_ = 0;
+  stolen_cycles_ = 0;
+  in_interrupt_ = 0;
+  num_events_ = 0;
+  next_overflow_[0] = kTimer0Period;
+  next_overflow_[1] = kTimer2Period;
+  host_delay_hook = &Delay;
+}
+
+/* static */
+void VirtualClock::Delay(uint16_t num_cycles) {
+  // Interrupts are disabled in an interrupt handler, so a handler waiting for
+  // something would hang on the chip. Here, it does not see the time advance.
+  if (in_interrupt_) {
+    return;
+  }
+  Advance(num_cycles);
+}
+
+/* static */
+uint64_t VirtualClock::NextOverflow(uint16_t period) {
+  return (cycles_ / period + 1) * period;
+}
+
+/* static */
+void VirtualClock::Schedule(uint32_t num_cycles,
+                            VirtualClockCallback callback) {
+  if (num_events_ == kMaxScheduledEvents) {
+    fprintf(stderr, "Too many events scheduled on the virtual clock\n");
+    exit(1);
+  }
+  events_[num_events_].time = cycles_ + num_cycles;
+  events_[num_events_].callback = callback;
+  ++num_events_;
+}
+
+/* static */
+void VirtualClock::Interrupt(VirtualClockCallback handler) {
+  in_interrupt_ = 1;
+  (*handler)();
+  in_interrupt_ = 0;
+  stolen_cycles_ += interrupt_cost_;
+}
+
+/* static */
+void VirtualClock::Advance(uint32_t num_cycles) {
+  uint64_t end = cycles_ + num_cycles;
+  while (1) {
+    // Find the next thing to happen: a timer overflow, or a scheduled event.
+    // Ties are resolved in favor of timer 2, then timer 0.
+    uint64_t next = end + 1;
+    VirtualClockCallback handler = NULL;
+    uint8_t event = kMaxScheduledEvents;
+    if (TIMER2_OVF_vect && (TIMSK2 & _BV(TOIE2))) {
+      next = next_overflow_[1];
+      handler = &TIMER2_OVF_vect;
+    } else {
+      next_overflow_[1] = NextOverflow(kTimer2Period);
+    }
+    if (TIMER0_OVF_vect && (TIMSK0 & _BV(TOIE0))) {
+      if (next_overflow_[0] < next) {
+        next = next_overflow_[0];
+        handler = &TIMER0_OVF_vect;
+      }
+    } else {
+      next_overflow_[0] = NextOverflow(kTimer0Period);
+    }
+    for (uint8_t i = 0; i < num_events_; ++i) {
+      if (events_[i].time < next) {
+        next = events_[i].time;
+        event = i;
+      }
+    }
+    if (next > end) {
+      break;
+    }
+    cycles_ = next;
+    if (event != kMaxScheduledEvents) {
+      VirtualClockCallback callback = events_[event].callback;
+      --num_events_;
+      events_[event] = events_[num_events_];
+      (*callback)();
+    } else {
+      Interrupt(handler);
+      if (handler == &TIMER0_OVF_vect) {
+        next_overflow_[0] += kTimer0Period;
+      } else {
+        next_overflow_[1] += kTimer2Period;
+        ++num_ticks_;
+        if (tick_callback_) {
+          (*tick_callback_)();
+        }
+      }
+    }
+    // The main program is suspended while the interrupts are handled.
+    end += stolen_cycles_;
+    stolen_cycles_ = 0;
+  }
+  cycles_ = end;
+}
+
+}  // namespace hardware_hal
@@ -0,0 +1,106 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Deterministic virtual clock for the desktop simulation of the firmware.
+//
+// The simulated time is counted in CPU cycles, and only advances when it is
+// told to: by the simulator, after each task, by the estimated cost of the
+// task ; and by the firmware itself whenever it busy-waits (see BusyWait() in
+// hardware/hal/hal.h). As the time advances, the overflow interrupts of the
+// enabled timers are called, as are the events scheduled by the simulated
+// peripherals (end of an ADC conversion, arrival of a byte on the UART...).
+//
+// Timer 2 overflows at the nominal main timer rate of the firmware (31250 Hz),
+// and timer 0 at the rate assumed by the real time clock in time.cc. The
+// handlers are called only if the corresponding overflow interrupt is enabled
+// in the TIMSKx register, and if the program defines them.
+
+#ifndef HARDWARE_HAL_HOST_VIRTUAL_CLOCK_H_
+#define HARDWARE_HAL_HOST_VIRTUAL_CLOCK_H_
+
+#include <avr/io.h>
+
+#include "hardware/base/base.h"
+
+namespace hardware_hal {
+
+typedef void (*VirtualClockCallback)();
+
+static const uint8_t kMaxScheduledEvents = 16;
+
+struct ScheduledEvent {
+  uint64_t time;
+  VirtualClockCallback callback;
+};
+
+class VirtualClock {
+ public:
+  VirtualClock() { }
+
+  // Resets the time, and installs the hook through which the firmware reports
+  // its busy-waits.
+  static void Init();
+
+  // Lets num_cycles CPU cycles of the main program elapse. The interrupts
+  // occurring in the meantime are handled, and the time they take is added on
+  // top of num_cycles.
+  static void Advance(uint32_t num_cycles);
+
+  // Calls callback in num_cycles cycles.
+  static void Schedule(uint32_t num_cycles, VirtualClockCallback callback);
+
+  // Calls an interrupt handler, and charges its cost to the main program.
+  static void Interrupt(VirtualClockCallback handler);
+
+  // Called right after each timer 2 interrupt, for example to sample the
+  // outputs of the simulated chip at the main timer rate.
+  static void set_tick_callback(VirtualClockCallback callback) {
+    tick_callback_ = callback;
+  }
+
+  // Number of cycles spent in each timer interrupt handler.
+  static void set_interrupt_cost(uint16_t num_cycles) {
+    interrupt_cost_ = num_cycles;
+  }
+
+  static uint64_t cycles() { return cycles_; }
+  static uint32_t milliseconds() { return cycles_ / (F_CPU / 1000); }
+  static uint32_t num_ticks() { return num_ticks_; }
+  static uint8_t in_interrupt() { return in_interrupt_; }
+
+ private:
+  static void Delay(uint16_t num_cycles);
+  static uint64_t NextOverflow(uint16_t period);
+
+  static uint64_t cycles_;
+  static uint32_t num_ticks_;
+  static uint16_t interrupt_cost_;
+  static uint32_t stolen_cycles_;
+  static uint8_t in_interrupt_;
+  static VirtualClockCallback tick_callback_;
+  static ScheduledEvent events_[kMaxScheduledEvents];
+  static uint8_t num_events_;
+
+  // Time of the next overflow of timer 0 and timer 2.
+  static uint64_t next_overflow_[2];
+
+  DISALLOW_COPY_AND_ASSIGN(VirtualClock);
+};
+
+}  // namespace hardware_hal
+
+#endif  // HARDWARE_HAL_HOST_VIRTUAL_CLOCK_H_
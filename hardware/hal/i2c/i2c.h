@@ -107,10 +107,15 @@ class I2cMaster {
   }
 
   static uint8_t Wait() {
-    while (state_ != I2C_STATE_READY) { }
+    while (state_ != I2C_STATE_READY) { BusyWait(); }
     return error_;
   }
 
+  // Non-blocking alternative to Wait(), for callers polling the bus from a
+  // task.
+  static inline uint8_t busy() { return state_ != I2C_STATE_READY; }
+  static inline uint8_t error() { return error_; }
+
   static uint8_t Send(uint8_t address) {
     // The output buffer is empty, no need to do anything.
     if (!Output::readable()) {
@@ -166,6 +171,7 @@ class I2cMaster {
   static inline Value ImmediateRead() { return Input::ImmediateRead(); }
 
   static inline void FlushInputBuffer() { Input::Flush(); }
+  static inline void FlushOutputBuffer() { Output::Flush(); }
 
  private:
   static inline void Continue(uint8_t ack) {
@@ -178,7 +184,7 @@ class I2cMaster {
 
   static inline void Stop() {
     I2cStop::set();
-    while (I2cStop::value()) { }
+    while (I2cStop::value()) { BusyWait(); }
     state_ = I2C_STATE_READY;
   }
 
@@ -220,7 +226,9 @@ class I2cMaster {
         Input::Overwrite(TWDR);
         ++received_;
       case TW_MR_SLA_ACK:
-        if (received_ < requested_) {
+        // Acknowledge the next byte only if it is not the last one requested,
+        // so that the slave stops after exactly requested_ bytes.
+        if (received_ + 1 < requested_) {
           Continue(1);
         } else {
           Continue(0);
@@ -39,7 +39,7 @@ class Buffer : public Input, Output {
   };
   static inline uint8_t capacity() { return size; }
   static inline void Write(Value v) {
-    while (!writable());
+    while (!writable()) { BusyWait(); }
     Overwrite(v);
   }
   static inline uint8_t writable() {
@@ -59,7 +59,7 @@ class Buffer : public Input, Output {
   }
   static inline uint8_t Requested() { return 0; }
   static inline Value Read() {
-    while (!readable());
+    while (!readable()) { BusyWait(); }
     return ImmediateRead();
   }
   static inline uint8_t readable() {
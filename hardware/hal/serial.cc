@@ -27,3 +27,7 @@ using namespace hardware_hal;
 ISR(USART_RX_vect) {
   SerialInput<SerialPort0>::Received();
 }
+
+ISR(USART_UDRE_vect) {
+  SerialOutput<SerialPort0>::Requested();
+}
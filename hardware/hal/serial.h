@@ -40,8 +40,14 @@
 // Flushing a buffer:
 // Serial::InputBuffer::Flush()
 //
-// TODO(pichenettes): Buffered writes not supported for now (should look up
-// the right interrupt handler).
+// Input buffer statistics (for buffered input):
+// Serial::input_high_water_mark()  // Largest number of bytes ever waiting.
+// Serial::num_dropped_input_bytes()  // Bytes lost because the buffer was full.
+//
+// In buffered output mode, Write() and NonBlockingWrite() put the data in a
+// buffer, and return immediately (unless the buffer is full for Write). The
+// buffer is emptied, one byte at a time, by the "data register empty"
+// interrupt, which is enabled only as long as there is something to send.
 
 #ifndef HARDWARE_HAL_SERIAL_H_
 #define HARDWARE_HAL_SERIAL_H_
@@ -60,7 +66,7 @@ const uint8_t kSerialInputBufferSize = 32;
 // for non-blocking write or polling reads.
 template<typename TxEnableBit, typename TxReadyBit,
          typename RxEnableBit, typename RxReadyBit,
-         typename RxInterruptBit,
+         typename RxInterruptBit, typename TxInterruptBit,
          typename PrescalerRegisterH, typename PrescalerRegisterL,
          typename DataRegister,
          uint8_t input_buffer_size_,
@@ -69,6 +75,7 @@ struct SerialPort {
   typedef TxEnableBit Tx;
   typedef RxEnableBit Rx;
   typedef RxInterruptBit RxInterrupt;
+  typedef TxInterruptBit TxInterrupt;
   enum {
     input_buffer_size = input_buffer_size_,
     output_buffer_size = output_buffer_size_
@@ -92,7 +99,10 @@ struct SerialInput : public Input {
   typedef uint8_t Value;
   
   // Blocking!
-  static inline Value Read() { while (!readable()); return ImmediateRead(); }  
+  static inline Value Read() {
+    while (!readable()) { BusyWait(); }
+    return ImmediateRead();
+  }  
   
   // Number of bytes available for read.
   static inline uint8_t readable() { return SerialPort::rx_ready(); }
@@ -105,11 +115,31 @@ struct SerialInput : public Input {
   
   // Called in data reception interrupt.
   static inline void Received() {
+    typedef Buffer<SerialInput<SerialPort> > InputBuffer;
     // This will discard data if the buffer is full.
-    Buffer<SerialInput<SerialPort> >::NonBlockingWrite(ImmediateRead());
+    if (!InputBuffer::NonBlockingWrite(ImmediateRead())) {
+      ++num_dropped_bytes_;
+    } else if (InputBuffer::readable() > high_water_mark_) {
+      high_water_mark_ = InputBuffer::readable();
+    }
   }
+
+  // Largest number of bytes waiting in the buffer, and number of bytes
+  // discarded because the buffer was full.
+  static inline uint8_t high_water_mark() { return high_water_mark_; }
+  static inline uint16_t num_dropped_bytes() { return num_dropped_bytes_; }
+
+ private:
+  static uint8_t high_water_mark_;
+  static uint16_t num_dropped_bytes_;
 };
 
+template<typename SerialPort>
+uint8_t SerialInput<SerialPort>::high_water_mark_;
+
+template<typename SerialPort>
+uint16_t SerialInput<SerialPort>::num_dropped_bytes_;
+
 template<typename SerialPort>
 struct SerialOutput : public Output {
   enum {
@@ -119,7 +149,10 @@ struct SerialOutput : public Output {
   typedef uint8_t Value;
   
   // Blocking!
-  static inline void Write(Value v) { while (!writable()); Overwrite(v); }
+  static inline void Write(Value v) {
+    while (!writable()) { BusyWait(); }
+    Overwrite(v);
+  }
   
   // Number of bytes that can be fed.
   static inline uint8_t writable() { return SerialPort::tx_ready(); }
@@ -136,15 +169,57 @@ struct SerialOutput : public Output {
   // No check for ready state.
   static inline void Overwrite(Value v) { SerialPort::set_data(v); }
   
-  // Called in data emission interrupt.
-  static inline Value Requested() {
-    Value v = Buffer<SerialOutput<SerialPort> >::NonBlockingRead();
-    if (v >= 0) {
-      Overwrite(v);
+  // Called in data register empty interrupt.
+  static inline void Requested() {
+    typedef Buffer<SerialOutput<SerialPort> > OutputBuffer;
+    if (OutputBuffer::readable()) {
+      Overwrite(OutputBuffer::ImmediateRead());
+    } else {
+      // Nothing left to send - the interrupt is enabled again by the next
+      // write.
+      SerialPort::TxInterrupt::clear();
     }
   }
 };
 
+// Writes to the output buffer, and makes sure the interrupt emptying it is
+// enabled.
+template<typename SerialPort>
+struct BufferedSerialOutput : public Output {
+  typedef Buffer<SerialOutput<SerialPort> > OutputBuffer;
+  enum {
+    buffer_size = SerialPort::output_buffer_size,
+    data_size = 8
+  };
+  typedef uint8_t Value;
+
+  // Blocks only if the buffer is full.
+  static inline void Write(Value v) {
+    OutputBuffer::Write(v);
+    SerialPort::TxInterrupt::set();
+  }
+
+  // Number of bytes that can be fed.
+  static inline uint8_t writable() { return OutputBuffer::writable(); }
+
+  // 1 if success.
+  static inline uint8_t NonBlockingWrite(Value v) {
+    if (!OutputBuffer::NonBlockingWrite(v)) {
+      return 0;
+    }
+    SerialPort::TxInterrupt::set();
+    return 1;
+  }
+
+  // No check for available space.
+  static inline void Overwrite(Value v) {
+    OutputBuffer::Overwrite(v);
+    SerialPort::TxInterrupt::set();
+  }
+
+  static inline void Flush() { OutputBuffer::Flush(); }
+};
+
 template<typename SerialPort, PortMode input = POLLED, PortMode output = POLLED>
 struct SerialImplementation { };
 
@@ -158,7 +233,7 @@ struct SerialImplementation<SerialPort, DISABLED, POLLED> {
 };
 template<typename SerialPort>
 struct SerialImplementation<SerialPort, DISABLED, BUFFERED> {
-  typedef Buffer<SerialOutput<SerialPort> > OutputBuffer;
+  typedef BufferedSerialOutput<SerialPort> OutputBuffer;
   typedef InputOutput<DisabledInput, OutputBuffer > IO;
 };
 template<typename SerialPort>
@@ -171,7 +246,7 @@ struct SerialImplementation<SerialPort, POLLED, POLLED> {
 };
 template<typename SerialPort>
 struct SerialImplementation<SerialPort, POLLED, BUFFERED> {
-  typedef Buffer<SerialOutput<SerialPort> > OutputBuffer;
+  typedef BufferedSerialOutput<SerialPort> OutputBuffer;
   typedef InputOutput<SerialInput<SerialPort>, OutputBuffer> IO;
 };
 template<typename SerialPort>
@@ -187,7 +262,7 @@ struct SerialImplementation<SerialPort, BUFFERED, POLLED> {
 template<typename SerialPort>
 struct SerialImplementation<SerialPort, BUFFERED, BUFFERED> {
   typedef Buffer<SerialInput<SerialPort> > InputBuffer;
-  typedef Buffer<SerialOutput<SerialPort> > OutputBuffer;
+  typedef BufferedSerialOutput<SerialPort> OutputBuffer;
   typedef InputOutput<InputBuffer, OutputBuffer> IO;
 };
 
@@ -237,6 +312,14 @@ struct Serial {
     return Impl::IO::NonBlockingRead();
   }
   static inline Value ImmediateRead() { return Impl::IO::ImmediateRead(); }
+
+  // Occupancy statistics of the input buffer (in buffered input mode).
+  static inline uint8_t input_high_water_mark() {
+    return SerialInput<SerialPort>::high_water_mark();
+  }
+  static inline uint16_t num_dropped_input_bytes() {
+    return SerialInput<SerialPort>::num_dropped_bytes();
+  }
 };
 
 // For other uC with several UARTs (eg Arduino mega), you can declare the other
@@ -253,6 +336,7 @@ typedef SerialPort<
     BitInRegister<UCSR0BRegister, RXEN0>,
     BitInRegister<UCSR0ARegister, RXC0>,
     BitInRegister<UCSR0BRegister, RXCIE0>,
+    BitInRegister<UCSR0BRegister, UDRIE0>,
     UBRR0HRegister,
     UBRR0LRegister,
     UDR0Register,
@@ -261,4 +345,4 @@ typedef SerialPort<
 
 }  // namespace hardware_hal
 
-#endif HARDWARE_HAL_SERIAL_H_
+#endif  // HARDWARE_HAL_SERIAL_H_
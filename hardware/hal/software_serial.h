@@ -171,6 +171,10 @@ struct SoftwareSerialOutput {
   }
   
   static inline void TunedDelay(uint16_t delay) {
+#ifndef __AVR__
+    // 7 cycles per iteration of the loop below.
+    HostDelay(delay * 7);
+#else
     uint8_t tmp = 0;
     asm volatile(
       "sbiw %0, 0x01"  "\n\t"
@@ -181,9 +185,10 @@ struct SoftwareSerialOutput {
       : "+r" (delay), "+a" (tmp)
       : "0" (delay)
     );
+#endif  // __AVR__
   }
 };
 
 }  // namespace hardware_hal
 
-#endif HARDWARE_HAL_SOFTWARE_SERIAL_H_
+#endif  // HARDWARE_HAL_SOFTWARE_SERIAL_H_
@@ -24,25 +24,66 @@
 //   around 15 cycles (not including the interrupt prelude/postlude), which is
 //   close to the transmission time at the fastest speed.
 // - the atmega is always configured as a master.
-// - no support for reading back from the slave.
+// - only the last byte received from the slave can be read back.
+//
+// Code which cannot afford to busy-wait for the end of a transmission (for
+// example, in the audio interrupt) can instead start it with Send(), and be
+// called back from the "transfer complete" interrupt. The application defines
+// this interrupt handler with SPI_TRANSFER_COMPLETE, only when it has such a
+// client, so that it costs nothing otherwise:
+//
+// SPI_TRANSFER_COMPLETE {
+//   SpiMaster<>::OnTransferComplete();
+// }
+//
+// SpiMaster queues multi-bytes transactions (rather than bytes, for the reason
+// given above), which are transmitted one after the other from the "transfer
+// complete" interrupt. Each transaction selects its own slave, so several
+// devices can share the bus. The caller is notified of the completion of a
+// transaction by a flag, which a task can poll before yielding, and by an
+// optional callback (called from the interrupt):
+//
+// SpiTransaction transaction = { &Gpio<9>::set_value, data, NULL, 4 };
+// SpiMaster<>::Submit(&transaction);
+// ...
+// while (!transaction.done) {
+//   TASK_SWITCH;
+// }
+//
+// SpiMaster owns the "transfer complete" interrupt, and cannot be used along
+// with the interrupt mode of Spi (for example, StreamingDac).
 
 #ifndef HARDWARE_HAL_SPI_H_
 #define HARDWARE_HAL_SPI_H_
 
+#include <avr/interrupt.h>
+
 #include "hardware/hal/hal.h"
 #include "hardware/hal/gpio.h"
+#include "hardware/hal/ring_buffer.h"
 
 namespace hardware_hal {
 
 const uint8_t kSpiDataOutPin = 11;
 const uint8_t kSpiDataInPin = 12;
 const uint8_t kSpiClockPin = 13;
+// The hardware slave select pin must be an output for the master mode to be
+// kept.
+const uint8_t kSpiSlaveSelectPin = 10;
+
+const uint8_t kSpiQueueSize = 4;
 
+IORegister(SPCR);
 IORegister(SPSR);
+IORegister(SPDR);
+typedef BitInRegister<SPCRRegister, SPIE> TransferCompleteInterrupt;
 typedef BitInRegister<SPSRRegister, SPI2X> DoubleSpeed;
 typedef BitInRegister<SPSRRegister, SPIF> TransferComplete;
 
-template<uint8_t slave_select_pin = 10,
+// Readable alias for the "transfer complete" interrupt.
+#define SPI_TRANSFER_COMPLETE ISR(SPI_STC_vect)
+
+template<uint8_t slave_select_pin = kSpiSlaveSelectPin,
          DataOrder order = MSB_FIRST,
          uint8_t speed = 4>
 class Spi {
@@ -90,27 +131,155 @@ class Spi {
   
   static inline void Write(uint8_t v) {
     SlaveSelect::Low();
-    SPDR = v;
-    while (!TransferComplete::value());
+    set_data(v);
+    while (!TransferComplete::value()) { BusyWait(); }
     SlaveSelect::High();
   }
 
   static inline void WriteWord(uint8_t a, uint8_t b) {
     SlaveSelect::Low();
-    SPDR = a;
-    while (!TransferComplete::value());
-    SPDR = b;
-    while (!TransferComplete::value());
+    set_data(a);
+    while (!TransferComplete::value()) { BusyWait(); }
+    set_data(b);
+    while (!TransferComplete::value()) { BusyWait(); }
     SlaveSelect::High();
   }
+
+  // Non-blocking transmission. The slave is selected with Begin(), and
+  // released with End() once the last byte sent has been transmitted.
+  static inline void Begin() {
+    SlaveSelect::Low();
+  }
+
+  static inline void Send(uint8_t v) {
+    // Reading SPSR, then writing SPDR, clears the "transfer complete" flag
+    // left by the previous transmission.
+    TransferComplete::value();
+    set_data(v);
+  }
+
+  static inline void End() {
+    SlaveSelect::High();
+  }
+
+  static inline void EnableInterrupt() {
+    TransferCompleteInterrupt::set();
+  }
+
+  static inline void DisableInterrupt() {
+    TransferCompleteInterrupt::clear();
+  }
+
+  // Last byte received from the slave, while sending the last byte.
+  static inline uint8_t data() { return *SPDRRegister::ptr(); }
   
  private:
+  static inline void set_data(uint8_t value) { *SPDRRegister::ptr() = value; }
+
   typedef Gpio<slave_select_pin> SlaveSelect;
   typedef Gpio<kSpiDataOutPin> DataOut;
   typedef Gpio<kSpiDataInPin> DataIn;
   typedef Gpio<kSpiClockPin> Clock;
 };
 
+struct SpiTransaction {
+  // Drives the slave select line of the device, for example
+  // &Gpio<9>::set_value. Called with LOW at the beginning of the transaction,
+  // and with HIGH at the end.
+  void (*select)(uint8_t);
+  const uint8_t* tx_data;
+  // The bytes received during the transaction are stored here, unless NULL.
+  uint8_t* rx_data;
+  // Must not be 0.
+  uint8_t size;
+  // Set by the interrupt handler when the last byte has been transmitted.
+  volatile uint8_t done;
+  // Called from the interrupt handler when the transaction is done, unless
+  // NULL.
+  void (*callback)();
+};
+
+template<DataOrder order = MSB_FIRST, uint8_t speed = 4>
+class SpiMaster {
+ public:
+  typedef SpiTransaction* Value;
+  enum {
+    buffer_size = kSpiQueueSize,
+    data_size = 16
+  };
+  typedef Buffer<SpiMaster<order, speed> > Queue;
+
+  static void Init() {
+    Bus::Init();
+  }
+
+  // Returns 0 if the queue is full. The transaction must not be modified until
+  // it is done.
+  static uint8_t Submit(SpiTransaction* transaction) {
+    transaction->done = 0;
+    // The interrupt is masked while the queue is modified ; a transfer
+    // completed in the meantime raises it as soon as it is unmasked.
+    Bus::DisableInterrupt();
+    uint8_t success = 1;
+    if (!current_) {
+      Start(transaction);
+    } else {
+      success = Queue::NonBlockingWrite(transaction);
+    }
+    Bus::EnableInterrupt();
+    return success;
+  }
+
+  static inline uint8_t busy() { return current_ != NULL; }
+
+  // To be called from the "transfer complete" interrupt, after each byte.
+  static void OnTransferComplete() {
+    SpiTransaction* transaction = current_;
+    if (transaction->rx_data) {
+      transaction->rx_data[position_] = Bus::data();
+    }
+    ++position_;
+    if (position_ < transaction->size) {
+      Bus::Send(transaction->tx_data[position_]);
+      return;
+    }
+    (*transaction->select)(HIGH);
+    transaction->done = 1;
+    if (transaction->callback) {
+      (*transaction->callback)();
+    }
+    if (Queue::readable()) {
+      Start(Queue::ImmediateRead());
+    } else {
+      current_ = NULL;
+      Bus::DisableInterrupt();
+    }
+  }
+
+ private:
+  typedef Spi<kSpiSlaveSelectPin, order, speed> Bus;
+
+  static void Start(SpiTransaction* transaction) {
+    current_ = transaction;
+    position_ = 0;
+    (*transaction->select)(LOW);
+    Bus::Send(transaction->tx_data[0]);
+  }
+
+  static SpiTransaction* volatile current_;
+  static uint8_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpiMaster);
+};
+
+/* static */
+template<DataOrder order, uint8_t speed>
+SpiTransaction* volatile SpiMaster<order, speed>::current_;
+
+/* static */
+template<DataOrder order, uint8_t speed>
+uint8_t SpiMaster<order, speed>::position_;
+
 }  // namespace hardware_hal
 
-#endif HARDWARE_HAL_SPI_H_
+#endif  // HARDWARE_HAL_SPI_H_
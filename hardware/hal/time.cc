@@ -34,7 +34,11 @@ const uint32_t fractional_increment = (
 
 const uint32_t fractional_max = 1000 >> 3;
 
+// Timer 0 counts at F_CPU / 64.
+const uint8_t microseconds_per_timer0_tick = 64 / (F_CPU / 1000000L);
+
 volatile uint32_t timer0_milliseconds = 0;
+volatile uint32_t timer0_overflows = 0;
 static uint8_t timer0_fractional = 0;
 
 TIMER_0_TICK {
@@ -50,22 +54,74 @@ TIMER_0_TICK {
 
   timer0_fractional = f;
   timer0_milliseconds = m;
+  ++timer0_overflows;
 }
 
-uint32_t Delay(uint32_t delay) {
+void Delay(uint32_t delay) {
   uint32_t t = milliseconds() + delay;
-  while (milliseconds() < t);
+  while (milliseconds() < t) { BusyWait(); }
 }
 
 uint32_t milliseconds() {
   uint32_t m;
-  uint8_t oldSREG = SREG;
-  cli();
-  m = timer0_milliseconds;
-  SREG = oldSREG;
+  do {
+    m = timer0_milliseconds;
+  } while (m != timer0_milliseconds);
+  return m;
+}
+
+uint16_t fast_milliseconds() {
+  uint16_t m;
+  do {
+    m = timer0_milliseconds;
+  } while (m != static_cast<uint16_t>(timer0_milliseconds));
   return m;
 }
 
+// If the interrupts are disabled (for example when called from an interrupt
+// handler), an overflow might be pending - in which case the counter is behind
+// by one overflow. Returns 1 in this case. The flag is read after the timer: if
+// it is set, the timer has wrapped around before the flag was read, and is read
+// again to be consistent with the pending overflow. The callers read the
+// counter before and after, in case the overflow handler runs in between.
+static inline uint8_t ReadTimer0(uint8_t* ticks) {
+  *ticks = MutableTimer0::value();
+  if (TIFR0 & _BV(TOV0)) {
+    *ticks = MutableTimer0::value();
+    return 1;
+  }
+  return 0;
+}
+
+uint32_t microseconds() {
+  uint32_t overflows;
+  uint8_t ticks;
+  uint8_t pending;
+  do {
+    overflows = timer0_overflows;
+    pending = ReadTimer0(&ticks);
+  } while (overflows != timer0_overflows);
+  overflows += pending;
+  return ((overflows << 8) + ticks) * microseconds_per_timer0_tick;
+}
+
+uint16_t fast_microseconds() {
+  // Only the 8 lowest bits of the overflow counter are needed, and they can be
+  // read atomically.
+  const volatile uint8_t* overflows_lsb = reinterpret_cast<
+      const volatile uint8_t*>(&timer0_overflows);
+  uint8_t overflows;
+  uint8_t ticks;
+  uint8_t pending;
+  do {
+    overflows = *overflows_lsb;
+    pending = ReadTimer0(&ticks);
+  } while (overflows != *overflows_lsb);
+  overflows += pending;
+  return ((static_cast<uint16_t>(overflows) << 8) + ticks) *
+      microseconds_per_timer0_tick;
+}
+
 void InitClock() {
   MutableTimer0::set_prescaler(3);
   MutableTimer0::set_mode(TIMER_FAST_PWM);
@@ -24,9 +24,20 @@
 
 namespace hardware_hal {
 
+// None of these functions disable the interrupts: the counters updated by the
+// timer 0 overflow interrupt are read until two consecutive reads agree.
 uint32_t milliseconds();
 
-uint32_t Delay(uint32_t delay);
+// Free-running timer 0 counter, combined with the number of overflows. The
+// resolution is that of the timer: 4us at 16 MHz. Wraps every 71 minutes.
+uint32_t microseconds();
+
+// Cheaper variants, which can only measure intervals shorter than 65.5ms
+// (respectively 65.5s).
+uint16_t fast_microseconds();
+uint16_t fast_milliseconds();
+
+void Delay(uint32_t delay);
 
 void InitClock();
 
@@ -129,7 +129,9 @@ uint8_t MidiStreamParser<Device>::PushByte(uint8_t byte) {
           }
           break;
       }
-      if (running_status_ == 0xf0) {
+      // A status byte terminates the SysEx message in progress. 0xf7 is not
+      // handled here, since MessageReceived() takes care of it.
+      if (running_status_ == 0xf0 && byte != 0xf7) {
         Device::SysExEnd();
       }
       running_status_ = byte;
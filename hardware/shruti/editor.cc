@@ -25,6 +25,7 @@
 #include "hardware/shruti/patch_metadata.h"
 #include "hardware/shruti/synthesis_engine.h"
 #include "hardware/utils/string.h"
+#include "hardware/hal/serial.h"
 #include "hardware/hal/watchdog_timer.h"
 
 using namespace hardware_hal;
@@ -127,6 +128,7 @@ uint8_t Editor::subpage_;
 uint8_t Editor::action_;
 uint8_t Editor::current_patch_number_ = 0;
 uint8_t Editor::previous_patch_number_ = 0;
+uint8_t Editor::saved_patch_number_[2] __attribute__((section(".noinit")));
 uint8_t Editor::test_note_playing_ = 0;
 uint8_t Editor::assign_in_progress_ = 0;
 ParameterAssignment Editor::assigned_parameters_[kNumEditingPots] = {
@@ -173,6 +175,20 @@ void Editor::DoShiftFunction(ParameterGroup group, uint8_t hold_time) {
       break;
       
     case GROUP_MOD:
+#ifdef HAS_PATCH_MORPHING
+      if (hold_time <= 8 && current_page_ == PAGE_LOAD_SAVE) {
+        // Morphs between the patch loaded before entering the load/save page
+        // and the patch currently selected, with the third CV input.
+        if (engine.morphing()) {
+          engine.StopMorph();
+          display.set_status('.');
+        } else if (current_patch_number_ != previous_patch_number_) {
+          engine.StartMorph(previous_patch_number_, current_patch_number_,
+                            MOD_SRC_CV_3);
+          display.set_status('M');
+        }
+      } else
+#endif  // HAS_PATCH_MORPHING
       if (hold_time > 8 /* 1.5 SECONDS */) {
         if (current_page_ == PAGE_LOAD_SAVE) {
           display.set_status('O');
@@ -189,6 +205,12 @@ void Editor::DoShiftFunction(ParameterGroup group, uint8_t hold_time) {
       break;
 
     case GROUP_PLAY:
+#ifdef HAS_MIDI_STATISTICS
+      if (hold_time > 8 /* 2.048 seconds */) {
+        DisplayMidiStatistics();
+        break;
+      }
+#endif  // HAS_MIDI_STATISTICS
       engine.NoteOn(0, 48, test_note_playing_ ? 0 : 100);
       test_note_playing_ ^= 1;
       break;
@@ -232,6 +254,15 @@ void Editor::ToggleGroup(ParameterGroup group) {
   }
 }
 
+#ifdef HAS_VOICE_LFO
+// The voice LFO does not fit in the 4 bits of a saved source: it can only be
+// routed by the rows of the modulation matrix which are not saved.
+static inline uint8_t ClipModulationSource(uint8_t row, uint8_t source) {
+  return row < kSavedModulationMatrixSize && source > MOD_SRC_GATE ?
+      MOD_SRC_GATE : source;
+}
+#endif  // HAS_VOICE_LFO
+
 /* static */
 void Editor::RandomizeParameter(uint8_t subpage, uint8_t parameter_index) {
   const ParameterDefinition& parameter = PatchMetadata::parameter_definition(
@@ -242,6 +273,11 @@ void Editor::RandomizeParameter(uint8_t subpage, uint8_t parameter_index) {
     value -= range;
   }
   value += parameter.min_value;
+#ifdef HAS_VOICE_LFO
+  if (parameter.id == PRM_MOD_SOURCE) {
+    value = ClipModulationSource(subpage, value);
+  }
+#endif  // HAS_VOICE_LFO
   engine.SetParameter(parameter.id + subpage * 3, value);
 }
 
@@ -309,11 +345,14 @@ void Editor::HandleLoadSaveInput(uint8_t knob_index, uint16_t value) {
         const uint8_t num_patches = kEepromSize / kSerializedPatchSize;
         uint8_t new_patch = value * num_patches / 1024;
         if (new_patch != current_patch_number_ && action_ == ACTION_LOAD) {
+#ifdef HAS_PATCH_MORPHING
+          engine.StopMorph();
+#endif  // HAS_PATCH_MORPHING
           engine.mutable_patch()->EepromLoad(new_patch);
           engine.TouchPatch();
         }
         if (action_ != ACTION_EXIT) {
-          current_patch_number_ = new_patch;
+          set_current_patch_number(new_patch);
         }
       }
       break;
@@ -334,7 +373,7 @@ void Editor::HandleLoadSaveInput(uint8_t knob_index, uint16_t value) {
       } else {
         // We are leaving the load mode - restore the previously saved patch.
         if (action_ == ACTION_LOAD) {
-          current_patch_number_ = previous_patch_number_;
+          set_current_patch_number(previous_patch_number_);
           engine.mutable_patch()->Restore();
           engine.TouchPatch();
         }
@@ -582,6 +621,12 @@ void Editor::HandleEditIncrement(int8_t direction) {
     }
   } else {
     value += direction;
+#if defined(HAS_USER_WAVETABLES) && !defined(HAS_UNISON_SAW)
+    // Step over the unison saw, which is not compiled in.
+    if (parameter.id == PRM_OSC_SHAPE_1 && value == WAVEFORM_UNISON_SAW) {
+      value += direction;
+    }
+#endif  // HAS_USER_WAVETABLES && !HAS_UNISON_SAW
     if (value >= parameter.min_value && value <= parameter.max_value) {
       SetParameterValue(parameter.id, value);
     }
@@ -595,6 +640,11 @@ void Editor::SetParameterValue(uint8_t id, uint8_t value) {
     subpage_ = value;
     last_visited_subpage_ = value;
   } else {
+#ifdef HAS_VOICE_LFO
+    if (id == PRM_MOD_SOURCE) {
+      value = ClipModulationSource(subpage_, value);
+    }
+#endif  // HAS_VOICE_LFO
     engine.SetParameter(id + subpage_ * 3, value);
   }
 }
@@ -625,6 +675,55 @@ void Editor::DisplaySplashScreen(ResourceId first_line) {
   }
 }
 
+#ifdef HAS_MIDI_STATISTICS
+/* static */
+void Editor::DisplayMidiStatistics() {
+  // 0123456789abcdef
+  // midi peak     12
+  // midi lost      0
+  typedef Serial<SerialPort0, 31250, BUFFERED, BUFFERED> MidiIO;
+  for (uint8_t i = 0; i < 2; ++i) {
+    ResourcesManager::LoadStringResource(
+        STR_RES_MIDI_PEAK + i,
+        line_buffer_,
+        kLcdWidth);
+    AlignLeft(line_buffer_, kLcdWidth);
+    uint16_t value = i ?
+        MidiIO::num_dropped_input_bytes() : MidiIO::input_high_water_mark();
+    // Shares the conversion code with the parameter values.
+    UnsafeItoa<int16_t>(value > 32767 ? 32767 : value, 5, line_buffer_ + 11);
+    AlignRight(line_buffer_ + 11, 5);
+    display.Print(i, line_buffer_);
+  }
+  // The statistics stay on the screen until the next edit.
+  current_display_type_ = PAGE_TYPE_SUMMARY;
+}
+#endif  // HAS_MIDI_STATISTICS
+
+/* static */
+void Editor::set_current_patch_number(uint8_t patch_number) {
+  current_patch_number_ = patch_number;
+  saved_patch_number_[0] = patch_number;
+  saved_patch_number_[1] = ~patch_number;
+}
+
+/* static */
+void Editor::RestorePatch() {
+  const uint8_t num_patches = kEepromSize / kSerializedPatchSize;
+  uint8_t patch_number = saved_patch_number_[0];
+  if (static_cast<uint8_t>(~saved_patch_number_[1]) != patch_number ||
+      patch_number >= num_patches) {
+    patch_number = 0;
+  }
+  set_current_patch_number(patch_number);
+  engine.mutable_patch()->EepromLoad(patch_number);
+  if (engine.patch().name[0] == '?') {
+    engine.ResetPatch();
+  } else {
+    engine.TouchPatch();
+  }
+}
+
 /* static */
 void Editor::PrettyPrintParameterValue(const ParameterDefinition& parameter,
                                        char* buffer, uint8_t width) {
@@ -680,6 +779,13 @@ void Editor::PrettyPrintParameterValue(const ParameterDefinition& parameter,
       value = value & 0xf;
       break;
     case UNIT_MIDI_CHANNEL:
+#ifdef HAS_DUOPHONIC
+      if (value >= 51) {
+        prefix = 'd';
+        value -= 51;
+      }
+      else
+#endif  // HAS_DUOPHONIC
       if (value >= 34) {
         prefix = '>';
         value -= 34;
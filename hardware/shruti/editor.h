@@ -138,6 +138,16 @@ class Editor {
   
   // Displays two lines of text read from a resource.
   static void DisplaySplashScreen(ResourceId first_line);
+
+#ifdef HAS_MIDI_STATISTICS
+  // Displays the peak occupancy of the MIDI input buffer, and the number of
+  // MIDI bytes lost because it was full.
+  static void DisplayMidiStatistics();
+#endif  // HAS_MIDI_STATISTICS
+
+  // Reloads the patch which was used before a watchdog or bootloader reset, or
+  // the first patch after a power cycle.
+  static void RestorePatch();
   
   static inline ParameterPage current_page() { return current_page_; }
   static inline uint8_t cursor() { return cursor_; }
@@ -165,6 +175,7 @@ class Editor {
   static void EnterLoadSaveMode();
   static void HandleLoadSaveIncrement(int8_t direction);
   static void DumpCurrentPatch();
+  static void set_current_patch_number(uint8_t patch_number);
   
   static void DisplayStepSequencerPage();
   static void HandleStepSequencerInput(uint8_t knob_index, uint16_t value);
@@ -195,6 +206,9 @@ class Editor {
   static uint8_t action_;
   static uint8_t current_patch_number_;
   static uint8_t previous_patch_number_;
+  // Copy of current_patch_number_ which is not cleared at startup, and its
+  // complement, to tell it from garbage after a power cycle.
+  static uint8_t saved_patch_number_[2];
 
   static uint8_t assign_in_progress_; 
   static uint8_t test_note_playing_;
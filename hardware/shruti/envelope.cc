@@ -20,48 +20,178 @@
 namespace hardware_shruti {
 
 void Envelope::Init() {
-  stage_target_[ATTACK] = 16383;
-  stage_increment_[SUSTAIN] = 0;
-  stage_target_[RELEASE] = 0;
-  stage_target_[DEAD] = -1;
-  stage_increment_[DEAD] = 0;
+  ResetStageTable();
   Trigger(DEAD);
 }
 
+void Envelope::ResetStageTable() {
+  data_.adsr.target[ATTACK] = 16383;
+  data_.adsr.increment[SUSTAIN] = 0;
+  data_.adsr.target[SUSTAIN] = 0;
+  data_.adsr.target[RELEASE] = 0;
+  data_.adsr.target[DEAD] = -1;
+  data_.adsr.increment[DEAD] = 0;
+}
+
 void Envelope::Trigger(uint8_t stage) {
   if (stage_ == DEAD && stage == RELEASE) {
     return;
   }
   stage_ = stage;
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  if (curve_ == kEnvelopeMultiStage) {
+    if (stage < RELEASE) {
+      stage_ = ATTACK;
+      GoToStep(0);
+    } else if (stage == RELEASE) {
+      target_ = 0;
+      increment_ = -ScaleEnvelopeIncrement(
+          ResourcesManager::Lookup<uint16_t, uint8_t>(
+              lut_res_env_portamento_increments, data_.ms.release),
+          value_ >> 7);
+    } else {
+      target_ = -1;
+      increment_ = 0;
+    }
+    return;
+  }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
   // The note might be released at any moment, so we need to figure out
   // the right slope to make it reach 0 within the release time.
-  if (stage == RELEASE) {
-    increment_ = -ScaleEnvelopeIncrement(release_, value_ >> 7);
-    if (increment_ == 0) {
-      increment_ = -1;
-    }
+  if (stage == RELEASE && curve_ == ENVELOPE_CURVE_LINEAR) {
+    increment_ = -ScaleEnvelopeIncrement(
+        data_.adsr.increment[RELEASE],
+        value_ >> 7);
   } else {
-    increment_ = stage_increment_[stage];
+    increment_ = data_.adsr.increment[stage];
   }
-  target_ = stage_target_[stage];
+  target_ = data_.adsr.target[stage];
+#ifdef HAS_ENVELOPE_CURVES
+  start_ = value_;
+  phase_ = 0;
+#endif  // HAS_ENVELOPE_CURVES
+}
+
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+void Envelope::GoToStep(uint8_t step) {
+  data_.ms.step = step;
+  target_ = static_cast<int16_t>(data_.ms.level[step]) << 7;
+  // As for the release stage, the slope is scaled by the distance to the
+  // target, so that the duration of a step only depends on its time.
+  int16_t delta = target_ - value_;
+  uint16_t increment = ScaleEnvelopeIncrement(
+      ResourcesManager::Lookup<uint16_t, uint8_t>(
+          lut_res_env_portamento_increments, data_.ms.time[step]),
+      abs(delta) >> 7);
+  increment_ = delta < 0 ? -increment : increment;
 }
 
+void Envelope::NextStep() {
+  if (stage_ != ATTACK) {
+    ++stage_;
+    Trigger(stage_);
+    return;
+  }
+  uint8_t step = data_.ms.step;
+  uint8_t loop_start = data_.ms.loop & 0x0f;
+  if (step == ShiftRight4(data_.ms.loop) && loop_start < step) {
+    step = loop_start;
+  } else {
+    ++step;
+  }
+  if (step == kNumMultiStageSteps) {
+    // Hold the last level until the note is released.
+    increment_ = 0;
+  } else {
+    GoToStep(step);
+  }
+}
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+
+#ifdef HAS_ENVELOPE_CURVES
+void Envelope::RenderCurve() {
+  phase_ += increment_;
+  if (phase_ >= 16384) {
+    value_ = target_;
+    ++stage_;
+    Trigger(stage_);
+    return;
+  }
+  const prog_uint8_t* curve = shp_res_env_curves +
+      (curve_ - ENVELOPE_CURVE_EXPONENTIAL) * (kEnvelopeCurveSize + 1);
+  uint8_t index = phase_ >> 8;
+  uint8_t shape = Mix(
+      ResourcesManager::Lookup<uint8_t, uint8_t>(curve, index),
+      ResourcesManager::Lookup<uint8_t, uint8_t>(curve, index + 1),
+      phase_ & 0xff);
+  value_ = start_ + ((static_cast<int32_t>(target_ - start_) * shape) >> 8);
+}
+#endif  // HAS_ENVELOPE_CURVES
+
 void Envelope::Update(
-  uint8_t attack, uint8_t decay, uint8_t sustain, uint8_t release) {
+  uint8_t attack, uint8_t decay, uint8_t sustain, uint8_t release,
+  uint8_t curve) {
+  uint16_t attack_increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+      lut_res_env_portamento_increments, attack);
+  uint16_t decay_increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+      lut_res_env_portamento_increments, decay);
+  uint16_t release_increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+      lut_res_env_portamento_increments, release);
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  if (curve_ == kEnvelopeMultiStage) {
+    ResetStageTable();
+  }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+#ifdef HAS_ENVELOPE_CURVES
+  // The curve can be received by NRPN, without any range check.
+  if (curve > ENVELOPE_CURVE_S) {
+    curve = ENVELOPE_CURVE_S;
+  }
+#else
+  curve = ENVELOPE_CURVE_LINEAR;
+#endif  // HAS_ENVELOPE_CURVES
   // Update the envelope increments and targets.
-  stage_increment_[ATTACK] = ScaleEnvelopeIncrement(
-      attack, 127);
-  stage_increment_[DECAY] = -ScaleEnvelopeIncrement(
-      decay,
-      127 - sustain);
-  stage_target_[DECAY] = static_cast<int16_t>(sustain) << 7;
-  release_ = release;
+  data_.adsr.target[DECAY] = static_cast<int16_t>(sustain) << 7;
+  data_.adsr.increment[ATTACK] = ScaleEnvelopeIncrement(attack_increment, 127);
+  if (curve == ENVELOPE_CURVE_LINEAR) {
+    data_.adsr.increment[DECAY] = -ScaleEnvelopeIncrement(
+        decay_increment,
+        127 - sustain);
+    data_.adsr.increment[RELEASE] = release_increment;
+  } else {
+    // The phase always goes from 0 to 16384, whatever the distance between the
+    // start value and the target.
+    data_.adsr.increment[DECAY] = ScaleEnvelopeIncrement(decay_increment, 127);
+    data_.adsr.increment[RELEASE] = ScaleEnvelopeIncrement(
+        release_increment,
+        127);
+  }
+  if (curve != curve_) {
+    // Restart the current stage from the current value, with the new curve.
+    curve_ = curve;
+    Trigger(stage_);
+  }
+}
+
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+void Envelope::UpdateMultiStage(
+    const uint8_t* level, const uint8_t* time,
+    uint8_t loop_start, uint8_t loop_end, uint8_t release) {
+  for (uint8_t i = 0; i < kNumMultiStageSteps; ++i) {
+    data_.ms.level[i] = level[i];
+    data_.ms.time[i] = time[i];
+  }
+  data_.ms.loop = loop_start | ShiftLeft4(loop_end);
+  data_.ms.release = release;
+  if (curve_ != kEnvelopeMultiStage) {
+    curve_ = kEnvelopeMultiStage;
+    Trigger(stage_);
+  }
 }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
 
 /* static */
-uint16_t Envelope::ScaleEnvelopeIncrement(uint8_t time, uint8_t scale) {
-  uint16_t increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
-      lut_res_env_portamento_increments, time);
+uint16_t Envelope::ScaleEnvelopeIncrement(uint16_t increment, uint8_t scale) {
   increment = (uint32_t(increment) * scale) >> 8;
   if (increment == 0) {
     increment = 1;
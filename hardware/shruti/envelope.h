@@ -36,10 +36,42 @@ enum EnvelopeStage {
   SUSTAIN = 2,
   RELEASE = 3,
   DEAD = 4,
-  // Padding added so that the size of an envelope object is exactly 32 bytes.
-  UNKNOWN = 5,
 };
 
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+// Used internally instead of a curve, when the envelope runs through the stage
+// table of the multi-stage envelope.
+static const uint8_t kEnvelopeMultiStage = ENVELOPE_CURVE_S + 1;
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+
+// Number of segments in each of the curves of the env_curves resource.
+static const uint8_t kEnvelopeCurveSize = 64;
+
+// Increment and target for each stage of the ADSR envelope. With the linear
+// curve, the increment stored for the release stage is not scaled, since the
+// note might be released at any level.
+struct AdsrEnvelopeData {
+  int16_t increment[DEAD + 1];
+  int16_t target[DEAD + 1];
+};
+
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+// Copy of the stage table of the multi-stage envelope.
+struct MultiStageEnvelopeData {
+  uint8_t level[kNumMultiStageSteps];
+  uint8_t time[kNumMultiStageSteps];
+  uint8_t loop;  // loop start in the 4 lower bits, end in the 4 upper bits.
+  uint8_t step;  // current step.
+  uint8_t release;  // release time.
+};
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+
+union EnvelopeData {
+  AdsrEnvelopeData adsr;
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  MultiStageEnvelopeData ms;
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+};
 
 class Envelope {
  public:
@@ -53,9 +85,34 @@ class Envelope {
 
   void Trigger(uint8_t stage);
 
-  void Update(uint8_t attack, uint8_t decay, uint8_t sustain, uint8_t release);
+  // Without HAS_ENVELOPE_CURVES, the curve is ignored and the segments are
+  // linear.
+  void Update(uint8_t attack, uint8_t decay, uint8_t sustain, uint8_t release,
+              uint8_t curve);
+
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  // Switches to the multi-stage mode. As long as the note is held, the
+  // envelope goes through the levels of the stage table, then stays at the
+  // last level - or loops between the loop start and end steps, if the loop
+  // start is before the loop end. Then the release stage brings the value
+  // back to 0.
+  void UpdateMultiStage(const uint8_t* level, const uint8_t* time,
+                        uint8_t loop_start, uint8_t loop_end, uint8_t release);
+#endif  // HAS_MULTI_STAGE_ENVELOPES
 
   void Render() {
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+    if (curve_ == kEnvelopeMultiStage) {
+      RenderMultiStage();
+      return;
+    }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+#ifdef HAS_ENVELOPE_CURVES
+    if (curve_ != ENVELOPE_CURVE_LINEAR) {
+      RenderCurve();
+      return;
+    }
+#endif  // HAS_ENVELOPE_CURVES
     value_ += increment_;
     // This code makes the assumption that only the ATTACK stage has a positive
     // slope. This is true for the classical ADSR envelope. To support more
@@ -64,8 +121,6 @@ class Envelope {
     // if ((increment_ > 0) ^ (value_ < target_)) {
     //
     // but the first test is more expensive on AVR...
-    // TODO(pichenettes): to get a more exponential feel, divide the increment
-    // by 2 mid-stage.
     if ((stage_ == ATTACK) ^ (value_ < target_)) {
       value_ = target_;
       ++stage_;
@@ -74,16 +129,39 @@ class Envelope {
   }
 
  private:
-  uint8_t release_;  // release time.
+#ifdef HAS_ENVELOPE_CURVES
+  // With a curve, the stage is driven by a linear ramp from 0 to 16384
+  // (phase_), which indexes the curve table. The envelope value is then
+  // interpolated between the value at the beginning of the stage and the
+  // target.
+  void RenderCurve();
+#endif  // HAS_ENVELOPE_CURVES
+
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  // Same as the linear envelope, but segments can go up or down.
+  void RenderMultiStage() {
+    value_ += increment_;
+    if ((increment_ > 0) ^ (value_ < target_)) {
+      value_ = target_;
+      NextStep();
+    }
+  }
+  void NextStep();
+  void GoToStep(uint8_t step);
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+  void ResetStageTable();
+
   uint8_t stage_;  // current envelope stage.
-  int16_t increment_;  // envelope value increment.
+  uint8_t curve_;  // shape of the segments, or multi-stage mode.
+  int16_t increment_;  // envelope value (or phase) increment.
   int16_t target_;  // target value (moves to next stage once reached).
   int16_t value_;  // envelope value, 0-16384.
-  // Increment and target for each stage of the envelope.
-  int16_t stage_increment_[UNKNOWN + 1];
-  int16_t stage_target_[UNKNOWN + 1];
+  int16_t start_;  // envelope value at the beginning of the stage.
+  uint16_t phase_;  // progress through the stage, 0-16384.
+  // Stage tables. The size of an envelope object is exactly 32 bytes.
+  EnvelopeData data_;
    
-  static uint16_t ScaleEnvelopeIncrement(uint8_t time, uint8_t scale);
+  static uint16_t ScaleEnvelopeIncrement(uint16_t increment, uint8_t scale);
   
   DISALLOW_COPY_AND_ASSIGN(Envelope);
 };
@@ -0,0 +1,218 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Model of the cost, in ATmega328p cycles, of rendering a voice.
+
+#include "hardware/shruti/host/cycle_model.h"
+
+namespace hardware_shruti {
+
+// Cost of the basic operations, in cycles.
+// lds + lds + add + adc + sts + sts, for both the phase and the increment.
+static const uint8_t kPhaseIncrementCycles = 14;
+// InterpolateSample: 2 lpm (3 cycles each), 2 mul (2 cycles each), and 9
+// single cycle instructions.
+static const uint8_t kInterpolatedFlashReadCycles = 21;
+// InterpolateSampleRam: same as above, with ld instead of lpm.
+static const uint8_t kInterpolatedRamReadCycles = 19;
+// ResourcesManager::Lookup: address computation and lpm.
+static const uint8_t kFlashReadCycles = 6;
+// Mix: 2 mul, 6 single cycle instructions.
+static const uint8_t kMixCycles = 10;
+// MulScale8 and its signed variants.
+static const uint8_t kMulCycles = 4;
+// Call through the fn_ pointer of the oscillator: 2 lds, icall, ret, and the
+// save of the registers used by the callee.
+static const uint8_t kIndirectCallCycles = 14;
+// HALF_SAMPLE_RATE or FOURTH_SAMPLE_RATE: lds, test, and branch.
+static const uint8_t kDecimationCheckCycles = 4;
+// Folding of the phase, and negation of the sample, by
+// InterpolateTwoSymmetricTables.
+static const uint8_t kSymmetryCycles = 10;
+// Voice::Audio, besides the oscillators and the mix: call, and store of the
+// signal.
+static const uint8_t kVoiceAudioCycles = 8;
+
+// Cost of the control-rate code, for one block: 2 envelopes, 2 LFOs, the
+// portamento, the scaling of the modulation sources and destinations, the
+// pitch computations and the updates of the 3 oscillators, the refill of the
+// noise buffer, and the voice controller.
+static const uint16_t kControlCycles = 1300;
+// Cost of one row of the modulation matrix with a non-zero amount: 3 lds,
+// SignedUnsignedMul, the relative modulation test, and the clipping.
+static const uint8_t kModulationRowCycles = 45;
+// 32-bit multiplication, called by the update of the FM, quad saw and unison
+// saw algorithms.
+static const uint8_t kLongMulCycles = 60;
+
+/* static */
+uint16_t CycleModel::OscillatorCycles(uint8_t shape, uint8_t parameter) {
+  // The analog wavetable sweeps through the 4 first algorithms.
+  if (shape == WAVEFORM_ANALOG_WAVETABLE) {
+    shape = (parameter >> 5) + 1;
+    parameter = (parameter & 0x1f) << 2;
+  }
+  // A square with a null pulse width is read from a simple wavetable.
+  if (shape == WAVEFORM_SQUARE && parameter == 0) {
+    shape = WAVEFORM_TRIANGLE;
+  }
+  uint16_t cycles = 0;
+  switch (shape) {
+    case WAVEFORM_IMPULSE_TRAIN:
+    case WAVEFORM_SQUARE:
+      // RenderPulseSquare, at half the sample rate.
+      cycles += kDecimationCheckCycles + (kPhaseIncrementCycles +
+          3 * kInterpolatedFlashReadCycles + kMixCycles + 2 * kMulCycles +
+          8) / 2;
+      break;
+
+    case WAVEFORM_SAW:
+    case WAVEFORM_TRIANGLE:
+      // RenderSimpleWavetable.
+      cycles += kPhaseIncrementCycles + kSymmetryCycles +
+          2 * kInterpolatedFlashReadCycles + kMixCycles + 4;
+      break;
+
+    case WAVEFORM_CZ_RESO:
+    case WAVEFORM_CZ_SYNC:
+      cycles += 2 * kPhaseIncrementCycles + kInterpolatedFlashReadCycles +
+          kMulCycles + 4;
+      break;
+
+    case WAVEFORM_FM:
+      cycles += 2 * kPhaseIncrementCycles + kFlashReadCycles + kMulCycles +
+          kInterpolatedFlashReadCycles + 2;
+      break;
+
+    case WAVEFORM_8BITLAND:
+      cycles += kPhaseIncrementCycles + 6;
+      break;
+
+    case WAVEFORM_DIRTY_PWM:
+      cycles += kPhaseIncrementCycles + 4;
+      break;
+
+    case WAVEFORM_FILTERED_NOISE:
+      cycles += kMixCycles + 8;
+      break;
+
+    case WAVEFORM_VOWEL:
+      // 3 formants, at half the sample rate.
+      cycles += kDecimationCheckCycles + (3 * (kPhaseIncrementCycles +
+          kFlashReadCycles + 2) + kPhaseIncrementCycles + 2 * kMulCycles +
+          12) / 2;
+      break;
+
+    case WAVEFORM_WAVETABLE:
+    case WAVEFORM_USER_WAVETABLE:
+      // RenderWavetable128.
+      cycles += kPhaseIncrementCycles + 2 * kInterpolatedRamReadCycles +
+          kMixCycles + 2;
+      break;
+
+    case WAVEFORM_QUAD_SAW_PAD:
+      cycles += 4 * kPhaseIncrementCycles + 4 * 3 + 3;
+      break;
+
+    case WAVEFORM_UNISON_SAW:
+      cycles += 4 * kPhaseIncrementCycles + 4 * kInterpolatedFlashReadCycles +
+          3 * 2 + 4;
+      break;
+
+    default:
+      // RenderSilence.
+      cycles += 2;
+      break;
+  }
+  return cycles;
+}
+
+/* static */
+uint16_t CycleModel::LowComplexityOscillatorCycles(
+    uint8_t shape,
+    uint8_t parameter) {
+  // The shapes above the triangle are not supported (the oscillator keeps its
+  // previous algorithm), and the silent shape is rendered as a triangle.
+  if (shape > WAVEFORM_TRIANGLE || shape == WAVEFORM_NONE) {
+    shape = WAVEFORM_TRIANGLE;
+  }
+  return OscillatorCycles(shape, parameter);
+}
+
+/* static */
+uint16_t CycleModel::AudioCycles(
+    const Patch& patch,
+    uint8_t parameter_1,
+    uint8_t parameter_2) {
+  uint16_t cycles = kVoiceAudioCycles;
+  cycles += kIndirectCallCycles + OscillatorCycles(
+      patch.osc_shape[0],
+      parameter_1);
+  // No call through a pointer for osc 2, but a test of the shape instead.
+  cycles += 4 + LowComplexityOscillatorCycles(
+      patch.osc_shape[1],
+      parameter_2);
+  switch (patch.osc_option[0]) {
+    case SYNC:
+      cycles += kMixCycles + 8;
+      break;
+    case SUM:
+      cycles += kMixCycles + 2;
+      break;
+    case RING_MOD:
+      cycles += kMulCycles + 4;
+      break;
+    case XOR:
+      cycles += 4;
+      break;
+  }
+  if (patch.osc_shape[0] != WAVEFORM_VOWEL) {
+    // Sub oscillator, at a fourth of the sample rate, and its mix.
+    cycles += kDecimationCheckCycles + (kPhaseIncrementCycles +
+        kSymmetryCycles + 2 * kInterpolatedFlashReadCycles + kMixCycles) / 4;
+    cycles += kMixCycles + 2;
+    // Noise, and its mix.
+    cycles += kMixCycles + 2;
+  }
+  return cycles;
+}
+
+/* static */
+uint16_t CycleModel::ControlCycles(const Patch& patch) {
+  uint16_t cycles = kControlCycles;
+  for (uint8_t i = 0; i < kModulationMatrixSize; ++i) {
+    if (patch.modulation_matrix.modulation[i].amount) {
+      cycles += kModulationRowCycles;
+    }
+  }
+  switch (patch.osc_shape[0]) {
+    case WAVEFORM_FM:
+      cycles += kLongMulCycles + kFlashReadCycles;
+      break;
+    case WAVEFORM_QUAD_SAW_PAD:
+    case WAVEFORM_UNISON_SAW:
+      cycles += kLongMulCycles;
+      break;
+    case WAVEFORM_VOWEL:
+      // 10 reads and 5 mixes, every kVowelControlRateDecimation blocks.
+      cycles += (10 * kFlashReadCycles + 5 * kMixCycles) / 4;
+      break;
+  }
+  return cycles;
+}
+
+}  // namespace hardware_shruti
@@ -0,0 +1,71 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Model of the cost, in ATmega328p cycles, of rendering a voice, for the
+// desktop tools which have to rank patches or share a CPU budget. The time
+// spent by the host CPU says little about the chip (no hardware multiplier
+// on 16 bits, 3 cycles for a read from the flash...) and varies from one run
+// to the other ; the model is deterministic.
+//
+// The cost of each oscillator algorithm is built from the cost of the
+// operations it performs for each sample: phase increments, reads from the
+// flash or the SRAM, multiplications. These are counted from the assembly
+// versions of op.h and oscillator.h. The algorithms which skip samples
+// (HALF_SAMPLE_RATE, FOURTH_SAMPLE_RATE) are charged their average cost.
+// The control-rate code (envelopes, LFOs, modulation matrix) is estimated
+// once per block.
+
+#ifndef HARDWARE_SHRUTI_HOST_CYCLE_MODEL_H_
+#define HARDWARE_SHRUTI_HOST_CYCLE_MODEL_H_
+
+#include "hardware/shruti/shruti.h"
+
+#include "hardware/shruti/patch.h"
+
+namespace hardware_shruti {
+
+// Number of cycles in a block: this is the budget for rendering all the
+// voices, and for everything else the firmware does.
+static const uint32_t kBlockCycles = kAudioBlockSize * (F_CPU / kSampleRate);
+
+class CycleModel {
+ public:
+  // Cycles spent rendering one sample of a voice playing patch (Voice::Audio):
+  // the two oscillators, the mixing operator, the sub oscillator and the
+  // noise. parameter_1 and parameter_2 are the modulated parameters of the
+  // oscillators, which select the algorithm used by some of the shapes.
+  static uint16_t AudioCycles(
+      const Patch& patch,
+      uint8_t parameter_1,
+      uint8_t parameter_2);
+
+  // Cycles spent updating a voice playing patch, once per block
+  // (SynthesisEngine::Control and Voice::Control).
+  static uint16_t ControlCycles(const Patch& patch);
+
+ private:
+  static uint16_t OscillatorCycles(uint8_t shape, uint8_t parameter);
+  static uint16_t LowComplexityOscillatorCycles(
+      uint8_t shape,
+      uint8_t parameter);
+
+  DISALLOW_COPY_AND_ASSIGN(CycleModel);
+};
+
+}  // namespace hardware_shruti
+
+#endif  // HARDWARE_SHRUTI_HOST_CYCLE_MODEL_H_
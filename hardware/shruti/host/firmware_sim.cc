@@ -0,0 +1,290 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Simulation of the whole firmware on a desktop computer. The tasks and
+// interrupt handlers of shruti.cc run unmodified, against the simulated
+// peripherals of hardware/hal/host, and a virtual clock which advances, after
+// each task, by an estimate of its cost on the chip. The simulation is thus
+// deterministic, and runs many times faster than real time.
+//
+// The front panel and MIDI input are driven by a script, with one event per
+// line:
+//
+// <time in ms> pot <0-3> <0-1023>    Moves an editing pot.
+// <time in ms> switch <0-6> <0|1>    Presses (1) or releases (0) a switch.
+//                                    5 and 6 are the -/+ switches.
+// <time in ms> cv <0-2> <0-1023>     Sets a CV input.
+// <time in ms> midi <hex bytes...>   Sends bytes to the MIDI input.
+// <time in ms> dump                  Prints the LCD, LEDs and PWM outputs.
+//
+// Lines starting with # are comments. The events must be sorted by time.
+//
+// Usage: firmware_sim [-s script.txt] [-t duration_ms] [-e eeprom.bin]
+//                     [-x external_eeprom.bin] [-o output.wav]
+//                     [-a audio_load_percent] [-v]
+//
+// The audio output (PWM duty cycle on the VCO output pin, or 8 most significant
+// bits of the DAC with HAS_DAC_AUDIO_OUTPUT) is written, at the main timer
+// rate, to a 8-bit .wav file. The bytes sent to the LCD and to the
+// MIDI output are logged with -v. The EEPROM contents are loaded from, and
+// saved to, the file given with -e ; and those of the external EEPROM storing
+// the user wavetables, from and to the file given with -x.
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hardware/hal/serial.h"
+#include "hardware/shruti/host/simulated_shruti.h"
+
+using namespace hardware_hal;
+using namespace hardware_shruti;
+
+typedef SerialInput<SerialPort0> MidiInput;
+
+static const uint8_t kMaxScriptLineSize = 255;
+
+static uint8_t verbose = 0;
+
+static FILE* wav_file = NULL;
+static uint32_t num_samples = 0;
+
+static void OnLcdByte(uint8_t value) {
+  if (verbose) {
+    printf("%8.3f\tlcd\t%02x\n",
+           static_cast<double>(VirtualClock::cycles()) / kCyclesPerMillisecond,
+           value);
+  }
+}
+
+static void OnMidiOutByte(uint8_t value) {
+  if (verbose) {
+    printf("%8.3f\tmidi_out\t%02x\n",
+           static_cast<double>(VirtualClock::cycles()) / kCyclesPerMillisecond,
+           value);
+  }
+}
+
+static void OnTick() {
+  if (wav_file) {
+#ifdef HAS_DAC_AUDIO_OUTPUT
+    fputc(SimulatedSpiDac::value() >> 4, wav_file);
+#else
+    fputc(OCR2B, wav_file);
+#endif  // HAS_DAC_AUDIO_OUTPUT
+    ++num_samples;
+  }
+}
+
+static void WriteUint32(FILE* fp, uint32_t value) {
+  for (uint8_t i = 0; i < 4; ++i) {
+    fputc((value >> (i * 8)) & 0xff, fp);
+  }
+}
+
+static void WriteUint16(FILE* fp, uint16_t value) {
+  fputc(value & 0xff, fp);
+  fputc(value >> 8, fp);
+}
+
+static void WriteWavHeader(FILE* fp, uint32_t num_samples) {
+  fwrite("RIFF", 1, 4, fp);
+  WriteUint32(fp, 36 + num_samples);
+  fwrite("WAVEfmt ", 1, 8, fp);
+  WriteUint32(fp, 16);
+  WriteUint16(fp, 1);  // PCM.
+  WriteUint16(fp, 1);  // Mono.
+  WriteUint32(fp, kSampleRate);
+  WriteUint32(fp, kSampleRate);
+  WriteUint16(fp, 1);
+  WriteUint16(fp, 8);
+  fwrite("data", 1, 4, fp);
+  WriteUint32(fp, num_samples);
+}
+
+// Executes the next event of the script, if it is due. Returns 0 when there
+// are no more events.
+static uint8_t RunScript(FILE* script, uint8_t* line_pending, char* line,
+                         uint32_t* event_time) {
+  while (1) {
+    if (!*line_pending) {
+      if (!fgets(line, kMaxScriptLineSize, script)) {
+        return 0;
+      }
+      if (line[0] == '#' || line[0] == '\n') {
+        continue;
+      }
+      *event_time = atoi(line);
+      *line_pending = 1;
+    }
+    if (*event_time > VirtualClock::milliseconds()) {
+      return 1;
+    }
+    *line_pending = 0;
+    char command[16];
+    int offset;
+    if (sscanf(line, "%*d %15s %n", command, &offset) < 1) {
+      continue;
+    }
+    const char* arguments = line + offset;
+    int index = 0;
+    int value = 0;
+    if (!strcmp(command, "pot") &&
+        sscanf(arguments, "%d %d", &index, &value) == 2 &&
+        index < kNumEditingPots) {
+      SimulatedShruti::set_pot(index, value);
+    } else if (!strcmp(command, "switch") &&
+        sscanf(arguments, "%d %d", &index, &value) == 2 &&
+        index < kNumSwitches) {
+      SimulatedShruti::set_switch(index, value);
+    } else if (!strcmp(command, "cv") &&
+        sscanf(arguments, "%d %d", &index, &value) == 2 &&
+        index < kNumCvInputs) {
+      SimulatedAdc::set_value(kPinCvInput + index, value);
+    } else if (!strcmp(command, "midi")) {
+      int n;
+      while (sscanf(arguments, "%x %n", &value, &n) == 1) {
+        SimulatedUart::Receive(value);
+        arguments += n;
+      }
+    } else if (!strcmp(command, "dump")) {
+      SimulatedShruti::Dump();
+    } else {
+      fprintf(stderr, "Invalid script line: %s", line);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* script_file_name = NULL;
+  const char* eeprom_file_name = NULL;
+  const char* external_eeprom_file_name = NULL;
+  const char* output_file_name = NULL;
+  uint32_t duration = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "s:t:e:x:o:a:v")) != -1) {
+    switch (option) {
+      case 's':
+        script_file_name = optarg;
+        break;
+      case 't':
+        duration = atoi(optarg);
+        break;
+      case 'e':
+        eeprom_file_name = optarg;
+        break;
+      case 'x':
+        external_eeprom_file_name = optarg;
+        break;
+      case 'o':
+        output_file_name = optarg;
+        break;
+      case 'a':
+        SimulatedShruti::set_audio_load(atoi(optarg));
+        break;
+      case 'v':
+        verbose = 1;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-s script.txt] [-t duration_ms] "
+                "[-e eeprom.bin] [-x external_eeprom.bin] [-o output.wav] "
+                "[-a audio_load_percent] [-v]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  FILE* script = NULL;
+  if (script_file_name) {
+    script = fopen(script_file_name, "r");
+    if (!script) {
+      fprintf(stderr, "Could not open %s\n", script_file_name);
+      return 1;
+    }
+  } else if (!duration) {
+    duration = 5000;
+  }
+  if (output_file_name) {
+    wav_file = fopen(output_file_name, "wb");
+    if (!wav_file) {
+      fprintf(stderr, "Could not open %s\n", output_file_name);
+      return 1;
+    }
+    WriteWavHeader(wav_file, 0);
+  }
+
+  SimulatedShruti::Init();
+  SimulatedShruti::set_lcd_callback(&OnLcdByte);
+  SimulatedShruti::set_tick_callback(&OnTick);
+  SimulatedUart::set_transmit_callback(&OnMidiOutByte);
+  if (eeprom_file_name) {
+    SimulatedEeprom::Load(eeprom_file_name);
+  }
+  if (external_eeprom_file_name) {
+    SimulatedI2cEeprom::Load(external_eeprom_file_name);
+  }
+
+  clock_t start = clock();
+  SimulatedShruti::Boot();
+
+  char line[kMaxScriptLineSize];
+  uint8_t line_pending = 0;
+  uint32_t event_time = 0;
+  uint8_t script_running = script != NULL;
+  uint32_t end_time = duration;
+  while (1) {
+    if (script_running) {
+      script_running = RunScript(script, &line_pending, line, &event_time);
+      if (!script_running && !duration) {
+        end_time = VirtualClock::milliseconds() + 1000;
+      }
+    }
+    if (!script_running && VirtualClock::milliseconds() >= end_time) {
+      break;
+    }
+    SimulatedShruti::Step();
+  }
+
+  double elapsed = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  if (script) {
+    fclose(script);
+  }
+  if (wav_file) {
+    fseek(wav_file, 0, SEEK_SET);
+    WriteWavHeader(wav_file, num_samples);
+    fclose(wav_file);
+  }
+  if (eeprom_file_name && !SimulatedEeprom::Save(eeprom_file_name)) {
+    fprintf(stderr, "Could not save %s\n", eeprom_file_name);
+  }
+  if (external_eeprom_file_name &&
+      !SimulatedI2cEeprom::Save(external_eeprom_file_name)) {
+    fprintf(stderr, "Could not save %s\n", external_eeprom_file_name);
+  }
+  SimulatedShruti::Dump();
+  printf("simulated: %d ms in %.2f s (%.1fx real time)\n",
+         VirtualClock::milliseconds(), elapsed,
+         VirtualClock::milliseconds() / 1000.0 / elapsed);
+  printf("audio glitches: %d\n", Audio::num_glitches());
+  printf("midi overruns: %d\n", SimulatedUart::num_overruns());
+  printf("midi input buffer peak: %d\n", MidiInput::high_water_mark());
+  printf("midi dropped bytes: %d\n", MidiInput::num_dropped_bytes());
+  printf("lcd characters: %d\n", SimulatedSerialLcd::num_characters());
+  return 0;
+}
@@ -0,0 +1,582 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// Throughput and stress benchmark of the MIDI input path: MidiStreamParser,
+// and the dispatch of the messages to the SynthesisEngine and its
+// VoiceController, as they are used by the MIDI task of shruti.cc.
+//
+// The traffic comes from a synthetic corpus, which covers the dense
+// situations met on stage: note streams with and without running status,
+// clock bytes interleaved within messages, aftertouch and pitch bend floods,
+// NRPN bursts, patch dumps and foreign SysEx, messages for other channels,
+// and malformed data (bytes without status, truncated messages, undefined
+// status bytes, stray end of exclusive). Each stream is as long as one second
+// of traffic at 31250 bps. It can also be written to disk, to be replayed by
+// the benchmark (or sent to the synth).
+//
+// A call to PushByte takes a few nanoseconds, less than reading the clock, so
+// the bytes are timed in batches. Each stream is parsed several times from a
+// clean state, and the time spent in PushByte for the whole stream is
+// measured; the fastest of the runs is kept, to get rid of the preemptions of
+// the host. For the statistics per type of message, the bytes of each type
+// are extracted from the stream, in order, and timed in the same way. The
+// parser sees the same messages, but the engine may do less work on its own
+// (for example, for a note off without the note on which preceded it).
+//
+// Usage: midi_benchmark [-r num_runs] [-s seed] [-g output_directory]
+//                       [stream.raw...]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "hardware/base/base.h"
+#include "hardware/midi/midi.h"
+#include "hardware/shruti/synthesis_engine.h"
+
+using namespace hardware_midi;
+using namespace hardware_shruti;
+
+static const uint16_t kStreamSize = 3125;  // 1s at 31250 bps.
+static const uint16_t kMaxStreamSize = 32768;
+static const uint8_t kMaxFileNameSize = 255;
+
+enum MessageType {
+  MESSAGE_NOTE_OFF,
+  MESSAGE_NOTE_ON,
+  MESSAGE_POLY_AFTERTOUCH,
+  MESSAGE_CONTROL_CHANGE,
+  MESSAGE_PROGRAM_CHANGE,
+  MESSAGE_CHANNEL_AFTERTOUCH,
+  MESSAGE_PITCH_BEND,
+  MESSAGE_SYSEX,
+  MESSAGE_SYSTEM_COMMON,
+  MESSAGE_REALTIME,
+  MESSAGE_STRAY_DATA,
+  MESSAGE_LAST
+};
+
+static const char* message_names[] = {
+  "note off", "note on", "poly aftertouch", "control change",
+  "program change", "channel aftertouch", "pitch bend", "sysex",
+  "system common", "realtime", "stray data"
+};
+
+struct Stream {
+  const char* name;
+  uint8_t data[kMaxStreamSize];
+  uint16_t size;
+};
+
+struct MessageStatistics {
+  uint32_t num_messages;
+  uint32_t num_bytes;
+  double total_time;
+};
+
+static Stream stream;
+static uint8_t byte_types[kMaxStreamSize];
+static uint8_t batch[kMaxStreamSize];
+static MessageStatistics statistics[MESSAGE_LAST];
+
+// ---- Corpus -----------------------------------------------------------------
+
+static inline uint8_t RandomByte(uint8_t range) {
+  return rand() % range;
+}
+
+static inline void Append(uint8_t value) {
+  if (stream.size < kMaxStreamSize) {
+    stream.data[stream.size++] = value;
+  }
+}
+
+static inline uint8_t Full() {
+  return stream.size >= kStreamSize;
+}
+
+static void GenerateNotes() {
+  while (!Full()) {
+    uint8_t note = 36 + RandomByte(48);
+    Append(0x90);
+    Append(note);
+    Append(1 + RandomByte(127));
+    Append(0x80);
+    Append(note);
+    Append(RandomByte(128));
+  }
+}
+
+// Note offs are sent as note ons with a null velocity.
+static void GenerateRunningStatus() {
+  Append(0x90);
+  while (!Full()) {
+    uint8_t note = 36 + RandomByte(48);
+    Append(note);
+    Append(1 + RandomByte(127));
+    Append(note);
+    Append(0);
+  }
+}
+
+// A clock byte can be inserted anywhere, including between a status byte and
+// its data bytes.
+static void GenerateInterleavedClock() {
+  while (!Full()) {
+    uint8_t note = 36 + RandomByte(48);
+    uint8_t message[] = { 0x90, note, 100, 0x80, note, 0 };
+    for (uint8_t i = 0; i < sizeof(message); ++i) {
+      Append(message[i]);
+      if (RandomByte(3) == 0) {
+        Append(0xf8);
+      }
+    }
+  }
+}
+
+static void GenerateAftertouchFlood() {
+  Append(0x90);
+  Append(60);
+  Append(100);
+  Append(0xd0);
+  while (stream.size < kStreamSize / 2) {
+    Append(RandomByte(128));
+  }
+  Append(0xa0);
+  while (!Full()) {
+    Append(60);
+    Append(RandomByte(128));
+  }
+}
+
+static void GeneratePitchBendFlood() {
+  Append(0xe0);
+  while (!Full()) {
+    Append(RandomByte(128));
+    Append(RandomByte(128));
+  }
+}
+
+// NRPN bursts on the patch parameters, the MIDI channel excepted.
+static void GenerateNrpnBursts() {
+  while (!Full()) {
+    uint8_t parameter = RandomByte(PRM_KBD_MIDI_CHANNEL);
+    Append(0xb0);
+    Append(kNrpnMsb);
+    Append(0);
+    Append(kNrpnLsb);
+    Append(parameter);
+    Append(kDataEntryMsb);
+    Append(0);
+    Append(kDataEntryLsb);
+    Append(RandomByte(128));
+  }
+}
+
+// Mapped controllers (16-31 and 102-116), modulation wheel and brightness,
+// with running status.
+static void GenerateControllerFlood() {
+  static const uint8_t controllers[] = {
+    16, 17, 20, 24, 31, 102, 110, 116, kModulationWheelMsb, kBrightness
+  };
+  Append(0xb0);
+  while (!Full()) {
+    Append(controllers[RandomByte(sizeof(controllers))]);
+    Append(RandomByte(128));
+  }
+}
+
+// Patch dumps, one out of four with a bad checksum.
+static void GeneratePatchDumps() {
+  uint8_t dump[kSysExPatchDumpSize];
+  uint8_t count = 0;
+  while (!Full()) {
+    engine.mutable_patch()->filter_cutoff = RandomByte(128);
+    engine.patch().SysExDump(dump);
+    if ((count++ & 3) == 3) {
+      dump[kSysExPatchDumpSize - 2] ^= 0x01;
+    }
+    for (uint8_t i = 0; i < kSysExPatchDumpSize; ++i) {
+      Append(dump[i]);
+    }
+  }
+}
+
+// Long messages for another manufacturer, and universal SysEx.
+static void GenerateForeignSysEx() {
+  while (!Full()) {
+    Append(0xf0);
+    if (RandomByte(2)) {
+      Append(0x43);  // Yamaha.
+    } else {
+      Append(0x7e);  // Universal, non realtime.
+    }
+    uint16_t size = 64 + RandomByte(255) * 4;
+    for (uint16_t i = 0; i < size; ++i) {
+      Append(RandomByte(128));
+    }
+    Append(0xf7);
+  }
+}
+
+static void GenerateOtherChannels() {
+  while (!Full()) {
+    uint8_t channel = 1 + RandomByte(15);
+    Append(0x90 | channel);
+    Append(RandomByte(128));
+    Append(100);
+    Append(0xb0 | channel);
+    Append(16 + RandomByte(16));
+    Append(RandomByte(128));
+  }
+}
+
+static void GenerateMalformed() {
+  while (!Full()) {
+    switch (RandomByte(6)) {
+      case 0:
+        // Data bytes without status.
+        Append(0xf6);
+        for (uint8_t i = RandomByte(8); i > 0; --i) {
+          Append(RandomByte(128));
+        }
+        break;
+      case 1:
+        // Truncated message, interrupted by another one.
+        Append(0x90);
+        Append(60);
+        Append(0xe0);
+        Append(0);
+        Append(64);
+        break;
+      case 2:
+        // Undefined status bytes.
+        Append(0xf4 + RandomByte(2));
+        Append(0xf9);
+        Append(0xfd);
+        break;
+      case 3:
+        // Stray end of exclusive.
+        Append(0xf7);
+        break;
+      case 4:
+        // SysEx interrupted by a status byte.
+        Append(0xf0);
+        Append(0x00);
+        Append(0x20);
+        Append(0x77);
+        Append(0x80);
+        Append(60);
+        Append(0);
+        break;
+      case 5:
+        // Random bytes.
+        for (uint8_t i = RandomByte(16); i > 0; --i) {
+          Append(RandomByte(255) + 1);
+        }
+        break;
+    }
+  }
+}
+
+// Everything at once, at the maximum rate of the MIDI port.
+static void GenerateMix() {
+  while (!Full()) {
+    uint8_t note = 36 + RandomByte(48);
+    switch (RandomByte(8)) {
+      case 0:
+        Append(0x90);
+        Append(note);
+        Append(100);
+        break;
+      case 1:
+        Append(0x80);
+        Append(note);
+        Append(0);
+        break;
+      case 2:
+        Append(0xd0);
+        Append(RandomByte(128));
+        break;
+      case 3:
+        Append(0xe0);
+        Append(RandomByte(128));
+        Append(RandomByte(128));
+        break;
+      case 4:
+        Append(0xb0);
+        Append(16 + RandomByte(16));
+        Append(RandomByte(128));
+        break;
+      case 5:
+        Append(0xf8);
+        break;
+      case 6:
+        Append(0xfe);
+        break;
+      case 7:
+        Append(0xb0);
+        Append(kNrpnLsb);
+        Append(RandomByte(PRM_KBD_MIDI_CHANNEL));
+        Append(kDataEntryLsb);
+        Append(RandomByte(128));
+        break;
+    }
+  }
+}
+
+struct Generator {
+  const char* name;
+  void (*generate)();
+};
+
+static const Generator generators[] = {
+  { "notes", &GenerateNotes },
+  { "running_status", &GenerateRunningStatus },
+  { "interleaved_clock", &GenerateInterleavedClock },
+  { "aftertouch_flood", &GenerateAftertouchFlood },
+  { "pitch_bend_flood", &GeneratePitchBendFlood },
+  { "nrpn_bursts", &GenerateNrpnBursts },
+  { "controller_flood", &GenerateControllerFlood },
+  { "patch_dumps", &GeneratePatchDumps },
+  { "foreign_sysex", &GenerateForeignSysEx },
+  { "other_channels", &GenerateOtherChannels },
+  { "malformed", &GenerateMalformed },
+  { "mix", &GenerateMix },
+};
+
+static const uint8_t kNumGenerators = sizeof(generators) / sizeof(Generator);
+
+static void Generate(uint8_t index) {
+  stream.name = generators[index].name;
+  stream.size = 0;
+  engine.Init();
+  (*generators[index].generate)();
+}
+
+static uint8_t Load(const char* file_name) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  stream.name = file_name;
+  stream.size = fread(stream.data, 1, kMaxStreamSize, fp);
+  fclose(fp);
+  return 1;
+}
+
+static uint8_t Save(const char* directory) {
+  char file_name[kMaxFileNameSize + 1];
+  snprintf(file_name, kMaxFileNameSize, "%s/%s.raw", directory, stream.name);
+  FILE* fp = fopen(file_name, "wb");
+  if (!fp) {
+    return 0;
+  }
+  fwrite(stream.data, 1, stream.size, fp);
+  fclose(fp);
+  return 1;
+}
+
+// ---- Benchmark --------------------------------------------------------------
+
+// Assigns each byte of the stream to a type of message, following the same
+// rules as the parser, and counts the messages.
+static void Classify(uint32_t* num_messages) {
+  uint8_t running_status = 0;
+  uint8_t data_size = 0;
+  uint8_t expected_data_size = 0;
+  for (uint16_t i = 0; i < stream.size; ++i) {
+    uint8_t byte = stream.data[i];
+    uint8_t type;
+    if (byte >= 0xf8) {
+      byte_types[i] = MESSAGE_REALTIME;
+      ++num_messages[MESSAGE_REALTIME];
+      continue;
+    }
+    if (byte >= 0x80) {
+      data_size = 0;
+      if (byte < 0xf0) {
+        expected_data_size = (byte & 0xf0) == 0xc0 ||
+            (byte & 0xf0) == 0xd0 ? 1 : 2;
+      } else if (byte == 0xf1 || byte == 0xf2) {
+        expected_data_size = 2;
+      } else {
+        expected_data_size = byte >= 0xf4 ? 0 : 1;
+      }
+      if (byte == 0xf7 && running_status == 0xf0) {
+        type = MESSAGE_SYSEX;
+      } else if (byte == 0xf0) {
+        type = MESSAGE_SYSEX;
+        ++num_messages[MESSAGE_SYSEX];
+      } else if (byte > 0xf0) {
+        type = MESSAGE_SYSTEM_COMMON;
+      } else {
+        type = MESSAGE_NOTE_OFF + ((byte >> 4) & 0x07);
+      }
+      running_status = byte;
+    } else {
+      ++data_size;
+      if (!running_status) {
+        type = MESSAGE_STRAY_DATA;
+      } else if (running_status == 0xf0) {
+        type = MESSAGE_SYSEX;
+      } else if (running_status > 0xf0) {
+        type = MESSAGE_SYSTEM_COMMON;
+      } else {
+        type = MESSAGE_NOTE_OFF + ((running_status >> 4) & 0x07);
+      }
+    }
+    byte_types[i] = type;
+    if (data_size >= expected_data_size) {
+      data_size = 0;
+      if (type != MESSAGE_SYSEX) {
+        ++num_messages[type];
+      }
+      if (running_status > 0xf0) {
+        expected_data_size = 0;
+        running_status = 0;
+      }
+    }
+  }
+}
+
+// Parses size bytes from data, num_runs times, from a clean state. Returns
+// the time spent in PushByte by the fastest run, in nanoseconds.
+static uint32_t Measure(const uint8_t* data, uint16_t size, uint8_t num_runs) {
+  uint32_t best = 0xffffffff;
+  for (uint8_t run = 0; run < num_runs; ++run) {
+    engine.Init();
+    MidiStreamParser<SynthesisEngine>* parser =
+        new MidiStreamParser<SynthesisEngine>();
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (uint16_t i = 0; i < size; ++i) {
+      parser->PushByte(data[i]);
+    }
+    uint32_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (elapsed < best) {
+      best = elapsed;
+    }
+    delete parser;
+  }
+  return best;
+}
+
+static void Benchmark(uint8_t num_runs) {
+  uint32_t num_messages[MESSAGE_LAST];
+  memset(num_messages, 0, sizeof(num_messages));
+  Classify(num_messages);
+
+  uint32_t total = Measure(stream.data, stream.size, num_runs);
+  for (uint8_t type = 0; type < MESSAGE_LAST; ++type) {
+    uint16_t size = 0;
+    for (uint16_t i = 0; i < stream.size; ++i) {
+      if (byte_types[i] == type) {
+        batch[size++] = stream.data[i];
+      }
+    }
+    MessageStatistics* s = &statistics[type];
+    s->num_messages += num_messages[type];
+    if (size) {
+      s->num_bytes += size;
+      s->total_time += Measure(batch, size, num_runs);
+    }
+  }
+  printf("%-20s %6d %9.1f %9.1f\n", stream.name, stream.size,
+         total / 1000.0, stream.size ? static_cast<double>(total) /
+             stream.size : 0.0);
+}
+
+static void PrintMessageStatistics() {
+  printf("\n%-20s %8s %8s %9s %9s\n", "message", "count", "bytes",
+         "ns/byte", "ns/msg");
+  for (uint8_t i = 0; i < MESSAGE_LAST; ++i) {
+    const MessageStatistics& s = statistics[i];
+    if (!s.num_bytes) {
+      continue;
+    }
+    printf("%-20s %8d %8d %9.1f", message_names[i], s.num_messages,
+           s.num_bytes, s.total_time / s.num_bytes);
+    if (s.num_messages) {
+      printf(" %9.1f\n", s.total_time / s.num_messages);
+    } else {
+      printf(" %9s\n", "-");
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  uint8_t num_runs = 20;
+  const char* output_directory = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "r:s:g:")) != -1) {
+    switch (option) {
+      case 'r':
+        num_runs = atoi(optarg);
+        break;
+      case 's':
+        srand(atoi(optarg));
+        break;
+      case 'g':
+        output_directory = optarg;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-r num_runs] [-s seed] "
+                "[-g output_directory] [stream.raw...]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (!num_runs) {
+    num_runs = 1;
+  }
+
+  if (output_directory) {
+    for (uint8_t i = 0; i < kNumGenerators; ++i) {
+      Generate(i);
+      if (!Save(output_directory)) {
+        fprintf(stderr, "Could not write %s in %s\n", stream.name,
+                output_directory);
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  printf("%-20s %6s %9s %9s\n", "stream", "bytes", "us", "ns/byte");
+  if (optind < argc) {
+    for (int i = optind; i < argc; ++i) {
+      if (!Load(argv[i])) {
+        fprintf(stderr, "Could not open %s\n", argv[i]);
+        return 1;
+      }
+      Benchmark(num_runs);
+    }
+  } else {
+    for (uint8_t i = 0; i < kNumGenerators; ++i) {
+      Generate(i);
+      Benchmark(num_runs);
+    }
+  }
+  PrintMessageStatistics();
+  return 0;
+}
@@ -0,0 +1,152 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// Checks that the *Block operations of op.h are bit-exact with the per-sample
+// operations they replace: every balance or scale value, every 16-bit value to
+// clip, and a sweep of phases and phase increments for the table reads. The
+// blocks are processed at all the sizes from 1 to kAudioBlockSize, and the
+// bytes following them must be left untouched.
+//
+// Usage: op_test. Prints the number of mismatches for each operation, and
+// returns 1 if there is any.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/shruti/shruti.h"
+#include "hardware/utils/op.h"
+
+using namespace hardware_utils_op;
+using namespace hardware_shruti;
+
+static const uint8_t kGuard = 0xa5;
+
+static uint8_t RandomByte() {
+  return rand() & 0xff;
+}
+
+static uint32_t TestMixBlock() {
+  uint32_t errors = 0;
+  uint8_t a[kAudioBlockSize + 1];
+  uint8_t b[kAudioBlockSize];
+  uint8_t original[kAudioBlockSize];
+  for (uint16_t balance = 0; balance < 256; ++balance) {
+    for (uint8_t size = 1; size <= kAudioBlockSize; ++size) {
+      for (uint8_t i = 0; i < size; ++i) {
+        original[i] = a[i] = RandomByte();
+        b[i] = RandomByte();
+      }
+      a[size] = kGuard;
+      MixBlock(a, b, balance, size);
+      for (uint8_t i = 0; i < size; ++i) {
+        errors += a[i] != Mix(original[i], b[i], balance);
+      }
+      errors += a[size] != kGuard;
+    }
+  }
+  return errors;
+}
+
+static uint32_t TestScaleBlock() {
+  uint32_t errors = 0;
+  uint8_t a[kAudioBlockSize + 1];
+  uint8_t original[kAudioBlockSize];
+  for (uint16_t scale = 0; scale < 256; ++scale) {
+    for (uint8_t size = 1; size <= kAudioBlockSize; ++size) {
+      for (uint8_t i = 0; i < size; ++i) {
+        original[i] = a[i] = RandomByte();
+      }
+      a[size] = kGuard;
+      ScaleBlock(a, scale, size);
+      for (uint8_t i = 0; i < size; ++i) {
+        errors += a[i] != MulScale8(original[i], scale);
+      }
+      errors += a[size] != kGuard;
+    }
+  }
+  return errors;
+}
+
+static uint32_t TestClipBlock() {
+  uint32_t errors = 0;
+  int16_t source[kAudioBlockSize];
+  uint8_t destination[kAudioBlockSize + 1];
+  int32_t value = -32768;
+  while (value < 32768) {
+    for (uint8_t size = 1; size <= kAudioBlockSize && value < 32768; ++size) {
+      for (uint8_t i = 0; i < size; ++i) {
+        source[i] = value < 32768 ? value++ : 0;
+      }
+      destination[size] = kGuard;
+      ClipBlock(source, destination, size);
+      for (uint8_t i = 0; i < size; ++i) {
+        errors += destination[i] != Clip8(source[i]);
+      }
+      errors += destination[size] != kGuard;
+    }
+  }
+  return errors;
+}
+
+static uint32_t TestInterpolateTableBlock() {
+  uint32_t errors = 0;
+  uint8_t table[257];
+  uint8_t destination[kAudioBlockSize + 1];
+  for (uint16_t i = 0; i < sizeof(table); ++i) {
+    table[i] = RandomByte();
+  }
+  for (uint32_t increment = 0; increment < 65536; increment += 251) {
+    uint16_t phase = (RandomByte() << 8) | RandomByte();
+    for (uint8_t size = 1; size <= kAudioBlockSize; ++size) {
+      destination[size] = kGuard;
+      uint16_t expected_phase = phase;
+      phase = InterpolateTableBlock(table, phase, increment, destination, size);
+      for (uint8_t i = 0; i < size; ++i) {
+        expected_phase += increment;
+        uint8_t expected = Mix(
+            table[expected_phase >> 8],
+            table[(expected_phase >> 8) + 1],
+            expected_phase & 0xff);
+        errors += destination[i] != expected;
+      }
+      errors += phase != expected_phase;
+      errors += destination[size] != kGuard;
+    }
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  srand(0);
+  uint32_t errors[4] = {
+    TestMixBlock(),
+    TestScaleBlock(),
+    TestClipBlock(),
+    TestInterpolateTableBlock()
+  };
+  static const char* names[] = {
+    "MixBlock", "ScaleBlock", "ClipBlock", "InterpolateTableBlock"
+  };
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < 4; ++i) {
+    printf("%-24s %u mismatches\n", names[i], errors[i]);
+    total += errors[i];
+  }
+  return total ? 1 : 0;
+}
@@ -0,0 +1,594 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// Similarity index over patch libraries, to find the patches which sound like
+// a given one.
+//
+// Each patch plays a probe phrase on the firmware's SynthesisEngine: a C3
+// held for 400ms, and released. A few features are extracted from the result:
+//
+// - spectral centroid of the oscillators signal, and its movement ;
+// - brightness envelope, as seen by the analog filter (cutoff CV at 5, 50,
+// 150, 350 and 450ms) ;
+// - attack time, release time and sustain level of the VCA CV ;
+// - pitch stability (deviation of the fundamental frequency during the note) ;
+// - noisiness (spectral flatness).
+//
+// They are normalized in the [0, 1] range and stored, along with a hash of the
+// patch, in an index file. When the index is rebuilt, the features of the
+// patches whose hash is already in the index are reused, so that only the new
+// or modified patches are rendered. Queries are answered by an exhaustive
+// search in the index, which takes a few ms for thousands of patches.
+//
+// The patches are read from libraries in the format of patch_library.txt (one
+// patch per line, see hardware/tools/librarian) and from SysEx dumps (.syx).
+// They are identified by their file name and position in the file.
+//
+// Usage: patch_index -i index.bin -b library.txt|dump.syx...
+//        patch_index -i index.bin -q name|file:position|dump.syx [-k count]
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "hardware/shruti/synthesis_engine.h"
+
+using namespace hardware_shruti;
+
+extern uint8_t host_eeprom[1024];
+
+static const uint16_t kMaxPatches = 16384;
+static const uint8_t kMaxKeySize = 48;
+static const uint8_t kNumFeatures = 12;
+// Bumped whenever the features change, to invalidate the existing indices.
+static const uint16_t kFeaturesVersion = 1;
+
+static const uint8_t kProbeNote = 48;
+static const uint16_t kNoteOnBlocks = 400;
+static const uint16_t kReleaseBlocks = 200;
+static const uint16_t kNumBlocks = kNoteOnBlocks + kReleaseBlocks;
+static const uint32_t kNumSamples = kNumBlocks * kAudioBlockSize;
+static const uint16_t kFrameSize = 256;
+static const uint16_t kNumFrames = kNumSamples / kFrameSize;
+static const uint8_t kNumPitchFrames = 8;
+static const uint16_t kPitchFrameSize = 512;
+static const uint16_t kMinPitchLag = 16;  // 1953 Hz.
+static const uint16_t kMaxPitchLag = 400;  // 78 Hz.
+static const uint8_t kSilence = 8;
+static const uint16_t kBrightnessProbes[] = { 5, 50, 150, 350, 450 };
+static const uint8_t kLibraryDataSize = kSerializedPatchSize - kPatchNameSize;
+
+static const char kIndexHeader[] = "SHIX";
+
+struct PatchRecord {
+  char key[kMaxKeySize];
+  char name[kPatchNameSize + 1];
+  uint32_t hash;
+  float features[kNumFeatures];
+};
+
+struct IndexHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t num_features;
+  uint32_t num_records;
+};
+
+static PatchRecord records[kMaxPatches];
+static uint16_t num_records = 0;
+static PatchRecord old_records[kMaxPatches];
+static uint16_t num_old_records = 0;
+static uint8_t patches[kMaxPatches][sizeof(Patch)];
+
+static uint8_t signal[kNumSamples];
+static uint8_t cutoff[kNumBlocks];
+static uint8_t vca[kNumBlocks];
+
+// ---- Patch loading ----------------------------------------------------------
+
+// FNV-1a.
+static uint32_t Hash(const uint8_t* data, uint16_t size) {
+  uint32_t hash = 2166136261U;
+  for (uint16_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 16777619U;
+  }
+  return hash;
+}
+
+static const char* BaseName(const char* file_name) {
+  const char* slash = strrchr(file_name, '/');
+  return slash ? slash + 1 : file_name;
+}
+
+// Adds the patch currently loaded in the engine.
+static void AddPatch(const char* file_name, uint16_t position) {
+  if (num_records == kMaxPatches) {
+    fprintf(stderr, "Too many patches, %s:%d ignored\n", file_name, position);
+    return;
+  }
+  PatchRecord* record = &records[num_records];
+  snprintf(record->key, kMaxKeySize, "%s:%d", BaseName(file_name), position);
+  memcpy(record->name, engine.patch().name, kPatchNameSize);
+  record->name[kPatchNameSize] = '\0';
+  memcpy(patches[num_records], &engine.patch(), sizeof(Patch));
+  record->hash = Hash(patches[num_records], sizeof(Patch));
+  ++num_records;
+}
+
+static inline uint8_t HexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  return (c | 0x20) - 'a' + 10;
+}
+
+// One patch per line: its name, a tab, and the 56 bytes of packed data in
+// hexadecimal, as they are stored in the EEPROM.
+static uint8_t LoadLibrary(const char* file_name) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    return 0;
+  }
+  char line[256];
+  uint16_t position = 0;
+  while (fgets(line, sizeof(line), fp)) {
+    const char* data = strchr(line, '\t');
+    if (!data || strlen(data + 1) < kLibraryDataSize * 2) {
+      continue;
+    }
+    ++data;
+    for (uint8_t i = 0; i < kLibraryDataSize; ++i) {
+      host_eeprom[i] = (HexDigit(data[2 * i]) << 4) |
+          HexDigit(data[2 * i + 1]);
+    }
+    for (uint8_t i = 0; i < kPatchNameSize; ++i) {
+      uint8_t c = line + i < data - 1 ? line[i] : ' ';
+      host_eeprom[kLibraryDataSize + i] = c;
+    }
+    engine.ResetPatch();
+    engine.mutable_patch()->EepromLoad(0);
+    if (engine.patch().name[0] != '?') {
+      AddPatch(file_name, position);
+    }
+    ++position;
+  }
+  fclose(fp);
+  return 1;
+}
+
+static uint8_t LoadSysEx(const char* file_name) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  uint16_t position = 0;
+  int c;
+  engine.ResetPatch();
+  while ((c = fgetc(fp)) != EOF) {
+    engine.mutable_patch()->SysExReceive(c);
+    if (c == 0xf7) {
+      if (engine.patch().sysex_reception_state() == RECEPTION_OK) {
+        AddPatch(file_name, position);
+      }
+      ++position;
+      engine.ResetPatch();
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+static uint8_t LoadPatches(const char* file_name) {
+  const char* extension = strrchr(file_name, '.');
+  if (extension && !strcmp(extension, ".syx")) {
+    return LoadSysEx(file_name);
+  } else {
+    return LoadLibrary(file_name);
+  }
+}
+
+// ---- Feature extraction -----------------------------------------------------
+
+static void Render(const uint8_t* patch) {
+  engine.Reset();
+  memcpy(engine.mutable_patch(), patch, sizeof(Patch));
+  engine.TouchPatch();
+  engine.NoteOn(0, kProbeNote, 100);
+  uint32_t sample = 0;
+  for (uint16_t i = 0; i < kNumBlocks; ++i) {
+    if (i == kNoteOnBlocks) {
+      engine.NoteOff(0, kProbeNote, 0);
+    }
+    // Same as AudioRenderingTask in shruti.cc.
+    engine.Control();
+    for (uint8_t j = 0; j < kAudioBlockSize; ++j) {
+      if (engine.voice(0).dead()) {
+        signal[sample++] = 128;
+      } else {
+        engine.Audio();
+        signal[sample++] = engine.voice(0).signal();
+      }
+    }
+    cutoff[i] = engine.voice(0).cutoff();
+    vca[i] = engine.voice(0).vca();
+  }
+}
+
+static inline float Clip(float value) {
+  return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+// Spectral centroid (in Hz) and flatness of a frame, with a Hann window.
+static void AnalyzeFrame(const uint8_t* frame, float* centroid,
+                         float* flatness) {
+  static float window[kFrameSize];
+  static float cosines[kFrameSize];
+  static float sines[kFrameSize];
+  static uint8_t initialized = 0;
+  if (!initialized) {
+    for (uint16_t i = 0; i < kFrameSize; ++i) {
+      window[i] = 0.5f - 0.5f * cosf(2.0f * M_PI * i / kFrameSize);
+      cosines[i] = cosf(2.0f * M_PI * i / kFrameSize);
+      sines[i] = sinf(2.0f * M_PI * i / kFrameSize);
+    }
+    initialized = 1;
+  }
+  float x[kFrameSize];
+  for (uint16_t i = 0; i < kFrameSize; ++i) {
+    x[i] = (frame[i] - 128.0f) / 128.0f * window[i];
+  }
+  double weighted = 0.0;
+  double total = 0.0;
+  double log_total = 0.0;
+  for (uint16_t k = 1; k < kFrameSize / 2; ++k) {
+    float re = 0.0f;
+    float im = 0.0f;
+    uint16_t phase = 0;
+    for (uint16_t i = 0; i < kFrameSize; ++i) {
+      re += x[i] * cosines[phase];
+      im -= x[i] * sines[phase];
+      phase = (phase + k) & (kFrameSize - 1);
+    }
+    double power = re * re + im * im + 1e-9;
+    weighted += power * k;
+    total += power;
+    log_total += log(power);
+  }
+  uint16_t num_bins = kFrameSize / 2 - 1;
+  *centroid = weighted / total * kSampleRate / kFrameSize;
+  *flatness = exp(log_total / num_bins) / (total / num_bins);
+}
+
+// Fundamental frequency (in Hz) of a frame, by autocorrelation.
+static float EstimatePitch(const uint8_t* frame) {
+  float best = 0.0f;
+  uint16_t best_lag = 0;
+  for (uint16_t lag = kMinPitchLag; lag <= kMaxPitchLag; ++lag) {
+    float correlation = 0.0f;
+    for (uint16_t i = 0; i < kPitchFrameSize - kMaxPitchLag; ++i) {
+      correlation += (frame[i] - 128.0f) * (frame[i + lag] - 128.0f);
+    }
+    if (correlation > best) {
+      best = correlation;
+      best_lag = lag;
+    }
+  }
+  return best_lag ? static_cast<float>(kSampleRate) / best_lag : 0.0f;
+}
+
+// Time, in ms, at which the VCA reaches 90% of its peak during the note.
+static float AttackTime() {
+  uint8_t peak = 0;
+  for (uint16_t i = 0; i < kNoteOnBlocks; ++i) {
+    if (vca[i] > peak) {
+      peak = vca[i];
+    }
+  }
+  for (uint16_t i = 0; i < kNoteOnBlocks; ++i) {
+    if (vca[i] * 10 >= peak * 9) {
+      return i * kAudioBlockSize * 1000.0f / kSampleRate;
+    }
+  }
+  return 0.0f;
+}
+
+// Time, in ms, after which the VCA is below 10% of its level at the release.
+static float ReleaseTime() {
+  uint8_t level = vca[kNoteOnBlocks - 1];
+  for (uint16_t i = kNoteOnBlocks; i < kNumBlocks; ++i) {
+    if (vca[i] * 10 <= level) {
+      return (i - kNoteOnBlocks) * kAudioBlockSize * 1000.0f / kSampleRate;
+    }
+  }
+  return kReleaseBlocks * kAudioBlockSize * 1000.0f / kSampleRate;
+}
+
+static void ExtractFeatures(const uint8_t* patch, float* features) {
+  Render(patch);
+
+  // Spectrum, on the frames during which the VCA is open.
+  double log_centroid_sum = 0.0;
+  double log_centroid_square_sum = 0.0;
+  double flatness_sum = 0.0;
+  uint16_t num_frames = 0;
+  for (uint16_t i = 0; i < kNumFrames; ++i) {
+    if (vca[i * kFrameSize / kAudioBlockSize] < kSilence) {
+      continue;
+    }
+    float centroid;
+    float flatness;
+    AnalyzeFrame(signal + i * kFrameSize, &centroid, &flatness);
+    float log_centroid = log2f(centroid / 100.0f + 1.0f);
+    log_centroid_sum += log_centroid;
+    log_centroid_square_sum += log_centroid * log_centroid;
+    flatness_sum += flatness;
+    ++num_frames;
+  }
+  if (num_frames) {
+    float mean = log_centroid_sum / num_frames;
+    float variance = log_centroid_square_sum / num_frames - mean * mean;
+    features[0] = Clip(mean / 7.0f);
+    features[1] = Clip(sqrtf(variance > 0.0f ? variance : 0.0f) / 2.0f);
+    features[11] = Clip(flatness_sum / num_frames);
+  } else {
+    features[0] = features[1] = features[11] = 0.0f;
+  }
+
+  // Brightness envelope.
+  for (uint8_t i = 0; i < 5; ++i) {
+    uint16_t block = kBrightnessProbes[i] * kSampleRate / 1000 /
+        kAudioBlockSize;
+    features[2 + i] = cutoff[block] / 255.0f;
+  }
+
+  // Amplitude envelope.
+  features[7] = Clip(log2f(1.0f + AttackTime()) / 10.0f);
+  features[8] = Clip(log2f(1.0f + ReleaseTime()) / 8.0f);
+  features[9] = vca[kNoteOnBlocks - 50] / 255.0f;
+
+  // Pitch stability, in cents, during the note.
+  float log_pitch_sum = 0.0f;
+  float log_pitch_square_sum = 0.0f;
+  uint8_t num_pitches = 0;
+  for (uint8_t i = 0; i < kNumPitchFrames; ++i) {
+    uint32_t start = (i + 1) * (kNoteOnBlocks * kAudioBlockSize -
+        kPitchFrameSize) / (kNumPitchFrames + 1);
+    if (vca[start / kAudioBlockSize] < kSilence) {
+      continue;
+    }
+    float pitch = EstimatePitch(signal + start);
+    if (pitch > 0.0f) {
+      float cents = 1200.0f * log2f(pitch);
+      log_pitch_sum += cents;
+      log_pitch_square_sum += cents * cents;
+      ++num_pitches;
+    }
+  }
+  if (num_pitches > 1) {
+    float mean = log_pitch_sum / num_pitches;
+    float variance = log_pitch_square_sum / num_pitches - mean * mean;
+    float deviation = sqrtf(variance > 0.0f ? variance : 0.0f);
+    features[10] = Clip(log2f(1.0f + deviation) / 10.0f);
+  } else {
+    features[10] = 1.0f;
+  }
+}
+
+// ---- Index ------------------------------------------------------------------
+
+static uint8_t LoadIndex(const char* file_name, PatchRecord* destination,
+                         uint16_t* size) {
+  FILE* fp = fopen(file_name, "rb");
+  *size = 0;
+  if (!fp) {
+    return 0;
+  }
+  IndexHeader header;
+  uint8_t ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+      !memcmp(header.magic, kIndexHeader, 4) &&
+      header.version == kFeaturesVersion &&
+      header.num_features == kNumFeatures &&
+      header.num_records <= kMaxPatches &&
+      fread(destination, sizeof(PatchRecord), header.num_records, fp) ==
+          header.num_records;
+  fclose(fp);
+  if (ok) {
+    *size = header.num_records;
+  }
+  return ok;
+}
+
+static uint8_t SaveIndex(const char* file_name) {
+  FILE* fp = fopen(file_name, "wb");
+  if (!fp) {
+    return 0;
+  }
+  IndexHeader header;
+  memcpy(header.magic, kIndexHeader, 4);
+  header.version = kFeaturesVersion;
+  header.num_features = kNumFeatures;
+  header.num_records = num_records;
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(records, sizeof(PatchRecord), num_records, fp);
+  fclose(fp);
+  return 1;
+}
+
+static const PatchRecord* FindHash(uint32_t hash) {
+  for (uint16_t i = 0; i < num_old_records; ++i) {
+    if (old_records[i].hash == hash) {
+      return &old_records[i];
+    }
+  }
+  return NULL;
+}
+
+static int Build(const char* index_file_name, char** inputs,
+                 uint16_t num_inputs) {
+  for (uint16_t i = 0; i < num_inputs; ++i) {
+    if (!LoadPatches(inputs[i])) {
+      fprintf(stderr, "Could not open %s\n", inputs[i]);
+      return 1;
+    }
+  }
+  LoadIndex(index_file_name, old_records, &num_old_records);
+  uint16_t num_rendered = 0;
+  for (uint16_t i = 0; i < num_records; ++i) {
+    const PatchRecord* previous = FindHash(records[i].hash);
+    if (previous) {
+      memcpy(records[i].features, previous->features,
+             sizeof(records[i].features));
+    } else {
+      ExtractFeatures(patches[i], records[i].features);
+      ++num_rendered;
+    }
+  }
+  if (!SaveIndex(index_file_name)) {
+    fprintf(stderr, "Could not write %s\n", index_file_name);
+    return 1;
+  }
+  printf("%d patches indexed, %d rendered, %d reused\n", num_records,
+         num_rendered, num_records - num_rendered);
+  return 0;
+}
+
+static float Distance(const float* a, const float* b) {
+  float distance = 0.0f;
+  for (uint8_t i = 0; i < kNumFeatures; ++i) {
+    distance += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return sqrtf(distance);
+}
+
+static int Query(const char* index_file_name, const char* query,
+                 uint8_t count) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  if (!LoadIndex(index_file_name, old_records, &num_old_records)) {
+    fprintf(stderr, "Could not load %s\n", index_file_name);
+    return 1;
+  }
+
+  // The query is either a patch file, or a patch of the index, designated by
+  // its key or name.
+  float features[kNumFeatures];
+  const PatchRecord* target = NULL;
+  FILE* fp = fopen(query, "rb");
+  if (fp) {
+    fclose(fp);
+    if (!LoadPatches(query) || !num_records) {
+      fprintf(stderr, "No patch in %s\n", query);
+      return 1;
+    }
+    ExtractFeatures(patches[0], features);
+  } else {
+    for (uint16_t i = 0; i < num_old_records && !target; ++i) {
+      if (!strcmp(old_records[i].key, query) ||
+          !strncasecmp(old_records[i].name, query, strlen(query))) {
+        target = &old_records[i];
+      }
+    }
+    if (!target) {
+      fprintf(stderr, "No patch named %s in the index\n", query);
+      return 1;
+    }
+    memcpy(features, target->features, sizeof(features));
+  }
+
+  // Keeps the count closest patches, sorted by distance.
+  const PatchRecord* nearest[256];
+  float distances[256];
+  uint8_t num_nearest = 0;
+  for (uint16_t i = 0; i < num_old_records; ++i) {
+    if (&old_records[i] == target) {
+      continue;
+    }
+    float distance = Distance(features, old_records[i].features);
+    if (num_nearest == count && distance >= distances[num_nearest - 1]) {
+      continue;
+    }
+    uint8_t position = num_nearest < count ? num_nearest++ : num_nearest - 1;
+    while (position > 0 && distances[position - 1] > distance) {
+      nearest[position] = nearest[position - 1];
+      distances[position] = distances[position - 1];
+      --position;
+    }
+    nearest[position] = &old_records[i];
+    distances[position] = distance;
+  }
+  uint32_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+  for (uint8_t i = 0; i < num_nearest; ++i) {
+    printf("%2d  %-8s  %-32s  %.3f\n", i + 1, nearest[i]->name,
+           nearest[i]->key, distances[i]);
+  }
+  printf("%d patches searched in %.2f ms\n", num_old_records,
+         elapsed / 1000.0);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const char* index_file_name = NULL;
+  const char* query = NULL;
+  uint8_t build = 0;
+  int count = 10;
+
+  int option;
+  while ((option = getopt(argc, argv, "i:bq:k:")) != -1) {
+    switch (option) {
+      case 'i':
+        index_file_name = optarg;
+        break;
+      case 'b':
+        build = 1;
+        break;
+      case 'q':
+        query = optarg;
+        break;
+      case 'k':
+        count = atoi(optarg);
+        break;
+      default:
+        index_file_name = NULL;
+        break;
+    }
+  }
+  if (!index_file_name || build == (query != NULL)) {
+    fprintf(stderr, "Usage: %s -i index.bin -b library.txt|dump.syx...\n"
+            "       %s -i index.bin -q name|file:position|dump.syx "
+            "[-k count]\n", argv[0], argv[0]);
+    return 1;
+  }
+  if (count < 1) {
+    count = 1;
+  } else if (count > 256) {
+    count = 256;
+  }
+
+  engine.Init();
+  if (build) {
+    return Build(index_file_name, argv + optind, argc - optind);
+  } else {
+    return Query(index_file_name, query, count);
+  }
+}
@@ -0,0 +1,357 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Guided search for the patches which are the most expensive to render with
+// the monophonic engine. Each candidate (a patch and a note) is played on the
+// firmware's SynthesisEngine, and the cost of its blocks on the chip is
+// estimated by the CycleModel, from the algorithms used by the oscillators
+// while the patch is modulated. A hill-climber with random restarts mutates
+// one parameter (or the note) at a time and keeps the mutations which make the
+// block more expensive.
+//
+// The worst patches are printed, ranked, and written as .syx files which can
+// be loaded in the synth, or in poly_render. Only the parameters saved in the
+// .syx files are mutated, and the candidates which do not load back exactly
+// are skipped, so that the files reproduce the cost.
+//
+// Usage: patch_search [-r restarts] [-i iterations] [-n num_results]
+//                     [-s seed] [-o output_prefix]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/shruti/host/cycle_model.h"
+#include "hardware/shruti/patch_metadata.h"
+#include "hardware/shruti/synthesis_engine.h"
+#include "hardware/utils/random.h"
+
+using namespace hardware_shruti;
+using hardware_utils::Random;
+
+static const uint8_t kMaxResults = 32;
+static const uint8_t kLowestSearchedNote = 24;
+static const uint8_t kHighestSearchedNote = 108;
+static const uint8_t kNumWarmUpBlocks = 16;
+static const uint8_t kNumMeasuredBlocks = 32;
+static const uint16_t kRandomSeed = 0x21;
+
+struct ExtraParameter {
+  uint8_t id;
+  uint8_t min_value;
+  uint8_t max_value;
+};
+
+// Parameters which can only be reached by NRPN, and thus have no metadata.
+// Only those saved with the patch are searched: the multi-stage envelopes and
+// the voice LFO would be lost in the .syx files.
+static const ExtraParameter extra_parameters[] = {
+  { PRM_ENV_CURVE_1, ENVELOPE_CURVE_LINEAR, ENVELOPE_CURVE_S },
+  { PRM_ENV_CURVE_2, ENVELOPE_CURVE_LINEAR, ENVELOPE_CURVE_S },
+};
+
+static const uint8_t kNumExtraParameters = sizeof(extra_parameters) /
+    sizeof(ExtraParameter);
+
+struct Candidate {
+  uint8_t patch[sizeof(Patch)];
+  uint8_t note;
+  uint32_t cost;
+};
+
+static Candidate init_patch;
+static Candidate results[kMaxResults];
+static uint8_t num_results = 0;
+
+static uint8_t RandomInRange(uint8_t min_value, uint8_t max_value) {
+  return min_value + rand() % (max_value - min_value + 1);
+}
+
+// Sets one of the editable parameters (or the note, for the index just after
+// the last one) to a random value. The parameters which are not saved with the
+// patch are left untouched.
+static void Mutate(Candidate* candidate, uint8_t index) {
+  uint8_t* base = candidate->patch + 1;
+  if (index == kNumEditableParameters + kNumExtraParameters) {
+    candidate->note = RandomInRange(kLowestSearchedNote, kHighestSearchedNote);
+  } else if (index >= kNumEditableParameters) {
+    const ExtraParameter& parameter = extra_parameters[
+        index - kNumEditableParameters];
+    base[parameter.id] = RandomInRange(
+        parameter.min_value,
+        parameter.max_value);
+  } else {
+    const ParameterDefinition& parameter =
+        PatchMetadata::parameter_definition(index);
+    uint8_t id = parameter.id;
+    // The arpeggiator and keyboard settings are not saved.
+    if (id == PRM_MOD_ROW || id >= PRM_ARP_TEMPO) {
+      return;
+    }
+    uint8_t max_value = parameter.max_value;
+    // The modulation matrix is edited one row at a time, among the saved rows.
+    // Only the sources which fit in 4 bits are saved.
+    if (id >= PRM_MOD_SOURCE && id <= PRM_MOD_AMOUNT) {
+      if (id == PRM_MOD_SOURCE && max_value > 15) {
+        max_value = 15;
+      }
+      id += RandomInRange(0, kSavedModulationMatrixSize - 1) * 3;
+    }
+    if (parameter.unit == UNIT_INT8) {
+      int8_t min_value = parameter.min_value;
+      int8_t signed_max_value = max_value;
+      base[id] = min_value + rand() % (signed_max_value - min_value + 1);
+    } else {
+      base[id] = RandomInRange(parameter.min_value, max_value);
+    }
+  }
+}
+
+static void Randomize(Candidate* candidate) {
+  for (uint8_t i = 0; i <= kNumEditableParameters + kNumExtraParameters;
+       ++i) {
+    Mutate(candidate, i);
+  }
+  // Give a chance to all the saved rows of the modulation matrix.
+  for (uint8_t i = 0; i < kSavedModulationMatrixSize * 3; ++i) {
+    Mutate(candidate, rand() % kNumEditableParameters);
+  }
+}
+
+// Returns 1 if the candidate is exactly the patch obtained by loading its .syx
+// file on top of the init patch. Otherwise, its cost would not be reproduced
+// by the file.
+static uint8_t SurvivesSysEx(const Candidate& candidate) {
+  uint8_t buffer[kSysExPatchDumpSize];
+  Patch* patch = engine.mutable_patch();
+  memcpy(patch, candidate.patch, sizeof(Patch));
+  patch->SysExDump(buffer);
+  memcpy(patch, init_patch.patch, sizeof(Patch));
+  for (uint8_t i = 0; i < kSysExPatchDumpSize; ++i) {
+    patch->SysExReceive(buffer[i]);
+  }
+  return patch->sysex_reception_state() == RECEPTION_OK &&
+      !memcmp(patch, candidate.patch, sizeof(Patch));
+}
+
+// Same as AudioRenderingTask in shruti.cc, without the writes to the outputs.
+static void RenderBlock() {
+  engine.Control();
+  if (!engine.voice(0).dead()) {
+    for (uint8_t i = kAudioBlockSize; i > 0 ; --i) {
+      engine.Audio();
+    }
+  }
+}
+
+// Returns the estimated number of cycles spent rendering a block with the
+// candidate, averaged over the measured blocks. The random generators are
+// restarted, so that a candidate always gets the same cost.
+static uint32_t Evaluate(const Candidate& candidate) {
+  Random::Seed(kRandomSeed);
+  engine.Reset();
+  memcpy(engine.mutable_patch(), candidate.patch, sizeof(Patch));
+  engine.TouchPatch();
+  engine.NoteOn(0, candidate.note, 100);
+  for (uint8_t i = 0; i < kNumWarmUpBlocks; ++i) {
+    RenderBlock();
+  }
+  const Patch& patch = engine.patch();
+  uint32_t cycles = 0;
+  for (uint8_t i = 0; i < kNumMeasuredBlocks; ++i) {
+    RenderBlock();
+    cycles += CycleModel::ControlCycles(patch);
+    if (!engine.voice(0).dead()) {
+      cycles += kAudioBlockSize * CycleModel::AudioCycles(
+          patch,
+          Voice::modulation_destination(MOD_DST_PWM_1),
+          Voice::modulation_destination(MOD_DST_PWM_2));
+    }
+  }
+  engine.NoteOff(0, candidate.note, 0);
+  return cycles / kNumMeasuredBlocks;
+}
+
+// Inserts a candidate in the ranked list of results, if it is expensive
+// enough. A candidate identical to one already in the list replaces it.
+static void Rank(const Candidate& candidate) {
+  uint8_t position = num_results;
+  for (uint8_t i = 0; i < num_results; ++i) {
+    if (results[i].note == candidate.note &&
+        !memcmp(results[i].patch, candidate.patch, sizeof(Patch))) {
+      if (candidate.cost <= results[i].cost) {
+        return;
+      }
+      position = i;
+      break;
+    }
+  }
+  if (position == num_results) {
+    if (num_results < kMaxResults) {
+      ++num_results;
+    } else if (candidate.cost <= results[kMaxResults - 1].cost) {
+      return;
+    } else {
+      position = kMaxResults - 1;
+    }
+  }
+  while (position > 0 && results[position - 1].cost < candidate.cost) {
+    results[position] = results[position - 1];
+    --position;
+  }
+  results[position] = candidate;
+}
+
+static void PrintCandidate(const Candidate& candidate) {
+  const uint8_t* base = candidate.patch + 1;
+  char name[17] = { 0 };
+  printf("  note: %d\n", candidate.note);
+  for (uint8_t i = 0; i < kNumEditableParameters; ++i) {
+    const ParameterDefinition& parameter =
+        PatchMetadata::parameter_definition(i);
+    if (parameter.id >= PRM_MOD_SOURCE && parameter.id <= PRM_MOD_ROW) {
+      continue;
+    }
+    ResourcesManager::LoadStringResource(
+        parameter.long_name,
+        name,
+        sizeof(name) - 1);
+    int16_t value = base[parameter.id];
+    if (parameter.unit == UNIT_INT8) {
+      value = static_cast<int8_t>(value);
+    }
+    printf("  %-16s %d\n", name, value);
+  }
+  for (uint8_t i = 0; i < kNumExtraParameters; ++i) {
+    printf("  nrpn %-11d %d\n", extra_parameters[i].id,
+           base[extra_parameters[i].id]);
+  }
+  for (uint8_t i = 0; i < kModulationMatrixSize; ++i) {
+    const uint8_t* row = base + PRM_MOD_SOURCE + i * 3;
+    if (row[2]) {
+      printf("  modulation %-5d %d -> %d (%d)\n", i + 1, row[0], row[1],
+             static_cast<int8_t>(row[2]));
+    }
+  }
+}
+
+static int WriteSysEx(const Candidate& candidate, const char* file_name) {
+  FILE* fp = fopen(file_name, "wb");
+  if (!fp) {
+    return 0;
+  }
+  uint8_t buffer[kSysExPatchDumpSize];
+  memcpy(engine.mutable_patch(), candidate.patch, sizeof(Patch));
+  engine.mutable_patch()->SysExDump(buffer);
+  fwrite(buffer, 1, kSysExPatchDumpSize, fp);
+  fclose(fp);
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  uint16_t num_restarts = 20;
+  uint16_t num_iterations = 1000;
+  uint8_t num_printed_results = 10;
+  unsigned int seed = 1;
+  const char* output_prefix = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "r:i:n:s:o:")) != -1) {
+    switch (option) {
+      case 'r':
+        num_restarts = atoi(optarg);
+        break;
+      case 'i':
+        num_iterations = atoi(optarg);
+        break;
+      case 'n':
+        num_printed_results = atoi(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case 'o':
+        output_prefix = optarg;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-r restarts] [-i iterations] "
+                "[-n num_results] [-s seed] [-o output_prefix]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (num_printed_results > kMaxResults) {
+    num_printed_results = kMaxResults;
+  }
+  srand(seed);
+
+  engine.Init();
+  memcpy(init_patch.patch, &engine.patch(), sizeof(Patch));
+  init_patch.note = 60;
+  uint32_t reference_cost = Evaluate(init_patch);
+
+  for (uint16_t restart = 0; restart < num_restarts; ++restart) {
+    Candidate current = init_patch;
+    Randomize(&current);
+    if (!SurvivesSysEx(current)) {
+      fprintf(stderr, "Restart %d: the random patch cannot be saved\n",
+              restart);
+      return 1;
+    }
+    current.cost = Evaluate(current);
+    Rank(current);
+    for (uint16_t i = 0; i < num_iterations; ++i) {
+      Candidate mutated = current;
+      Mutate(
+          &mutated,
+          rand() % (kNumEditableParameters + kNumExtraParameters + 1));
+      if (!SurvivesSysEx(mutated)) {
+        continue;
+      }
+      mutated.cost = Evaluate(mutated);
+      if (mutated.cost > current.cost) {
+        current = mutated;
+        Rank(current);
+      }
+    }
+    fprintf(stderr, "restart %d: %.2fx\n", restart,
+            static_cast<float>(current.cost) / reference_cost);
+  }
+
+  if (num_printed_results > num_results) {
+    num_printed_results = num_results;
+  }
+  printf("init patch: %d cycles/block, %.1f%% of a block\n", reference_cost,
+         100.0 * reference_cost / kBlockCycles);
+  for (uint8_t i = 0; i < num_printed_results; ++i) {
+    printf("#%d: %d cycles/block, %.1f%% of a block, %.2fx\n", i + 1,
+           results[i].cost,
+           100.0 * results[i].cost / kBlockCycles,
+           static_cast<float>(results[i].cost) / reference_cost);
+    PrintCandidate(results[i]);
+    if (output_prefix) {
+      char file_name[256];
+      snprintf(file_name, sizeof(file_name), "%s_%02d.syx", output_prefix,
+               i + 1);
+      if (!WriteSysEx(results[i], file_name)) {
+        fprintf(stderr, "Could not write %s\n", file_name);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
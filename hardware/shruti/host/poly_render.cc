@@ -0,0 +1,202 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Desktop renderer for the polyphonic engine. Plays a chord with a patch
+// (optionally loaded from a .syx dump), writes the result to a .wav file, and
+// reports the cost of each voice, in ATmega328p cycles (see cycle_model.h).
+//
+// Usage: poly_render [-v num_voices] [-n num_notes] [-p patch.syx]
+//                    [-o output.wav] [-b cpu_budget_cycles]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hardware/shruti/host/poly_synthesis_engine.h"
+
+using hardware_shruti::engine;
+using hardware_shruti::kAudioBlockSize;
+using hardware_shruti::kBlockCycles;
+using hardware_shruti::kMaxPolyVoices;
+using hardware_shruti::kSampleRate;
+using hardware_shruti::Patch;
+using hardware_shruti::PolyVoice;
+using hardware_shruti::RECEPTION_OK;
+
+static const uint16_t kNumHoldBlocks = 2000;
+static const uint16_t kNumReleaseBlocks = 1000;
+static const uint16_t kNumBlocksBetweenNotes = 50;
+
+static void WriteUint32(FILE* fp, uint32_t value) {
+  for (uint8_t i = 0; i < 4; ++i) {
+    fputc((value >> (i * 8)) & 0xff, fp);
+  }
+}
+
+static void WriteUint16(FILE* fp, uint16_t value) {
+  fputc(value & 0xff, fp);
+  fputc(value >> 8, fp);
+}
+
+static void WriteWavHeader(FILE* fp, uint32_t num_samples) {
+  fwrite("RIFF", 1, 4, fp);
+  WriteUint32(fp, 36 + num_samples * 2);
+  fwrite("WAVEfmt ", 1, 8, fp);
+  WriteUint32(fp, 16);
+  WriteUint16(fp, 1);  // PCM.
+  WriteUint16(fp, 1);  // Mono.
+  WriteUint32(fp, kSampleRate);
+  WriteUint32(fp, kSampleRate * 2);
+  WriteUint16(fp, 2);
+  WriteUint16(fp, 16);
+  fwrite("data", 1, 4, fp);
+  WriteUint32(fp, num_samples * 2);
+}
+
+static int LoadPatch(const char* file_name) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  Patch* patch = engine.mutable_patch();
+  int c;
+  while ((c = fgetc(fp)) != EOF) {
+    patch->SysExReceive(c);
+    if (c == 0xf7) {
+      break;
+    }
+  }
+  fclose(fp);
+  if (patch->sysex_reception_state() != RECEPTION_OK) {
+    return 0;
+  }
+  engine.TouchPatch();
+  return 1;
+}
+
+static void RenderBlocks(FILE* fp, uint16_t num_blocks, uint8_t num_notes) {
+  float buffer[kAudioBlockSize];
+  for (uint16_t i = 0; i < num_blocks; ++i) {
+    engine.Render(buffer);
+    if (!fp) {
+      continue;
+    }
+    for (uint8_t j = 0; j < kAudioBlockSize; ++j) {
+      float sample = buffer[j] / num_notes * 32767.0f;
+      if (sample > 32767.0f) {
+        sample = 32767.0f;
+      } else if (sample < -32768.0f) {
+        sample = -32768.0f;
+      }
+      WriteUint16(fp, static_cast<int16_t>(sample));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  uint8_t num_voices = 8;
+  uint8_t num_notes = 4;
+  const char* patch_file_name = NULL;
+  const char* output_file_name = NULL;
+  uint32_t cpu_budget = kBlockCycles;
+
+  int option;
+  while ((option = getopt(argc, argv, "v:n:p:o:b:")) != -1) {
+    switch (option) {
+      case 'v':
+        num_voices = atoi(optarg);
+        break;
+      case 'n':
+        num_notes = atoi(optarg);
+        break;
+      case 'p':
+        patch_file_name = optarg;
+        break;
+      case 'o':
+        output_file_name = optarg;
+        break;
+      case 'b':
+        cpu_budget = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-v num_voices] [-n num_notes] "
+                "[-p patch.syx] [-o output.wav] [-b cpu_budget_cycles]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (num_voices == 0 || num_voices > kMaxPolyVoices || num_notes == 0 ||
+      num_notes * kNumBlocksBetweenNotes > kNumHoldBlocks) {
+    fprintf(stderr, "Invalid number of voices or notes\n");
+    return 1;
+  }
+
+  engine.Init(num_voices);
+  engine.set_cpu_budget(cpu_budget);
+  if (patch_file_name && !LoadPatch(patch_file_name)) {
+    fprintf(stderr, "Could not load patch %s\n", patch_file_name);
+    return 1;
+  }
+
+  FILE* fp = NULL;
+  if (output_file_name) {
+    fp = fopen(output_file_name, "wb");
+    if (!fp) {
+      fprintf(stderr, "Could not open %s\n", output_file_name);
+      return 1;
+    }
+    WriteWavHeader(
+        fp,
+        static_cast<uint32_t>(kNumHoldBlocks + kNumReleaseBlocks) *
+            kAudioBlockSize);
+  }
+
+  // Stacked fifths and fourths, from C2. The notes are played one after the
+  // other so that the allocator can see the cost of the voices already
+  // playing.
+  for (uint8_t i = 0; i < num_notes; ++i) {
+    engine.NoteOn(36 + i * 7 - (i / 2) * 2, 100);
+    RenderBlocks(fp, kNumBlocksBetweenNotes, num_notes);
+  }
+  RenderBlocks(fp, kNumHoldBlocks - num_notes * kNumBlocksBetweenNotes,
+               num_notes);
+  for (uint8_t i = 0; i < num_notes; ++i) {
+    engine.NoteOff(36 + i * 7 - (i / 2) * 2);
+  }
+  RenderBlocks(fp, kNumReleaseBlocks, num_notes);
+  if (fp) {
+    fclose(fp);
+  }
+
+  printf("voice   blocks   cycles/block   %% of block   decimation\n");
+  double total = 0.0;
+  for (uint8_t i = 0; i < engine.num_voices(); ++i) {
+    const PolyVoice& voice = engine.voice(i);
+    if (!voice.num_blocks()) {
+      printf("%5d   %6d              -            -            -\n", i, 0);
+      continue;
+    }
+    double per_block = static_cast<double>(voice.total_cost()) /
+        voice.num_blocks();
+    total += per_block;
+    printf("%5d   %6d   %12.0f   %10.2f   %10d\n", i, voice.num_blocks(),
+           per_block, 100.0 * per_block / kBlockCycles, voice.decimation());
+  }
+  printf("total            %12.0f   %10.2f\n", total,
+         100.0 * total / kBlockCycles);
+  printf("stolen voices: %d\n", engine.num_stolen_voices());
+  return 0;
+}
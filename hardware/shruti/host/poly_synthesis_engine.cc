@@ -0,0 +1,768 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Polyphonic variant of the synthesis engine, for the desktop build only.
+
+#include <math.h>
+#include <string.h>
+
+
+#include "hardware/shruti/host/poly_synthesis_engine.h"
+
+#include "hardware/resources/resources_manager.h"
+#include "hardware/shruti/oscillator.h"
+#include "hardware/utils/op.h"
+#include "hardware/utils/random.h"
+
+using namespace hardware_utils_op;
+using hardware_utils::Random;
+
+namespace hardware_shruti {
+
+// Same as in synthesis_engine.h.
+static const int16_t kLowestNote = 0 * 128;
+static const int16_t kHighestNote = 108 * 128;
+static const int16_t kOctave = 12 * 128;
+static const int16_t kPitchTableStart = 96 * 128;
+
+// Cutoff frequency of the digital filter, for a cutoff CV of 0. The cutoff CV
+// spans 10 octaves.
+static const float kFilterLowestCutoff = 20.0f;
+
+/* extern */
+PolySynthesisEngine engine;
+
+// Each voice of the pool has its own set of oscillators. Since all the
+// members of an Oscillator are static, each voice has to use a different
+// instance of the template.
+template<int n>
+struct PolyVoiceOscillators {
+  typedef Oscillator<kPolyOscillatorBaseId + 3 * n, FULL> Osc1;
+  typedef Oscillator<kPolyOscillatorBaseId + 3 * n + 1, LOW_COMPLEXITY> Osc2;
+  typedef Oscillator<kPolyOscillatorBaseId + 3 * n + 2, SUB_OSCILLATOR> SubOsc;
+
+  static void Setup(const Patch& patch) {
+    Osc1::SetupAlgorithm(patch.osc_shape[0]);
+    Osc2::SetupAlgorithm(patch.osc_shape[1]);
+    SubOsc::SetupAlgorithm(patch.mix_sub_osc_shape);
+  }
+
+  static void Update(uint8_t oscillator, uint8_t parameter, uint8_t note,
+                     uint16_t increment) {
+    if (oscillator == 0) {
+      Osc1::Update(parameter, note, increment);
+      SubOsc::Update(0, note - 12, increment >> 1);
+    } else {
+      Osc2::Update(parameter, note, increment);
+    }
+  }
+
+  static void UpdateFm(uint8_t range) {
+    Osc1::UpdateSecondaryParameter(range);
+  }
+
+  // Same as Voice::Audio, for size samples.
+  static void Render(const Patch& patch, const int8_t* modulation_destinations,
+                     uint8_t* sync_state, uint8_t* buffer, uint8_t size) {
+    PolyVoice* voice = engine.mutable_voice(n);
+    uint8_t sub_osc[kAudioBlockSize];
+    uint8_t noise[kAudioBlockSize];
+    for (uint8_t i = 0; i < size; ++i) {
+      voice->TickOscillatorDecimation();
+      voice->mutable_random()->NextNoiseSample();
+      uint8_t osc_2_signal = Osc2::Render();
+      uint8_t mix = Osc1::Render();
+      switch (patch.osc_option[0]) {
+        case SYNC:
+          {
+            uint8_t phase_msb = Osc1::phase() >> 8;
+            if (phase_msb < *sync_state) {
+              Osc2::ResetPhase();
+            }
+            *sync_state = phase_msb;
+          }
+          // Fall through!
+        case SUM:
+          mix = Mix(
+              mix,
+              osc_2_signal,
+              modulation_destinations[MOD_DST_MIX_BALANCE]);
+          break;
+        case RING_MOD:
+          mix = SignedSignedMulScale8(mix + 128, osc_2_signal + 128) + 128;
+          break;
+        case XOR:
+          mix ^= osc_2_signal;
+          mix += modulation_destinations[MOD_DST_MIX_BALANCE];
+          break;
+      }
+      if (patch.osc_shape[0] != WAVEFORM_VOWEL) {
+        sub_osc[i] = SubOsc::Render();
+        noise[i] = voice->noise_sample();
+      }
+      buffer[i] = mix;
+    }
+    // The sub oscillator and the noise are mixed in afterwards, one block at
+    // a time.
+    if (patch.osc_shape[0] != WAVEFORM_VOWEL) {
+      MixBlock(buffer, sub_osc, modulation_destinations[MOD_DST_MIX_SUB_OSC],
+               size);
+      MixBlock(buffer, noise, modulation_destinations[MOD_DST_MIX_NOISE],
+               size);
+    }
+  }
+
+  static PolyOscillatorBank bank() {
+    PolyOscillatorBank b = { &Setup, &Update, &UpdateFm, &Render };
+    return b;
+  }
+};
+
+// Fills a table with the oscillator banks of voices 0 to n - 1.
+template<int n>
+struct PolyOscillatorBankTable {
+  static void Fill(PolyOscillatorBank* table) {
+    PolyOscillatorBankTable<n - 1>::Fill(table);
+    table[n - 1] = PolyVoiceOscillators<n - 1>::bank();
+  }
+};
+
+template<>
+struct PolyOscillatorBankTable<0> {
+  static void Fill(PolyOscillatorBank*) { }
+};
+
+static PolyOscillatorBank oscillator_banks[kMaxPolyVoices];
+
+/* <static> */
+Patch PolySynthesisEngine::patch_;
+PolyVoice PolySynthesisEngine::voice_[kMaxPolyVoices];
+uint8_t PolySynthesisEngine::num_voices_;
+uint32_t PolySynthesisEngine::clock_;
+NoteStack PolySynthesisEngine::notes_;
+uint8_t PolySynthesisEngine::modulation_sources_[kNumGlobalModulationSources];
+uint32_t PolySynthesisEngine::cpu_budget_;
+uint32_t PolySynthesisEngine::num_stolen_voices_;
+/* </static> */
+
+/* static */
+void PolySynthesisEngine::Init(uint8_t num_voices) {
+  PolyOscillatorBankTable<kMaxPolyVoices>::Fill(oscillator_banks);
+  num_voices_ = num_voices > kMaxPolyVoices ? kMaxPolyVoices : num_voices;
+  notes_.Clear();
+  clock_ = 0;
+  cpu_budget_ = kBlockCycles;
+  num_stolen_voices_ = 0;
+  memset(modulation_sources_, 0, kNumGlobalModulationSources);
+  modulation_sources_[MOD_SRC_PITCH_BEND] = 128;
+  modulation_sources_[MOD_SRC_OFFSET] = 255;
+  for (uint8_t i = 0; i < kMaxPolyVoices; ++i) {
+    voice_[i].Init(i);
+  }
+  // Decoded now rather than at the first use, by whichever voice comes first.
+  UserWavetables::decoded_builtin_wave(kFirstBuiltinWave);
+  ResetPatch();
+}
+
+/* static */
+void PolySynthesisEngine::ResetPatch() {
+  ResourcesManager::Load(empty_patch, 0, &patch_);
+  TouchPatch();
+}
+
+/* static */
+void PolySynthesisEngine::SetParameter(
+    uint8_t parameter_index,
+    uint8_t parameter_value) {
+  uint8_t* base = reinterpret_cast<uint8_t*>(&patch_);
+  base[parameter_index + 1] = parameter_value;
+  TouchPatch();
+}
+
+/* static */
+void PolySynthesisEngine::TouchPatch() {
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    voice_[i].UpdateModulationIncrements(patch_);
+    voice_[i].UpdateOscillatorAlgorithms(patch_);
+  }
+}
+
+/* static */
+PolyVoice* PolySynthesisEngine::FindVoice(uint8_t note) {
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    if (voice_[i].note() == note && !voice_[i].dead()) {
+      return &voice_[i];
+    }
+  }
+  return NULL;
+}
+
+/* static */
+PolyVoice* PolySynthesisEngine::AllocateVoice() {
+  // First choice: a silent voice. Then, the oldest released voice. Then, the
+  // oldest voice.
+  PolyVoice* oldest_released = NULL;
+  PolyVoice* oldest = NULL;
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    PolyVoice* v = &voice_[i];
+    if (v->dead()) {
+      return v;
+    }
+    if (v->released() &&
+        (!oldest_released || v->age() < oldest_released->age())) {
+      oldest_released = v;
+    }
+    if (!oldest || v->age() < oldest->age()) {
+      oldest = v;
+    }
+  }
+  return oldest_released ? oldest_released : oldest;
+}
+
+/* static */
+uint32_t PolySynthesisEngine::load() {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    if (!voice_[i].dead()) {
+      total += voice_[i].cost();
+    }
+  }
+  return total;
+}
+
+// Checks if playing a new note on the candidate voice would exceed the CPU
+// budget, and if so, makes room for it. Returns the voice to use for the new
+// note.
+/* static */
+PolyVoice* PolySynthesisEngine::MakeRoom(PolyVoice* candidate) {
+  // The cost of the new note is estimated from the cost of the voices
+  // currently playing - they use the same patch, thus the same algorithms.
+  uint32_t load = 0;
+  uint32_t estimate = 0;
+  uint8_t num_active_voices = 0;
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    PolyVoice* v = &voice_[i];
+    if (v != candidate && !v->dead()) {
+      load += v->cost();
+      estimate += v->cost() * v->decimation();
+      ++num_active_voices;
+    }
+  }
+  if (!num_active_voices) {
+    return candidate;
+  }
+  estimate /= num_active_voices;
+
+  // First, kill the quietest voices among those which are being released.
+  while (load + estimate > cpu_budget_) {
+    PolyVoice* quietest = NULL;
+    for (uint8_t i = 0; i < num_voices_; ++i) {
+      PolyVoice* v = &voice_[i];
+      if (v != candidate && !v->dead() && v->released() &&
+          (!quietest || v->previous_vca() < quietest->previous_vca())) {
+        quietest = v;
+      }
+    }
+    if (!quietest) {
+      break;
+    }
+    quietest->Kill();
+    load -= quietest->cost();
+    ++num_stolen_voices_;
+  }
+
+  // Then, run the oscillators of the most expensive voices at half the sample
+  // rate.
+  while (load + estimate > cpu_budget_) {
+    PolyVoice* most_expensive = NULL;
+    for (uint8_t i = 0; i < num_voices_; ++i) {
+      PolyVoice* v = &voice_[i];
+      if (v != candidate && !v->dead() && v->decimation() == 1 &&
+          (!most_expensive || v->cost() > most_expensive->cost())) {
+        most_expensive = v;
+      }
+    }
+    if (!most_expensive) {
+      break;
+    }
+    load -= most_expensive->cost();
+    most_expensive->Degrade();
+    load += most_expensive->cost();
+  }
+
+  // As a last resort, steal the oldest voices.
+  while (load + estimate > cpu_budget_) {
+    PolyVoice* oldest = NULL;
+    for (uint8_t i = 0; i < num_voices_; ++i) {
+      PolyVoice* v = &voice_[i];
+      if (v != candidate && !v->dead() &&
+          (!oldest || v->age() < oldest->age())) {
+        oldest = v;
+      }
+    }
+    if (!oldest) {
+      break;
+    }
+    load -= oldest->cost();
+    if (candidate->dead()) {
+      candidate = oldest;
+    } else {
+      oldest->Kill();
+    }
+    ++num_stolen_voices_;
+  }
+  candidate->Restore();
+  return candidate;
+}
+
+/* static */
+void PolySynthesisEngine::NoteOn(uint8_t note, uint8_t velocity) {
+  if (velocity == 0) {
+    NoteOff(note);
+    return;
+  }
+  notes_.NoteOn(note, velocity);
+  PolyVoice* v = FindVoice(note);
+  if (!v) {
+    v = MakeRoom(AllocateVoice());
+  }
+  v->set_age(++clock_);
+  v->Trigger(patch_, note, velocity, 0);
+}
+
+/* static */
+void PolySynthesisEngine::NoteOff(uint8_t note) {
+  notes_.NoteOff(note);
+  PolyVoice* v = FindVoice(note);
+  if (!v) {
+    return;
+  }
+  // As in the monophonic VoiceController, when a key is released, the voice
+  // goes back to the most recently played note that is still held - if this
+  // note had lost its voice because of voice stealing.
+  uint8_t current = notes_.size() ? notes_.most_recent_note().next_ptr : 0;
+  const NoteEntry* entry = notes_.size() ? &notes_.most_recent_note() : NULL;
+  while (entry) {
+    if (!FindVoice(entry->note)) {
+      v->Trigger(patch_, entry->note, entry->velocity, 1);
+      return;
+    }
+    entry = current ? &notes_.note(current) : NULL;
+    current = entry ? entry->next_ptr : 0;
+  }
+  v->Release();
+}
+
+/* static */
+void PolySynthesisEngine::AllNotesOff() {
+  notes_.Clear();
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    voice_[i].Release();
+  }
+}
+
+/* static */
+void PolySynthesisEngine::PitchBend(uint16_t pitch_bend) {
+  modulation_sources_[MOD_SRC_PITCH_BEND] = ShiftRight6(pitch_bend);
+}
+
+/* static */
+void PolySynthesisEngine::ModulationWheel(uint8_t value) {
+  modulation_sources_[MOD_SRC_WHEEL] = value << 1;
+}
+
+/* static */
+void PolySynthesisEngine::Render(float* buffer) {
+  memset(buffer, 0, sizeof(float) * kAudioBlockSize);
+  modulation_sources_[MOD_SRC_RANDOM] = Random::GetByte();
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    voice_[i].Render(patch_, modulation_sources_, buffer);
+  }
+
+  // When there is enough headroom, the degraded voices are restored, one at
+  // a time.
+  uint32_t total = load();
+  for (uint8_t i = 0; i < num_voices_; ++i) {
+    PolyVoice* v = &voice_[i];
+    if (v->decimation() != 1 && !v->dead() &&
+        total + v->cost() < cpu_budget_ - (cpu_budget_ >> 2)) {
+      v->Restore();
+      break;
+    }
+  }
+}
+
+/* --- Random -------------------------------------------------------------- */
+
+void PolyRandom::Init() {
+  rng_state_ = 0x21;
+  noise_state_ = 0x21;
+  noise_index_ = 0;
+  noise_sample_ = 0;
+}
+
+// Same as Random::FillNoiseBuffer.
+void PolyRandom::FillNoiseBuffer() {
+  uint32_t x = noise_state_;
+  uint8_t* sample = noise_buffer_;
+  for (uint8_t i = hardware_utils::kNoiseBufferSize / 4; i > 0; --i) {
+    x ^= x << 8;
+    x ^= x >> 9;
+    x ^= x << 23;
+    *sample++ = x;
+    *sample++ = x >> 8;
+    *sample++ = x >> 16;
+    *sample++ = x >> 24;
+  }
+  noise_state_ = x;
+  noise_index_ = 0;
+}
+
+/* --- Voice --------------------------------------------------------------- */
+
+void PolyVoice::Init(uint8_t index) {
+  index_ = index;
+  oscillators_ = &oscillator_banks[index];
+  note_ = 0;
+  age_ = 0;
+  pitch_value_ = 0;
+  pitch_increment_ = 0;
+  sync_state_ = 0;
+  filter_.lp = filter_.bp = 0.0f;
+  previous_vca_ = 0;
+  cost_ = 0;
+  decimation_ = 1;
+  oscillator_decimation_ = 0;
+  random_.Init();
+  memset(modulation_sources_, 0, kNumVoiceModulationSources);
+  memset(modulation_destinations_, 0, kNumModulationDestinations);
+  for (uint8_t i = 0; i < kNumPolyEnvelopes; ++i) {
+    envelope_[i].Init();
+  }
+  for (uint8_t i = 0; i < kNumPolyLfos; ++i) {
+    lfo_[i].Reset();
+    lfo_value_[i] = 0;
+  }
+  voice_lfo_.Reset();
+  ResetStatistics();
+}
+
+void PolyVoice::TriggerEnvelope(uint8_t stage) {
+  for (uint8_t i = 0; i < kNumPolyEnvelopes; ++i) {
+    envelope_[i].Trigger(stage);
+  }
+}
+
+void PolyVoice::UpdateModulationIncrements(const Patch& patch) {
+  for (uint8_t i = 0; i < kNumPolyLfos; ++i) {
+    // There is no arpeggiator clock in the polyphonic engine, so the
+    // tempo-synced rates are approximated by a 120 BPM clock.
+    uint16_t increment;
+    if (patch.lfo_rate[i] < 16) {
+      increment = 65536 / (
+          (kSampleRate * 60L / kControlRate / 120) * (1 + patch.lfo_rate[i]));
+    } else {
+      increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+          lut_res_lfo_increments, patch.lfo_rate[i] - 16);
+    }
+    lfo_[i].Update(patch.lfo_wave[i], increment);
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+    if (patch.env_multistage & _BV(i)) {
+      envelope_[i].UpdateMultiStage(
+          patch.mseg_level,
+          patch.mseg_time,
+          patch.mseg_loop_start,
+          patch.mseg_loop_end,
+          patch.env_release[i]);
+      continue;
+    }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+    envelope_[i].Update(
+        patch.env_attack[i],
+        patch.env_decay[i],
+        patch.env_sustain[i],
+        patch.env_release[i],
+        patch.env_curve[i]);
+  }
+  voice_lfo_.Update(
+      patch.voice_lfo_wave,
+      ResourcesManager::Lookup<uint16_t, uint8_t>(
+          lut_res_lfo_increments, patch.voice_lfo_rate));
+}
+
+void PolyVoice::UpdateOscillatorAlgorithms(const Patch& patch) {
+  (*oscillators_->setup)(patch);
+}
+
+void PolyVoice::Trigger(const Patch& patch, uint8_t note, uint8_t velocity,
+                        uint8_t legato) {
+  note_ = note;
+  if (patch.kbd_raga) {
+    int16_t pitch_shift = ResourcesManager::Lookup<int16_t, uint8_t>(
+        ResourceId(LUT_RES_SCALE_JUST + patch.kbd_raga - 1),
+        note % 12);
+    if (pitch_shift == 32767) {
+      return;
+    }
+    pitch_target_ = (static_cast<uint16_t>(note) << 7) + pitch_shift;
+  } else {
+    pitch_target_ = (static_cast<uint16_t>(note) << 7);
+  }
+
+  if (!legato || patch.kbd_portamento >= 0) {
+    TriggerEnvelope(ATTACK);
+    modulation_sources_[MOD_SRC_VELOCITY - kNumGlobalModulationSources] =
+        velocity << 1;
+  }
+  if (!legato) {
+    // Each voice has its own LFOs, restarted with each note.
+    for (uint8_t i = 0; i < kNumPolyLfos; ++i) {
+      lfo_[i].Reset();
+    }
+    voice_lfo_.Reset();
+  }
+  if (pitch_value_ == 0 || (!legato && patch.kbd_portamento < 0)) {
+    pitch_value_ = pitch_target_;
+  }
+  int16_t delta = pitch_target_ - pitch_value_;
+  int32_t increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+      lut_res_env_portamento_increments,
+      abs(patch.kbd_portamento));
+  pitch_increment_ = (delta * increment) >> 15;
+  if (pitch_increment_ == 0) {
+    pitch_increment_ = delta < 0 ? -1 : 1;
+  }
+}
+
+// Same as Voice::Control, with per-voice LFOs.
+void PolyVoice::Control(const Patch& patch,
+                        const uint8_t* global_modulation_sources) {
+  for (uint8_t i = 0; i < kNumPolyEnvelopes; ++i) {
+    envelope_[i].Render();
+  }
+  for (uint8_t i = 0; i < kNumPolyLfos; ++i) {
+    lfo_[i].Increment();
+    lfo_value_[i] = lfo_[i].Render(patch, &random_);
+  }
+  voice_lfo_.Increment();
+
+  pitch_value_ += pitch_increment_;
+  if ((pitch_increment_ > 0) ^ (pitch_value_ < pitch_target_)) {
+    pitch_value_ = pitch_target_;
+    pitch_increment_ = 0;
+  }
+
+  int16_t dst[kNumModulationDestinations];
+
+  modulation_sources_[MOD_SRC_ENV_1 - kNumGlobalModulationSources] =
+      ShiftRight6(envelope_[0].value());
+  modulation_sources_[MOD_SRC_ENV_2 - kNumGlobalModulationSources] =
+      ShiftRight6(envelope_[1].value());
+  modulation_sources_[MOD_SRC_NOTE - kNumGlobalModulationSources] =
+      ShiftRight6(pitch_value_);
+  modulation_sources_[MOD_SRC_GATE - kNumGlobalModulationSources] =
+      envelope_[0].stage() >= RELEASE ? 0 : 255;
+  modulation_sources_[MOD_SRC_VOICE_LFO - kNumGlobalModulationSources] =
+      voice_lfo_.Render(patch, &random_);
+
+  modulation_destinations_[MOD_DST_VCA] = 255;
+
+  dst[MOD_DST_FILTER_CUTOFF] = patch.filter_cutoff << 7;
+  dst[MOD_DST_PWM_1] = patch.osc_parameter[0] << 7;
+  dst[MOD_DST_PWM_2] = patch.osc_parameter[1] << 7;
+  dst[MOD_DST_VCO_1_2_FINE] = dst[MOD_DST_VCO_2] = dst[MOD_DST_VCO_1] = 8192;
+  dst[MOD_DST_MIX_BALANCE] = patch.mix_balance << 8;
+  dst[MOD_DST_MIX_NOISE] = patch.mix_noise << 8;
+  dst[MOD_DST_MIX_SUB_OSC] = patch.mix_sub_osc << 8;
+  dst[MOD_DST_FILTER_RESONANCE] = patch.filter_resonance << 8;
+
+  for (uint8_t i = 0; i < kModulationMatrixSize; ++i) {
+    int8_t amount = patch.modulation_matrix.modulation[i].amount;
+    if (!amount) {
+      continue;
+    }
+    if (i == kSavedModulationMatrixSize - 1) {
+      amount = SignedMulScale8(
+          amount,
+          global_modulation_sources[MOD_SRC_WHEEL]);
+    }
+    uint8_t source = patch.modulation_matrix.modulation[i].source;
+    uint8_t destination = patch.modulation_matrix.modulation[i].destination;
+    uint8_t source_value;
+    if (source <= MOD_SRC_LFO_2) {
+      source_value = lfo_value_[source - MOD_SRC_LFO_1];
+    } else if (source < kNumGlobalModulationSources) {
+      source_value = global_modulation_sources[source];
+    } else {
+      source_value = modulation_sources_[source - kNumGlobalModulationSources];
+    }
+    if (destination != MOD_DST_VCA) {
+      int16_t modulation = dst[destination];
+      modulation += SignedUnsignedMul(amount, source_value);
+      if (source <= MOD_SRC_LFO_2 ||
+          source == MOD_SRC_PITCH_BEND ||
+          source == MOD_SRC_NOTE ||
+          source == MOD_SRC_VOICE_LFO) {
+        modulation -= amount << 7;
+      }
+      dst[destination] = Clip(modulation, 0, 16383);
+    } else {
+      if (amount < 0) {
+        amount = -amount;
+        source_value = 255 - source_value;
+      }
+      modulation_destinations_[MOD_DST_VCA] = MulScale8(
+          modulation_destinations_[MOD_DST_VCA],
+          Mix(255, source_value, amount << 2));
+    }
+  }
+  dst[MOD_DST_FILTER_CUTOFF] = Clip(
+      dst[MOD_DST_FILTER_CUTOFF] + SignedUnsignedMul(
+          patch.filter_env,
+          modulation_sources_[MOD_SRC_ENV_1 - kNumGlobalModulationSources]),
+      0,
+      16383);
+  dst[MOD_DST_FILTER_CUTOFF] = Clip(
+      dst[MOD_DST_FILTER_CUTOFF] + SignedUnsignedMul(
+          patch.filter_lfo,
+          lfo_value_[1]) - (patch.filter_lfo << 7),
+      0,
+      16383);
+
+  modulation_destinations_[MOD_DST_FILTER_CUTOFF] = ShiftRight6(
+      dst[MOD_DST_FILTER_CUTOFF]);
+  modulation_destinations_[MOD_DST_FILTER_RESONANCE] = ShiftRight6(
+      dst[MOD_DST_FILTER_RESONANCE]);
+  modulation_destinations_[MOD_DST_PWM_1] = dst[MOD_DST_PWM_1] >> 7;
+  modulation_destinations_[MOD_DST_PWM_2] = dst[MOD_DST_PWM_2] >> 7;
+  modulation_destinations_[MOD_DST_MIX_BALANCE] = ShiftRight6(
+      dst[MOD_DST_MIX_BALANCE]);
+  modulation_destinations_[MOD_DST_MIX_NOISE] = dst[MOD_DST_MIX_NOISE] >> 8;
+  modulation_destinations_[MOD_DST_MIX_SUB_OSC] = dst[MOD_DST_MIX_SUB_OSC] >> 7;
+
+  for (uint8_t i = 0; i < kNumPolyOscillators; ++i) {
+    int16_t pitch = pitch_value_;
+    if (patch.osc_shape[i] == WAVEFORM_FM) {
+      (*oscillators_->update_fm)(patch.osc_range[i] + 12);
+    } else {
+      pitch += static_cast<int16_t>(patch.osc_range[i]) << 7;
+    }
+    pitch += static_cast<int16_t>(patch.kbd_octave) * kOctave;
+    if (i == 1) {
+      pitch += patch.osc_option[1];
+    }
+    pitch += (dst[MOD_DST_VCO_1 + i] - 8192) >> 2;
+    pitch += (dst[MOD_DST_VCO_1_2_FINE] - 8192) >> 4;
+    while (pitch < kLowestNote) {
+      pitch += kOctave;
+    }
+    while (pitch >= kHighestNote) {
+      pitch -= kOctave;
+    }
+    int16_t ref_pitch = pitch - kPitchTableStart;
+    uint8_t num_shifts = 0;
+    while (ref_pitch < 0) {
+      ref_pitch += kOctave;
+      ++num_shifts;
+    }
+    uint16_t increment = ResourcesManager::Lookup<uint16_t, uint16_t>(
+        lut_res_oscillator_increments, ref_pitch >> 1);
+    increment >>= num_shifts;
+    // The highest increment (for note 108) is below 32768, so this does not
+    // overflow.
+    if (decimation_ == 2) {
+      increment <<= 1;
+    }
+    (*oscillators_->update)(
+        i,
+        modulation_destinations_[i == 0 ? MOD_DST_PWM_1 : MOD_DST_PWM_2],
+        pitch >> 7,
+        increment);
+  }
+}
+
+// 2-pole state variable filter (trapezoidal integration), and VCA. The VCA
+// gain is interpolated over the block to avoid zipper noise.
+void PolyVoice::Filter(const float* input, float* output) {
+  float cutoff = kFilterLowestCutoff * powf(
+      2.0f,
+      static_cast<uint8_t>(modulation_destinations_[MOD_DST_FILTER_CUTOFF]) *
+          (10.0f / 256.0f));
+  if (cutoff > kSampleRate * 0.45f) {
+    cutoff = kSampleRate * 0.45f;
+  }
+  float g = tanf(M_PI * cutoff / kSampleRate);
+  float k = 2.0f - 1.95f * static_cast<uint8_t>(
+      modulation_destinations_[MOD_DST_FILTER_RESONANCE]) / 255.0f;
+  float a1 = 1.0f / (1.0f + g * (g + k));
+  float a2 = g * a1;
+  float a3 = g * a2;
+
+  float gain = previous_vca_ / 255.0f;
+  float gain_increment = (vca() - previous_vca_) / (255.0f * kAudioBlockSize);
+  previous_vca_ = vca();
+
+  float ic1 = filter_.bp;
+  float ic2 = filter_.lp;
+  for (uint8_t i = 0; i < kAudioBlockSize; ++i) {
+    float v3 = input[i] - ic2;
+    float v1 = a1 * ic1 + a2 * v3;
+    float v2 = ic2 + a2 * ic1 + a3 * v3;
+    ic1 = 2.0f * v1 - ic1;
+    ic2 = 2.0f * v2 - ic2;
+    gain += gain_increment;
+    output[i] += v2 * gain;
+  }
+  filter_.bp = ic1;
+  filter_.lp = ic2;
+}
+
+void PolyVoice::Render(const Patch& patch,
+                       const uint8_t* global_modulation_sources,
+                       float* buffer) {
+  if (dead() && previous_vca_ == 0) {
+    return;
+  }
+  uint8_t samples[kAudioBlockSize];
+  float signal[kAudioBlockSize];
+  Control(patch, global_modulation_sources);
+  if (dead()) {
+    modulation_destinations_[MOD_DST_VCA] = 0;
+  }
+  uint8_t size = kAudioBlockSize / decimation_;
+  random_.FillNoiseBuffer();
+  (*oscillators_->render)(patch, modulation_destinations_, &sync_state_,
+                          samples, size);
+  if (decimation_ == 2) {
+    for (uint8_t i = kAudioBlockSize; i--; ) {
+      samples[i] = samples[i >> 1];
+    }
+  }
+  for (uint8_t i = 0; i < kAudioBlockSize; ++i) {
+    signal[i] = (static_cast<int16_t>(samples[i]) - 128) / 128.0f;
+  }
+  Filter(signal, buffer);
+
+  cost_ = CycleModel::ControlCycles(patch) + size * CycleModel::AudioCycles(
+      patch,
+      modulation_destinations_[MOD_DST_PWM_1],
+      modulation_destinations_[MOD_DST_PWM_2]);
+  total_cost_ += cost_;
+  ++num_blocks_;
+}
+
+}  // namespace hardware_shruti
@@ -0,0 +1,278 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Polyphonic variant of the synthesis engine, for the desktop build only.
+//
+// The firmware engine is monophonic, and its Voice class and oscillators are
+// "static singletons". Here, a pool of voices is allocated once and for all.
+// Each voice has its own envelopes, LFOs, and oscillators - since oscillators
+// are static templates, each voice of the pool uses a different instance of
+// the Oscillator template, selected by id. The analog filter and VCA of the
+// Shruti-1 are replaced by a digital filter and VCA in each voice.
+//
+// Voices are rendered one block of kAudioBlockSize samples at a time. Besides
+// the patch and the global modulation sources, which are only read, each voice
+// has its own copy of the state the firmware oscillators share: the decimation
+// counter and the noise generator, read by the oscillators through the engine,
+// from their id. The built-in wavetable is decoded once by Init(). Thus, the
+// blocks of the voices can be rendered concurrently - except with the user
+// wavetable shape (HAS_USER_WAVETABLES), whose waves are requested from the
+// cache of UserWavetables, shared by all the voices.
+//
+// The voice allocator is aware of the CPU budget: the cost of each voice is
+// estimated, in ATmega328p cycles, by the CycleModel, and when a new note
+// would bring the total above the number of cycles in a block, room is made
+// by stealing a silent voice, rendering the oscillators of the most expensive
+// voices at half the sample rate, and as a last resort, stealing the oldest
+// voice. The digital filter and VCA, which have no counterpart in the
+// firmware, are not counted.
+//
+// Important: this header must not be included in the same file as
+// synthesis_engine.h - the oscillators expect a global object called "engine"
+// to provide the decimation counter, and in the desktop polyphonic build, this
+// object is the PolySynthesisEngine.
+
+#ifndef HARDWARE_SHRUTI_HOST_POLY_SYNTHESIS_ENGINE_H_
+#define HARDWARE_SHRUTI_HOST_POLY_SYNTHESIS_ENGINE_H_
+
+#include "hardware/shruti/shruti.h"
+
+#include "hardware/shruti/envelope.h"
+#include "hardware/shruti/host/cycle_model.h"
+#include "hardware/shruti/lfo.h"
+#include "hardware/shruti/note_stack.h"
+#include "hardware/shruti/patch.h"
+#include "hardware/utils/random.h"
+
+namespace hardware_shruti {
+
+static const uint8_t kMaxPolyVoices = 32;
+
+// The firmware uses the oscillators with ids 1, 2 and 3. Voice n uses the
+// oscillators with ids kPolyOscillatorBaseId + 3 * n to
+// kPolyOscillatorBaseId + 3 * n + 2.
+static const int kPolyOscillatorBaseId = 16;
+
+// Same as in synthesis_engine.h.
+static const uint8_t kNumPolyLfos = 2;
+static const uint8_t kNumPolyEnvelopes = 2;
+static const uint8_t kNumPolyOscillators = 2;
+
+// Update/render functions of the oscillators of one voice.
+struct PolyOscillatorBank {
+  void (*setup)(const Patch& patch);
+  void (*update)(uint8_t oscillator, uint8_t parameter, uint8_t note,
+                 uint16_t increment);
+  void (*update_fm)(uint8_t range);
+  void (*render)(const Patch& patch, const int8_t* modulation_destinations,
+                 uint8_t* sync_state, uint8_t* buffer, uint8_t size);
+};
+
+// Same generators as hardware_utils::Random, with one instance per voice.
+class PolyRandom {
+ public:
+  PolyRandom() { }
+  void Init();
+
+  uint8_t GetByte() {
+    rng_state_ = (rng_state_ >> 1) ^ (-(rng_state_ & 1) & 0xb400);
+    return static_cast<uint8_t>(rng_state_ >> 8);
+  }
+  void FillNoiseBuffer();
+  void NextNoiseSample() {
+    noise_sample_ = noise_buffer_[noise_index_];
+    noise_index_ = (noise_index_ + 1) & (hardware_utils::kNoiseBufferSize - 1);
+  }
+  uint8_t noise_sample() const { return noise_sample_; }
+
+ private:
+  uint16_t rng_state_;
+  uint32_t noise_state_;
+  uint8_t noise_buffer_[hardware_utils::kNoiseBufferSize];
+  uint8_t noise_index_;
+  uint8_t noise_sample_;
+
+  DISALLOW_COPY_AND_ASSIGN(PolyRandom);
+};
+
+// State of the digital filter replacing the SSM2044 (or whatever you have
+// wired on your board).
+struct PolyFilterState {
+  float lp;
+  float bp;
+};
+
+class PolyVoice {
+ public:
+  PolyVoice() { }
+  void Init(uint8_t index);
+
+  void Trigger(const Patch& patch, uint8_t note, uint8_t velocity,
+               uint8_t legato);
+  void Release() { TriggerEnvelope(RELEASE); }
+  void Kill() { TriggerEnvelope(DEAD); }
+  void TriggerEnvelope(uint8_t stage);
+
+  // Called whenever a parameter of the envelopes/LFOs/oscillators has been
+  // modified.
+  void UpdateModulationIncrements(const Patch& patch);
+  void UpdateOscillatorAlgorithms(const Patch& patch);
+
+  // Renders one block of kAudioBlockSize samples. The output of the voice
+  // (after the filter and VCA) is added to buffer.
+  void Render(const Patch& patch, const uint8_t* global_modulation_sources,
+              float* buffer);
+
+  uint8_t index() const { return index_; }
+  uint8_t note() const { return note_; }
+  uint8_t dead() { return envelope_[1].dead(); }
+  uint8_t released() { return envelope_[1].stage() >= RELEASE; }
+  uint8_t vca() const { return modulation_destinations_[MOD_DST_VCA]; }
+  uint8_t previous_vca() const { return previous_vca_; }
+  uint32_t age() const { return age_; }
+  void set_age(uint32_t age) { age_ = age; }
+
+  // Cycles spent rendering this voice, and number of blocks rendered while it
+  // was active.
+  uint64_t total_cost() const { return total_cost_; }
+  uint32_t num_blocks() const { return num_blocks_; }
+  void ResetStatistics() {
+    total_cost_ = 0;
+    num_blocks_ = 0;
+  }
+
+  // Cycles spent rendering the last block. This tracks the cost of the
+  // algorithms currently used by the voice (a vowel or FM oscillator is more
+  // expensive than a square wave).
+  uint32_t cost() const { return cost_; }
+
+  // When set to 2, the oscillators run at half the sample rate.
+  uint8_t decimation() const { return decimation_; }
+  void Degrade() {
+    decimation_ = 2;
+    cost_ >>= 1;
+  }
+  void Restore() { decimation_ = 1; }
+
+  // Read by the oscillators of the voice, through the engine.
+  uint8_t oscillator_decimation() const { return oscillator_decimation_; }
+  void TickOscillatorDecimation() {
+    oscillator_decimation_ = (oscillator_decimation_ + 1) & 3;
+  }
+  PolyRandom* mutable_random() { return &random_; }
+  uint8_t noise_sample() const { return random_.noise_sample(); }
+
+ private:
+  void Control(const Patch& patch, const uint8_t* global_modulation_sources);
+  void Filter(const float* input, float* output);
+
+  uint8_t index_;
+  const PolyOscillatorBank* oscillators_;
+
+  Envelope envelope_[kNumPolyEnvelopes];
+  Lfo lfo_[kNumPolyLfos];
+  uint8_t lfo_value_[kNumPolyLfos];
+  Lfo voice_lfo_;
+
+  uint8_t note_;
+  uint32_t age_;
+
+  // Same as in the firmware Voice.
+  int16_t pitch_increment_;
+  int16_t pitch_target_;
+  int16_t pitch_value_;
+  uint8_t modulation_sources_[kNumVoiceModulationSources];
+  int8_t modulation_destinations_[kNumModulationDestinations];
+  uint8_t sync_state_;
+
+  PolyFilterState filter_;
+  uint8_t previous_vca_;
+
+  uint64_t total_cost_;
+  uint32_t num_blocks_;
+  uint32_t cost_;
+  uint8_t decimation_;
+
+  uint8_t oscillator_decimation_;
+  PolyRandom random_;
+
+  DISALLOW_COPY_AND_ASSIGN(PolyVoice);
+};
+
+class PolySynthesisEngine {
+ public:
+  PolySynthesisEngine() { }
+  static void Init(uint8_t num_voices);
+
+  static void NoteOn(uint8_t note, uint8_t velocity);
+  static void NoteOff(uint8_t note);
+  static void AllNotesOff();
+  static void PitchBend(uint16_t pitch_bend);
+  static void ModulationWheel(uint8_t value);
+
+  // Renders one block of kAudioBlockSize samples, mixing all the voices.
+  static void Render(float* buffer);
+
+  static void SetParameter(uint8_t parameter_index, uint8_t parameter_value);
+  static void ResetPatch();
+  static void TouchPatch();
+  static inline Patch* mutable_patch() { return &patch_; }
+  static inline const Patch& patch() { return patch_; }
+
+  static uint8_t num_voices() { return num_voices_; }
+  static PolyVoice* mutable_voice(uint8_t i) { return &voice_[i]; }
+  static const PolyVoice& voice(uint8_t i) { return voice_[i]; }
+
+  // Maximum time, in nanoseconds, that can be spent rendering a block. Defaults
+  // to the duration of a block.
+  static void set_cpu_budget(uint32_t budget) { cpu_budget_ = budget; }
+  static uint32_t cpu_budget() { return cpu_budget_; }
+  static uint32_t load();
+  static uint32_t num_stolen_voices() { return num_stolen_voices_; }
+
+  // Read by the oscillators, which use the decimation counter and the noise
+  // source of the voice they belong to.
+  static inline uint8_t oscillator_decimation(uint8_t oscillator_id) {
+    return voice_[(oscillator_id - kPolyOscillatorBaseId) / 3].
+        oscillator_decimation();
+  }
+  static inline uint8_t noise_sample(uint8_t oscillator_id) {
+    return voice_[(oscillator_id - kPolyOscillatorBaseId) / 3].noise_sample();
+  }
+
+ private:
+  static PolyVoice* FindVoice(uint8_t note);
+  static PolyVoice* AllocateVoice();
+  static PolyVoice* MakeRoom(PolyVoice* candidate);
+
+  static Patch patch_;
+  static PolyVoice voice_[kMaxPolyVoices];
+  static uint8_t num_voices_;
+  static uint32_t clock_;
+  static NoteStack notes_;
+  static uint8_t modulation_sources_[kNumGlobalModulationSources];
+  static uint32_t cpu_budget_;
+  static uint32_t num_stolen_voices_;
+
+  DISALLOW_COPY_AND_ASSIGN(PolySynthesisEngine);
+};
+
+extern PolySynthesisEngine engine;
+
+}  // namespace hardware_shruti
+
+#endif  // HARDWARE_SHRUTI_HOST_POLY_SYNTHESIS_ENGINE_H_
@@ -0,0 +1,199 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// The Shruti-1 board around the simulated chip.
+
+#include <stdio.h>
+
+#include "hardware/shruti/host/simulated_shruti.h"
+
+#include "hardware/hal/init_atmega.h"
+#include "hardware/shruti/editor.h"
+
+using namespace hardware_hal;
+
+using hardware_utils::Task;
+
+namespace hardware_shruti {
+
+static const uint32_t kBlockCycles = kAudioBlockSize * (F_CPU / kSampleRate);
+static const uint16_t kEmptySlotCost = 20;
+static const uint16_t kIdleAudioRenderingCost = 40;
+
+static const TaskCost task_costs[] = {
+  { &AudioRenderingTask, 0 },  // See audio_load_.
+  { &MidiTask, 120 },
+  { &UpdateLedsTask, 450 },
+  { &UpdateDisplayTask, 250 },
+  { &AudioGlitchMonitoringTask, 30 },
+  { &InputTask, 1500 },
+  { &CvTask, 80 },
+};
+
+/* <static> */
+uint16_t SimulatedShruti::pots_[kNumEditingPots];
+uint8_t SimulatedShruti::switches_[kNumSwitches];
+uint8_t SimulatedShruti::input_mux_value_;
+uint8_t SimulatedShruti::audio_load_ = 60;
+SimulatedShiftRegister SimulatedShruti::input_mux_;
+SimulatedShiftRegister SimulatedShruti::leds_;
+SoftwareSerialReceiver SimulatedShruti::lcd_line_;
+uint16_t SimulatedShruti::led_history_[16];
+uint8_t SimulatedShruti::led_history_ptr_;
+ByteCallback SimulatedShruti::lcd_callback_ = NULL;
+VirtualClockCallback SimulatedShruti::tick_callback_ = NULL;
+/* </static> */
+
+/* static */
+void SimulatedShruti::Init() {
+  SimulatedGpio::Init();
+  VirtualClock::Init();
+  VirtualClock::set_tick_callback(&OnTick);
+  input_mux_.Init(kPinClk, kPinData, kPinInputLatch, &OnInputMuxLatched);
+  leds_.Init(kPinClk, kPinData, kPinOutputLatch, &OnLedsLatched);
+  lcd_line_.Init(kPinLcdTx, kMainTimerRate / kDisplayBaudRate, &OnLcdByte);
+#ifdef HAS_DAC_AUDIO_OUTPUT
+  SimulatedSpiDac::Init(kPinDacSlaveSelect);
+#endif  // HAS_DAC_AUDIO_OUTPUT
+  SimulatedEeprom::Erase();
+  for (uint8_t i = 0; i < kNumSwitches; ++i) {
+    switches_[i] = 0;
+  }
+  UpdateMultiplexer();
+}
+
+/* static */
+void SimulatedShruti::Boot() {
+  // Same as the main() of the firmware, with control regained between tasks.
+  InitAtmega(false);
+  ::Init();
+}
+
+/* static */
+const Task* SimulatedShruti::Step() {
+  // The cost of the audio rendering task depends on whether a block has
+  // been rendered.
+  uint8_t rendering = Audio::writable_block();
+  const Task* task = scheduler.Step();
+  VirtualClock::Advance(EstimatedCost(task, rendering));
+  return task;
+}
+
+/* static */
+void SimulatedShruti::RunUntil(uint32_t milliseconds) {
+  while (VirtualClock::milliseconds() < milliseconds) {
+    Step();
+  }
+}
+
+/* static */
+void SimulatedShruti::set_pot(uint8_t index, uint16_t value) {
+  pots_[index] = value;
+  UpdateMultiplexer();
+}
+
+/* static */
+void SimulatedShruti::set_switch(uint8_t index, uint8_t pressed) {
+  switches_[index] = pressed;
+  UpdateMultiplexer();
+}
+
+/* static */
+uint8_t SimulatedShruti::led_brightness(uint8_t index) {
+  uint8_t brightness = 0;
+  for (uint8_t i = 0; i < 16; ++i) {
+    if (led_history_[i] & (1 << index)) {
+      ++brightness;
+    }
+  }
+  return brightness;
+}
+
+/* static */
+void SimulatedShruti::Dump() {
+  printf("t = %d ms\n", VirtualClock::milliseconds());
+  SimulatedSerialLcd::Print(stdout);
+  printf("leds:");
+  for (uint8_t i = 0; i < kNumPages; ++i) {
+    printf(" %2d", led_brightness(i));
+  }
+  printf("\n");
+  printf("cutoff: %d resonance: %d vca: %d\n", OCR1A, OCR1B, OCR2A);
+}
+
+// The multiplexer connects the pot and switch selected by the input shift
+// register to the ADC and digital input.
+/* static */
+void SimulatedShruti::UpdateMultiplexer() {
+  uint8_t digital = input_mux_value_ & 0x07;
+  uint8_t analog = (input_mux_value_ >> 3) & 0x07;
+  // Switches are active low.
+  SimulatedGpio::set_input(
+      kPinDigitalInput,
+      digital < kNumSwitches ? !switches_[digital] : 1);
+  SimulatedAdc::set_value(
+      kPinAnalogInput,
+      analog < kNumEditingPots ? pots_[analog] : 0);
+}
+
+/* static */
+void SimulatedShruti::OnInputMuxLatched(uint16_t value) {
+  input_mux_value_ = value;
+  UpdateMultiplexer();
+}
+
+/* static */
+void SimulatedShruti::OnLedsLatched(uint16_t value) {
+  led_history_[led_history_ptr_] = value;
+  led_history_ptr_ = (led_history_ptr_ + 1) & 15;
+}
+
+/* static */
+void SimulatedShruti::OnLcdByte(uint8_t value) {
+  SimulatedSerialLcd::Receive(value);
+  if (lcd_callback_) {
+    (*lcd_callback_)(value);
+  }
+}
+
+/* static */
+void SimulatedShruti::OnTick() {
+  lcd_line_.Tick();
+  if (tick_callback_) {
+    (*tick_callback_)();
+  }
+}
+
+/* static */
+uint16_t SimulatedShruti::EstimatedCost(const Task* task, uint8_t rendering) {
+  if (!task) {
+    return kEmptySlotCost;
+  }
+  if (task->code == &AudioRenderingTask) {
+    return rendering ? kBlockCycles * audio_load_ / 100 :
+        kIdleAudioRenderingCost;
+  }
+  for (uint8_t i = 0; i < sizeof(task_costs) / sizeof(TaskCost); ++i) {
+    if (task_costs[i].code == task->code) {
+      return task_costs[i].cycles;
+    }
+  }
+  return 0;
+}
+
+}  // namespace hardware_shruti
@@ -0,0 +1,142 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// The Shruti-1 board around the simulated chip, for the desktop tools running
+// the firmware: the editing pots and switches behind the input multiplexer,
+// the LED shift register, the serial LCD, and the MIDI port. The tasks of
+// shruti.cc are run one scheduler slot at a time, and the virtual clock is
+// advanced, after each task, by an estimate of its cost on the chip.
+
+#ifndef HARDWARE_SHRUTI_HOST_SIMULATED_SHRUTI_H_
+#define HARDWARE_SHRUTI_HOST_SIMULATED_SHRUTI_H_
+
+#include "hardware/base/base.h"
+#include "hardware/hal/audio_output.h"
+#include "hardware/hal/devices/mcp492x.h"
+#include "hardware/hal/gpio.h"
+#include "hardware/hal/host/peripherals.h"
+#include "hardware/hal/host/virtual_clock.h"
+#include "hardware/shruti/shruti.h"
+#include "hardware/utils/task.h"
+
+// Defined in shruti.cc, compiled with its main() renamed.
+extern hardware_utils::NaiveScheduler<
+    hardware_shruti::kSchedulerNumSlots> scheduler;
+void Init();
+void AudioRenderingTask();
+void MidiTask();
+void UpdateLedsTask();
+void UpdateDisplayTask();
+void AudioGlitchMonitoringTask();
+void InputTask();
+void CvTask();
+
+namespace hardware_shruti {
+
+static const uint8_t kNumSwitches = kNumGroupSwitches + 2;
+static const uint32_t kCyclesPerMillisecond = F_CPU / 1000;
+
+// Same type as the audio output of shruti.cc.
+#ifdef HAS_DAC_AUDIO_OUTPUT
+typedef hardware_hal::AudioOutput<
+    hardware_hal::StreamingDac<kPinDacSlaveSelect>,
+    kAudioBufferSize, kAudioBlockSize> Audio;
+#else
+typedef hardware_hal::AudioOutput<
+    hardware_hal::PwmOutput<kPinVcoOut>,
+    kAudioBufferSize, kAudioBlockSize> Audio;
+#endif  // HAS_DAC_AUDIO_OUTPUT
+
+// Estimated cost, in CPU cycles, of a task. The time spent waiting for the
+// peripherals (ADC conversions, UART) is not included, since it is simulated.
+struct TaskCost {
+  void (*code)();
+  uint16_t cycles;
+};
+
+class SimulatedShruti {
+ public:
+  SimulatedShruti() { }
+
+  // Wires the simulated peripherals. The EEPROM is erased.
+  static void Init();
+
+  // Runs the initialization code of the firmware.
+  static void Boot();
+
+  // Runs the task in the next slot of the scheduler, and advances the virtual
+  // clock by its estimated cost. Returns the task, or NULL for an empty slot.
+  static const hardware_utils::Task* Step();
+
+  // Runs the firmware until the virtual clock reaches the given time.
+  static void RunUntil(uint32_t milliseconds);
+
+  static void set_pot(uint8_t index, uint16_t value);
+  static void set_switch(uint8_t index, uint8_t pressed);
+  static uint16_t pot(uint8_t index) { return pots_[index]; }
+
+  // Fraction (in %) of a block duration spent rendering a block of audio.
+  static void set_audio_load(uint8_t audio_load) { audio_load_ = audio_load; }
+
+  // Called with each byte received by the LCD, after it has been processed.
+  static void set_lcd_callback(hardware_hal::ByteCallback callback) {
+    lcd_callback_ = callback;
+  }
+
+  // Called at the main timer rate.
+  static void set_tick_callback(hardware_hal::VirtualClockCallback callback) {
+    tick_callback_ = callback;
+  }
+
+  // Brightness (0 to 16) of a LED, averaged over the last 16 refreshes.
+  static uint8_t led_brightness(uint8_t index);
+
+  // Prints the LCD, LEDs and PWM outputs.
+  static void Dump();
+
+ private:
+  static void UpdateMultiplexer();
+  static void OnInputMuxLatched(uint16_t value);
+  static void OnLedsLatched(uint16_t value);
+  static void OnLcdByte(uint8_t value);
+  static void OnTick();
+  static uint16_t EstimatedCost(const hardware_utils::Task* task,
+                                uint8_t rendering);
+
+  static uint16_t pots_[kNumEditingPots];
+  static uint8_t switches_[kNumSwitches];
+  static uint8_t input_mux_value_;
+  static uint8_t audio_load_;
+
+  static hardware_hal::SimulatedShiftRegister input_mux_;
+  static hardware_hal::SimulatedShiftRegister leds_;
+  static hardware_hal::SoftwareSerialReceiver lcd_line_;
+
+  // Latched values of the LED shift register, for the last 16 updates.
+  static uint16_t led_history_[16];
+  static uint8_t led_history_ptr_;
+
+  static hardware_hal::ByteCallback lcd_callback_;
+  static hardware_hal::VirtualClockCallback tick_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedShruti);
+};
+
+}  // namespace hardware_shruti
+
+#endif  // HARDWARE_SHRUTI_HOST_SIMULATED_SHRUTI_H_
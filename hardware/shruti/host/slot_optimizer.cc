@@ -0,0 +1,745 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// Offline optimizer for the slot table of the scheduler in shruti.cc.
+//
+// The tasks of the firmware are replaced by a statistical model: the cost of
+// each call is drawn from a list of measured values, and the load they have to
+// absorb is described by arrival rates - MIDI bytes, knob moves, characters
+// updated on the LCD. The model tracks:
+//
+// - the audio buffer, drained at the sample rate by the timer interrupt, and
+// filled by one block every time the audio task finds room for it ;
+// - the MIDI input buffer (kSerialInputBufferSize bytes), filled by the
+// receive interrupt, which steals some cycles from the task running when a
+// byte arrives, and emptied by the MIDI task. When kMidiBacklogThreshold
+// bytes are waiting, the LED and LCD tasks run the MIDI task instead. Bytes
+// arriving while the buffer is full are lost ;
+// - the pots, read one after the other by every other call of the input task,
+// the other call refreshing the editor page (which marks the value on the LCD
+// as modified) ;
+// - the scan of the LCD by the display task, one character per call, and the
+// transmission of the modified characters at 2400 bps ;
+// - the time between two calls of each task.
+//
+// Starting from the current table, a local search adds, removes, or moves
+// slots between tasks, until no change improves the score. Audio underruns,
+// lost MIDI bytes, and tasks called less often than required weigh much more
+// than the 99th percentile of the MIDI, knob-to-parameter and LCD latencies,
+// which are counted relative to their value with the current table. The same
+// random sequence is used for each evaluation.
+//
+// Usage: slot_optimizer [-c model.txt] [-t simulated_seconds]
+//
+// The model file overrides the default values, with one setting per line:
+//
+// cost <name> <cycles> [<cycles>...]   Measured costs of a task, in cycles.
+//                                      Names: audio (rendering a block),
+//                                      audio_idle, midi (without any byte to
+//                                      read), midi_byte (per byte read),
+//                                      leds, display, glitch, input, cv,
+//                                      empty (empty slot).
+// interrupt <cycles>                   Cost of the timer interrupt handler.
+// rx_interrupt <cycles>                Cost of the UART receive interrupt
+//                                      handler, per byte.
+// rate midi|knob|display <per second>  MIDI bytes, pot moves, and characters
+//                                      modified on the LCD by anything else
+//                                      than the pots.
+// period <task> <ms>                   Maximum time between two calls.
+// weight midi|knob|display <weight>    Weight of a latency in the score.
+//
+// The result is printed as the tasks_[] array of shruti.cc, with a report on
+// the predicted latencies and the headroom of each task.
+
+#include <avr/io.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/hal/serial.h"
+#include "hardware/shruti/shruti.h"
+
+using namespace hardware_hal;
+using namespace hardware_shruti;
+
+enum TaskId {
+  TASK_AUDIO,
+  TASK_MIDI,
+  TASK_LEDS,
+  TASK_DISPLAY,
+  TASK_GLITCH,
+  TASK_INPUT,
+  TASK_CV,
+  TASK_LAST
+};
+
+enum CostId {
+  COST_AUDIO,
+  COST_AUDIO_IDLE,
+  COST_MIDI,
+  COST_MIDI_BYTE,
+  COST_LEDS,
+  COST_DISPLAY,
+  COST_GLITCH,
+  COST_INPUT,
+  COST_CV,
+  COST_EMPTY,
+  COST_LAST
+};
+
+enum LatencyId {
+  LATENCY_MIDI,
+  LATENCY_KNOB,
+  LATENCY_DISPLAY,
+  LATENCY_LAST
+};
+
+static const char* task_names[] = {
+  "audio", "midi", "leds", "display", "glitch", "input", "cv"
+};
+
+static const char* task_functions[] = {
+  "AudioRenderingTask", "MidiTask", "UpdateLedsTask", "UpdateDisplayTask",
+  "AudioGlitchMonitoringTask", "InputTask", "CvTask"
+};
+
+static const char* cost_names[] = {
+  "audio", "audio_idle", "midi", "midi_byte", "leds", "display", "glitch",
+  "input", "cv", "empty"
+};
+
+static const char* latency_names[] = { "midi", "knob", "display" };
+
+// The table currently used by shruti.cc.
+static const uint8_t current_weights[] = { 16, 6, 4, 2, 1, 2, 1 };
+
+static const uint8_t kMaxCostSamples = 64;
+static const uint16_t kMaxLatencySamples = 32768;
+static const uint16_t kSamplePeriod = F_CPU / kSampleRate;
+static const uint32_t kMidiByteDuration = F_CPU / 3125;
+static const uint32_t kLcdByteDuration = F_CPU / (kDisplayBaudRate / 10);
+static const uint8_t kLcdBufferSize = kLcdWidth * kLcdHeight;
+static const uint8_t kLcdOutputBufferSize = 8;
+// Number of characters modified on the LCD when a pot is moved.
+static const uint8_t kKnobDisplayCharacters = 4;
+static const uint32_t kRandomSeed = 0x2a2a2a2a;
+
+struct CostDistribution {
+  uint16_t samples[kMaxCostSamples];
+  uint8_t num_samples;
+};
+
+struct LatencySamples {
+  uint32_t values[kMaxLatencySamples];
+  uint16_t num_values;
+};
+
+struct Statistics {
+  uint64_t duration;
+  uint32_t num_runs[TASK_LAST];
+  uint64_t busy_cycles[TASK_LAST];
+  uint32_t max_interval[TASK_LAST];
+  uint64_t idle_cycles;
+  uint32_t num_underruns;
+  double min_audio_level;
+  uint32_t num_midi_bytes;
+  uint32_t num_lost_midi_bytes;
+  LatencySamples latency[LATENCY_LAST];
+};
+
+// ---- Model ------------------------------------------------------------------
+
+static CostDistribution costs[COST_LAST];
+static uint16_t interrupt_cost = 60;
+static uint16_t rx_interrupt_cost = 80;
+static double rates[LATENCY_LAST] = { 500.0, 20.0, 40.0 };
+static double weights[LATENCY_LAST] = { 1.0, 1.0, 1.0 };
+// Maximum time between two calls, in ms. 0 when there is no requirement. The
+// MIDI task has none: the bytes it loses are counted instead.
+static double periods[TASK_LAST] = {
+  0.0, 0.0, 2.0, 10.0, 100.0, 20.0, 10.0
+};
+
+static void SetCosts(uint8_t id, const uint16_t* values, uint8_t num_values) {
+  for (uint8_t i = 0; i < num_values; ++i) {
+    costs[id].samples[i] = values[i];
+  }
+  costs[id].num_samples = num_values;
+}
+
+// The defaults match the estimates of the firmware simulator, with some
+// spread. The ADC conversions (13 ADC cycles, with a prescaler of 128) are
+// included in the cost of the input and CV tasks.
+static void InitDefaultModel() {
+  static const uint16_t audio[] = { 8192, 9830, 11469 };
+  static const uint16_t audio_idle[] = { 40 };
+  static const uint16_t midi[] = { 60 };
+  static const uint16_t midi_byte[] = { 200 };
+  static const uint16_t leds[] = { 450 };
+  static const uint16_t display[] = { 150, 250, 400 };
+  static const uint16_t glitch[] = { 30 };
+  static const uint16_t input[] = { 1500, 2000, 3200 };
+  static const uint16_t cv[] = { 1750 };
+  static const uint16_t empty[] = { 20 };
+  SetCosts(COST_AUDIO, audio, 3);
+  SetCosts(COST_AUDIO_IDLE, audio_idle, 1);
+  SetCosts(COST_MIDI, midi, 1);
+  SetCosts(COST_MIDI_BYTE, midi_byte, 1);
+  SetCosts(COST_LEDS, leds, 1);
+  SetCosts(COST_DISPLAY, display, 3);
+  SetCosts(COST_GLITCH, glitch, 1);
+  SetCosts(COST_INPUT, input, 3);
+  SetCosts(COST_CV, cv, 1);
+  SetCosts(COST_EMPTY, empty, 1);
+}
+
+static int8_t FindName(const char* name, const char** names, uint8_t size) {
+  for (uint8_t i = 0; i < size; ++i) {
+    if (!strcmp(name, names[i])) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static uint8_t LoadModel(const char* file_name) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    return 0;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    char keyword[16];
+    char name[16];
+    int offset;
+    double value;
+    if (line[0] == '#' || sscanf(line, "%15s %n", keyword, &offset) < 1) {
+      continue;
+    }
+    const char* arguments = line + offset;
+    int8_t id = -1;
+    if (!strcmp(keyword, "cost") &&
+        sscanf(arguments, "%15s %n", name, &offset) == 1 &&
+        (id = FindName(name, cost_names, COST_LAST)) != -1) {
+      arguments += offset;
+      int cycles;
+      int n;
+      costs[id].num_samples = 0;
+      while (costs[id].num_samples < kMaxCostSamples &&
+             sscanf(arguments, "%d %n", &cycles, &n) == 1) {
+        costs[id].samples[costs[id].num_samples++] = cycles;
+        arguments += n;
+      }
+      if (!costs[id].num_samples) {
+        id = -1;
+      }
+    } else if (!strcmp(keyword, "interrupt") &&
+               sscanf(arguments, "%lf", &value) == 1) {
+      interrupt_cost = value;
+      id = 0;
+    } else if (!strcmp(keyword, "rx_interrupt") &&
+               sscanf(arguments, "%lf", &value) == 1) {
+      rx_interrupt_cost = value;
+      id = 0;
+    } else if (!strcmp(keyword, "rate") &&
+               sscanf(arguments, "%15s %lf", name, &value) == 2 &&
+               (id = FindName(name, latency_names, LATENCY_LAST)) != -1) {
+      rates[id] = value;
+    } else if (!strcmp(keyword, "period") &&
+               sscanf(arguments, "%15s %lf", name, &value) == 2 &&
+               (id = FindName(name, task_names, TASK_LAST)) != -1) {
+      periods[id] = value;
+    } else if (!strcmp(keyword, "weight") &&
+               sscanf(arguments, "%15s %lf", name, &value) == 2 &&
+               (id = FindName(name, latency_names, LATENCY_LAST)) != -1) {
+      weights[id] = value;
+    }
+    if (id == -1) {
+      fprintf(stderr, "Invalid model line: %s", line);
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+// ---- Simulation -------------------------------------------------------------
+
+static uint32_t rng_state;
+
+static inline uint32_t Random() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static inline uint16_t DrawCost(uint8_t id) {
+  return costs[id].samples[Random() % costs[id].num_samples];
+}
+
+// Time, in cycles, until the next event of a Poisson process.
+static inline uint64_t DrawInterval(double rate) {
+  if (rate <= 0.0) {
+    return 0xffffffffffffULL;
+  }
+  double u = (Random() + 1.0) / 4294967297.0;
+  return 1 + static_cast<uint64_t>(-log(u) / rate * F_CPU);
+}
+
+static inline void AddLatency(LatencySamples* samples, uint64_t latency) {
+  if (samples->num_values < kMaxLatencySamples) {
+    samples->values[samples->num_values++] = latency;
+  }
+}
+
+// Same slot allocation as NaiveScheduler::Init(), with task ids starting at 1.
+static void BuildSlotTable(const uint8_t* task_weights, uint8_t* slots) {
+  uint8_t slot = 0;
+  memset(slots, 0, kSchedulerNumSlots);
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    for (uint8_t j = 0; j < task_weights[i]; ++j) {
+      while (1) {
+        if (slot >= kSchedulerNumSlots) {
+          slot = 0;
+        }
+        if (slots[slot] == 0) {
+          break;
+        }
+        ++slot;
+      }
+      slots[slot] = i + 1;
+      slot += kSchedulerNumSlots / task_weights[i];
+    }
+  }
+}
+
+static void Simulate(const uint8_t* task_weights, uint32_t duration,
+                     Statistics* statistics) {
+  uint8_t slots[kSchedulerNumSlots];
+  BuildSlotTable(task_weights, slots);
+  memset(statistics, 0, sizeof(Statistics));
+  rng_state = kRandomSeed;
+
+  uint64_t now = 0;
+  uint64_t end = static_cast<uint64_t>(duration) * F_CPU;
+  uint64_t last_run[TASK_LAST];
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    last_run[i] = 0;
+  }
+
+  double audio_level = kAudioBufferSize;
+  statistics->min_audio_level = audio_level;
+
+  // Arrival times of the bytes in the MIDI input buffer. As with the ring
+  // buffer of the firmware, one entry is always left free.
+  uint64_t midi_buffer[kSerialInputBufferSize];
+  uint8_t midi_buffer_size = 0;
+  uint64_t next_midi_byte = DrawInterval(rates[LATENCY_MIDI]);
+
+  // Time at which each pot has been moved, 0 if it has not.
+  uint64_t pot_moves[kNumEditingPots];
+  uint64_t next_pot_move = DrawInterval(rates[LATENCY_KNOB]);
+  uint8_t input_phase = 0;
+  uint8_t active_pot = 0;
+  uint64_t pot_read = 0;
+  memset(pot_moves, 0, sizeof(pot_moves));
+
+  // Time at which each character of the LCD has been modified, 0 if it is
+  // up to date.
+  uint64_t lcd[kLcdBufferSize];
+  uint64_t next_lcd_update = DrawInterval(rates[LATENCY_DISPLAY]);
+  uint8_t scan_position = 0;
+  uint8_t last_write_position = 0xff;
+  uint64_t lcd_busy_until = 0;
+  memset(lcd, 0, sizeof(lcd));
+
+  uint8_t slot = 0;
+  while (now < end) {
+    // Process the arrivals up to the beginning of the task. The MIDI bytes are
+    // received by the interrupt handler, while the previous task runs.
+    while (next_pot_move <= now) {
+      uint64_t* pot = &pot_moves[Random() % kNumEditingPots];
+      if (!*pot) {
+        *pot = next_pot_move;
+      }
+      next_pot_move += DrawInterval(rates[LATENCY_KNOB]);
+    }
+    while (next_lcd_update <= now) {
+      uint64_t* character = &lcd[Random() % kLcdBufferSize];
+      if (!*character) {
+        *character = next_lcd_update;
+      }
+      next_lcd_update += DrawInterval(rates[LATENCY_DISPLAY]);
+    }
+
+    slot = slot + 1 >= kSchedulerNumSlots ? 0 : slot + 1;
+    uint32_t cost = 0;
+    uint8_t rendering = 0;
+    int8_t task = slots[slot] - 1;
+    if ((task == TASK_LEDS || task == TASK_DISPLAY) &&
+        midi_buffer_size >= kMidiBacklogThreshold) {
+      task = TASK_MIDI;
+    }
+    switch (task) {
+      case -1:
+        cost = DrawCost(COST_EMPTY);
+        break;
+
+      case TASK_AUDIO:
+        rendering = audio_level <= kAudioBufferSize - kAudioBlockSize;
+        if (rendering) {
+          cost = DrawCost(COST_AUDIO);
+        } else {
+          cost = DrawCost(COST_AUDIO_IDLE);
+        }
+        break;
+
+      case TASK_MIDI:
+        cost = DrawCost(COST_MIDI);
+        for (uint8_t i = 0; i < midi_buffer_size; ++i) {
+          AddLatency(&statistics->latency[LATENCY_MIDI], now - midi_buffer[i]);
+          cost += DrawCost(COST_MIDI_BYTE);
+        }
+        midi_buffer_size = 0;
+        break;
+
+      case TASK_INPUT:
+        cost = DrawCost(COST_INPUT);
+        if (input_phase == 0) {
+          // The editor sees the new value at the end of the call.
+          pot_read = pot_moves[active_pot];
+          pot_moves[active_pot] = 0;
+          active_pot = active_pot + 1 >= kNumEditingPots ? 0 : active_pot + 1;
+        } else if (pot_read) {
+          // The editor refreshes the value shown on the second line.
+          for (uint8_t i = 0; i < kKnobDisplayCharacters; ++i) {
+            uint64_t* character = &lcd[kLcdWidth + (Random() % kLcdWidth)];
+            if (!*character) {
+              *character = pot_read;
+            }
+          }
+          pot_read = 0;
+        }
+        break;
+
+      case TASK_DISPLAY:
+        cost = DrawCost(COST_DISPLAY);
+        break;
+
+      case TASK_LEDS:
+        cost = DrawCost(COST_LEDS);
+        break;
+
+      case TASK_GLITCH:
+        cost = DrawCost(COST_GLITCH);
+        break;
+
+      case TASK_CV:
+        cost = DrawCost(COST_CV);
+        break;
+    }
+
+    // The timer interrupt steals some time from the task.
+    uint32_t elapsed = static_cast<uint64_t>(cost) * kSamplePeriod /
+        (kSamplePeriod - interrupt_cost);
+    // And so does the receive interrupt, for each MIDI byte arriving during
+    // the task.
+    while (next_midi_byte <= now + elapsed) {
+      if (midi_buffer_size < kSerialInputBufferSize - 1) {
+        midi_buffer[midi_buffer_size++] = next_midi_byte;
+      } else {
+        ++statistics->num_lost_midi_bytes;
+      }
+      ++statistics->num_midi_bytes;
+      elapsed += rx_interrupt_cost;
+      uint64_t interval = DrawInterval(rates[LATENCY_MIDI]);
+      next_midi_byte += interval < kMidiByteDuration ? kMidiByteDuration :
+          interval;
+    }
+    audio_level -= static_cast<double>(elapsed) / kSamplePeriod;
+    if (audio_level < 0.0) {
+      ++statistics->num_underruns;
+      audio_level = 0.0;
+    }
+    if (audio_level < statistics->min_audio_level) {
+      statistics->min_audio_level = audio_level;
+    }
+
+    if (task == -1) {
+      statistics->idle_cycles += elapsed;
+    } else {
+      uint64_t interval = now - last_run[task];
+      if (interval > statistics->max_interval[task]) {
+        statistics->max_interval[task] = interval;
+      }
+      last_run[task] = now;
+      ++statistics->num_runs[task];
+      statistics->busy_cycles[task] += elapsed;
+    }
+    now += elapsed;
+
+    if (task == TASK_AUDIO) {
+      // The block is complete at the end of the call.
+      if (rendering) {
+        audio_level += kAudioBlockSize;
+      } else {
+        statistics->idle_cycles += elapsed;
+      }
+    } else if (task == TASK_INPUT) {
+      if (input_phase == 0 && pot_read) {
+        AddLatency(&statistics->latency[LATENCY_KNOB], now - pot_read);
+      }
+      input_phase ^= 1;
+    } else if (task == TASK_DISPLAY) {
+      // Nothing is done when there is not enough room in the output buffer.
+      uint32_t queued = lcd_busy_until > now ?
+          (lcd_busy_until - now + kLcdByteDuration - 1) / kLcdByteDuration : 0;
+      if (queued + 3 <= kLcdOutputBufferSize) {
+        if (lcd[scan_position]) {
+          uint8_t num_bytes = (scan_position == last_write_position + 1 &&
+              (scan_position % kLcdWidth)) ? 1 : 3;
+          lcd_busy_until = (lcd_busy_until > now ? lcd_busy_until : now) +
+              num_bytes * kLcdByteDuration;
+          AddLatency(&statistics->latency[LATENCY_DISPLAY],
+                     lcd_busy_until - lcd[scan_position]);
+          lcd[scan_position] = 0;
+          last_write_position = scan_position;
+        }
+        scan_position = scan_position + 1 >= kLcdBufferSize ?
+            0 : scan_position + 1;
+      }
+    }
+  }
+  statistics->duration = now;
+}
+
+// ---- Search -----------------------------------------------------------------
+
+static int CompareLatencies(const void* a, const void* b) {
+  uint32_t x = *static_cast<const uint32_t*>(a);
+  uint32_t y = *static_cast<const uint32_t*>(b);
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Nearest-rank percentile, in ms. The samples are sorted in place.
+static double Percentile(LatencySamples* samples, uint8_t percent) {
+  if (!samples->num_values) {
+    return 0.0;
+  }
+  qsort(samples->values, samples->num_values, sizeof(uint32_t),
+        &CompareLatencies);
+  uint32_t rank = (static_cast<uint32_t>(samples->num_values) * percent +
+                   99) / 100;
+  if (rank) {
+    --rank;
+  }
+  return samples->values[rank] * 1000.0 / F_CPU;
+}
+
+static inline double Milliseconds(uint64_t num_cycles) {
+  return num_cycles * 1000.0 / F_CPU;
+}
+
+static double Score(Statistics* statistics, const double* reference) {
+  double score = 1000.0 * (statistics->num_underruns +
+                           statistics->num_lost_midi_bytes);
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    double interval = Milliseconds(statistics->max_interval[i]);
+    if (periods[i] > 0.0 && interval > periods[i]) {
+      score += 100.0 * interval / periods[i];
+    }
+  }
+  for (uint8_t i = 0; i < LATENCY_LAST; ++i) {
+    double latency = Percentile(&statistics->latency[i], 99);
+    if (reference[i] > 0.0) {
+      score += weights[i] * latency / reference[i];
+    }
+  }
+  return score;
+}
+
+static uint8_t IsValid(const uint8_t* task_weights) {
+  uint8_t total = 0;
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    if (task_weights[i] == 0) {
+      return 0;
+    }
+    total += task_weights[i];
+  }
+  return total <= kSchedulerNumSlots;
+}
+
+// Steepest descent: among all the tables which differ from the current one by
+// a slot added to, removed from, or moved between tasks, picks the best one,
+// until none is better.
+static void Optimize(uint8_t* task_weights, uint32_t duration,
+                     const double* reference, Statistics* trial) {
+  Simulate(task_weights, duration, trial);
+  double score = Score(trial, reference);
+  printf("initial score: %.3f\n", score);
+  while (1) {
+    uint8_t best[TASK_LAST];
+    double best_score = score;
+    for (uint8_t from = 0; from <= TASK_LAST; ++from) {
+      for (uint8_t to = 0; to <= TASK_LAST; ++to) {
+        // TASK_LAST stands for the pool of empty slots.
+        if (from == to) {
+          continue;
+        }
+        uint8_t candidate[TASK_LAST];
+        memcpy(candidate, task_weights, TASK_LAST);
+        if (from != TASK_LAST) {
+          --candidate[from];
+        }
+        if (to != TASK_LAST) {
+          ++candidate[to];
+        }
+        if (!IsValid(candidate)) {
+          continue;
+        }
+        Simulate(candidate, duration, trial);
+        double candidate_score = Score(trial, reference);
+        if (candidate_score < best_score - 1e-6) {
+          best_score = candidate_score;
+          memcpy(best, candidate, TASK_LAST);
+        }
+      }
+    }
+    if (best_score == score) {
+      break;
+    }
+    score = best_score;
+    memcpy(task_weights, best, TASK_LAST);
+    printf("score: %.3f with", score);
+    for (uint8_t i = 0; i < TASK_LAST; ++i) {
+      printf(" %s %d", task_names[i], task_weights[i]);
+    }
+    printf("\n");
+  }
+}
+
+// ---- Report -----------------------------------------------------------------
+
+static void PrintLatency(Statistics* statistics, uint8_t id) {
+  LatencySamples* samples = &statistics->latency[id];
+  printf("%s latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%d samples)\n",
+         latency_names[id], Percentile(samples, 50), Percentile(samples, 99),
+         Percentile(samples, 100), samples->num_values);
+}
+
+static void PrintReport(const uint8_t* task_weights, Statistics* statistics) {
+  double duration = Milliseconds(statistics->duration) / 1000.0;
+  printf("task       slots  calls/s  cpu %%  max interval  required"
+         "  headroom\n");
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    double interval = Milliseconds(statistics->max_interval[i]);
+    printf("%-9s  %5d  %7.0f  %5.1f  %9.2f ms", task_names[i],
+           task_weights[i], statistics->num_runs[i] / duration,
+           100.0 * statistics->busy_cycles[i] / statistics->duration,
+           interval);
+    if (i == TASK_AUDIO) {
+      // For the audio task, the headroom is the smallest amount of audio left
+      // in the buffer.
+      printf("         -  %7.0f%%\n",
+             100.0 * statistics->min_audio_level / kAudioBufferSize);
+    } else if (periods[i] > 0.0) {
+      printf("  %5.2f ms  %7.0f%%\n", periods[i],
+             100.0 * (periods[i] - interval) / periods[i]);
+    } else {
+      printf("         -         -\n");
+    }
+  }
+  printf("idle: %.1f%% of the cpu\n",
+         100.0 * statistics->idle_cycles / statistics->duration);
+  printf("audio underruns: %d, smallest buffer level: %.2f ms\n",
+         statistics->num_underruns,
+         statistics->min_audio_level * 1000.0 / kSampleRate);
+  printf("midi bytes: %d, lost: %d\n", statistics->num_midi_bytes,
+         statistics->num_lost_midi_bytes);
+  for (uint8_t i = 0; i < LATENCY_LAST; ++i) {
+    PrintLatency(statistics, i);
+  }
+}
+
+static void PrintTable(const uint8_t* task_weights) {
+  printf("/* static */\n");
+  printf("template<>\n");
+  printf("Task Scheduler::tasks_[] = {\n");
+  for (uint8_t i = 0; i < TASK_LAST; ++i) {
+    if (i == TASK_GLITCH) {
+      printf("#ifdef HAS_GLITCH_MONITORING\n");
+    }
+    printf("    { &%s, %d },\n", task_functions[i], task_weights[i]);
+    if (i == TASK_GLITCH) {
+      printf("#endif  // HAS_GLITCH_MONITORING\n");
+    }
+  }
+  printf("};\n");
+}
+
+static Statistics baseline;
+static Statistics trial;
+
+int main(int argc, char** argv) {
+  const char* model_file_name = NULL;
+  uint32_t duration = 5;
+
+  int option;
+  while ((option = getopt(argc, argv, "c:t:")) != -1) {
+    switch (option) {
+      case 'c':
+        model_file_name = optarg;
+        break;
+      case 't':
+        duration = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-c model.txt] [-t simulated_seconds]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+
+  InitDefaultModel();
+  if (model_file_name && !LoadModel(model_file_name)) {
+    fprintf(stderr, "Could not open %s\n", model_file_name);
+    return 1;
+  }
+
+  uint8_t task_weights[TASK_LAST];
+  memcpy(task_weights, current_weights, TASK_LAST);
+  Simulate(task_weights, duration, &baseline);
+  double reference[LATENCY_LAST];
+  for (uint8_t i = 0; i < LATENCY_LAST; ++i) {
+    reference[i] = Percentile(&baseline.latency[i], 99);
+  }
+  printf("---- current table ----\n");
+  PrintReport(task_weights, &baseline);
+
+  printf("---- search ----\n");
+  Optimize(task_weights, duration, reference, &trial);
+
+  printf("---- optimized table ----\n");
+  Simulate(task_weights, duration, &trial);
+  PrintReport(task_weights, &trial);
+  printf("\n");
+  PrintTable(task_weights);
+  return 0;
+}
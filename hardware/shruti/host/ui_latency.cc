@@ -0,0 +1,363 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+//
+// Front panel latency benchmark. The firmware runs in the simulator of
+// firmware_sim, with the slot table of shruti.cc, while a scripted user plays
+// with the front panel: page changes with the group switches, increments with
+// the -/+ switches, pot jumps and pot sweeps. Each gesture is followed by a
+// pause, during which the benchmark watches:
+//
+// - the patch, for the changes made by SynthesisEngine::SetParameter ;
+// - the text shown by the LCD, as decoded from its 2400 bps serial line.
+//
+// For each gesture, the response time is measured from the first input change
+// to the first modification, and the settling time from the last input change
+// (the release of a switch, the end of a sweep) to the last modification.
+// Percentiles are reported for each kind of gesture.
+//
+// Usage: ui_latency [-n num_gestures] [-g pause_ms] [-a audio_load_percent]
+//                   [-m midi_notes_per_second] [-r random_seed] [-v]
+//
+// The MIDI notes sent with -m load the MIDI task (and the LCD with status
+// indicators, which are ignored by the measurements). The pause should be
+// longer than the time needed to redraw the screen, and shorter than the delay
+// after which the firmware reverts to the summary page (900 ms).
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/shruti/display.h"
+#include "hardware/shruti/host/simulated_shruti.h"
+#include "hardware/shruti/synthesis_engine.h"
+
+using namespace hardware_hal;
+using namespace hardware_shruti;
+
+static const uint16_t kMaxGestures = 2000;
+static const uint32_t kWarmUpDuration = 3000;
+static const uint16_t kSwitchHoldDuration = 150;
+static const uint16_t kPotJumpMinDelta = 256;
+static const uint16_t kPotSweepMinDelta = 512;
+static const uint16_t kPotSweepDuration = 250;
+static const uint8_t kPotSweepStepDuration = 2;
+
+enum GestureType {
+  GESTURE_PAGE,
+  GESTURE_INCREMENT,
+  GESTURE_POT_JUMP,
+  GESTURE_POT_SWEEP,
+  GESTURE_LAST
+};
+
+static const char* gesture_names[] = {
+  "page", "increment", "pot jump", "pot sweep"
+};
+
+enum Metric {
+  METRIC_PARAMETER_RESPONSE,
+  METRIC_PARAMETER_SETTLING,
+  METRIC_LCD_RESPONSE,
+  METRIC_LCD_SETTLING,
+  METRIC_LAST
+};
+
+static const char* metric_names[] = {
+  "parameter response", "parameter settling",
+  "lcd response", "lcd settling"
+};
+
+// Times, in CPU cycles, of the input changes and of the first and last
+// modifications observed during a gesture. 0 when nothing happened.
+struct Gesture {
+  uint64_t first_input;
+  uint64_t last_input;
+  uint64_t first_change[2];
+  uint64_t last_change[2];
+};
+
+struct Latencies {
+  uint32_t values[kMaxGestures];
+  uint16_t num_values;
+  uint16_t num_missing;
+};
+
+static Latencies latencies[GESTURE_LAST][METRIC_LAST];
+static Gesture gesture;
+
+static uint8_t screen[kSerialLcdHeight][kSerialLcdWidth];
+static uint8_t patch_copy[sizeof(Patch)];
+
+static uint32_t midi_note_interval = 0;
+static uint64_t next_midi_note = 0;
+static uint8_t midi_note_on = 0;
+static uint8_t verbose = 0;
+
+static inline uint64_t Now() {
+  return VirtualClock::cycles();
+}
+
+static void RecordChange(uint8_t index) {
+  if (!gesture.first_input) {
+    return;
+  }
+  if (!gesture.first_change[index]) {
+    gesture.first_change[index] = Now();
+  }
+  gesture.last_change[index] = Now();
+}
+
+static uint8_t IsStatusIndicator(uint8_t line, uint8_t column,
+                                 uint8_t character) {
+  return line == 0 && (column == 0 || column == kSerialLcdWidth - 1) &&
+      (character < 8 || strchr("!~+#", character));
+}
+
+// Compares the text shown by the LCD with the last copy. The status
+// indicators and the blinking cursor, which appear and disappear by
+// themselves, are ignored.
+static void OnLcdByte(uint8_t value) {
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < kSerialLcdHeight; ++i) {
+    for (uint8_t j = 0; j < kSerialLcdWidth; ++j) {
+      uint8_t character = SimulatedSerialLcd::character(i, j);
+      if (character == screen[i][j]) {
+        continue;
+      }
+      uint8_t blink = character == kLcdCursor || screen[i][j] == kLcdCursor ||
+          (screen[i][j] == ' ' && IsStatusIndicator(i, j, character)) ||
+          (character == ' ' && IsStatusIndicator(i, j, screen[i][j]));
+      if (!blink) {
+        changed = 1;
+      }
+      screen[i][j] = character;
+    }
+  }
+  if (changed) {
+    RecordChange(1);
+  }
+}
+
+static void SendMidiNote() {
+  SimulatedUart::Receive(midi_note_on ? 0x80 : 0x90);
+  SimulatedUart::Receive(60);
+  SimulatedUart::Receive(100);
+  midi_note_on = !midi_note_on;
+}
+
+static void RunFor(uint32_t milliseconds) {
+  uint64_t end = Now() + milliseconds * kCyclesPerMillisecond;
+  while (Now() < end) {
+    if (midi_note_interval && Now() >= next_midi_note) {
+      SendMidiNote();
+      next_midi_note += midi_note_interval;
+    }
+    const hardware_utils::Task* task = SimulatedShruti::Step();
+    // Only the input task calls SetParameter when no MIDI controller is sent.
+    if (task && task->code == &InputTask &&
+        memcmp(&engine.patch(), patch_copy, sizeof(Patch))) {
+      memcpy(patch_copy, &engine.patch(), sizeof(Patch));
+      RecordChange(0);
+    }
+  }
+}
+
+static void MarkInput() {
+  if (!gesture.first_input) {
+    gesture.first_input = Now();
+  }
+  gesture.last_input = Now();
+}
+
+static void PressSwitch(uint8_t index) {
+  SimulatedShruti::set_switch(index, 1);
+  RunFor(kSwitchHoldDuration + rand() % 50);
+  // Actions are performed when the switch is released.
+  SimulatedShruti::set_switch(index, 0);
+  MarkInput();
+}
+
+// Returns a random pot value far enough from the current one.
+static uint16_t RandomPotValue(uint8_t pot, uint16_t min_delta) {
+  uint16_t current = SimulatedShruti::pot(pot);
+  uint16_t value;
+  do {
+    value = rand() % 1024;
+  } while (abs(static_cast<int16_t>(value) - current) < min_delta);
+  return value;
+}
+
+static void PlayGesture(uint8_t type) {
+  uint8_t pot = rand() % kNumEditingPots;
+  switch (type) {
+    case GESTURE_PAGE:
+      // The load/save group is avoided, since its pots load patches.
+      PressSwitch(rand() % (kNumGroupSwitches - 1));
+      break;
+
+    case GESTURE_INCREMENT:
+      PressSwitch(kNumGroupSwitches + rand() % 2);
+      break;
+
+    case GESTURE_POT_JUMP:
+      SimulatedShruti::set_pot(pot, RandomPotValue(pot, kPotJumpMinDelta));
+      MarkInput();
+      break;
+
+    case GESTURE_POT_SWEEP:
+      {
+        int16_t start = SimulatedShruti::pot(pot);
+        int16_t delta = RandomPotValue(pot, kPotSweepMinDelta) - start;
+        uint8_t num_steps = kPotSweepDuration / kPotSweepStepDuration;
+        for (uint8_t i = 1; i <= num_steps; ++i) {
+          SimulatedShruti::set_pot(pot, start + delta * i / num_steps);
+          MarkInput();
+          RunFor(kPotSweepStepDuration);
+        }
+      }
+      break;
+  }
+}
+
+static void AddLatency(uint8_t type, uint8_t metric, uint64_t from,
+                       uint64_t to) {
+  Latencies* l = &latencies[type][metric];
+  if (!to) {
+    ++l->num_missing;
+  } else if (l->num_values < kMaxGestures) {
+    l->values[l->num_values++] = to > from ? to - from : 0;
+  }
+}
+
+static int CompareLatencies(const void* a, const void* b) {
+  uint32_t x = *static_cast<const uint32_t*>(a);
+  uint32_t y = *static_cast<const uint32_t*>(b);
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Nearest-rank percentile, in ms.
+static double Percentile(const Latencies& l, uint8_t percent) {
+  uint16_t rank = (static_cast<uint32_t>(l.num_values) * percent + 99) / 100;
+  if (rank) {
+    --rank;
+  }
+  return static_cast<double>(l.values[rank]) / kCyclesPerMillisecond;
+}
+
+static void PrintReport() {
+  printf("gesture     metric                  n  none     p50     p90"
+         "     p99     max (ms)\n");
+  for (uint8_t i = 0; i < GESTURE_LAST; ++i) {
+    for (uint8_t j = 0; j < METRIC_LAST; ++j) {
+      Latencies* l = &latencies[i][j];
+      if (i == GESTURE_PAGE && j <= METRIC_PARAMETER_SETTLING) {
+        continue;
+      }
+      printf("%-10s  %-19s  %4d  %4d", gesture_names[i], metric_names[j],
+             l->num_values, l->num_missing);
+      if (!l->num_values) {
+        printf("       -       -       -       -\n");
+        continue;
+      }
+      qsort(l->values, l->num_values, sizeof(uint32_t), &CompareLatencies);
+      printf("  %6.1f  %6.1f  %6.1f  %6.1f\n", Percentile(*l, 50),
+             Percentile(*l, 90), Percentile(*l, 99), Percentile(*l, 100));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  uint16_t num_gestures = 200;
+  uint16_t pause = 600;
+  uint16_t midi_notes_per_second = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:g:a:m:r:v")) != -1) {
+    switch (option) {
+      case 'n':
+        num_gestures = atoi(optarg);
+        break;
+      case 'g':
+        pause = atoi(optarg);
+        break;
+      case 'a':
+        SimulatedShruti::set_audio_load(atoi(optarg));
+        break;
+      case 'm':
+        midi_notes_per_second = atoi(optarg);
+        break;
+      case 'r':
+        srand(atoi(optarg));
+        break;
+      case 'v':
+        verbose = 1;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-n num_gestures] [-g pause_ms] "
+                "[-a audio_load_percent] [-m midi_notes_per_second] "
+                "[-r random_seed] [-v]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (num_gestures > kMaxGestures) {
+    num_gestures = kMaxGestures;
+  }
+  if (midi_notes_per_second) {
+    // Each note is sent as a note on and a note off.
+    midi_note_interval = F_CPU / 2 / midi_notes_per_second;
+  }
+
+  SimulatedShruti::Init();
+  SimulatedShruti::set_lcd_callback(&OnLcdByte);
+  SimulatedShruti::Boot();
+  RunFor(kWarmUpDuration);
+  memcpy(patch_copy, &engine.patch(), sizeof(Patch));
+  uint16_t num_glitches = Audio::num_glitches();
+
+  for (uint16_t i = 0; i < num_gestures; ++i) {
+    uint8_t type = i % GESTURE_LAST;
+    memset(&gesture, 0, sizeof(Gesture));
+    PlayGesture(type);
+    // The pause is randomized to avoid any phase locking with the scheduler.
+    RunFor(pause + rand() % 100);
+    for (uint8_t j = 0; j < 2; ++j) {
+      AddLatency(type, j * 2, gesture.first_input, gesture.first_change[j]);
+      AddLatency(type, j * 2 + 1, gesture.last_input, gesture.last_change[j]);
+    }
+    if (verbose) {
+      printf("%8.1f\t%s", static_cast<double>(gesture.first_input) /
+             kCyclesPerMillisecond, gesture_names[type]);
+      for (uint8_t j = 0; j < METRIC_LAST; ++j) {
+        const Latencies& l = latencies[type][j];
+        if (l.num_values && gesture.first_change[j / 2]) {
+          printf("\t%.1f", static_cast<double>(l.values[l.num_values - 1]) /
+                 kCyclesPerMillisecond);
+        } else {
+          printf("\t-");
+        }
+      }
+      printf("\n");
+    }
+  }
+
+  PrintReport();
+  printf("audio glitches: %d\n", Audio::num_glitches() - num_glitches);
+  printf("midi overruns: %d\n", SimulatedUart::num_overruns());
+  return 0;
+}
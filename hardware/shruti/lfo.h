@@ -28,17 +28,41 @@
 #include "hardware/shruti/shruti.h"
 
 #include "hardware/shruti/patch.h"
+#include "hardware/shruti/resources.h"
+#include "hardware/utils/op.h"
 #include "hardware/utils/random.h"
 
+using namespace hardware_utils_op;
 using hardware_utils::Random;
 
 namespace hardware_shruti {
 
+// Number of segments in each of the shapes of the lfo_waveforms resource.
+static const uint8_t kLfoWaveformSize = 64;
+
 class Lfo {
  public:
   Lfo() { }
   
   uint8_t Render(const Patch& patch) {
+#ifdef HAS_LFO_SHAPES
+    // The table-based shapes all cost the same interpolated lookup: 64
+    // segments for the shapes stored in flash, 16 for the user shape.
+    if (shape_ >= LFO_WAVEFORM_SINE) {
+      if (shape_ == LFO_WAVEFORM_USER) {
+        uint8_t index = phase_ >> 12;
+        return Mix(
+            patch.lfo_user_shape[index],
+            patch.lfo_user_shape[(index + 1) & (kLfoUserShapeSize - 1)],
+            phase_ >> 4);
+      }
+      uint8_t index = phase_ >> 10;
+      return Mix(
+          ResourcesManager::Lookup<uint8_t, uint8_t>(table_, index),
+          ResourcesManager::Lookup<uint8_t, uint8_t>(table_, index + 1),
+          phase_ >> 2);
+    }
+#endif  // HAS_LFO_SHAPES
     switch (shape_) {
       case LFO_WAVEFORM_S_H:
         if (phase_ < previous_phase_) {
@@ -67,6 +91,20 @@ class Lfo {
         return phase_ >> 8;
     }
   }
+  // Same as Render, with the S&H values drawn from another generator than
+  // hardware_utils::Random. Used by the voices of the desktop polyphonic
+  // engine, which have their own.
+  template<typename Generator>
+  uint8_t Render(const Patch& patch, Generator* random) {
+    if (shape_ != LFO_WAVEFORM_S_H) {
+      return Render(patch);
+    }
+    if (phase_ < previous_phase_) {
+      value_ = random->GetByte();
+    }
+    previous_phase_ = phase_;
+    return value_;
+  }
   void Reset() {
     phase_ = 0;
   }
@@ -76,6 +114,12 @@ class Lfo {
   void Update(uint8_t shape, uint16_t increment) {
     shape_ = shape;
     phase_increment_ = increment;
+#ifdef HAS_LFO_SHAPES
+    if (shape >= LFO_WAVEFORM_SINE && shape < LFO_WAVEFORM_USER) {
+      table_ = shp_res_lfo_waveforms +
+          (shape - LFO_WAVEFORM_SINE) * (kLfoWaveformSize + 1);
+    }
+#endif  // HAS_LFO_SHAPES
   }
 
  private:
@@ -89,6 +133,11 @@ class Lfo {
   // Copy of the shape used by this lfo.
   uint8_t shape_;
 
+#ifdef HAS_LFO_SHAPES
+  // Table read by the table-based shapes.
+  const prog_uint8_t* table_;
+#endif  // HAS_LFO_SHAPES
+
   // Current value of S&H.
   uint8_t value_;
   
@@ -37,6 +37,8 @@
 // Vowel    sr/2      n/a              n/a
 // Table    sr/2      n/a              n/a
 // Sweep    ?         n/a              n/a
+// Unison   sr        n/a              n/a
+// User     sr        n/a              n/a
 
 #ifndef HARDWARE_SHRUTI_OSCILLATOR_H_
 #define HARDWARE_SHRUTI_OSCILLATOR_H_
@@ -46,6 +48,7 @@
 
 #include "hardware/shruti/patch.h"
 #include "hardware/shruti/resources.h"
+#include "hardware/shruti/user_wavetables.h"
 #include "hardware/utils/random.h"
 #include "hardware/utils/op.h"
 
@@ -54,9 +57,9 @@ using hardware_utils::Random;
 
 namespace hardware_shruti {
 
-#define WAV_RES_SINE WAV_RES_BANDLIMITED_TRIANGLE_6
-#define HALF_SAMPLE_RATE if (engine.oscillator_decimation() & 1) return;
-#define FOURTH_SAMPLE_RATE if (engine.oscillator_decimation()) return;
+#define WAV_RES_SINE WAV_RES_BANDLIMITED_SAW_6
+#define HALF_SAMPLE_RATE if (engine.oscillator_decimation(id) & 1) return;
+#define FOURTH_SAMPLE_RATE if (engine.oscillator_decimation(id)) return;
 
 enum OscillatorMode {
   FULL = 0,
@@ -64,6 +67,15 @@ enum OscillatorMode {
   SUB_OSCILLATOR = 2
 };
 
+// Part of the period stored in a band-limited wavetable. The rest of the period
+// is obtained by negating (half wave) or mirroring and negating (quarter wave)
+// the stored part.
+enum WaveformSymmetry {
+  SYMMETRY_NONE = 0,
+  SYMMETRY_HALF_WAVE = 1,
+  SYMMETRY_QUARTER_WAVE = 2
+};
+
 static const uint8_t kVowelControlRateDecimation = 4;
 static const uint8_t kNumZonesFullSampleRate = 6;
 static const uint8_t kNumZonesHalfSampleRate = 5;
@@ -76,10 +88,11 @@ struct BandlimitedPwmOscillatorData {
   int8_t previous;
 };
 
-// Interpolates between two 256-samples wavetables.
+// Interpolates between two band-limited wavetables.
 struct SawTriangleOscillatorData {
   const prog_uint8_t* wave[2];
   uint8_t balance;
+  uint8_t symmetry;
 };
 
 struct CzOscillatorData {
@@ -95,8 +108,9 @@ struct FmOscillatorData {
 struct VowelSynthesizerData {
   uint16_t formant_increment[3];
   uint16_t formant_phase[3];
-  uint8_t formant_amplitude[3];
-  uint8_t noise_modulation;
+  // The amplitudes of the 3 formants, followed by the amount of noise added to
+  // the phase.
+  uint8_t formant_amplitude[4];
   uint8_t update;  // Update only every kVowelControlRateDecimation-th call.
 };
 
@@ -109,6 +123,20 @@ struct QuadSawPadData {
   uint16_t phase[3];
 };
 
+// Detuned copies of a band-limited saw, all read from the same wavetable.
+struct UnisonSawData {
+  const prog_uint8_t* wave;
+  uint16_t phase_increment[3];
+  uint16_t phase[3];
+};
+
+// Same as SawTriangleOscillatorData, with the waves in the SRAM cache of
+// UserWavetables.
+struct CachedWavetableOscillatorData {
+  const uint8_t* wave[2];
+  uint8_t balance;
+};
+
 union OscillatorData {
   BandlimitedPwmOscillatorData pw;
   SawTriangleOscillatorData st;
@@ -117,6 +145,8 @@ union OscillatorData {
   VowelSynthesizerData vw;
   FilteredNoiseData no;
   QuadSawPadData qs;
+  UnisonSawData us;
+  CachedWavetableOscillatorData cw;
 };
 
 struct AlgorithmFn {
@@ -132,7 +162,7 @@ class Oscillator {
    // Called whenever the parameters of the oscillator change. Can be used
    // to pre-compute parameters, set tables, etc.
    static inline void SetupAlgorithm(uint8_t shape) {
-     if ((mode == FULL && shape > WAVEFORM_QUAD_SAW_PAD) ||
+     if ((mode == FULL && shape > WAVEFORM_USER_WAVETABLE) ||
          (mode == LOW_COMPLEXITY && shape > WAVEFORM_TRIANGLE)) {
        return;  // Protection against NULL function pointers.
      }
@@ -282,6 +312,40 @@ class Oscillator {
   }
 #endif  // USE_OPTIMIZED_OP
 
+  // Same as InterpolateSample, for a table in SRAM.
+#ifdef USE_OPTIMIZED_OP
+  static inline uint8_t InterpolateSampleRam(
+      const uint8_t* table,
+      uint16_t phase) {
+    uint8_t result;
+    asm(
+      "movw r30, %A1"           "\n\t"  // copy base address to r30:r31
+      "add r30, %B2"            "\n\t"  // increment table address by phaseH
+      "adc r31, r1"             "\n\t"  // just carry
+      "ld %0, z+"               "\n\t"  // load sample[n]
+      "ld r1, z+"               "\n\t"  // load sample[n+1]
+      "mul %A2, r1"             "\n\t"  // multiply second sample by phaseL
+      "movw r30, r0"            "\n\t"  // result to accumulator
+      "com %A2"                 "\n\t"  // 255 - phaseL -> phaseL
+      "mul %A2, %0"             "\n\t"  // multiply first sample by phaseL
+      "com %A2"                 "\n\t"  // 255 - phaseL -> phaseL
+      "add r30, r0"             "\n\t"  // accumulate L
+      "adc r31, r1"             "\n\t"  // accumulate H
+      "eor r1, r1"              "\n\t"  // reset r1 after multiplication
+      "mov %0, r31"             "\n\t"  // use sum H as output
+      : "=r" (result)
+      : "a" (table), "a" (phase)
+      : "r30", "r31"
+    );
+    return result;
+  }
+#else
+  static inline uint8_t InterpolateSampleRam(const uint8_t* table,
+                                             uint16_t phase) {
+    return Mix(table[phase >> 8], table[(phase >> 8) + 1], phase & 0xff);
+  }
+#endif  // USE_OPTIMIZED_OP
+
   static inline uint8_t InterpolateTwoTables(
       const prog_uint8_t* table_a, const prog_uint8_t* table_b,
       uint16_t phase, uint8_t balance) {
@@ -290,6 +354,37 @@ class Oscillator {
         InterpolateSample(table_b, phase),
         balance);
   }
+
+  // Same as InterpolateTwoTables, for tables storing only the first half of
+  // the period of a waveform whose second half is the first one, negated
+  // (SYMMETRY_HALF_WAVE: square), or only its first quarter when it is, in
+  // addition, symmetric around 0 (SYMMETRY_QUARTER_WAVE: triangle, sine). In
+  // the latter case, the phase is mirrored in the second and fourth quarters,
+  // and the sample is negated in the second and third quarters. The phase is
+  // folded first, so that all the symmetries share the same lookup code.
+  static inline uint8_t InterpolateTwoSymmetricTables(
+      const prog_uint8_t* table_a, const prog_uint8_t* table_b,
+      uint16_t phase, uint8_t balance, uint8_t symmetry) {
+    uint8_t negate = 0;
+    if (symmetry == SYMMETRY_HALF_WAVE) {
+      negate = static_cast<uint8_t>(phase >> 8) & 0x80;
+      phase &= 0x7fff;
+    } else if (symmetry == SYMMETRY_QUARTER_WAVE) {
+      negate = static_cast<uint8_t>((phase ^ (phase << 1)) >> 8) & 0x80;
+      phase &= 0x7fff;
+      if (phase & 0x4000) {
+        phase = 0x8000 - phase;
+      }
+    }
+    uint8_t sample = InterpolateTwoTables(table_a, table_b, phase, balance);
+    if (negate) {
+      // The interpolation rounds down, by half a LSB on average. Negating
+      // around 127.5 (255 - sample) would turn it into a rounding up, so the
+      // negated sample is 1 lower.
+      sample = sample == 255 ? 0 : 254 - sample;
+    }
+    return sample;
+  }
   
   // ------- Silence (useful when processing external signals) -----------------
   static void RenderSilence() {
@@ -345,6 +440,9 @@ class Oscillator {
     uint8_t base_resource_id = shape_ == WAVEFORM_SQUARE ?
         WAV_RES_BANDLIMITED_SQUARE_1 :
         WAV_RES_BANDLIMITED_TRIANGLE_1;
+    data_.st.symmetry = shape_ == WAVEFORM_SQUARE ?
+        SYMMETRY_HALF_WAVE :
+        SYMMETRY_QUARTER_WAVE;
 
     wave_index = AddClip(wave_index, 1, kNumZonesHalfSampleRate);
     data_.st.wave[0] = waveform_table[base_resource_id + wave_index];
@@ -354,9 +452,9 @@ class Oscillator {
   static void RenderSub() {
     FOURTH_SAMPLE_RATE;
     phase_ += phase_increment_;
-    held_sample_ = InterpolateTwoTables(
+    held_sample_ = InterpolateTwoSymmetricTables(
         data_.st.wave[0], data_.st.wave[1],
-        phase_, data_.st.balance);
+        phase_, data_.st.balance, data_.st.symmetry);
   }
 
   // ------- Interpolation between two waveforms from two wavetables -----------
@@ -369,6 +467,10 @@ class Oscillator {
         WAV_RES_BANDLIMITED_SAW_0 :
         (shape_ == WAVEFORM_SQUARE ? WAV_RES_BANDLIMITED_SQUARE_0  : 
         WAV_RES_BANDLIMITED_TRIANGLE_0);
+    data_.st.symmetry = shape_ == WAVEFORM_SAW ?
+        SYMMETRY_NONE :
+        (shape_ == WAVEFORM_SQUARE ? SYMMETRY_HALF_WAVE :
+        SYMMETRY_QUARTER_WAVE);
       
     data_.st.wave[0] = waveform_table[base_resource_id + wave_index];
     wave_index = AddClip(wave_index, 1, kNumZonesFullSampleRate);
@@ -376,20 +478,20 @@ class Oscillator {
   }
   static void RenderSimpleWavetable() {
     phase_ += phase_increment_;
-    uint8_t sample = InterpolateTwoTables(
+    uint8_t sample = InterpolateTwoSymmetricTables(
         data_.st.wave[0], data_.st.wave[1],
-        phase_, data_.st.balance);
+        phase_, data_.st.balance, data_.st.symmetry);
 
     // To produce pulse width-modulated variants, we shift (saw) or set to
     // a constant (triangle) a portion of the waveform within an increasingly
     // large fraction of the period. Note that this is pure waveshapping - the
     // phase information is not used to determine when/where to shift.
     //
-    //     /|            /|          /\             /\
-    //    / |           / |         /  \           /  \
-    //   /  |    =>  /|/  |        /    \  =>  ___/    \
-    //  /   |       /     |/      /      \
-    // /    |/                   /        \
+    //     /\             /\          /|            /|
+    //    /  \           /  \        / |           / |
+    //   /    \  =>  ___/    \      /  |    =>  /|/  |
+    //  /      \                   /   |       /     |/
+    // /        \                 /    |/
     //
     if (sample < parameter_) {
       if (shape_ == WAVEFORM_SAW) {
@@ -404,25 +506,63 @@ class Oscillator {
   }
 
   // ------- Interpolation between two offsets of a wavetable ------------------
-  // 64 samples per cycle.
+  // 64 samples per cycle. The waves are decoded in the SRAM cache of
+  // UserWavetables when they are selected, which takes a few control periods.
   static void UpdateWavetable128() {
     uint8_t balance_index = Swap4(parameter_ << 1);
-    data_.st.balance = balance_index & 0xf0;
+    data_.cw.balance = balance_index & 0xf0;
 
-    uint8_t wave_index = balance_index & 0xf;
-    uint16_t offset = wave_index * 129;
-    data_.st.wave[0] = waveform_table[WAV_RES_WAVETABLE] + offset;
-    if (offset < 2048 - 129) {
-      data_.st.wave[1] = waveform_table[WAV_RES_WAVETABLE] + offset + 129;
-    } else {
-      data_.st.wave[1] = data_.st.wave[0] - 129;
+    uint8_t wave = kFirstBuiltinWave + (balance_index & 0xf);
+    uint8_t next_wave = (balance_index & 0xf) == 0xf ? wave - 1 : wave + 1;
+#ifdef USE_DECODED_BUILTIN_WAVETABLE
+    data_.cw.wave[0] = UserWavetables::decoded_builtin_wave(wave);
+    data_.cw.wave[1] = UserWavetables::decoded_builtin_wave(next_wave);
+#else
+    UserWavetables::RequestBuiltin(wave, next_wave);
+    const uint8_t* wave_data = UserWavetables::cached_wave(wave);
+    const uint8_t* next_wave_data = UserWavetables::cached_wave(next_wave);
+    // While one of the waves is being decoded, use the other one.
+    if (!wave_data) {
+      wave_data = next_wave_data;
+    } else if (!next_wave_data) {
+      next_wave_data = wave_data;
     }
+    data_.cw.wave[0] = wave_data;
+    data_.cw.wave[1] = next_wave_data;
+    fn_.render = wave_data ? &RenderWavetable128 : &RenderSilence;
+#endif  // USE_DECODED_BUILTIN_WAVETABLE
   }
   static void RenderWavetable128() {
     phase_ += phase_increment_;
-    held_sample_ = InterpolateTwoTables(
-        data_.st.wave[0], data_.st.wave[1],
-        phase_ >> 1, data_.st.balance);
+    uint16_t phase = phase_ >> 1;
+    held_sample_ = Mix(
+        InterpolateSampleRam(data_.cw.wave[0], phase),
+        InterpolateSampleRam(data_.cw.wave[1], phase),
+        data_.cw.balance);
+  }
+  
+  // ------- Interpolation between two waves of a user wavetable ---------------
+  // The two most significant bits of the parameter select the table, the
+  // others the position in the table. The waves are read from the SRAM cache
+  // of UserWavetables - until they are in it, the oscillator is silent.
+  static void UpdateUserWavetable() {
+    uint8_t balance_index = Swap4(parameter_ << 3);
+    data_.cw.balance = balance_index & 0xf0;
+
+    uint8_t wave = ((parameter_ & 0x60) >> 1) | (balance_index & 0xf);
+    uint8_t next_wave = (wave & 0xf) == 0xf ? wave : wave + 1;
+    UserWavetables::Request(wave, next_wave);
+    const uint8_t* wave_data = UserWavetables::cached_wave(wave);
+    const uint8_t* next_wave_data = UserWavetables::cached_wave(next_wave);
+    // While one of the waves is being loaded, use the other one.
+    if (!wave_data) {
+      wave_data = next_wave_data;
+    } else if (!next_wave_data) {
+      next_wave_data = wave_data;
+    }
+    data_.cw.wave[0] = wave_data;
+    data_.cw.wave[1] = next_wave_data;
+    fn_.render = wave_data ? &RenderWavetable128 : &RenderSilence;
   }
   
   // ------- Casio CZ-like synthesis -------------------------------------------
@@ -481,6 +621,44 @@ class Oscillator {
     held_sample_ += (data_.qs.phase[1] >> 10);
     held_sample_ += (data_.qs.phase[2] >> 10);
   }
+
+  // ------- Unison saw (ohne aliasing) ----------------------------------------
+  //
+  // Same idea as the quad saw, but the four saws are read from a band-limited
+  // wavetable. Only one zone is used for all of them - the zone immediately
+  // above the one that would be used for the note, so that the detuned copies
+  // (less than a semitone above the note) do not alias. This costs four
+  // interpolated reads per sample, and can be used on the whole keyboard.
+  static void UpdateUnisonSaw() {
+    uint8_t wave_index = Swap4(note_ - 12) & 0xf;
+    wave_index = AddClip(wave_index, 1, kNumZonesFullSampleRate);
+    data_.us.wave = waveform_table[WAV_RES_BANDLIMITED_SAW_0 + wave_index];
+
+    uint16_t phase_spread = (
+        static_cast<uint32_t>(phase_increment_) * parameter_) >> 13;
+    ++phase_spread;
+    data_.us.phase_increment[0] = phase_increment_ + phase_spread;
+    data_.us.phase_increment[1] = phase_increment_ - phase_spread;
+    data_.us.phase_increment[2] = phase_increment_ + (phase_spread << 1);
+  }
+
+  static void RenderUnisonSaw() {
+    const prog_uint8_t* wave = data_.us.wave;
+    uint16_t phase = phase_ + phase_increment_;
+    uint16_t phase_0 = data_.us.phase[0] + data_.us.phase_increment[0];
+    uint16_t phase_1 = data_.us.phase[1] + data_.us.phase_increment[1];
+    uint16_t phase_2 = data_.us.phase[2] + data_.us.phase_increment[2];
+    phase_ = phase;
+    data_.us.phase[0] = phase_0;
+    data_.us.phase[1] = phase_1;
+    data_.us.phase[2] = phase_2;
+
+    uint16_t sum = InterpolateSample(wave, phase);
+    sum += InterpolateSample(wave, phase_0);
+    sum += InterpolateSample(wave, phase_1);
+    sum += InterpolateSample(wave, phase_2);
+    held_sample_ = sum >> 2;
+  }
   
   // ------- FM ----------------------------------------------------------------
   static void UpdateFm() {
@@ -567,8 +745,8 @@ class Oscillator {
     result = SignedMulScale8(result, ~(phase_ >> 8));
 
     phase_ += phase_increment_;
-    int16_t phase_noise = int8_t(Random::state_msb()) *
-        int8_t(data_.vw.noise_modulation);
+    int16_t phase_noise = int8_t(engine.noise_sample(id)) *
+        int8_t(data_.vw.formant_amplitude[3]);
     if ((phase_ + phase_noise) < phase_increment_) {
       data_.vw.formant_phase[0] = 0;
       data_.vw.formant_phase[1] = 0;
@@ -585,7 +763,7 @@ class Oscillator {
   
   // ------- Low-passed, then high-passed white noise --------------------------
   static void RenderFilteredNoise() {
-    uint8_t innovation = Random::GetByte();
+    uint8_t innovation = engine.noise_sample(id);
     // This trick is used to avoid having a DC component (no innovation) when
     // the parameter is set to its minimal or maximal value.
     uint8_t offset = parameter_ == 127 ? 0 : 2;
@@ -642,6 +820,16 @@ AlgorithmFn Oscillator<id, mode>::fn_table_[] = {
   { &Osc::UpdateSimpleWavetable, &Osc::RenderSimpleWavetable },
   { &Osc::UpdateCz, &Osc::RenderCzSyncReso },
   { &Osc::UpdateQuadSawPad, &Osc::RenderQuadSawPad },
+#ifdef HAS_UNISON_SAW
+  { &Osc::UpdateUnisonSaw, &Osc::RenderUnisonSaw },
+#else
+  { NULL, &Osc::RenderSilence },
+#endif  // HAS_UNISON_SAW
+#ifdef HAS_USER_WAVETABLES
+  { &Osc::UpdateUserWavetable, &Osc::RenderWavetable128 },
+#else
+  { NULL, &Osc::RenderSilence },
+#endif  // HAS_USER_WAVETABLES
 };
 
 }  // namespace hardware_shruti
@@ -21,9 +21,12 @@
 
 #include <avr/eeprom.h>
 #include <avr/pgmspace.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "hardware/hal/serial.h"
 #include "hardware/shruti/display.h"
+#include "hardware/shruti/shruti.h"
 #include "hardware/utils/op.h"
 
 using namespace hardware_hal;
@@ -31,14 +34,63 @@ using namespace hardware_utils_op;
 
 namespace hardware_shruti {
 
+/* extern */
+const prog_char empty_patch[] PROGMEM = {
+    99,
+    WAVEFORM_SAW, WAVEFORM_SQUARE, 0, 24,
+    0, -12, 0, 12,
+    16, 0, 0, WAVEFORM_SQUARE,
+    90, 0, 20, 0,
+    20, 0,
+    60, 40,
+    20, 80,
+    60, 40,
+    LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_TRIANGLE, 96, 3,
+    MOD_SRC_LFO_1, MOD_DST_VCO_1, 0,
+    MOD_SRC_LFO_1, MOD_DST_VCO_2, 0,
+    MOD_SRC_LFO_1, MOD_DST_PWM_1, 0,
+    MOD_SRC_LFO_1, MOD_DST_PWM_2, 0,
+    MOD_SRC_LFO_2, MOD_DST_MIX_BALANCE, 0,
+    // By default, the resonance tracks the note. This value was empirically
+    // obtained and it is not clear whether it depends on the positive supply
+    // voltage, and if it varies from chip to chip.
+    MOD_SRC_NOTE, MOD_DST_FILTER_CUTOFF, 58,
+    MOD_SRC_ENV_2, MOD_DST_VCA, 63,
+    MOD_SRC_VELOCITY, MOD_DST_VCA, 16,
+    MOD_SRC_PITCH_BEND, MOD_DST_VCO_1_2_FINE, 32,
+    MOD_SRC_LFO_1, MOD_DST_VCO_1_2_FINE, 16,
+    MOD_SRC_CV_1, MOD_DST_PWM_1, 0,
+    MOD_SRC_CV_2, MOD_DST_PWM_2, 0,
+    MOD_SRC_CV_3, MOD_DST_FILTER_CUTOFF, 0,
+    MOD_SRC_RANDOM, MOD_DST_FILTER_CUTOFF, 0,
+    120, 0, 0, 0,
+    0x00, 0x00, 0xff, 0xff, 0xcc, 0xcc, 0x44, 0x44,
+    0, 0, 0, 1,
+    'n', 'e', 'w', ' ', ' ', ' ', ' ', ' ',
+    16, 0,
+    ENVELOPE_CURVE_LINEAR, ENVELOPE_CURVE_LINEAR,
+    127, 64, 127, 64, 127, 64, 127, 0,
+    10, 40, 40, 40, 40, 40, 40, 40,
+    1, 2,
+    0,
+    LFO_WAVEFORM_SINE, 96,
+    0, 32, 64, 96, 128, 160, 192, 224,
+    255, 224, 192, 160, 128, 96, 64, 32 };
+
 void Patch::Pack(uint8_t* patch_buffer) const {
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(this);
   for (uint8_t i = 0; i < 28; ++i) {
-    patch_buffer[i] = osc_shape[i];
+    patch_buffer[i] = base[i + 1];
   }
+  patch_buffer[1] |= ShiftLeft4(
+      (env_curve[0] & 3) | ((env_curve[1] & 3) << 2));
   for (uint8_t i = 0; i < kSavedModulationMatrixSize; ++i) {
-    patch_buffer[2 * i + 28] = modulation_matrix.modulation[i].source |
+    uint8_t source = modulation_matrix.modulation[i].source;
+    // Sources which do not fit in 4 bits are saved as disabled modulations.
+    patch_buffer[2 * i + 28] = (source & 0x0f) |
         ShiftLeft4(modulation_matrix.modulation[i].destination);
-    patch_buffer[2 * i + 29] = modulation_matrix.modulation[i].amount;
+    patch_buffer[2 * i + 29] = source < 16 ?
+        modulation_matrix.modulation[i].amount : 0;
   }
   for (uint8_t i = 0; i < 8; ++i) {
     patch_buffer[2 * kSavedModulationMatrixSize + 28 + i] = sequence[i];
@@ -64,9 +116,13 @@ uint8_t Patch::CheckBuffer() {
 }
 
 void Patch::Unpack(const uint8_t* patch_buffer) {
+  uint8_t* base = reinterpret_cast<uint8_t*>(this);
   for (uint8_t i = 0; i < 28; ++i) {
-    osc_shape[i] = patch_buffer[i];
+    base[i + 1] = patch_buffer[i];
   }
+  osc_shape[1] &= 0x0f;
+  env_curve[0] = ShiftRight4(patch_buffer[1]) & 0x03;
+  env_curve[1] = ShiftRight4(patch_buffer[1]) >> 2;
   for (uint8_t i = 0; i < kSavedModulationMatrixSize; ++i) {
     modulation_matrix.modulation[i].source = patch_buffer[2 * i + 28] & 0xf;
     modulation_matrix.modulation[i].destination = ShiftRight4(
@@ -79,20 +135,28 @@ void Patch::Unpack(const uint8_t* patch_buffer) {
   for (uint8_t i = 0; i < 8; ++i) {
     name[i] = patch_buffer[i + 2 * kSavedModulationMatrixSize + 28 + 8];
   }
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  // The multi-stage envelopes do not fit in the serialized patch. Rather than
+  // keeping those of the previous patch, go back to the default ones.
+  memcpy_P(
+      mseg_level,
+      empty_patch + offsetof(Patch, mseg_level),
+      kMultiStageDataSize);
+#endif  // HAS_MULTI_STAGE_ENVELOPES
 }
 
 void Patch::EepromSave(uint8_t slot) const {
   Pack(load_save_buffer_);
-  int16_t offset = slot * kSerializedPatchSize;
+  uint8_t* address = (uint8_t*)(uintptr_t)(slot * kSerializedPatchSize);
   for (int16_t i = 0; i < kSerializedPatchSize; ++i) {
-    eeprom_write_byte((uint8_t*)(i + offset), load_save_buffer_[i]);
+    eeprom_write_byte(address + i, load_save_buffer_[i]);
   }
 }
 
 void Patch::EepromLoad(uint8_t slot) {
-  int16_t offset = slot * kSerializedPatchSize;
+  const uint8_t* address = (const uint8_t*)(uintptr_t)(slot * kSerializedPatchSize);
   for (int16_t i = 0; i < kSerializedPatchSize; ++i) {
-    load_save_buffer_[i] = eeprom_read_byte((uint8_t*)(i + offset));
+    load_save_buffer_[i] = eeprom_read_byte(address + i);
   }
   if (CheckBuffer()) {
     Unpack(load_save_buffer_);
@@ -105,32 +169,60 @@ static const prog_char sysex_header[] PROGMEM = {
   0xf0,  // <SysEx>
   0x00, 0x20, 0x77,  // TODO(pichenettes): register manufacturer ID.
   0x00, 0x01,  // Product ID for Shruti-1.
-  0x01,  // Command: patch transfer.
+  SYSEX_COMMAND_PATCH,  // Command: patch transfer.
   0x00,  // Argument: none.
 };
 
-void Patch::SysExSend() const {
-  Serial<SerialPort0, 31250, DISABLED, POLLED> midi_output;
-  
-  Pack(load_save_buffer_);
-  
-  // Outputs the SysEx header.
-  for (uint8_t i = 0; i < sizeof(sysex_header); ++i) {
-    midi_output.Write(pgm_read_byte(sysex_header + i));
+static const uint8_t kSysExCommandOffset = 6;
+static const uint8_t kSysExArgumentOffset = 7;
+
+// Byte at a given position of a dump, the patch data and its checksum being
+// stored in buffer.
+static uint8_t SysExDumpByte(const uint8_t* buffer, uint8_t position) {
+  if (position < sizeof(sysex_header)) {
+    return pgm_read_byte(sysex_header + position);
+  } else if (position < kSysExPatchDumpSize - 1) {
+    // Patch data and checksum, in high-low nibblized form.
+    position -= sizeof(sysex_header);
+    uint8_t value = buffer[position >> 1];
+    return (position & 1) ? value & 0x0f : ShiftRight4(value);
+  } else {
+    return 0xf7;  // </SysEx>
   }
-  
-  // Outputs the patch data, in high-low nibblized form.
-  uint8_t checksum = 0;  // Sum of all patch data bytes.
+}
+
+// Packs the patch data and appends the checksum (sum of all patch data bytes).
+void Patch::PackWithChecksum(uint8_t* buffer) const {
+  Pack(buffer);
+  uint8_t checksum = 0;
   for (uint8_t i = 0; i < kSerializedPatchSize; ++i) {
-    checksum += load_save_buffer_[i];
-    midi_output.Write(ShiftRight4(load_save_buffer_[i]));
-    midi_output.Write(load_save_buffer_[i] & 0x0f);
+    checksum += buffer[i];
   }
+  buffer[kSerializedPatchSize] = checksum;
+}
+
+void Patch::SysExSend() const {
+  PackWithChecksum(sysex_transmission_buffer_);
+  sysex_bytes_sent_ = 0;
+}
+
+/* static */
+void Patch::SysExTransmit() {
+  Serial<SerialPort0, 31250, DISABLED, BUFFERED> midi_output;
   
-  midi_output.Write(ShiftRight4(checksum));
-  midi_output.Write(checksum & 0x0f);
-  
-  midi_output.Write(0xf7);  // </SysEx>
+  while (sysex_transmission_pending() && midi_output.writable()) {
+    midi_output.Overwrite(SysExDumpByte(
+        sysex_transmission_buffer_,
+        sysex_bytes_sent_));
+    ++sysex_bytes_sent_;
+  }
+}
+
+void Patch::SysExDump(uint8_t* buffer) const {
+  PackWithChecksum(load_save_buffer_);
+  for (uint8_t i = 0; i < kSysExPatchDumpSize; ++i) {
+    *buffer++ = SysExDumpByte(load_save_buffer_, i);
+  }
 }
 
 uint8_t Patch::sequence_step(uint8_t step) const {
@@ -151,18 +243,41 @@ void Patch::SysExReceive(uint8_t sysex_byte) {
   if (sysex_byte == 0xf0) {
     sysex_reception_checksum_ = 0;
     sysex_bytes_received_ = 0;
+    sysex_data_size_ = kSerializedPatchSize;
+    sysex_command_ = SYSEX_COMMAND_PATCH;
+    sysex_argument_ = 0;
     sysex_reception_state_ = RECEIVING_HEADER;
   }
   switch (sysex_reception_state_) {
     case RECEIVING_HEADER:
-      if (pgm_read_byte(sysex_header + sysex_bytes_received_) == sysex_byte) {
-        ++sysex_bytes_received_;
-        if (sysex_bytes_received_ >= sizeof(sysex_header)) {
-          sysex_reception_state_ = RECEIVING_DATA;
-          sysex_bytes_received_ = 0;
-        }
-      } else {
+      // The user LFO shape and the blocks of user wavetables are sent with
+      // the same header, but with another command. The blocks of user
+      // wavetables have the same size as a patch, and an argument.
+#ifdef HAS_LFO_SHAPES
+      if (sysex_bytes_received_ == kSysExCommandOffset &&
+          sysex_byte == SYSEX_COMMAND_LFO_USER_SHAPE) {
+        sysex_command_ = sysex_byte;
+        sysex_data_size_ = kLfoUserShapeSize;
+      } else
+#endif  // HAS_LFO_SHAPES
+#ifdef HAS_USER_WAVETABLES
+      if (sysex_bytes_received_ == kSysExCommandOffset &&
+          sysex_byte == SYSEX_COMMAND_USER_WAVETABLE_BLOCK) {
+        sysex_command_ = sysex_byte;
+      } else if (sysex_bytes_received_ == kSysExArgumentOffset &&
+          sysex_command_ == SYSEX_COMMAND_USER_WAVETABLE_BLOCK) {
+        sysex_argument_ = sysex_byte;
+      } else
+#endif  // HAS_USER_WAVETABLES
+      if (pgm_read_byte(sysex_header + sysex_bytes_received_) !=
+                 sysex_byte) {
         sysex_reception_state_ = RECEIVING_FOOTER;
+        break;
+      }
+      ++sysex_bytes_received_;
+      if (sysex_bytes_received_ >= sizeof(sysex_header)) {
+        sysex_reception_state_ = RECEIVING_DATA;
+        sysex_bytes_received_ = 0;
       }
       break;
       
@@ -171,27 +286,41 @@ void Patch::SysExReceive(uint8_t sysex_byte) {
         uint8_t i = sysex_bytes_received_ >> 1;
         if (sysex_bytes_received_ & 1) {
           load_save_buffer_[i] |= sysex_byte & 0xf;
-          if (i < kSerializedPatchSize) {
+          if (i < sysex_data_size_) {
             sysex_reception_checksum_ += load_save_buffer_[i];
           }
         } else {
           load_save_buffer_[i] = ShiftLeft4(sysex_byte);
         }
         ++sysex_bytes_received_;
-        if (sysex_bytes_received_ >= (kSerializedPatchSize + 1) * 2) {
+        if (sysex_bytes_received_ >= (sysex_data_size_ + 1) * 2) {
           sysex_reception_state_ = RECEIVING_FOOTER;
         }
       }
     break;
     
   case RECEIVING_FOOTER:
+    sysex_reception_state_ = RECEPTION_ERROR;
     if (sysex_byte == 0xf7 &&
-        sysex_reception_checksum_ == load_save_buffer_[kSerializedPatchSize] &&
-        CheckBuffer()) {
-      Unpack(load_save_buffer_);
-      sysex_reception_state_ = RECEPTION_OK;
-    } else {
-      sysex_reception_state_ = RECEPTION_ERROR;
+        sysex_reception_checksum_ == load_save_buffer_[sysex_data_size_]) {
+#ifdef HAS_LFO_SHAPES
+      if (sysex_command_ == SYSEX_COMMAND_LFO_USER_SHAPE) {
+        for (uint8_t i = 0; i < kLfoUserShapeSize; ++i) {
+          lfo_user_shape[i] = load_save_buffer_[i];
+        }
+        sysex_reception_state_ = RECEPTION_OK;
+      } else
+#endif  // HAS_LFO_SHAPES
+#ifdef HAS_USER_WAVETABLES
+      if (sysex_command_ == SYSEX_COMMAND_USER_WAVETABLE_BLOCK) {
+        // Left in the buffer, to be written to the external EEPROM.
+        sysex_reception_state_ = RECEPTION_OK;
+      } else
+#endif  // HAS_USER_WAVETABLES
+      if (CheckBuffer()) {
+        Unpack(load_save_buffer_);
+        sysex_reception_state_ = RECEPTION_OK;
+      }
     }
     break;
   }
@@ -199,17 +328,33 @@ void Patch::SysExReceive(uint8_t sysex_byte) {
 
 void Patch::Backup() const {
   Pack(undo_buffer_);
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  memcpy(undo_buffer_ + kSerializedPatchSize, mseg_level, kMultiStageDataSize);
+#endif  // HAS_MULTI_STAGE_ENVELOPES
 }
 
 void Patch::Restore() {
   Unpack(undo_buffer_);
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  memcpy(mseg_level, undo_buffer_ + kSerializedPatchSize, kMultiStageDataSize);
+#endif  // HAS_MULTI_STAGE_ENVELOPES
 }
 
 /* static */
 uint8_t Patch::load_save_buffer_[kSerializedPatchSize + 1];
 
 /* static */
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+uint8_t Patch::undo_buffer_[kSerializedPatchSize + kMultiStageDataSize];
+#else
 uint8_t Patch::undo_buffer_[kSerializedPatchSize];
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+
+/* static */
+uint8_t Patch::sysex_transmission_buffer_[kSerializedPatchSize + 1];
+
+/* static */
+uint8_t Patch::sysex_bytes_sent_ = kSysExPatchDumpSize;
 
 /* static */
 uint8_t Patch::sysex_bytes_received_;
@@ -217,7 +362,16 @@ uint8_t Patch::sysex_bytes_received_;
 /* static */
 uint8_t Patch::sysex_reception_checksum_;
 
+/* static */
+uint8_t Patch::sysex_data_size_;
+
 /* static */
 uint8_t Patch::sysex_reception_state_;
 
+/* static */
+uint8_t Patch::sysex_command_;
+
+/* static */
+uint8_t Patch::sysex_argument_;
+
 }  // hardware_shruti
@@ -27,6 +27,9 @@
 #define HARDWARE_SHRUTI_PATCH_H_
 
 #include "hardware/base/base.h"
+#include "hardware/shruti/shruti.h"
+
+#include <avr/pgmspace.h>
 
 namespace hardware_shruti {
 
@@ -34,6 +37,12 @@ const uint8_t kPatchNameSize = 8;
 const uint8_t kSerializedPatchSize = 64;
 const uint8_t kModulationMatrixSize = 14;
 const uint8_t kSavedModulationMatrixSize = 10;
+const uint8_t kNumMultiStageSteps = 8;
+// Stage table and envelope selection bits of the multi-stage envelopes.
+const uint8_t kMultiStageDataSize = 2 * kNumMultiStageSteps + 3;
+const uint8_t kLfoUserShapeSize = 16;
+// Header, nibblized patch data and checksum, footer.
+const uint8_t kSysExPatchDumpSize = 8 + (kSerializedPatchSize + 1) * 2 + 1;
 
 struct Modulation {
   uint8_t source;
@@ -55,6 +64,13 @@ enum SysExReceptionState {
   RECEPTION_ERROR = 4,
 };
 
+enum SysExCommand {
+  SYSEX_COMMAND_PATCH = 1,
+  SYSEX_COMMAND_LFO_USER_SHAPE = 2,
+  // The argument is the index of the block of the user wavetables memory.
+  SYSEX_COMMAND_USER_WAVETABLE_BLOCK = 3,
+};
+
 class Patch {
  public:
   uint8_t keep_me_at_the_top;
@@ -108,6 +124,8 @@ class Patch {
   int8_t kbd_portamento;
 
   // Reception channel, 0 for omni. When value is above 17, use lazy mode.
+  // 34-50: notes bypass the arpeggiator. 51-67: duophonic mode (only with
+  // HAS_DUOPHONIC).
   uint8_t kbd_midi_channel;
 
   // Offset: 86-94
@@ -116,6 +134,29 @@ class Patch {
   // Offset: 94-95 not saved
   uint8_t pattern_size;
   uint8_t pattern_rotation;
+
+  // Offset: 96-97, saved in the 4 upper bits of the osc 2 shape.
+  uint8_t env_curve[2];
+
+  // Offset: 98-116, not saved. A patch loaded from the EEPROM or received by
+  // SysEx gets the stage table of empty_patch, and uses the ADSR envelopes.
+  // Stage table of the multi-stage envelope: level (0-127) and time of each
+  // step, loop start and end steps.
+  uint8_t mseg_level[kNumMultiStageSteps];
+  uint8_t mseg_time[kNumMultiStageSteps];
+  uint8_t mseg_loop_start;
+  uint8_t mseg_loop_end;
+  // Bit i set: envelope i uses the stage table instead of the ADSR settings.
+  uint8_t env_multistage;
+
+  // Offset: 117-118, not saved.
+  // Shape and rate of the LFO retriggered by each note.
+  uint8_t voice_lfo_wave;
+  uint8_t voice_lfo_rate;
+
+  // Offset: 119-135, not saved. Received by SysEx.
+  // Points of the LFO_WAVEFORM_USER shape.
+  uint8_t lfo_user_shape[kLfoUserShapeSize];
   
   // Get the value of a step in the sequence.
   uint8_t sequence_step(uint8_t step) const;
@@ -125,33 +166,70 @@ class Patch {
 
   void EepromSave(uint8_t slot) const;
   void EepromLoad(uint8_t slot);
+  // Does not block: the dump is copied in a transmission buffer, which is
+  // moved to the MIDI output buffer, a few bytes at a time, by
+  // SysExTransmit().
   void SysExSend() const;
+  // Same as SysExSend, but writes the message in a buffer of
+  // kSysExPatchDumpSize bytes.
+  void SysExDump(uint8_t* buffer) const;
   void SysExReceive(uint8_t sysex_byte);
   void Backup() const;
   void Restore();
+
+  // To be called periodically (from the MIDI task) to feed the MIDI output
+  // buffer with the pending dump, as room becomes available.
+  static void SysExTransmit();
   
   inline uint8_t sysex_reception_state() const {
     return sysex_reception_state_;
   }
+  static inline void set_sysex_reception_state(uint8_t state) {
+    sysex_reception_state_ = state;
+  }
+  // Command, argument and payload of the last message received. The payload
+  // is only valid for SYSEX_COMMAND_USER_WAVETABLE_BLOCK messages, which are
+  // not processed by the patch.
+  static inline uint8_t sysex_command() { return sysex_command_; }
+  static inline uint8_t sysex_argument() { return sysex_argument_; }
+  static inline const uint8_t* sysex_data() { return load_save_buffer_; }
+  static inline uint8_t sysex_transmission_pending() {
+    return sysex_bytes_sent_ < kSysExPatchDumpSize;
+  }
 
  private:
   static uint8_t CheckBuffer() __attribute__((noinline));
   void Pack(uint8_t* patch_buffer) const;
   void Unpack(const uint8_t* patch_buffer);
+  void PackWithChecksum(uint8_t* buffer) const;
   
   // Buffer in which the patch is compressed for load/save operations. The last
   // byte is for the checksum added to the stream during sysex dumps.
   static uint8_t load_save_buffer_[kSerializedPatchSize + 1];
   // Buffer used to allow the user to undo the loading of a patch (similar to
   // the "compare" function on some synths).
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+  // The multi-stage envelopes are kept after the serialized patch.
+  static uint8_t undo_buffer_[kSerializedPatchSize + kMultiStageDataSize];
+#else
   static uint8_t undo_buffer_[kSerializedPatchSize];
+#endif  // HAS_MULTI_STAGE_ENVELOPES
+  
+  // Patch being sent by SysExTransmit, with its checksum.
+  static uint8_t sysex_transmission_buffer_[kSerializedPatchSize + 1];
+  static uint8_t sysex_bytes_sent_;
   
   static uint8_t sysex_bytes_received_;
   static uint8_t sysex_reception_state_;
   static uint8_t sysex_reception_checksum_;
+  // Number of bytes in the payload: a full patch, the user LFO shape, or a
+  // block of user wavetable.
+  static uint8_t sysex_data_size_;
+  static uint8_t sysex_command_;
+  static uint8_t sysex_argument_;
 };
 
-static const uint8_t kNumModulationSources = 16;
+static const uint8_t kNumModulationSources = 17;
 static const uint8_t kNumGlobalModulationSources = 11;
 static const uint8_t kNumVoiceModulationSources = kNumModulationSources -
     kNumGlobalModulationSources;
@@ -176,6 +254,8 @@ enum ModulationSource {
   MOD_SRC_VELOCITY,
   MOD_SRC_NOTE,
   MOD_SRC_GATE,
+  // Not saved, since it does not fit in the 4 bits of a patch source field.
+  MOD_SRC_VOICE_LFO,
 };
 
 enum ModulationDestination {
@@ -249,6 +329,18 @@ enum Parameter {
   
   PRM_ARP_PATTERN_SIZE = 94,
   PRM_ARP_PATTERN_ROTATION = 95,
+
+  PRM_ENV_CURVE_1 = 96,
+  PRM_ENV_CURVE_2 = 97,
+
+  PRM_MSEG_LEVEL = 98,
+  PRM_MSEG_TIME = 98 + kNumMultiStageSteps,
+  PRM_MSEG_LOOP_START = 98 + 2 * kNumMultiStageSteps,
+  PRM_MSEG_LOOP_END,
+  PRM_ENV_MULTISTAGE,
+
+  PRM_VOICE_LFO_WAVE = 117,
+  PRM_VOICE_LFO_RATE = 118,
 };
 
 enum OscillatorAlgorithm {
@@ -267,6 +359,8 @@ enum OscillatorAlgorithm {
   WAVEFORM_ANALOG_WAVETABLE,
   WAVEFORM_CZ_SYNC,
   WAVEFORM_QUAD_SAW_PAD,
+  WAVEFORM_UNISON_SAW,
+  WAVEFORM_USER_WAVETABLE,
 };
 
 enum LfoWave {
@@ -276,6 +370,20 @@ enum LfoWave {
   LFO_WAVEFORM_S_H,
   LFO_WAVEFORM_RAMP,
   LFO_WAVEFORM_STEP_SEQUENCER,
+  // Read from a table: the ones from the lfo_waveforms resource, then the
+  // user shape.
+  LFO_WAVEFORM_SINE,
+  LFO_WAVEFORM_EXPONENTIAL_DECAY,
+  LFO_WAVEFORM_EXPONENTIAL_RISE,
+  LFO_WAVEFORM_STEPS,
+  LFO_WAVEFORM_USER,
+};
+
+enum EnvelopeCurve {
+  ENVELOPE_CURVE_LINEAR,
+  ENVELOPE_CURVE_EXPONENTIAL,
+  ENVELOPE_CURVE_LOGARITHMIC,
+  ENVELOPE_CURVE_S,
 };
 
 enum Status {
@@ -292,6 +400,10 @@ enum OPERATOR {
 
 static const uint8_t kNumEditableParameters = 42;
 
+// Patch loaded at startup, laid out as the fields of the Patch class (the
+// first byte is keep_me_at_the_top).
+extern const prog_char empty_patch[] PROGMEM;
+
 static const uint8_t kNumArpeggiatorPatterns = 15;
 
 }  // namespace hardware_shruti
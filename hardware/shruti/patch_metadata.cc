@@ -22,6 +22,7 @@
 #include <avr/pgmspace.h>
 
 #include "hardware/shruti/patch.h"
+#include "hardware/shruti/shruti.h"
 
 namespace hardware_shruti {
 
@@ -29,7 +30,13 @@ static const prog_char raw_parameter_definition[
     kNumEditableParameters * sizeof(ParameterDefinition)] PROGMEM = {
   // Osc 1.
   PRM_OSC_SHAPE_1,
+#if defined(HAS_USER_WAVETABLES)
+  WAVEFORM_NONE, WAVEFORM_USER_WAVETABLE,
+#elif defined(HAS_UNISON_SAW)
+  WAVEFORM_NONE, WAVEFORM_UNISON_SAW,
+#else
   WAVEFORM_NONE, WAVEFORM_QUAD_SAW_PAD,
+#endif  // HAS_USER_WAVETABLES
   UNIT_WAVEFORM,
   STR_RES_SHAPE, STR_RES_SHAPE,
 
@@ -155,7 +162,11 @@ static const prog_char raw_parameter_definition[
 
   // Lfo.
   PRM_LFO_WAVE_1,
+#ifdef HAS_LFO_SHAPES
+  LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_USER,
+#else
   LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_STEP_SEQUENCER,
+#endif  // HAS_LFO_SHAPES
   UNIT_LFO_WAVEFORM,
   STR_RES_WV1, STR_RES_LFO1_WAVE,
 
@@ -165,7 +176,11 @@ static const prog_char raw_parameter_definition[
   STR_RES_RT1, STR_RES_LFO1_RATE,
 
   PRM_LFO_WAVE_2,
+#ifdef HAS_LFO_SHAPES
+  LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_USER,
+#else
   LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_STEP_SEQUENCER,
+#endif  // HAS_LFO_SHAPES
   UNIT_LFO_WAVEFORM,
   STR_RES_WV2, STR_RES_LFO2_WAVE,
 
@@ -181,7 +196,11 @@ static const prog_char raw_parameter_definition[
   STR_RES_MOD_, STR_RES_MOD_,
 
   PRM_MOD_SOURCE,
+#ifdef HAS_VOICE_LFO
   0, kNumModulationSources - 1,
+#else
+  0, MOD_SRC_GATE,
+#endif  // HAS_VOICE_LFO
   UNIT_MODULATION_SOURCE,
   STR_RES_SRC, STR_RES_SOURCE,
 
@@ -233,7 +252,11 @@ static const prog_char raw_parameter_definition[
   STR_RES_PRT, STR_RES_PORTA,
 
   PRM_KBD_MIDI_CHANNEL,
+#ifdef HAS_DUOPHONIC
+  0, 67, 
+#else
   0, 50, 
+#endif  // HAS_DUOPHONIC
   UNIT_MIDI_CHANNEL,
   STR_RES_CHN, STR_RES_MIDI_CHAN,
 
@@ -58,6 +58,8 @@ static const prog_char str_res_wavtbl[] PROGMEM = "wavtbl";
 static const prog_char str_res_sweep[] PROGMEM = "sweep";
 static const prog_char str_res_zsync[] PROGMEM = "zsync";
 static const prog_char str_res_pad[] PROGMEM = "pad";
+static const prog_char str_res_unison[] PROGMEM = "unison";
+static const prog_char str_res_user[] PROGMEM = "user";
 static const prog_char str_res_1S2[] PROGMEM = "1+2";
 static const prog_char str_res_1_2[] PROGMEM = "1>2";
 static const prog_char str_res_1P2[] PROGMEM = "1*2";
@@ -130,6 +132,11 @@ static const prog_char str_res_sqr[] PROGMEM = "sqr";
 static const prog_char str_res_s_h[] PROGMEM = "s&h";
 static const prog_char str_res_3[] PROGMEM = "";
 static const prog_char str_res__seq[] PROGMEM = "seq";
+static const prog_char str_res_sin[] PROGMEM = "sin";
+static const prog_char str_res_dcy[] PROGMEM = "dcy";
+static const prog_char str_res_rse[] PROGMEM = "rse";
+static const prog_char str_res_stp[] PROGMEM = "stp";
+static const prog_char str_res_usr[] PROGMEM = "usr";
 static const prog_char str_res_lf1[] PROGMEM = "lf1";
 static const prog_char str_res_lf2[] PROGMEM = "lf2";
 static const prog_char str_res_seq[] PROGMEM = "seq";
@@ -146,6 +153,7 @@ static const prog_char str_res_en2[] PROGMEM = "en2";
 static const prog_char str_res_vel[] PROGMEM = "vel";
 static const prog_char str_res_not[] PROGMEM = "not";
 static const prog_char str_res_gat[] PROGMEM = "gat";
+static const prog_char str_res_vlf[] PROGMEM = "vlf";
 static const prog_char str_res_lfo1[] PROGMEM = "lfo1";
 static const prog_char str_res_lfo2[] PROGMEM = "lfo2";
 static const prog_char str_res_stpseq[] PROGMEM = "stpseq";
@@ -162,6 +170,7 @@ static const prog_char str_res_env2[] PROGMEM = "env2";
 static const prog_char str_res_velo[] PROGMEM = "velo";
 static const prog_char str_res_note[] PROGMEM = "note";
 static const prog_char str_res_gate[] PROGMEM = "gate";
+static const prog_char str_res_v_lfo[] PROGMEM = "v.lfo";
 static const prog_char str_res_270[] PROGMEM = "270";
 static const prog_char str_res_300[] PROGMEM = "300";
 static const prog_char str_res_360[] PROGMEM = "360";
@@ -184,6 +193,8 @@ static const prog_char str_res_x2_ext[] PROGMEM = "x2 ext";
 static const prog_char str_res__2_ext[] PROGMEM = "/2 ext";
 static const prog_char str_res__4_ext[] PROGMEM = "/4 ext";
 static const prog_char str_res__8_ext[] PROGMEM = "/8 ext";
+static const prog_char str_res_midi_peak[] PROGMEM = "midi peak";
+static const prog_char str_res_midi_lost[] PROGMEM = "midi lost";
 static const prog_char str_res_mutable____v0_59[] PROGMEM = "mutable    v0.59";
 static const prog_char str_res_instruments_671[] PROGMEM = "instruments -1";
 static const prog_char str_res_equal[] PROGMEM = "equal";
@@ -255,6 +266,8 @@ PROGMEM const prog_char* string_table[] = {
   str_res_sweep,
   str_res_zsync,
   str_res_pad,
+  str_res_unison,
+  str_res_user,
   str_res_1S2,
   str_res_1_2,
   str_res_1P2,
@@ -327,6 +340,11 @@ PROGMEM const prog_char* string_table[] = {
   str_res_s_h,
   str_res_3,
   str_res__seq,
+  str_res_sin,
+  str_res_dcy,
+  str_res_rse,
+  str_res_stp,
+  str_res_usr,
   str_res_lf1,
   str_res_lf2,
   str_res_seq,
@@ -343,6 +361,7 @@ PROGMEM const prog_char* string_table[] = {
   str_res_vel,
   str_res_not,
   str_res_gat,
+  str_res_vlf,
   str_res_lfo1,
   str_res_lfo2,
   str_res_stpseq,
@@ -359,6 +378,7 @@ PROGMEM const prog_char* string_table[] = {
   str_res_velo,
   str_res_note,
   str_res_gate,
+  str_res_v_lfo,
   str_res_270,
   str_res_300,
   str_res_360,
@@ -381,6 +401,8 @@ PROGMEM const prog_char* string_table[] = {
   str_res__2_ext,
   str_res__4_ext,
   str_res__8_ext,
+  str_res_midi_peak,
+  str_res_midi_lost,
   str_res_mutable____v0_59,
   str_res_instruments_671,
   str_res_equal,
@@ -705,6 +727,10 @@ const prog_uint16_t lut_res_groove_human[] PROGMEM = {
       88,   -101,    107,    -95,     88,    -88,     50,    -38, 
       65,    -88,    101,    -95,    101,   -127,     63,    -31, 
 };
+const prog_uint16_t lut_res_wavetable_offsets[] PROGMEM = {
+       0,     66,    132,    198,    264,    330,    396,    462, 
+     528,    594,    660,    789,    918,    984,   1050,   1179, 
+};
 
 
 PROGMEM const prog_uint16_t* lookup_table_table[] = {
@@ -751,6 +777,7 @@ PROGMEM const prog_uint16_t* lookup_table_table[] = {
   lut_res_groove_push,
   lut_res_groove_lag,
   lut_res_groove_human,
+  lut_res_wavetable_offsets,
 };
 
 const prog_uint8_t wav_res_formant_sine[] PROGMEM = {
@@ -838,23 +865,7 @@ const prog_uint8_t wav_res_bandlimited_square_0[] PROGMEM = {
      220,    220,    220,    220,    220,    220,    219,    218, 
      218,    217,    217,    218,    217,    217,    216,    216, 
      215,    215,    215,    215,    215,    214,    213,    213, 
-     212,    212,    213,    213,    212,    211,    211,    210, 
-     210,    210,    210,    210,    209,    208,    208,    207, 
-     207,    208,    208,    207,    206,    206,    205,    205, 
-     205,    205,    205,    204,    204,    203,    202,    202, 
-     203,    203,    202,    202,    201,    200,    200,    200, 
-     200,    200,    200,    198,    197,    197,    197,    198, 
-     198,    198,    197,    195,    194,    194,    195,    197, 
-     197,    196,    193,    189,    188,    191,    200,    213, 
-       0,     14,     24,     27,     27,     24,     22,     21, 
-      22,     24,     26,     27,     26,     25,     25,     25, 
-      26,     28,     29,     29,     28,     28,     28,     28, 
-      29,     30,     31,     31,     31,     30,     31,     31, 
-      32,     33,     33,     33,     33,     33,     34,     34, 
-      35,     36,     36,     36,     36,     36,     36,     37, 
-      38,     38,     38,     38,     38,     39,     39,     40, 
-      41,     41,     41,     41,     41,     41,     42,     43, 
-      43, 
+     212, 
 };
 const prog_uint8_t wav_res_bandlimited_square_1[] PROGMEM = {
       55,     54,     54,     56,     56,     55,     56,     57, 
@@ -873,23 +884,7 @@ const prog_uint8_t wav_res_bandlimited_square_1[] PROGMEM = {
      207,    207,    208,    207,    206,    206,    207,    206, 
      205,    206,    206,    205,    204,    205,    205,    203, 
      203,    204,    204,    202,    202,    203,    202,    201, 
-     201,    202,    201,    200,    200,    200,    200,    198, 
-     199,    199,    199,    197,    198,    198,    197,    196, 
-     197,    197,    196,    195,    196,    196,    195,    194, 
-     195,    195,    193,    193,    194,    194,    192,    192, 
-     193,    193,    191,    191,    192,    191,    189,    190, 
-     191,    190,    188,    189,    190,    189,    186,    188, 
-     190,    187,    185,    187,    189,    185,    183,    187, 
-     189,    182,    180,    189,    191,    175,    172,    219, 
-       0,     47,     45,     30,     33,     42,     40,     34, 
-      37,     42,     40,     36,     39,     42,     40,     38, 
-      41,     43,     41,     40,     42,     44,     42,     41, 
-      43,     44,     43,     43,     45,     45,     44,     44, 
-      46,     46,     45,     45,     47,     47,     46,     47, 
-      48,     48,     47,     48,     49,     49,     48,     49, 
-      51,     50,     50,     51,     52,     51,     51,     52, 
-      53,     52,     52,     53,     54,     53,     53,     55, 
-      55, 
+     201, 
 };
 const prog_uint8_t wav_res_bandlimited_square_2[] PROGMEM = {
       41,     40,     41,     42,     41,     41,     43,     43, 
@@ -908,23 +903,7 @@ const prog_uint8_t wav_res_bandlimited_square_2[] PROGMEM = {
      223,    224,    224,    222,    222,    223,    221,    221, 
      222,    221,    219,    220,    220,    219,    219,    220, 
      218,    217,    218,    218,    216,    217,    217,    215, 
-     215,    216,    215,    214,    215,    214,    213,    213, 
-     214,    212,    212,    213,    212,    210,    211,    211, 
-     209,    209,    210,    209,    208,    209,    209,    207, 
-     208,    208,    206,    206,    207,    206,    204,    206, 
-     205,    203,    204,    205,    203,    202,    204,    202, 
-     200,    202,    202,    199,    200,    202,    199,    198, 
-     201,    200,    196,    199,    200,    195,    196,    201, 
-     196,    191,    200,    199,    186,    197,    212,    158, 
-      54,      1,     17,     29,     16,     15,     25,     21, 
-      17,     23,     24,     19,     21,     25,     22,     21, 
-      25,     25,     22,     25,     27,     24,     25,     28, 
-      26,     25,     28,     28,     26,     28,     30,     28, 
-      28,     31,     30,     29,     31,     32,     30,     31, 
-      33,     32,     32,     34,     33,     33,     34,     35, 
-      34,     35,     36,     35,     35,     37,     37,     36, 
-      37,     38,     37,     38,     40,     39,     39,     40, 
-      41, 
+     215, 
 };
 const prog_uint8_t wav_res_bandlimited_square_3[] PROGMEM = {
       36,     37,     39,     41,     41,     41,     40,     39, 
@@ -943,23 +922,7 @@ const prog_uint8_t wav_res_bandlimited_square_3[] PROGMEM = {
      226,    224,    223,    223,    224,    225,    226,    226, 
      224,    222,    221,    220,    221,    222,    223,    223, 
      222,    220,    219,    218,    217,    218,    219,    220, 
-     220,    218,    216,    215,    214,    215,    216,    217, 
-     217,    216,    214,    213,    211,    211,    212,    213, 
-     214,    214,    212,    211,    209,    208,    209,    210, 
-     211,    211,    210,    209,    206,    205,    205,    206, 
-     208,    209,    209,    207,    204,    202,    201,    202, 
-     204,    206,    207,    206,    203,    199,    197,    197, 
-     199,    203,    206,    206,    203,    197,    192,    189, 
-     192,    199,    208,    213,    210,    194,    166,    127, 
-      85,     46,     18,      3,      1,      7,     17,     24, 
-      27,     26,     21,     16,     14,     15,     18,     23, 
-      26,     26,     24,     22,     19,     19,     21,     24, 
-      26,     28,     27,     26,     24,     23,     23,     25, 
-      28,     29,     30,     29,     28,     27,     26,     28, 
-      29,     31,     33,     32,     31,     30,     30,     30, 
-      32,     33,     35,     35,     35,     34,     33,     33, 
-      34,     35,     37,     38,     38,     37,     36,     36, 
-      36, 
+     220, 
 };
 const prog_uint8_t wav_res_bandlimited_square_4[] PROGMEM = {
       41,     41,     41,     40,     39,     38,     37,     36, 
@@ -978,23 +941,7 @@ const prog_uint8_t wav_res_bandlimited_square_4[] PROGMEM = {
      223,    222,    221,    221,    221,    222,    223,    224, 
      225,    227,    227,    228,    228,    228,    227,    226, 
      225,    223,    221,    220,    218,    217,    215,    215, 
-     214,    214,    215,    216,    217,    218,    219,    220, 
-     220,    221,    220,    220,    219,    218,    216,    214, 
-     212,    210,    209,    207,    207,    206,    206,    206, 
-     207,    209,    210,    211,    213,    214,    214,    215, 
-     214,    213,    212,    210,    207,    205,    202,    199, 
-     197,    196,    195,    195,    196,    197,    200,    203, 
-     206,    210,    213,    215,    217,    217,    215,    212, 
-     206,    198,    188,    177,    163,    148,    131,    114, 
-      97,     80,     64,     50,     36,     25,     16,      9, 
-       4,      1,      1,      2,      4,      7,     11,     15, 
-      19,     23,     26,     29,     30,     31,     30,     30, 
-      28,     26,     24,     22,     20,     19,     18,     18, 
-      19,     19,     21,     23,     25,     27,     29,     31, 
-      33,     34,     34,     35,     34,     34,     33,     31, 
-      30,     29,     28,     28,     27,     28,     28,     29, 
-      31,     32,     34,     36,     38,     39,     40,     41, 
-      41, 
+     214, 
 };
 const prog_uint8_t wav_res_bandlimited_square_5[] PROGMEM = {
       47,     47,     47,     47,     47,     46,     46,     45, 
@@ -1013,23 +960,7 @@ const prog_uint8_t wav_res_bandlimited_square_5[] PROGMEM = {
      245,    243,    241,    239,    237,    235,    233,    231, 
      229,    227,    225,    223,    221,    220,    218,    217, 
      215,    214,    213,    212,    211,    210,    209,    209, 
-     209,    209,    209,    209,    209,    209,    210,    210, 
-     211,    212,    213,    214,    215,    216,    217,    219, 
-     220,    221,    222,    223,    225,    226,    227,    228, 
-     229,    229,    230,    230,    231,    231,    231,    230, 
-     230,    229,    229,    227,    226,    224,    223,    221, 
-     218,    216,    213,    210,    207,    203,    199,    195, 
-     191,    187,    182,    177,    172,    167,    162,    156, 
-     151,    145,    139,    133,    127,    121,    115,    109, 
-     103,     97,     92,     86,     80,     74,     69,     63, 
-      58,     53,     48,     44,     39,     35,     31,     27, 
-      23,     20,     17,     14,     12,      9,      7,      6, 
-       4,      3,      2,      1,      1,      1,      1,      1, 
-       1,      2,      3,      4,      5,      6,      8,      9, 
-      11,     13,     15,     17,     19,     21,     23,     25, 
-      27,     29,     30,     32,     34,     36,     37,     39, 
-      40,     42,     43,     44,     45,     46,     46,     47, 
-      47, 
+     209, 
 };
 const prog_uint8_t wav_res_bandlimited_square_6[] PROGMEM = {
        1,      1,      1,      1,      2,      2,      2,      3, 
@@ -1048,23 +979,7 @@ const prog_uint8_t wav_res_bandlimited_square_6[] PROGMEM = {
      234,    235,    237,    239,    240,    241,    243,    244, 
      245,    247,    247,    249,    250,    251,    251,    252, 
      252,    254,    253,    254,    255,    254,    255,    255, 
-     255,    255,    254,    255,    255,    254,    254,    253, 
-     252,    252,    251,    250,    250,    248,    247,    246, 
-     245,    244,    243,    241,    239,    238,    237,    235, 
-     234,    232,    230,    228,    226,    224,    222,    220, 
-     217,    216,    214,    210,    208,    206,    204,    201, 
-     199,    196,    193,    191,    188,    185,    182,    179, 
-     177,    174,    171,    168,    164,    162,    159,    156, 
-     153,    149,    147,    143,    141,    138,    135,    131, 
-     128,    125,    122,    118,    115,    112,    109,    106, 
-     103,    100,     97,     94,     91,     88,     85,     83, 
-      80,     77,     74,     71,     68,     66,     62,     60, 
-      58,     55,     52,     50,     47,     45,     43,     40, 
-      38,     36,     34,     32,     30,     28,     26,     24, 
-      22,     21,     19,     18,     16,     15,     14,     12, 
-      11,     10,      9,      7,      6,      6,      4,      4, 
-       3,      3,      3,      2,      2,      2,      1,      1, 
-       1, 
+     255, 
 };
 const prog_uint8_t wav_res_bandlimited_saw_0[] PROGMEM = {
       85,     85,     86,     87,     88,     89,     90,     91, 
@@ -1276,6 +1191,41 @@ const prog_uint8_t wav_res_bandlimited_saw_5[] PROGMEM = {
       74,     75,     76,     77,     77,     78,     78,     79, 
       79, 
 };
+const prog_uint8_t wav_res_bandlimited_saw_6[] PROGMEM = {
+       1,      1,      1,      1,      2,      2,      2,      3, 
+       4,      4,      5,      5,      7,      8,      9,      9, 
+      11,     12,     13,     14,     16,     18,     19,     21, 
+      23,     24,     26,     28,     30,     32,     34,     36, 
+      38,     40,     43,     45,     48,     50,     52,     54, 
+      58,     60,     62,     66,     68,     71,     74,     77, 
+      80,     82,     86,     88,     91,     94,     97,    100, 
+     103,    106,    109,    113,    116,    118,    122,    125, 
+     128,    131,    134,    137,    141,    144,    147,    149, 
+     152,    156,    158,    162,    165,    167,    170,    174, 
+     177,    179,    182,    185,    187,    190,    193,    196, 
+     198,    201,    204,    206,    209,    211,    213,    215, 
+     218,    220,    222,    225,    226,    228,    230,    232, 
+     234,    235,    237,    239,    240,    241,    243,    244, 
+     245,    247,    247,    249,    250,    251,    251,    252, 
+     252,    254,    253,    254,    255,    254,    255,    255, 
+     255,    255,    254,    255,    255,    254,    254,    253, 
+     252,    252,    251,    250,    250,    248,    247,    246, 
+     245,    244,    243,    241,    239,    238,    237,    235, 
+     234,    232,    230,    228,    226,    224,    222,    220, 
+     217,    216,    214,    210,    208,    206,    204,    201, 
+     199,    196,    193,    191,    188,    185,    182,    179, 
+     177,    174,    171,    168,    164,    162,    159,    156, 
+     153,    149,    147,    143,    141,    138,    135,    131, 
+     128,    125,    122,    118,    115,    112,    109,    106, 
+     103,    100,     97,     94,     91,     88,     85,     83, 
+      80,     77,     74,     71,     68,     66,     62,     60, 
+      58,     55,     52,     50,     47,     45,     43,     40, 
+      38,     36,     34,     32,     30,     28,     26,     24, 
+      22,     21,     19,     18,     16,     15,     14,     12, 
+      11,     10,      9,      7,      6,      6,      4,      4, 
+       3,      3,      3,      2,      2,      2,      1,      1, 
+       1, 
+};
 const prog_uint8_t wav_res_bandlimited_triangle_0[] PROGMEM = {
        2,      5,      7,      9,     10,     12,     14,     16, 
       18,     20,     22,     24,     26,     28,     30,     32, 
@@ -1285,31 +1235,7 @@ const prog_uint8_t wav_res_bandlimited_triangle_0[] PROGMEM = {
       81,     83,     84,     86,     88,     90,     92,     94, 
       96,     98,    100,    102,    104,    106,    108,    110, 
      112,    114,    116,    118,    120,    122,    123,    125, 
-     127,    129,    131,    133,    135,    137,    139,    141, 
-     143,    145,    147,    149,    151,    153,    155,    157, 
-     159,    160,    162,    164,    166,    168,    170,    172, 
-     174,    176,    178,    180,    182,    184,    186,    188, 
-     190,    192,    194,    196,    198,    199,    201,    203, 
-     205,    207,    209,    211,    213,    215,    217,    219, 
-     221,    223,    225,    227,    229,    231,    233,    235, 
-     237,    239,    241,    242,    244,    246,    248,    250, 
-     255,    253,    250,    248,    247,    245,    243,    241, 
-     239,    237,    235,    233,    231,    229,    227,    225, 
-     223,    221,    219,    217,    215,    213,    211,    209, 
-     207,    205,    203,    201,    199,    197,    196,    194, 
-     192,    190,    188,    186,    184,    182,    180,    178, 
-     176,    174,    172,    170,    168,    166,    164,    162, 
-     160,    158,    156,    154,    152,    150,    148,    146, 
-     144,    142,    140,    138,    136,    134,    133,    131, 
-     129,    127,    125,    123,    121,    119,    117,    115, 
-     113,    111,    109,    107,    105,    103,    101,     99, 
-      97,     95,     93,     91,     89,     87,     85,     83, 
-      81,     79,     77,     75,     73,     72,     70,     68, 
-      66,     64,     62,     60,     58,     56,     54,     52, 
-      50,     48,     46,     44,     42,     40,     38,     36, 
-      34,     32,     30,     28,     26,     24,     22,     20, 
-      18,     16,     14,     12,     11,      9,      7,      5, 
-       2, 
+     127,    129, 
 };
 const prog_uint8_t wav_res_bandlimited_triangle_1[] PROGMEM = {
        2,      5,      7,      9,     11,     13,     15,     17, 
@@ -1320,31 +1246,7 @@ const prog_uint8_t wav_res_bandlimited_triangle_1[] PROGMEM = {
       81,     83,     85,     86,     88,     90,     92,     94, 
       96,     98,    100,    102,    104,    106,    108,    110, 
      112,    114,    116,    118,    119,    121,    123,    125, 
-     127,    129,    131,    133,    135,    137,    139,    141, 
-     143,    145,    147,    149,    151,    152,    154,    156, 
-     158,    160,    162,    164,    166,    168,    170,    172, 
-     174,    176,    178,    180,    182,    184,    186,    187, 
-     189,    191,    193,    195,    197,    199,    201,    203, 
-     205,    207,    209,    211,    213,    215,    217,    218, 
-     220,    222,    224,    226,    228,    230,    232,    234, 
-     236,    238,    240,    242,    244,    246,    248,    249, 
-     255,    252,    250,    249,    247,    244,    243,    241, 
-     239,    237,    235,    233,    231,    229,    227,    225, 
-     223,    221,    219,    217,    215,    213,    211,    209, 
-     207,    205,    203,    201,    199,    197,    196,    194, 
-     192,    190,    188,    186,    184,    182,    180,    178, 
-     176,    174,    172,    170,    168,    166,    164,    162, 
-     160,    158,    156,    154,    152,    150,    148,    146, 
-     144,    142,    140,    139,    137,    135,    133,    131, 
-     129,    127,    125,    123,    121,    119,    117,    115, 
-     113,    111,    109,    107,    105,    103,    101,     99, 
-      97,     95,     93,     91,     89,     87,     85,     84, 
-      82,     80,     78,     76,     74,     72,     70,     68, 
-      66,     64,     62,     60,     58,     56,     54,     52, 
-      50,     48,     46,     44,     42,     40,     38,     36, 
-      34,     32,     30,     29,     27,     25,     23,     21, 
-      19,     17,     15,     13,     11,      9,      7,      5, 
-       2, 
+     127,    129, 
 };
 const prog_uint8_t wav_res_bandlimited_triangle_2[] PROGMEM = {
        2,      3,      5,      7,      9,     11,     13,     15, 
@@ -1355,31 +1257,7 @@ const prog_uint8_t wav_res_bandlimited_triangle_2[] PROGMEM = {
       80,     82,     84,     86,     88,     90,     92,     94, 
       96,     98,    100,    102,    104,    106,    108,    110, 
      112,    114,    116,    118,    120,    122,    124,    126, 
-     128,    130,    132,    134,    136,    138,    140,    142, 
-     144,    146,    147,    149,    151,    153,    155,    157, 
-     159,    161,    163,    165,    167,    169,    171,    173, 
-     175,    177,    179,    181,    183,    185,    187,    189, 
-     191,    193,    195,    197,    199,    201,    203,    205, 
-     207,    209,    211,    213,    215,    217,    219,    221, 
-     223,    225,    227,    229,    231,    233,    235,    236, 
-     239,    240,    242,    244,    246,    248,    250,    253, 
-     255,    254,    251,    249,    248,    246,    243,    242, 
-     240,    238,    236,    234,    232,    230,    228,    226, 
-     224,    222,    220,    218,    216,    214,    212,    210, 
-     208,    206,    204,    202,    200,    198,    196,    194, 
-     192,    190,    188,    186,    184,    182,    180,    178, 
-     176,    174,    172,    170,    168,    166,    164,    162, 
-     160,    158,    156,    154,    152,    150,    148,    146, 
-     144,    142,    140,    138,    136,    134,    132,    130, 
-     128,    126,    124,    122,    120,    118,    116,    114, 
-     112,    110,    108,    106,    104,    102,    100,     98, 
-      96,     95,     93,     91,     89,     87,     85,     83, 
-      81,     79,     77,     75,     73,     71,     69,     67, 
-      65,     63,     61,     59,     57,     55,     53,     51, 
-      49,     47,     45,     43,     41,     39,     37,     35, 
-      33,     31,     29,     27,     25,     23,     21,     19, 
-      17,     15,     13,     11,      9,      7,      5,      3, 
-       2, 
+     128,    130, 
 };
 const prog_uint8_t wav_res_bandlimited_triangle_3[] PROGMEM = {
        1,      2,      3,      5,      7,     10,     12,     14, 
@@ -1390,31 +1268,7 @@ const prog_uint8_t wav_res_bandlimited_triangle_3[] PROGMEM = {
       80,     82,     84,     86,     88,     90,     92,     94, 
       96,     98,    100,    102,    104,    106,    108,    110, 
      112,    114,    116,    118,    120,    122,    124,    126, 
-     128,    130,    132,    134,    136,    138,    140,    142, 
-     144,    146,    148,    150,    152,    154,    156,    158, 
-     160,    162,    164,    166,    168,    170,    172,    174, 
-     176,    178,    180,    182,    184,    186,    188,    190, 
-     192,    194,    196,    198,    200,    202,    204,    206, 
-     208,    210,    212,    214,    216,    218,    220,    222, 
-     224,    226,    228,    230,    232,    234,    236,    238, 
-     240,    242,    244,    246,    248,    251,    253,    254, 
-     255,    255,    253,    251,    249,    247,    244,    242, 
-     240,    239,    237,    235,    233,    231,    228,    226, 
-     224,    222,    221,    219,    217,    215,    212,    210, 
-     208,    206,    204,    203,    201,    198,    196,    194, 
-     192,    190,    188,    186,    184,    182,    180,    178, 
-     176,    174,    172,    170,    168,    166,    164,    162, 
-     160,    158,    156,    154,    152,    150,    148,    146, 
-     144,    142,    140,    138,    136,    134,    132,    130, 
-     128,    126,    124,    122,    120,    118,    116,    114, 
-     112,    110,    108,    106,    104,    102,    100,     98, 
-      96,     94,     92,     90,     88,     86,     84,     82, 
-      80,     78,     76,     74,     72,     70,     68,     66, 
-      64,     62,     60,     58,     56,     54,     52,     50, 
-      48,     46,     44,     42,     40,     38,     36,     34, 
-      32,     30,     28,     26,     24,     21,     19,     18, 
-      16,     14,     12,     10,      7,      5,      3,      2, 
-       1, 
+     128,    130, 
 };
 const prog_uint8_t wav_res_bandlimited_triangle_4[] PROGMEM = {
        1,      1,      2,      3,      4,      6,      7,     10, 
@@ -1425,31 +1279,7 @@ const prog_uint8_t wav_res_bandlimited_triangle_4[] PROGMEM = {
       79,     81,     83,     85,     87,     89,     91,     93, 
       95,     97,     99,    101,    103,    105,    107,    110, 
      112,    114,    116,    118,    120,    122,    124,    126, 
-     128,    130,    132,    134,    136,    138,    140,    142, 
-     144,    146,    148,    151,    153,    155,    157,    159, 
-     161,    163,    165,    167,    169,    171,    173,    175, 
-     177,    179,    181,    183,    185,    187,    189,    191, 
-     194,    196,    198,    200,    202,    204,    206,    208, 
-     210,    212,    214,    216,    218,    220,    222,    224, 
-     226,    228,    230,    232,    235,    237,    239,    242, 
-     244,    246,    248,    250,    252,    253,    254,    255, 
-     255,    255,    254,    253,    252,    250,    249,    247, 
-     244,    242,    240,    237,    235,    232,    230,    228, 
-     226,    224,    222,    220,    218,    216,    214,    212, 
-     210,    209,    207,    205,    202,    200,    198,    196, 
-     194,    192,    189,    187,    185,    183,    181,    179, 
-     177,    175,    173,    171,    169,    167,    165,    163, 
-     161,    159,    157,    155,    153,    151,    149,    146, 
-     144,    142,    140,    138,    136,    134,    132,    130, 
-     128,    126,    124,    122,    120,    118,    116,    114, 
-     112,    110,    108,    105,    103,    101,     99,     97, 
-      95,     93,     91,     89,     87,     85,     83,     81, 
-      79,     77,     75,     73,     71,     69,     67,     64, 
-      62,     60,     58,     56,     54,     52,     50,     48, 
-      46,     44,     42,     40,     38,     36,     34,     32, 
-      30,     28,     26,     24,     21,     19,     16,     14, 
-      12,     10,      7,      6,      4,      3,      2,      1, 
-       1, 
+     128,    130, 
 };
 const prog_uint8_t wav_res_bandlimited_triangle_5[] PROGMEM = {
        1,      1,      1,      2,      2,      3,      3,      4, 
@@ -1460,291 +1290,188 @@ const prog_uint8_t wav_res_bandlimited_triangle_5[] PROGMEM = {
       77,     79,     82,     84,     87,     89,     91,     94, 
       96,     98,    100,    103,    105,    107,    109,    111, 
      113,    115,    117,    119,    120,    122,    124,    126, 
-     128,    130,    132,    134,    135,    137,    139,    141, 
-     143,    145,    147,    149,    151,    153,    156,    158, 
-     160,    162,    165,    167,    169,    172,    174,    176, 
-     179,    182,    184,    187,    189,    192,    195,    197, 
-     200,    202,    205,    208,    210,    213,    215,    218, 
-     221,    223,    225,    228,    230,    232,    234,    236, 
-     238,    240,    242,    244,    245,    247,    248,    249, 
-     251,    252,    252,    253,    254,    254,    255,    255, 
-     255,    255,    255,    254,    254,    253,    253,    252, 
-     251,    250,    248,    247,    245,    244,    242,    240, 
-     238,    236,    234,    232,    230,    228,    225,    223, 
-     221,    218,    216,    213,    210,    208,    205,    202, 
-     200,    197,    195,    192,    189,    187,    184,    182, 
-     179,    177,    174,    172,    169,    167,    165,    162, 
-     160,    158,    156,    153,    151,    149,    147,    145, 
-     143,    141,    139,    137,    136,    134,    132,    130, 
-     128,    126,    124,    122,    120,    119,    117,    115, 
-     113,    111,    109,    107,    105,    103,    100,     98, 
-      96,     94,     91,     89,     87,     84,     82,     79, 
-      77,     74,     72,     69,     67,     64,     61,     59, 
-      56,     54,     51,     48,     46,     43,     40,     38, 
-      35,     33,     31,     28,     26,     24,     22,     20, 
-      18,     16,     14,     12,     11,      9,      8,      6, 
-       5,      4,      3,      3,      2,      2,      1,      1, 
-       1, 
+     128,    130, 
+};
+const prog_uint8_t wav_res_bandlimited_triangle_6[] PROGMEM = {
+       1,      1,      1,      1,      2,      2,      2,      3, 
+       4,      4,      5,      5,      7,      8,      9,      9, 
+      11,     12,     13,     14,     16,     18,     19,     21, 
+      23,     24,     26,     28,     30,     32,     34,     36, 
+      38,     40,     43,     45,     48,     50,     52,     54, 
+      58,     60,     62,     66,     68,     71,     74,     77, 
+      80,     82,     86,     88,     91,     94,     97,    100, 
+     103,    106,    109,    113,    116,    118,    122,    125, 
+     128,    131, 
 };
 const prog_uint8_t wav_res_wavetable[] PROGMEM = {
-       0,      1,      2,      5,      8,     12,     17,     22, 
-      28,     35,     42,     49,     57,     65,     73,     81, 
-      89,     97,    105,    112,    119,    126,    133,    139, 
-     144,    149,    154,    158,    161,    164,    166,    167, 
-     168,    169,    168,    167,    166,    164,    162,    159, 
-     156,    153,    150,    146,    142,    138,    134,    130, 
-     125,    121,    118,    114,    110,    107,    104,    101, 
-      99,     97,     95,     94,     93,     92,     91,     91, 
-      91,     92,     92,     93,     94,     95,     97,     98, 
-     100,    101,    103,    104,    106,    107,    108,    109, 
-     115,    128,    144,    161,    178,    193,    207,    218, 
-     228,    236,    243,    249,    253,    255,    255,    255, 
-     254,    251,    247,    241,    235,    227,    219,    210, 
-     200,    189,    178,    167,    155,    143,    131,    119, 
-     107,     95,     84,     73,     63,     53,     44,     36, 
-      28,     21,     15,     10,      6,      3,      1,      0, 
-       0,     11,     17,     23,     30,     37,     46,     54, 
-      63,     73,     82,     91,    101,    110,    119,    128, 
-     136,    143,    151,    157,    163,    168,    172,    175, 
-     178,    180,    181,    181,    181,    179,    177,    175, 
-     172,    168,    164,    159,    154,    149,    144,    138, 
-     133,    127,    122,    117,    112,    107,    103,     99, 
-      95,     92,     89,     86,     85,     83,     82,     82, 
-      82,     82,     82,     84,     85,     86,     88,     90, 
-      92,     94,     97,     99,    101,    103,    105,    106, 
-     108,    109,    110,    111,    111,    112,    111,    111, 
-     111,    115,    125,    141,    159,    177,    194,    209, 
-     221,    232,    240,    247,    252,    255,    255,    255, 
-     254,    250,    245,    239,    231,    222,    212,    201, 
-     190,    178,    165,    152,    138,    125,    112,     99, 
-      86,     74,     62,     52,     42,     33,     25,     18, 
-      12,      7,      4,      1,      0,      0,      1,      4, 
-       7,     11,     84,     90,     95,     99,    100,    101, 
-     102,    101,    100,    100,     99,     98,    100,    101, 
-     103,    106,    109,    113,    117,    119,    124,    128, 
-     131,    135,    138,    141,    145,    149,    152,    154, 
-     156,    157,    158,    157,    156,    155,    155,    155, 
-     155,    156,    159,    163,    169,    176,    183,    192, 
-     203,    212,    221,    230,    238,    244,    249,    254, 
-     255,    255,    255,    249,    238,    225,    213,    197, 
-     175,    154,    135,    117,     96,     77,     61,     48, 
-      36,     29,     24,     20,     21,     24,     29,     36, 
-      45,     53,     63,     76,     89,     99,    109,    124, 
-     140,    153,    162,    173,    186,    198,    208,    216, 
-     224,    229,    233,    236,    235,    230,    224,    215, 
-     202,    187,    170,    149,    130,    111,     92,     69, 
-      50,     37,     24,     11,      3,      0,      1,      0, 
-       4,      9,     15,     22,     31,     40,     48,     58, 
-      68,     77,     84,    218,    210,    199,    187,    173, 
-     157,    142,    126,    111,     96,     83,     71,     61, 
-      53,     48,     45,     44,     46,     49,     55,     63, 
-      72,     82,     94,    106,    117,    129,    140,    151, 
-     160,    168,    174,    178,    181,    182,    182,    180, 
-     176,    171,    165,    158,    150,    142,    134,    126, 
-     118,    111,    105,    100,     96,     93,     91,     90, 
-      90,     92,     94,     97,    101,    105,    109,    114, 
-     118,    122,    126,    129,    132,    134,    136,    137, 
-     137,    137,    136,    135,    134,    132,    130,    129, 
-     127,    126,    125,    125,    127,    137,    157,    181, 
-     205,    226,    241,    251,    255,    255,    250,    240, 
-     227,    210,    191,    170,    148,    125,    103,     82, 
-      62,     44,     28,     16,      7,      2,      0,      2, 
-       7,     16,     27,     41,     58,     76,     94,    114, 
-     133,    152,    169,    185,    199,    211,    219,    225, 
-     228,    228,    224,    218,    103,    112,    116,    122, 
-     127,    128,    125,    124,    121,    115,    110,    108, 
-     101,     94,     92,     92,     90,     87,     89,     94, 
-      95,     97,    101,    105,    107,    110,    113,    113, 
-     113,    114,    115,    113,    111,    110,    110,    107, 
-     104,    103,    102,     99,     97,     96,     92,     87, 
-      84,     79,     71,     64,     57,     50,     43,     37, 
-      35,     32,     30,     29,     31,     32,     32,     33, 
-      35,     35,     35,     35,     35,     32,     30,     28, 
-      25,     21,     18,     17,     13,      9,      7,      5, 
-       0,      2,     10,     19,     24,     38,     62,     85, 
-     101,    125,    155,    176,    193,    217,    235,    239, 
-     244,    255,    254,    239,    231,    226,    210,    189, 
-     177,    164,    145,    129,    120,    106,     90,     81, 
-      75,     65,     52,     44,     39,     32,     24,     18, 
-      15,     13,     14,     16,     19,     26,     34,     44, 
-      57,     68,     78,     90,    103,    152,    142,    126, 
-     111,     98,     81,     60,     43,     35,     26,     17, 
-      12,     16,     22,     28,     36,     47,     61,     74, 
-      83,     94,    107,    117,    126,    133,    141,    147, 
-     152,    154,    155,    155,    153,    146,    137,    126, 
-     116,    103,     87,     73,     62,     51,     41,     33, 
-      30,     30,     28,     29,     33,     38,     42,     46, 
-      50,     55,     59,     62,     64,     66,     67,     68, 
-      66,     62,     59,     56,     50,     42,     35,     31, 
-      25,     16,     11,     10,      7,      2,      0,      3, 
-       4,      3,      6,     10,     16,     24,     42,     61, 
-      80,     98,    127,    162,    187,    201,    225,    250, 
-     255,    249,    244,    238,    222,    194,    166,    143, 
-     119,     95,     68,     48,     37,     31,     22,     16, 
-      20,     27,     29,     33,     41,     49,     54,     61, 
-      70,     76,     83,     94,    106,    115,    124,    136, 
-     147,    154,    156,    156,    156,    152,    194,    167, 
-     137,    107,     80,     59,     45,     41,     45,     58, 
-      78,    103,    129,    155,    179,    196,    207,    211, 
-     206,    194,    177,    155,    132,    110,     91,     76, 
-      67,     65,     70,     80,     95,    113,    133,    151, 
-     167,    178,    185,    186,    182,    173,    160,    146, 
-     130,    116,    103,     95,     90,     90,     93,    101, 
-     111,    122,    134,    144,    153,    159,    162,    162, 
-     158,    153,    146,    138,    130,    123,    118,    115, 
-     114,    114,    117,    120,    125,    129,    133,    136, 
-     138,    138,    138,    137,    135,    134,    132,    132, 
-     135,    152,    182,    211,    228,    229,    215,    186, 
-     149,    109,     69,     36,     12,      1,      2,     17, 
-      43,     77,    117,    157,    195,    226,    247,    255, 
-     253,    238,    213,    180,    143,    106,     71,     44, 
-      25,     18,     22,     36,     60,     90,    124,    158, 
-     188,    213,    228,    234,    230,    216,    194,    203, 
-     176,    142,    102,     67,     39,     25,     27,     36, 
-      53,     66,     82,     96,    114,    126,    132,    135, 
-     132,    130,    130,    140,    152,    168,    181,    189, 
-     193,    189,    182,    167,    148,    126,     97,     74, 
-      55,     48,     49,     59,     73,     88,    106,    120, 
-     136,    146,    156,    158,    156,    152,    148,    150, 
-     151,    157,    160,    162,    161,    157,    152,    141, 
-     130,    116,    100,     84,     72,     69,     70,     80, 
-      90,    106,    120,    134,    146,    156,    164,    164, 
-     163,    157,    152,    146,    144,    142,    140,    142, 
-     138,    137,    132,    128,    121,    112,    104,     96, 
-      92,     88,     91,     97,    106,    118,    128,    140, 
-     149,    158,    160,    162,    160,    154,    148,    140, 
-     136,    132,    128,    128,    126,    124,    122,    122, 
-     116,    128,    130,    128,    118,    114,    120,    136, 
-     165,    192,    217,    231,    235,    231,    221,    203, 
-     120,    128,    132,    134,    134,    126,    118,    100, 
-      88,     74,     70,     72,     80,     98,    116,    134, 
-     146,    158,    154,    149,    138,    128,    122,    118, 
-     126,    134,    152,    164,    176,    180,    176,    166, 
-     150,    138,    122,    114,    107,    108,    112,    118, 
-     128,    128,    132,    128,    124,    114,    106,     98, 
-      94,     98,    100,    110,    118,    128,    136,    144, 
-     148,    147,    146,    140,    138,    132,    132,    132, 
-     135,    139,    142,    148,    146,    144,    128,    114, 
-      94,     84,     86,    104,    134,    172,    212,    238, 
-     248,    234,    202,    160,    118,     86,     66,     74, 
-      96,    130,    160,    184,    186,    170,    138,     94, 
-      56,     20,      9,     12,     35,     66,    100,    128, 
-     144,    150,    140,    128,    112,     98,     92,     96, 
-     112,    128,    146,    165,    186,    192,    196,    190, 
-     181,    166,    148,    136,    124,    118,    112,    116, 
-     120,    181,    208,    222,    221,    204,    176,    141, 
-     104,     73,     52,     43,     49,     68,     96,    129, 
-     161,    186,    202,    205,    196,    176,    149,    120, 
-      93,     73,     63,     63,     75,     94,    119,    144, 
-     166,    181,    187,    183,    171,    152,    131,    110, 
-      93,     82,     80,     86,     98,    115,    133,    150, 
-     162,    168,    168,    161,    149,    135,    121,    109, 
-     101,     99,    101,    107,    117,    128,    137,    145, 
-     149,    150,    147,    141,    135,    128,    122,    118, 
-     117,    118,    120,    124,    127,    130,    132,    132, 
-     132,    130,    129,    133,    153,    184,    205,    204, 
-     180,    138,     89,     44,     12,      0,      9,     39, 
-      83,    135,    186,    227,    251,    255,    238,    204, 
-     158,    107,     61,     27,     10,     13,     34,     71, 
-     117,    164,    204,    231,    241,    233,    207,    170, 
-     126,     84,     50,     30,     26,     39,     67,    104, 
-     144,    181,    238,    238,    249,    249,    238,    194, 
-     150,    143,    120,     35,      0,     79,    131,    100, 
-     104,    158,    188,    183,    201,    231,    245,    229, 
-     191,    148,    117,    115,    117,     83,     54,     73, 
-      99,     86,     92,    145,    185,    194,    200,    210, 
-     209,    203,    194,    171,    143,    128,    117,     95, 
-      74,     85,    107,    112,    117,    144,    171,    182, 
-     195,    205,    200,    188,    175,    151,    126,    108, 
-      81,     59,     70,     77,     75,     93,    114,    126, 
-     147,    158,    164,    169,    160,    142,    131,    124, 
-     112,     96,     89,     92,     99,    108,    116,    126, 
-     137,    140,    139,    144,    149,    144,    137,    130, 
-     129,    130,    131,    135,    139,    146,    149,    149, 
-     154,    158,    162,    163,    159,    162,    167,    168, 
-     175,    180,    188,    197,    209,    219,    213,    227, 
-     240,    234,    251,    251,    252,    255,    238,    234, 
-     240,    241,    238,    110,    128,    148,    164,    167, 
-     162,    148,    136,    128,    130,    142,    154,    164, 
-     162,    152,    130,    116,    106,    110,    122,    132, 
-     140,    132,    120,     99,     90,     90,    104,    122, 
-     132,    134,    126,    114,    104,    106,    118,    134, 
-     148,    152,    150,    138,    130,    126,    130,    140, 
-     150,    156,    152,    140,    118,     92,     72,     82, 
-     122,    176,    219,    219,    180,    119,     76,     76, 
-     128,    198,    246,    246,    186,    112,     56,     53, 
-      96,    158,    198,    190,    140,     74,     31,     23, 
-      56,    100,    134,    136,    118,     84,     57,     52, 
-      64,     94,    120,    141,    148,    146,    134,    120, 
-     114,    115,    134,    158,    186,    195,    184,    156, 
-     126,    110,    114,    140,    168,    184,    172,    138, 
-     100,     73,     75,     96,    128,    142,    148,    128, 
-      98,     70,     65,     81,    109,    134,    146,    142, 
-     126,    110,    102,    110,    120,    152,    206,    230, 
-     222,    174,    128,     96,    104,    130,    164,    170, 
-     151,    116,     82,     68,     70,     88,    100,    106, 
-      94,     80,     58,     52,     44,     54,     64,     82, 
-      88,     91,     76,     62,     50,     58,     78,    104, 
-     124,    124,    110,     88,     82,     91,    124,    151, 
-     172,    164,    148,    128,    124,    130,    160,    184, 
-     198,    188,    170,    152,    146,    154,    170,    186, 
-     188,    180,    160,    150,    138,    144,    148,    160, 
-     158,    158,    142,    132,    116,    114,    114,    124, 
-     128,    128,    120,    104,     90,     82,     90,    100, 
-     114,    114,    110,     90,     82,     78,     92,    104, 
-     122,    122,    118,    104,     98,     98,    112,    126, 
-     134,    138,    132,    128,    122,    128,    130,    142, 
-     150,    150,    136,    122,    104,    116,    140,    188, 
-     216,    214,    174,    134,    114,    138,    190,    234, 
-     246,    212,    160,    118,    120,    168,    100,     47, 
-      35,     69,    131,    189,    216,    200,    148,     88, 
-      49,     50,     88,    145,    192,    206,    182,    132, 
-      82,     56,     66,    106,    155,    190,    193,    165, 
-     119,     80,     65,     81,    120,    160,    184,    179, 
-     150,    111,     82,     77,     96,    130,    161,    175, 
-     165,    137,    107,     88,     90,    109,    137,    158, 
-     164,    152,    129,    107,     97,    102,    119,    139, 
-     152,    152,    141,    124,    111,    108,    114,    126, 
-     137,    143,    141,    133,    124,    119,    119,    123, 
-     128,    132,    132,    130,    128,    127,    128,    134, 
-     155,    160,    121,     58,     19,     37,    107,    193, 
-     250,    246,    183,     92,     19,      0,     44,    129, 
-     213,    254,    232,    160,     72,     14,     12,     67, 
-     151,    222,    246,    211,    136,     58,     16,     29, 
-      91,    169,    226,    233,    189,    116,     50,     24, 
-      49,    112,    182,    223,    217,    168,    100,    115, 
-     111,    129,    127,    103,    123,    150,    130,    110, 
-     138,    144,    124,    135,    141,    129,    140,    136, 
-     130,    142,    121,    121,    142,    121,    119,    126, 
-     115,    124,    122,    114,    129,    122,    108,    134, 
-     144,    111,    116,    149,    142,    123,    139,    142, 
-     150,    151,    129,    187,    164,    103,    193,    212, 
-     131,    151,    209,    187,    179,    195,    207,    221, 
-     225,    225,    228,    209,    206,    198,    177,    187, 
-     158,     96,    111,    130,     66,     33,     57,     40, 
-      10,     10,     24,     18,      0,     25,     56,     48, 
-      56,     90,    110,    123,    142,    153,    184,    210, 
-     200,    212,    248,    248,    231,    237,    251,    234, 
-     200,    211,    215,    154,    126,    163,    135,     72, 
-      77,     70,     51,     53,     33,     28,     32,     32, 
-      43,     54,     72,     76,     51,     69,    130,     91, 
-      29,    120,    138,     56,    104,    121,    100,    122, 
-     123,     87,     45,     30,     35,     35,     30,     28, 
-      23,     15,     22,     52,     82,     95,     92,     86, 
-      89,    104,    117,    111,     86,     61,     51,     49, 
-      48,     55,     62,     45,     45,     90,    108,    104, 
-     119,    117,    103,    111,    112,     97,     85,     63, 
-      47,     53,     57,     47,     44,     52,     63,     72, 
-      79,     82,     80,     72,     60,     55,     56,     50, 
-      33,     23,     25,     32,     37,     35,     32,     41, 
-      51,     47,     43,     46,     42,     35,     32,     22, 
-      18,     22,     14,      8,     13,     17,     11,      7, 
-       0,      5,     22,     59,    124,    191,    208,    116, 
-      57,    150,    255,    199,     69,     21,     51,     66, 
-      52,     43,     46,     36,     20,     44,     98,    141, 
-     157,    145,    109,    100,    145,    180,    135,     56, 
-      21,     36,     44,     31,     24,     26,     21,     19, 
-      48,     91,    117,    116,    101,     89,    100,    122, 
+       0,      0,     16,     32,     17,      1,     16,      1, 
+       0,      0,      0,    240,      0,    255,      0,    255, 
+      15,    240,     14,      0,    240,    240,      0,    240, 
+       0,     15,     17,    240,     16,      1,      0,     16, 
+       0,     16,     31,     16,      1,    241,    241,    241, 
+     240,      5,     64,     32,    192,    223,    239,    254, 
+       0,     15,    239,    224,    224,    255,    240,     15, 
+       0,      0,      1,      1,      1,     16,     17,     17, 
+      17,      0,      1,     11,     48,     16,     47,     17, 
+     240,     31,      0,    255,     30,     15,    255,     15, 
+     255,     14,      0,    255,     15,      0,     15,     31, 
+      16,      0,     16,      1,      0,     47,     17,      0, 
+       2,    240,     16,      0,     31,      0,     15,     31, 
+       0,    241,    225,      4,     51,     16,    254,    223, 
+     223,    224,      0,    253,    255,    239,    255,     15, 
+     240,    241,      0,      1,      2,      1,     17,     17, 
+      32,      0,     18,      0,      1,     84,     48,    222, 
+       0,    224,     31,      3,    241,     16,     16,    227, 
+     255,     31,      1,     15,    240,    240,    224,      1, 
+       0,     18,     18,     16,     34,    224,     15,    239, 
+       0,      0,    174,      0,    205,     16,     45,     35, 
+      49,     81,     21,     18,     34,    242,     48,    208, 
+      81,    191,      3,    254,    224,    223,    252,    224, 
+     191,    192,    161,      0,    194,     48,      3,      1, 
+     228,     31,     34,     15,     32,    240,      0,    218, 
+     143,     12,     15,      1,      2,     18,     35,     34, 
+      49,     50,     17,     32,    241,    240,    239,    238, 
+     254,    254,    239,    255,    240,      0,      1,     17, 
+      17,     17,     18,      1,     16,      1,    240,     15, 
+      15,     15,    240,    240,     15,      1,    241,      1, 
+      39,     65,    240,    159,      0,    190,    238,    253, 
+      15,     17,     18,     36,     33,      2,     52,     19, 
+      49,      2,    240,    239,    238,    207,    221,    192, 
+       2,    103,     62,     16,    190,     30,    209,     59, 
+       5,     30,    245,     45,     18,     14,     16,    208, 
+      16,    208,     17,    208,     32,    225,     29,    242, 
+     237,     16,      0,     20,     15,     35,    255,     17, 
+     224,      0,    209,     15,    241,     45,      2,     13, 
+      38,     15,    116,     12,     49,    238,     46,    192, 
+      32,    130,     28,    242,     14,     23,    224,     50, 
+     223,     82,    224,     35,     19,     17,     65,      4, 
+     255,     32,      1,    152,    190,      2,    237,     52, 
+     242,     23,     47,     33,     32,    193,     45,    254, 
+      30,    253,    255,    235,    254,     29,    210,     48, 
+      18,     82,    226,     32,    225,      1,    255,    240, 
+     240,    222,     16,    222,     19,    237,     66,    254, 
+       3,    238,     65,      3,    114,     14,     98,    221, 
+      48,     13,     29,    139,     17,    241,    215,     50, 
+     226,     49,    224,     80,    210,     45,     20,     27, 
+      17,     12,    238,     16,      4,    194,    207,      2, 
+       4,     34,     34,     17,     12,    221,    219,    223, 
+     239,     19,     67,     66,     20,     16,    254,    190, 
+     222,    222,    255,     33,     82,     33,     97,      0, 
+     255,    221,    220,     12,      0,     18,     34,     19, 
+       2,    240,    255,    224,    255,     31,     35,    119, 
+      27,    222,    223,     14,     66,      1,     99,     19, 
+       0,    141,     15,    137,     14,     16,     66,     83, 
+      34,     33,     14,    234,    238,    208,      2,    203, 
+     142,    242,     35,     65,     47,     46,     46,    239, 
+     239,     55,     48,    238,    236,    252,    254,    194, 
+      36,     34,     16,     46,     25,     13,    238,     20, 
+       5,    253,    237,    250,     15,    193,     39,     51, 
+     244,    240,    223,    232,     13,      0,     64,      4, 
+     210,    209,    222,     16,     64,    113,     33,    211, 
+     208,    144,    238,     14,     64,      4,    240,      2, 
+     166,    224,    225,     51,     80,    237,    221,    224, 
+       2,    120,     62,     14,    223,    129,     23,     35, 
+      33,      8,      9,     13,      4,      6,      3,    225, 
+     189,    239,     27,     80,     65,     19,    129,    192, 
+     209,    245,     79,     95,     30,     12,    239,    194, 
+     227,      3,     31,     56,      9,     29,     53,     66, 
+      17,    175,    189,    225,     20,    114,     47,    250, 
+     238,    240,     19,     69,     18,    236,    252,    240, 
+      19,     84,      0,     33,    138,     14,    240,     32, 
+      81,    112,      3,    181,    126,    252,    255,    242, 
+      67,     52,     18,     12,    251,    221,    254,     21, 
+      36,     50,     17,    221,    204,    239,    225,     34, 
+      83,     20,      0,    158,    251,    254,     16,     83, 
+      34,     33,    192,    207,    175,     30,     18,     50, 
+      18,    240,    254,     14,     21,    116,    236,    222, 
+     241,     48,     55,     34,     12,    240,    174,    223, 
+      50,     51,     97,     63,     10,    237,    192,    209, 
+      51,     53,     49,      0,    255,    238,    238,    249, 
+     249,    238,    194,    150,    143,    120,     35,      0, 
+      79,    131,    100,    104,    158,    188,    183,    201, 
+     231,    245,    229,    191,    148,    117,    115,    117, 
+      83,     54,     73,     99,     86,     92,    145,    185, 
+     194,    200,    210,    209,    203,    194,    171,    143, 
+     128,    117,     95,     74,     85,    107,    112,    117, 
+     144,    171,    182,    195,    205,    200,    188,    175, 
+     151,    126,    108,     81,     59,     70,     77,     75, 
+      93,    114,    126,    147,    158,    164,    169,    160, 
+     142,    131,    124,    112,     96,     89,     92,     99, 
+     108,    116,    126,    137,    140,    139,    144,    149, 
+     144,    137,    130,    129,    130,    131,    135,    139, 
+     146,    149,    149,    154,    158,    162,    163,    159, 
+     162,    167,    168,    175,    180,    188,    197,    209, 
+     219,    213,    227,    240,    234,    251,    251,    252, 
+     255,    238,    234,    240,    241,    255,    110,    128, 
+     148,    164,    167,    162,    148,    136,    128,    130, 
+     142,    154,    164,    162,    152,    130,    116,    106, 
+     110,    122,    132,    140,    132,    120,     99,     90, 
+      90,    104,    122,    132,    134,    126,    114,    104, 
+     106,    118,    134,    148,    152,    150,    138,    130, 
+     126,    130,    140,    150,    156,    152,    140,    118, 
+      92,     72,     82,    122,    176,    219,    219,    180, 
+     119,     76,     76,    128,    198,    246,    246,    186, 
+     112,     56,     53,     96,    158,    198,    190,    140, 
+      74,     31,     23,     56,    100,    134,    136,    118, 
+      84,     57,     52,     64,     94,    120,    141,    148, 
+     146,    134,    120,    114,    115,    134,    158,    186, 
+     195,    184,    156,    126,    110,    114,    140,    168, 
+     184,    172,    138,    100,     73,     75,     96,    128, 
+     142,    148,    128,     98,     70,     65,     81,    109, 
+     134,    146,    142,    126,    110,    102,      5,    120, 
+      66,    237,    223,     66,     48,    221,    209,     51, 
+      47,    250,     13,     95,     80,     45,      8,     16, 
+      99,     15,    158,    228,     20,     14,    176,    227, 
+      36,    255,    159,      3,     65,     26,    239,     47, 
+      96,     44,     13,     45,     80,     46,     13,    209, 
+      68,     18,    160,    179,      4,      1,    191,    194, 
+      35,     28,     12,     31,    111,     63,    216,     14, 
+     118,     29,    219,      3,     82,     15,    158,     32, 
+       5,    168,    128,     52,     47,    221,    222,     51, 
+      65,    252,    207,    244,     51,     29,    220,    225, 
+      52,     32,    236,    239,     34,     65,    255,    142, 
+       1,     98,     16,    189,    224,     66,     33,    236, 
+     253,     34,     49,    255,    141,      3,     34,     29, 
+     222,      1,     37,    125,    137,     19,     81,     15, 
+     140,     16,     98,      0,    218,    241,     38,     47, 
+     251,    177,     20,     51,    222,    190,     18,     67, 
+      13,    208,    255,    100,    115,    111,    129,    127, 
+     103,    123,    150,    130,    110,    138,    144,    124, 
+     135,    141,    129,    140,    136,    130,    142,    121, 
+     121,    142,    121,    119,    126,    115,    124,    122, 
+     114,    129,    122,    108,    134,    144,    111,    116, 
+     149,    142,    123,    139,    142,    150,    151,    129, 
+     187,    164,    103,    193,    212,    131,    151,    209, 
+     187,    179,    195,    207,    221,    225,    225,    228, 
+     209,    206,    198,    177,    187,    158,     96,    111, 
+     130,     66,     33,     57,     40,     10,     10,     24, 
+      18,      0,     25,     56,     48,     56,     90,    110, 
+     123,    142,    153,    184,    210,    200,    212,    248, 
+     248,    231,    237,    251,    234,    200,    211,    215, 
+     154,    126,    163,    135,     72,     77,     70,     51, 
+      53,     33,     28,     32,     32,     43,     54,     72, 
+      76,     51,     69,    130,     91,     29,    120,    138, 
+      56,    104,    121,    255,    122,    123,     87,     45, 
+      30,     35,     35,     30,     28,     23,     15,     22, 
+      52,     82,     95,     92,     86,     89,    104,    117, 
+     111,     86,     61,     51,     49,     48,     55,     62, 
+      45,     45,     90,    108,    104,    119,    117,    103, 
+     111,    112,     97,     85,     63,     47,     53,     57, 
+      47,     44,     52,     63,     72,     79,     82,     80, 
+      72,     60,     55,     56,     50,     33,     23,     25, 
+      32,     37,     35,     32,     41,     51,     47,     43, 
+      46,     42,     35,     32,     22,     18,     22,     14, 
+       8,     13,     17,     11,      7,      0,      5,     22, 
+      59,    124,    191,    208,    116,     57,    150,    255, 
+     199,     69,     21,     51,     66,     52,     43,     46, 
+      36,     20,     44,     98,    141,    157,    145,    109, 
+     100,    145,    180,    135,     56,     21,     36,     44, 
+      31,     24,     26,     21,     19,     48,     91,    117, 
+     116,    101,     89,    100, 
+};
+const prog_uint8_t wav_res_wavetable_adpcm_steps[] PROGMEM = {
+       1,      2,      3,      4,      6,      8,     11,     16, 
+      23,     32,     45,     64, 
 };
 const prog_uint8_t wav_res_vowel_data[] PROGMEM = {
       27,     40,     89,    253,     16,     18,     51,     62, 
@@ -1772,15 +1499,16 @@ const prog_uint8_t* waveform_table[] = {
   wav_res_bandlimited_saw_3,
   wav_res_bandlimited_saw_4,
   wav_res_bandlimited_saw_5,
-  wav_res_bandlimited_square_6,
+  wav_res_bandlimited_saw_6,
   wav_res_bandlimited_triangle_0,
   wav_res_bandlimited_triangle_1,
   wav_res_bandlimited_triangle_2,
   wav_res_bandlimited_triangle_3,
   wav_res_bandlimited_triangle_4,
   wav_res_bandlimited_triangle_5,
-  wav_res_bandlimited_square_6,
+  wav_res_bandlimited_triangle_6,
   wav_res_wavetable,
+  wav_res_wavetable_adpcm_steps,
   wav_res_vowel_data,
 };
 
@@ -1800,5 +1528,74 @@ const prog_uint8_t* character_table[] = {
   chr_res_special_characters,
 };
 
+const prog_uint8_t shp_res_env_curves[] PROGMEM = {
+       0,     16,     31,     44,     57,     70,     81,     92, 
+     102,    112,    121,    129,    137,    144,    151,    158, 
+     164,    170,    175,    181,    185,    190,    194,    198, 
+     202,    205,    209,    212,    215,    217,    220,    222, 
+     225,    227,    229,    231,    232,    234,    236,    237, 
+     238,    240,    241,    242,    243,    244,    245,    246, 
+     247,    248,    248,    249,    250,    250,    251,    251, 
+     252,    252,    253,    253,    254,    254,    254,    255, 
+     255,      0,      0,      1,      1,      1,      2,      2, 
+       3,      3,      4,      4,      5,      5,      6,      7, 
+       7,      8,      9,     10,     11,     12,     13,     14, 
+      15,     17,     18,     19,     21,     23,     24,     26, 
+      28,     30,     33,     35,     38,     40,     43,     46, 
+      50,     53,     57,     61,     65,     70,     74,     80, 
+      85,     91,     97,    104,    111,    118,    126,    134, 
+     143,    153,    163,    174,    185,    198,    211,    224, 
+     239,    255,      0,      0,      1,      2,      3,      4, 
+       6,      8,     11,     14,     17,     20,     24,     27, 
+      31,     35,     40,     44,     49,     54,     59,     64, 
+      70,     75,     81,     86,     92,     98,    104,    110, 
+     116,    122,    128,    133,    139,    145,    151,    157, 
+     163,    169,    174,    180,    185,    191,    196,    201, 
+     206,    211,    215,    220,    224,    228,    231,    235, 
+     238,    241,    244,    247,    249,    251,    252,    253, 
+     254,    255,    255, 
+};
+const prog_uint8_t shp_res_lfo_waveforms[] PROGMEM = {
+     255,    254,    253,    250,    245,    240,    234,    226, 
+     218,    208,    198,    188,    176,    165,    152,    140, 
+     128,    115,    103,     90,     79,     67,     57,     47, 
+      37,     29,     21,     15,     10,      5,      2,      1, 
+       0,      1,      2,      5,     10,     15,     21,     29, 
+      37,     47,     57,     67,     79,     90,    103,    115, 
+     127,    140,    152,    165,    176,    188,    198,    208, 
+     218,    226,    234,    240,    245,    250,    253,    254, 
+     255,    255,    239,    224,    211,    198,    185,    174, 
+     163,    153,    143,    134,    126,    118,    111,    104, 
+      97,     91,     85,     80,     74,     70,     65,     61, 
+      57,     53,     50,     46,     43,     40,     38,     35, 
+      33,     30,     28,     26,     24,     23,     21,     19, 
+      18,     17,     15,     14,     13,     12,     11,     10, 
+       9,      8,      7,      7,      6,      5,      5,      4, 
+       4,      3,      3,      2,      2,      1,      1,      1, 
+       0,      0,      0,      0,      1,      1,      1,      2, 
+       2,      3,      3,      4,      4,      5,      5,      6, 
+       7,      7,      8,      9,     10,     11,     12,     13, 
+      14,     15,     17,     18,     19,     21,     23,     24, 
+      26,     28,     30,     33,     35,     38,     40,     43, 
+      46,     50,     53,     57,     61,     65,     70,     74, 
+      80,     85,     91,     97,    104,    111,    118,    126, 
+     134,    143,    153,    163,    174,    185,    198,    211, 
+     224,    239,    255,      0,      0,      0,      0,      0, 
+       0,      0,      0,     36,     36,     36,     36,     36, 
+      36,     36,     36,     73,     73,     73,     73,     73, 
+      73,     73,     73,    109,    109,    109,    109,    109, 
+     109,    109,    109,    146,    146,    146,    146,    146, 
+     146,    146,    146,    182,    182,    182,    182,    182, 
+     182,    182,    182,    219,    219,    219,    219,    219, 
+     219,    219,    219,    255,    255,    255,    255,    255, 
+     255,    255,    255,    255, 
+};
+
+
+PROGMEM const prog_uint8_t* shape_table[] = {
+  shp_res_env_curves,
+  shp_res_lfo_waveforms,
+};
+
 
 }  // namespace hardware_shruti
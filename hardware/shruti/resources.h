@@ -43,6 +43,8 @@ extern const prog_uint8_t* waveform_table[];
 
 extern const prog_uint8_t* character_table[];
 
+extern const prog_uint8_t* shape_table[];
+
 extern const prog_uint16_t lut_res_lfo_increments[] PROGMEM;
 extern const prog_uint16_t lut_res_env_portamento_increments[] PROGMEM;
 extern const prog_uint16_t lut_res_oscillator_increments[] PROGMEM;
@@ -84,6 +86,7 @@ extern const prog_uint16_t lut_res_groove_shuffle[] PROGMEM;
 extern const prog_uint16_t lut_res_groove_push[] PROGMEM;
 extern const prog_uint16_t lut_res_groove_lag[] PROGMEM;
 extern const prog_uint16_t lut_res_groove_human[] PROGMEM;
+extern const prog_uint16_t lut_res_wavetable_offsets[] PROGMEM;
 extern const prog_uint8_t wav_res_formant_sine[] PROGMEM;
 extern const prog_uint8_t wav_res_formant_square[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_square_0[] PROGMEM;
@@ -99,15 +102,20 @@ extern const prog_uint8_t wav_res_bandlimited_saw_2[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_saw_3[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_saw_4[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_saw_5[] PROGMEM;
+extern const prog_uint8_t wav_res_bandlimited_saw_6[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_0[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_1[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_2[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_3[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_4[] PROGMEM;
 extern const prog_uint8_t wav_res_bandlimited_triangle_5[] PROGMEM;
+extern const prog_uint8_t wav_res_bandlimited_triangle_6[] PROGMEM;
 extern const prog_uint8_t wav_res_wavetable[] PROGMEM;
+extern const prog_uint8_t wav_res_wavetable_adpcm_steps[] PROGMEM;
 extern const prog_uint8_t wav_res_vowel_data[] PROGMEM;
 extern const prog_uint8_t chr_res_special_characters[] PROGMEM;
+extern const prog_uint8_t shp_res_env_curves[] PROGMEM;
+extern const prog_uint8_t shp_res_lfo_waveforms[] PROGMEM;
 #define STR_RES_PRM 0  // prm
 #define STR_RES_RNG 1  // rng
 #define STR_RES_OP 2  // op
@@ -141,167 +149,178 @@ extern const prog_uint8_t chr_res_special_characters[] PROGMEM;
 #define STR_RES_SWEEP 30  // sweep
 #define STR_RES_ZSYNC 31  // zsync
 #define STR_RES_PAD 32  // pad
-#define STR_RES_1S2 33  // 1+2
-#define STR_RES_1_2 34  // 1>2
-#define STR_RES_1P2 35  // 1*2
-#define STR_RES_1X2 36  // 1^2
-#define STR_RES_CUT 37  // cut
-#define STR_RES_VCA 38  // vca
-#define STR_RES_PW1 39  // pw1
-#define STR_RES_PW2 40  // pw2
-#define STR_RES_51 41  // 1
-#define STR_RES_52 42  // 2
-#define STR_RES_5 43  // 
-#define STR_RES_MIX 44  // mix
-#define STR_RES_NOI 45  // noi
-#define STR_RES_SUB 46  // sub
-#define STR_RES_RES 47  // res
-#define STR_RES_CUTOFF 48  // cutoff
-#define STR_RES__VCA 49  //  vca
-#define STR_RES_PWM1 50  // pwm1
-#define STR_RES_PWM2 51  // pwm2
-#define STR_RES_OSC1 52  // osc1
-#define STR_RES_OSC2 53  // osc2
-#define STR_RES_OSC1S2 54  // osc1+2
-#define STR_RES__MIX 55  //  mix
-#define STR_RES__NOISE 56  //  noise
-#define STR_RES_SUBOSC 57  // subosc
-#define STR_RES_RESO 58  // reso
-#define STR_RES_ATK 59  // atk
-#define STR_RES_WV1 60  // wv1
-#define STR_RES_RT1 61  // rt1
-#define STR_RES_WV2 62  // wv2
-#define STR_RES_RT2 63  // rt2
-#define STR_RES_SRC 64  // src
-#define STR_RES_DST 65  // dst
-#define STR_RES_AMT 66  // amt
-#define STR_RES_CHN 67  // chn
-#define STR_RES_BPM 68  // bpm
-#define STR_RES_SWG 69  // swg
-#define STR_RES_SHAPE 70  // shape
-#define STR_RES_ENV1TVCF 71  // env1~vcf
-#define STR_RES_LFO2TVCF 72  // lfo2~vcf
-#define STR_RES_RESONANCE 73  // resonance
-#define STR_RES_ENVELOPE_1 74  // envelope 1
-#define STR_RES_ENVELOPE_2 75  // envelope 2
-#define STR_RES_SEQUENCER 76  // sequencer
-#define STR_RES_ATTACK 77  // attack
-#define STR_RES_DECAY 78  // decay
-#define STR_RES_SUSTAIN 79  // sustain
-#define STR_RES_RELEASE 80  // release
-#define STR_RES_LFO1_WAVE 81  // lfo1 wave
-#define STR_RES_LFO1_RATE 82  // lfo1 rate
-#define STR_RES_LFO2_WAVE 83  // lfo2 wave
-#define STR_RES_LFO2_RATE 84  // lfo2 rate
-#define STR_RES_MOD_ 85  // mod.
-#define STR_RES_SOURCE 86  // source
-#define STR_RES_DEST_ 87  // dest.
-#define STR_RES_AMOUNT 88  // amount
-#define STR_RES_OCTAVE 89  // octave
-#define STR_RES_RAGA 90  // raga
-#define STR_RES_MIDI_CHAN 91  // midi chan
-#define STR_RES_TEMPO 92  // tempo
-#define STR_RES_MIXER 93  // mixer
-#define STR_RES_FILTER 94  // filter
-#define STR_RES_LFOS 95  // lfos
-#define STR_RES_MODULATION 96  // modulation
-#define STR_RES_KEYBOARD 97  // keyboard
-#define STR_RES_OFF 98  // off
-#define STR_RES_ON 99  // on
-#define STR_RES_TRI 100  // tri
-#define STR_RES_SQR 101  // sqr
-#define STR_RES_S_H 102  // s&h
-#define STR_RES_3 103  // 
-#define STR_RES__SEQ 104  //  seq
-#define STR_RES_LF1 105  // lf1
-#define STR_RES_LF2 106  // lf2
-#define STR_RES_SEQ 107  // seq
-#define STR_RES_ARP 108  // arp
-#define STR_RES_WHL 109  // whl
-#define STR_RES_BND 110  // bnd
-#define STR_RES_OFS 111  // ofs
-#define STR_RES_CV1 112  // cv1
-#define STR_RES_CV2 113  // cv2
-#define STR_RES_CV3 114  // cv3
-#define STR_RES_RND 115  // rnd
-#define STR_RES_EN1 116  // en1
-#define STR_RES_EN2 117  // en2
-#define STR_RES_VEL 118  // vel
-#define STR_RES_NOT 119  // not
-#define STR_RES_GAT 120  // gat
-#define STR_RES_LFO1 121  // lfo1
-#define STR_RES_LFO2 122  // lfo2
-#define STR_RES_STPSEQ 123  // stpseq
-#define STR_RES__ARP 124  //  arp
-#define STR_RES_MWHEEL 125  // mwheel
-#define STR_RES_BENDER 126  // bender
-#define STR_RES_OFFSET 127  // offset
-#define STR_RES__CV1 128  //  cv1
-#define STR_RES__CV2 129  //  cv2
-#define STR_RES__CV3 130  //  cv3
-#define STR_RES_RANDOM 131  // random
-#define STR_RES_ENV1 132  // env1
-#define STR_RES_ENV2 133  // env2
-#define STR_RES_VELO 134  // velo
-#define STR_RES_NOTE 135  // note
-#define STR_RES_GATE 136  // gate
-#define STR_RES_270 137  // 270
-#define STR_RES_300 138  // 300
-#define STR_RES_360 139  // 360
-#define STR_RES_480 140  // 480
-#define STR_RES_720 141  // 720
-#define STR_RES_960 142  // 960
-#define STR_RES_START 143  // start
-#define STR_RES_LENGTH 144  // length
-#define STR_RES_TOUCH_A_KNOB_TO 145  // touch a knob to
-#define STR_RES_ASSIGN_PARAMETER 146  // assign parameter
-#define STR_RES_READY 147  // ready
-#define STR_RES_FOR_OS_UPDATE 148  // for os update
-#define STR_RES_PATCH_BANK 149  // patch bank
-#define STR_RES_STEP_SEQUENCER 150  // step sequencer
-#define STR_RES_LOAD 151  // load
-#define STR_RES_ 152  // ----
-#define STR_RES_SAVE 153  // save
-#define STR_RES_EXTERN 154  // extern
-#define STR_RES_X2_EXT 155  // x2 ext
-#define STR_RES__2_EXT 156  // /2 ext
-#define STR_RES__4_EXT 157  // /4 ext
-#define STR_RES__8_EXT 158  // /8 ext
-#define STR_RES_MUTABLE____V0_59 159  // mutable    v0.59
-#define STR_RES_INSTRUMENTS_671 160  // instruments -1
-#define STR_RES_EQUAL 161  // equal
-#define STR_RES_JUST 162  // just
-#define STR_RES_PYTHAG 163  // pythag
-#define STR_RES_1_4_EB 164  // 1/4 eb
-#define STR_RES_1_4_E 165  // 1/4 e
-#define STR_RES_1_4_EA 166  // 1/4 ea
-#define STR_RES_BHAIRA 167  // bhaira
-#define STR_RES_GUNAKR 168  // gunakr
-#define STR_RES_MARWA 169  // marwa
-#define STR_RES_SHREE 170  // shree
-#define STR_RES_PURVI 171  // purvi
-#define STR_RES_BILAWA 172  // bilawa
-#define STR_RES_YAMAN 173  // yaman
-#define STR_RES_KAFI 174  // kafi
-#define STR_RES_BHIMPA 175  // bhimpa
-#define STR_RES_DARBAR 176  // darbar
-#define STR_RES_BAGESH 177  // bagesh
-#define STR_RES_RAGESH 178  // ragesh
-#define STR_RES_KHAMAJ 179  // khamaj
-#define STR_RES_MIMAL 180  // mi'mal
-#define STR_RES_PARAME 181  // parame
-#define STR_RES_RANGES 182  // ranges
-#define STR_RES_GANGES 183  // ganges
-#define STR_RES_KAMESH 184  // kamesh
-#define STR_RES_PALAS_ 185  // palas 
-#define STR_RES_NATBHA 186  // natbha
-#define STR_RES_M_KAUN 187  // m.kaun
-#define STR_RES_BAIRAG 188  // bairag
-#define STR_RES_B_TODI 189  // b.todi
-#define STR_RES_CHANDR 190  // chandr
-#define STR_RES_KAUSHI 191  // kaushi
-#define STR_RES_JOGESH 192  // jogesh
-#define STR_RES_RASIA 193  // rasia
+#define STR_RES_UNISON 33  // unison
+#define STR_RES_USER 34  // user
+#define STR_RES_1S2 35  // 1+2
+#define STR_RES_1_2 36  // 1>2
+#define STR_RES_1P2 37  // 1*2
+#define STR_RES_1X2 38  // 1^2
+#define STR_RES_CUT 39  // cut
+#define STR_RES_VCA 40  // vca
+#define STR_RES_PW1 41  // pw1
+#define STR_RES_PW2 42  // pw2
+#define STR_RES_51 43  // 1
+#define STR_RES_52 44  // 2
+#define STR_RES_5 45  // 
+#define STR_RES_MIX 46  // mix
+#define STR_RES_NOI 47  // noi
+#define STR_RES_SUB 48  // sub
+#define STR_RES_RES 49  // res
+#define STR_RES_CUTOFF 50  // cutoff
+#define STR_RES__VCA 51  //  vca
+#define STR_RES_PWM1 52  // pwm1
+#define STR_RES_PWM2 53  // pwm2
+#define STR_RES_OSC1 54  // osc1
+#define STR_RES_OSC2 55  // osc2
+#define STR_RES_OSC1S2 56  // osc1+2
+#define STR_RES__MIX 57  //  mix
+#define STR_RES__NOISE 58  //  noise
+#define STR_RES_SUBOSC 59  // subosc
+#define STR_RES_RESO 60  // reso
+#define STR_RES_ATK 61  // atk
+#define STR_RES_WV1 62  // wv1
+#define STR_RES_RT1 63  // rt1
+#define STR_RES_WV2 64  // wv2
+#define STR_RES_RT2 65  // rt2
+#define STR_RES_SRC 66  // src
+#define STR_RES_DST 67  // dst
+#define STR_RES_AMT 68  // amt
+#define STR_RES_CHN 69  // chn
+#define STR_RES_BPM 70  // bpm
+#define STR_RES_SWG 71  // swg
+#define STR_RES_SHAPE 72  // shape
+#define STR_RES_ENV1TVCF 73  // env1~vcf
+#define STR_RES_LFO2TVCF 74  // lfo2~vcf
+#define STR_RES_RESONANCE 75  // resonance
+#define STR_RES_ENVELOPE_1 76  // envelope 1
+#define STR_RES_ENVELOPE_2 77  // envelope 2
+#define STR_RES_SEQUENCER 78  // sequencer
+#define STR_RES_ATTACK 79  // attack
+#define STR_RES_DECAY 80  // decay
+#define STR_RES_SUSTAIN 81  // sustain
+#define STR_RES_RELEASE 82  // release
+#define STR_RES_LFO1_WAVE 83  // lfo1 wave
+#define STR_RES_LFO1_RATE 84  // lfo1 rate
+#define STR_RES_LFO2_WAVE 85  // lfo2 wave
+#define STR_RES_LFO2_RATE 86  // lfo2 rate
+#define STR_RES_MOD_ 87  // mod.
+#define STR_RES_SOURCE 88  // source
+#define STR_RES_DEST_ 89  // dest.
+#define STR_RES_AMOUNT 90  // amount
+#define STR_RES_OCTAVE 91  // octave
+#define STR_RES_RAGA 92  // raga
+#define STR_RES_MIDI_CHAN 93  // midi chan
+#define STR_RES_TEMPO 94  // tempo
+#define STR_RES_MIXER 95  // mixer
+#define STR_RES_FILTER 96  // filter
+#define STR_RES_LFOS 97  // lfos
+#define STR_RES_MODULATION 98  // modulation
+#define STR_RES_KEYBOARD 99  // keyboard
+#define STR_RES_OFF 100  // off
+#define STR_RES_ON 101  // on
+#define STR_RES_TRI 102  // tri
+#define STR_RES_SQR 103  // sqr
+#define STR_RES_S_H 104  // s&h
+#define STR_RES_3 105  // 
+#define STR_RES__SEQ 106  //  seq
+#define STR_RES_SIN 107  // sin
+#define STR_RES_DCY 108  // dcy
+#define STR_RES_RSE 109  // rse
+#define STR_RES_STP 110  // stp
+#define STR_RES_USR 111  // usr
+#define STR_RES_LF1 112  // lf1
+#define STR_RES_LF2 113  // lf2
+#define STR_RES_SEQ 114  // seq
+#define STR_RES_ARP 115  // arp
+#define STR_RES_WHL 116  // whl
+#define STR_RES_BND 117  // bnd
+#define STR_RES_OFS 118  // ofs
+#define STR_RES_CV1 119  // cv1
+#define STR_RES_CV2 120  // cv2
+#define STR_RES_CV3 121  // cv3
+#define STR_RES_RND 122  // rnd
+#define STR_RES_EN1 123  // en1
+#define STR_RES_EN2 124  // en2
+#define STR_RES_VEL 125  // vel
+#define STR_RES_NOT 126  // not
+#define STR_RES_GAT 127  // gat
+#define STR_RES_VLF 128  // vlf
+#define STR_RES_LFO1 129  // lfo1
+#define STR_RES_LFO2 130  // lfo2
+#define STR_RES_STPSEQ 131  // stpseq
+#define STR_RES__ARP 132  //  arp
+#define STR_RES_MWHEEL 133  // mwheel
+#define STR_RES_BENDER 134  // bender
+#define STR_RES_OFFSET 135  // offset
+#define STR_RES__CV1 136  //  cv1
+#define STR_RES__CV2 137  //  cv2
+#define STR_RES__CV3 138  //  cv3
+#define STR_RES_RANDOM 139  // random
+#define STR_RES_ENV1 140  // env1
+#define STR_RES_ENV2 141  // env2
+#define STR_RES_VELO 142  // velo
+#define STR_RES_NOTE 143  // note
+#define STR_RES_GATE 144  // gate
+#define STR_RES_V_LFO 145  // v.lfo
+#define STR_RES_270 146  // 270
+#define STR_RES_300 147  // 300
+#define STR_RES_360 148  // 360
+#define STR_RES_480 149  // 480
+#define STR_RES_720 150  // 720
+#define STR_RES_960 151  // 960
+#define STR_RES_START 152  // start
+#define STR_RES_LENGTH 153  // length
+#define STR_RES_TOUCH_A_KNOB_TO 154  // touch a knob to
+#define STR_RES_ASSIGN_PARAMETER 155  // assign parameter
+#define STR_RES_READY 156  // ready
+#define STR_RES_FOR_OS_UPDATE 157  // for os update
+#define STR_RES_PATCH_BANK 158  // patch bank
+#define STR_RES_STEP_SEQUENCER 159  // step sequencer
+#define STR_RES_LOAD 160  // load
+#define STR_RES_ 161  // ----
+#define STR_RES_SAVE 162  // save
+#define STR_RES_EXTERN 163  // extern
+#define STR_RES_X2_EXT 164  // x2 ext
+#define STR_RES__2_EXT 165  // /2 ext
+#define STR_RES__4_EXT 166  // /4 ext
+#define STR_RES__8_EXT 167  // /8 ext
+#define STR_RES_MIDI_PEAK 168  // midi peak
+#define STR_RES_MIDI_LOST 169  // midi lost
+#define STR_RES_MUTABLE____V0_59 170  // mutable    v0.59
+#define STR_RES_INSTRUMENTS_671 171  // instruments -1
+#define STR_RES_EQUAL 172  // equal
+#define STR_RES_JUST 173  // just
+#define STR_RES_PYTHAG 174  // pythag
+#define STR_RES_1_4_EB 175  // 1/4 eb
+#define STR_RES_1_4_E 176  // 1/4 e
+#define STR_RES_1_4_EA 177  // 1/4 ea
+#define STR_RES_BHAIRA 178  // bhaira
+#define STR_RES_GUNAKR 179  // gunakr
+#define STR_RES_MARWA 180  // marwa
+#define STR_RES_SHREE 181  // shree
+#define STR_RES_PURVI 182  // purvi
+#define STR_RES_BILAWA 183  // bilawa
+#define STR_RES_YAMAN 184  // yaman
+#define STR_RES_KAFI 185  // kafi
+#define STR_RES_BHIMPA 186  // bhimpa
+#define STR_RES_DARBAR 187  // darbar
+#define STR_RES_BAGESH 188  // bagesh
+#define STR_RES_RAGESH 189  // ragesh
+#define STR_RES_KHAMAJ 190  // khamaj
+#define STR_RES_MIMAL 191  // mi'mal
+#define STR_RES_PARAME 192  // parame
+#define STR_RES_RANGES 193  // ranges
+#define STR_RES_GANGES 194  // ganges
+#define STR_RES_KAMESH 195  // kamesh
+#define STR_RES_PALAS_ 196  // palas 
+#define STR_RES_NATBHA 197  // natbha
+#define STR_RES_M_KAUN 198  // m.kaun
+#define STR_RES_BAIRAG 199  // bairag
+#define STR_RES_B_TODI 200  // b.todi
+#define STR_RES_CHANDR 201  // chandr
+#define STR_RES_KAUSHI 202  // kaushi
+#define STR_RES_JOGESH 203  // jogesh
+#define STR_RES_RASIA 204  // rasia
 #define LUT_RES_LFO_INCREMENTS 0
 #define LUT_RES_LFO_INCREMENTS_SIZE 128
 #define LUT_RES_ENV_PORTAMENTO_INCREMENTS 1
@@ -388,24 +407,26 @@ extern const prog_uint8_t chr_res_special_characters[] PROGMEM;
 #define LUT_RES_GROOVE_LAG_SIZE 16
 #define LUT_RES_GROOVE_HUMAN 42
 #define LUT_RES_GROOVE_HUMAN_SIZE 16
+#define LUT_RES_WAVETABLE_OFFSETS 43
+#define LUT_RES_WAVETABLE_OFFSETS_SIZE 16
 #define WAV_RES_FORMANT_SINE 0
 #define WAV_RES_FORMANT_SINE_SIZE 256
 #define WAV_RES_FORMANT_SQUARE 1
 #define WAV_RES_FORMANT_SQUARE_SIZE 256
 #define WAV_RES_BANDLIMITED_SQUARE_0 2
-#define WAV_RES_BANDLIMITED_SQUARE_0_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_0_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_1 3
-#define WAV_RES_BANDLIMITED_SQUARE_1_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_1_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_2 4
-#define WAV_RES_BANDLIMITED_SQUARE_2_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_2_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_3 5
-#define WAV_RES_BANDLIMITED_SQUARE_3_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_3_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_4 6
-#define WAV_RES_BANDLIMITED_SQUARE_4_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_4_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_5 7
-#define WAV_RES_BANDLIMITED_SQUARE_5_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_5_SIZE 129
 #define WAV_RES_BANDLIMITED_SQUARE_6 8
-#define WAV_RES_BANDLIMITED_SQUARE_6_SIZE 257
+#define WAV_RES_BANDLIMITED_SQUARE_6_SIZE 129
 #define WAV_RES_BANDLIMITED_SAW_0 9
 #define WAV_RES_BANDLIMITED_SAW_0_SIZE 257
 #define WAV_RES_BANDLIMITED_SAW_1 10
@@ -421,25 +442,31 @@ extern const prog_uint8_t chr_res_special_characters[] PROGMEM;
 #define WAV_RES_BANDLIMITED_SAW_6 15
 #define WAV_RES_BANDLIMITED_SAW_6_SIZE 257
 #define WAV_RES_BANDLIMITED_TRIANGLE_0 16
-#define WAV_RES_BANDLIMITED_TRIANGLE_0_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_0_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_1 17
-#define WAV_RES_BANDLIMITED_TRIANGLE_1_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_1_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_2 18
-#define WAV_RES_BANDLIMITED_TRIANGLE_2_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_2_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_3 19
-#define WAV_RES_BANDLIMITED_TRIANGLE_3_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_3_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_4 20
-#define WAV_RES_BANDLIMITED_TRIANGLE_4_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_4_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_5 21
-#define WAV_RES_BANDLIMITED_TRIANGLE_5_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_5_SIZE 66
 #define WAV_RES_BANDLIMITED_TRIANGLE_6 22
-#define WAV_RES_BANDLIMITED_TRIANGLE_6_SIZE 257
+#define WAV_RES_BANDLIMITED_TRIANGLE_6_SIZE 66
 #define WAV_RES_WAVETABLE 23
-#define WAV_RES_WAVETABLE_SIZE 2064
-#define WAV_RES_VOWEL_DATA 24
+#define WAV_RES_WAVETABLE_SIZE 1308
+#define WAV_RES_WAVETABLE_ADPCM_STEPS 24
+#define WAV_RES_WAVETABLE_ADPCM_STEPS_SIZE 12
+#define WAV_RES_VOWEL_DATA 25
 #define WAV_RES_VOWEL_DATA_SIZE 45
 #define CHR_RES_SPECIAL_CHARACTERS 0
 #define CHR_RES_SPECIAL_CHARACTERS_SIZE 64
+#define SHP_RES_ENV_CURVES 0
+#define SHP_RES_ENV_CURVES_SIZE 195
+#define SHP_RES_LFO_WAVEFORMS 1
+#define SHP_RES_LFO_WAVEFORMS_SIZE 260
 typedef hardware_resources::ResourcesManager<
     ResourceId,
     hardware_resources::ResourcesTables<
@@ -21,6 +21,8 @@
 
 import numpy
 
+import waveforms
+
 """----------------------------------------------------------------------------
 LFO and envelope increments.
 ----------------------------------------------------------------------------"""
@@ -407,3 +409,10 @@ lookup_tables.extend([
     ('groove_human', ConvertGrooveTemplate(
       [0.7, -0.8, 0.85, -0.75, 0.7, -0.7,  0.4, -0.3,
        0.5, -0.7, 0.8, -0.75, 0.8, -1, 0.5, -0.25]))])
+
+
+"""----------------------------------------------------------------------------
+Offsets of the waves of the compressed wavetable
+----------------------------------------------------------------------------"""
+
+lookup_tables.append(('wavetable_offsets', waveforms.wavetable_offsets))
@@ -68,4 +68,5 @@ resources = [
   (waveforms.waveforms,
    'waveform', 'WAV_RES', 'prog_uint8_t', int, True),
   (characters.characters, 'character', 'CHR_RES', 'prog_uint8_t', int, True),
+  (waveforms.shapes, 'shape', 'SHP_RES', 'prog_uint8_t', int, False),
 ]
@@ -55,6 +55,8 @@ wavtbl
 sweep
 zsync
 pad
+unison
+user
 
 1+2
 1>2
@@ -134,6 +136,11 @@ sqr
 s&h
 \x03
  seq
+sin
+dcy
+rse
+stp
+usr
 
 lf1
 lf2
@@ -151,6 +158,7 @@ en2
 vel
 not
 gat
+vlf
 lfo1
 lfo2
 stpseq
@@ -167,6 +175,7 @@ env2
 velo
 note
 gate
+v.lfo
 
 270
 300
@@ -192,6 +201,8 @@ x2 ext
 /2 ext
 /4 ext
 /8 ext
+midi peak
+midi lost
 
 mutable    v0.59
 instruments \x06\x07-1
@@ -105,6 +105,14 @@ wrap = numpy.fmod(numpy.arange(WAVETABLE_SIZE + 1) + WAVETABLE_SIZE / 2, WAVETAB
 quadrature = numpy.fmod(numpy.arange(WAVETABLE_SIZE + 1) + WAVETABLE_SIZE / 4, WAVETABLE_SIZE)
 fill = numpy.fmod(numpy.arange(WAVETABLE_SIZE + 1), WAVETABLE_SIZE)
 
+# The second half of a square period is the first one, negated ; and the
+# triangle (or sine) is, in addition, symmetric around 0. Only the first half
+# (square) or quarter (triangle) of the period is stored, the oscillator folds
+# the phase to read the rest. The saw has no such symmetry. The mirrored phase
+# of the triangle reaches the end of the quarter, so it needs 2 guard samples.
+HALF_WAVE_SIZE = WAVETABLE_SIZE / 2 + 1
+QUARTER_WAVE_SIZE = WAVETABLE_SIZE / 4 + 2
+
 if CAUSAL:
   window = numpy.hanning(WAVETABLE_SIZE)
 else:
@@ -131,13 +139,13 @@ for zone in range(num_zones):
   if zone == num_zones - 1:
     square = sine
   bl_square_tables.append(('bandlimited_square_%d' % zone,
-                          Scale(square[quadrature])))
+                          Scale(square[quadrature])[:HALF_WAVE_SIZE]))
   
   triangle = triangle[quadrature]
   if zone == num_zones - 1:
     triangle = sine
   bl_tri_tables.append(('bandlimited_triangle_%d' % zone,
-                        Scale(triangle[quadrature])))
+                        Scale(triangle[quadrature])[:QUARTER_WAVE_SIZE]))
 
   saw = -numpy.cumsum(pulse[wrap] - pulse.mean())
   saw -= JUNINESS * numpy.cumsum(saw - saw.mean()) / WAVETABLE_SIZE
@@ -165,9 +173,105 @@ def LoadWavetable(x):
   return wavetable.ravel()
 
 
+# The waves of the wavetable are stored in flash with a 4-bit ADPCM code, and
+# decoded in SRAM when the oscillator selects them. Each sample is predicted
+# by extrapolating the two previous ones, and the error is quantized with a
+# step size that adapts to the magnitude of the previous codes. The decoder
+# in user_wavetables.cc must follow the same rules.
+#
+# Format, for each wave: index of the initial step size, first sample, then the
+# 127 other samples as 4-bit signed codes, most significant nibble first. Waves
+# which would be too degraded by this (noisy ones) are stored verbatim, after
+# a 0xff byte.
+#
+# The compression is lossy, and audibly so on the brightest waves. With a
+# threshold of 24 dB, waves 10, 11, 14 and 15 are stored verbatim. Among the
+# encoded ones, waves 0 to 5 are above 39 dB, with errors of 3 LSB at most,
+# but waves 6 to 9 are between 29.5 and 33.3 dB (9 LSB for wave 8), and waves
+# 12 and 13 at 26.3 and 25.4 dB (12 and 17 LSB).
+#
+# Even so, there is no net saving of flash: the 756 bytes saved on the table
+# are eaten by the decoder (RequestBuiltin) and its lookup tables, and the
+# firmware ends up 65 bytes larger than with the verbatim table. Raising the
+# threshold to 40 dB would store 10 waves verbatim (1749 bytes instead of
+# 1308), and make it 506 bytes larger.
+WAVETABLE_ADPCM_STEPS = [1, 2, 3, 4, 6, 8, 11, 16, 23, 32, 45, 64]
+WAVETABLE_ADPCM_MIN_SNR = 24.0
+WAVETABLE_RAW_WAVE = 0xff
+
+
+def Clip(x, low, high):
+  return low if x < low else (high if x > high else x)
+
+
+def AdaptStepIndex(step_index, code):
+  magnitude = abs(code)
+  if magnitude >= 6:
+    step_index += 2
+  elif magnitude >= 4:
+    step_index += 1
+  elif magnitude <= 1:
+    step_index -= 1
+  return Clip(step_index, 0, len(WAVETABLE_ADPCM_STEPS) - 1)
+
+
+def AdpcmEncode(wave, initial_step_index):
+  codes = []
+  decoded = [wave[0]]
+  value = previous = wave[0]
+  step_index = initial_step_index
+  for sample in wave[1:]:
+    prediction = Clip(2 * value - previous, 0, 255)
+    step = WAVETABLE_ADPCM_STEPS[step_index]
+    code = Clip(int(numpy.floor((sample - prediction) / float(step) + 0.5)),
+                -8, 7)
+    previous = value
+    value = Clip(prediction + code * step, 0, 255)
+    codes.append(code)
+    decoded.append(value)
+    step_index = AdaptStepIndex(step_index, code)
+  return codes, decoded
+
+
+def CompressWave(wave):
+  wave = [int(x) for x in wave]
+  best = None
+  for initial_step_index in xrange(len(WAVETABLE_ADPCM_STEPS)):
+    codes, decoded = AdpcmEncode(wave, initial_step_index)
+    error = sum((x - y) ** 2 for x, y in zip(wave, decoded))
+    if best is None or error < best[0]:
+      best = (error, initial_step_index, codes)
+  error, initial_step_index, codes = best
+  signal = numpy.var(wave) * len(wave)
+  if error and 10 * numpy.log10(signal / error) < WAVETABLE_ADPCM_MIN_SNR:
+    return [WAVETABLE_RAW_WAVE] + wave
+  codes.append(0)
+  nibbles = [code & 0xf for code in codes]
+  packed = [(nibbles[i] << 4) | nibbles[i + 1]
+            for i in xrange(0, len(nibbles), 2)]
+  return [initial_step_index, wave[0]] + packed
+
+
+# Offset of each wave in the compressed data, so that the decoder does not have
+# to walk through the waves of variable size which precede it.
+wavetable_offsets = []
+
+
+def CompressWavetable(wavetable):
+  # Strips the copy of the first sample at the end of each cycle - the decoder
+  # restores it.
+  wavetable = wavetable.reshape((16, -1))[:, :-1]
+  data = []
+  for wave in wavetable:
+    wavetable_offsets.append(len(data))
+    data.extend(CompressWave(wave))
+  return data
+
+
 waveforms.append((
     'wavetable',
-    LoadWavetable('hardware/shruti/data/wavetable.bin')))
+    CompressWavetable(LoadWavetable('hardware/shruti/data/wavetable.bin'))))
+waveforms.append(('wavetable_adpcm_steps', WAVETABLE_ADPCM_STEPS))
 
 
 """----------------------------------------------------------------------------
@@ -186,3 +290,39 @@ vowel_data = [
  6, 73,  99, 122, 233]
 
 waveforms.append(('vowel_data', vowel_data))
+
+
+"""----------------------------------------------------------------------------
+Envelope curves
+-----------------------------------------------------------------------------"""
+
+# The envelope curves and LFO shapes are only used by optional features (see
+# shruti.h). They are not listed in the waveform table, and are read through
+# their own symbol, so that they are not linked when their feature is not.
+shapes = []
+
+envelope_curve_size = 64
+x = numpy.arange(envelope_curve_size + 1) / float(envelope_curve_size)
+curvature = 4.0
+exponential = (1 - numpy.exp(-curvature * x)) / (1 - numpy.exp(-curvature))
+logarithmic = 1 - exponential[::-1]
+s_curve = x * x * (3 - 2 * x)
+
+env_curves = numpy.hstack((exponential, logarithmic, s_curve))
+shapes.append(('env_curves', numpy.round(env_curves * 255)))
+
+
+"""----------------------------------------------------------------------------
+LFO waveforms
+-----------------------------------------------------------------------------"""
+
+lfo_waveform_size = 64
+x = numpy.arange(lfo_waveform_size + 1) / float(lfo_waveform_size)
+sine = (1 + numpy.cos(2 * numpy.pi * x)) / 2
+exponential_decay = (numpy.exp(-curvature * x) - numpy.exp(-curvature)) / (
+    1 - numpy.exp(-curvature))
+exponential_rise = exponential_decay[::-1]
+steps = numpy.minimum(numpy.floor(x * 8), 7) / 7
+
+lfo_waveforms = numpy.hstack((sine, exponential_decay, exponential_rise, steps))
+shapes.append(('lfo_waveforms', numpy.round(lfo_waveforms * 255)))
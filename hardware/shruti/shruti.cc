@@ -15,6 +15,7 @@
 
 #include "hardware/hal/adc.h"
 #include "hardware/hal/audio_output.h"
+#include "hardware/hal/devices/mcp492x.h"
 #include "hardware/hal/devices/output_array.h"
 #include "hardware/hal/devices/shift_register.h"
 #include "hardware/hal/gpio.h"
@@ -27,6 +28,8 @@
 #include "hardware/shruti/display.h"
 #include "hardware/shruti/editor.h"
 #include "hardware/shruti/synthesis_engine.h"
+#include "hardware/shruti/user_wavetables.h"
+#include "hardware/utils/op.h"
 #include "hardware/utils/task.h"
 
 using namespace hardware_hal;
@@ -35,9 +38,10 @@ using namespace hardware_shruti;
 
 using hardware_utils::NaiveScheduler;
 using hardware_utils::Task;
+using hardware_utils_op::SignedUnsignedMul;
 
 // Midi input.
-Serial<SerialPort0, 31250, BUFFERED, POLLED> midi_io;
+Serial<SerialPort0, 31250, BUFFERED, BUFFERED> midi_io;
 
 // Input event handlers.
 typedef InputArray<
@@ -51,7 +55,9 @@ typedef InputArray<
 
 PwmOutput<kPinVcfCutoffOut> vcf_cutoff_out;
 PwmOutput<kPinVcfResonanceOut> vcf_resonance_out;
+#ifndef HAS_DAC_AUDIO_OUTPUT
 PwmOutput<kPinVcaOut> vca_out;
+#endif  // HAS_DAC_AUDIO_OUTPUT
 
 Pots pots;
 Switches switches;
@@ -68,18 +74,44 @@ OutputArray<
     Gpio<kPinClk>,
     Gpio<kPinData>, kNumPages, 4, MSB_FIRST, false> leds;
 
+#ifdef HAS_DAC_AUDIO_OUTPUT
+// Audio output on the SPI DAC.
+AudioOutput<StreamingDac<kPinDacSlaveSelect>, kAudioBufferSize,
+            kAudioBlockSize> audio_out;
+
+// The amplitude envelope is applied to the samples, which are then scaled to
+// 12 bits.
+static inline uint16_t AudioSample(uint8_t signal, uint8_t vca) {
+  return 2048 + (SignedUnsignedMul(signal + 128, vca) >> 4);
+}
+#else
 // Audio output on pin 3.
 AudioOutput<PwmOutput<kPinVcoOut>, kAudioBufferSize, kAudioBlockSize> audio_out;
 
+static inline uint8_t AudioSample(uint8_t signal, uint8_t vca) {
+  return signal;
+}
+#endif  // HAS_DAC_AUDIO_OUTPUT
+
 MidiStreamParser<SynthesisEngine> midi_parser;
 
 static const uint16_t kDetailsPageDelay = 900;
 
+void MidiTask();
+
+static inline uint8_t midi_overloaded() {
+  return midi_io.readable() >= kMidiBacklogThreshold;
+}
+
 // What follows is a list of "tasks" - short functions handling a particular
 // aspect of the synth (rendering audio, updating the LCD display, etc). they
 // are called in sequence, with some tasks being more frequently called than
 // others, by the Scheduler.
 void UpdateLedsTask() {
+  if (midi_overloaded()) {
+    MidiTask();
+    return;
+  }
   leds.Clear();
   if (editor.current_page() == PAGE_MOD_MATRIX) {
     uint8_t current_modulation_source_value = engine.modulation_source(0,
@@ -104,6 +136,10 @@ void UpdateLedsTask() {
 }
 
 void UpdateDisplayTask() {
+  if (midi_overloaded()) {
+    MidiTask();
+    return;
+  }
   display.Update();
 }
 
@@ -186,13 +222,29 @@ void MidiTask() {
   // situation where MIDI bytes are dropped... at the cost of a more glitchy
   // audio output in case of MIDI overloading.
   uint8_t status = 0;
+  // Continue sending the patch dump, if any, and loading the user wavetables.
+  Patch::SysExTransmit();
+#ifdef HAS_USER_WAVETABLES
+  UserWavetables::Stream();
+#endif  // HAS_USER_WAVETABLES
+  // When the input is overloaded, the active sensing messages, and the clock
+  // messages if the arpeggiator does not use them, are dropped (not even
+  // copied to the output) to catch up with the note data.
+  uint8_t overloaded = midi_overloaded();
   while (midi_io.readable()) {
     uint8_t value = midi_io.ImmediateRead();
+    if (overloaded && (value == 0xfe || (value == 0xf8 &&
+        !engine.voice_controller().synced_to_midi_clock()))) {
+      continue;
+    }
     
-    // Copy the byte to the MIDI output (thru). We could use Overwrite here
-    // since the output rate is the same as the input rate, which ensures that
-    // 0.32ms have elapsed between the writes.
-    midi_io.Write(value);
+    // Copy the byte to the MIDI output (thru). The output rate is the same as
+    // the input rate, so the output buffer only fills up while a patch dump is
+    // being sent - and during this time, only the realtime messages, which
+    // can be interleaved with the SysEx data, are copied.
+    if (!Patch::sysex_transmission_pending() || value >= 0xf8) {
+      midi_io.Write(value);
+    }
     
     // Also, parse the message.
     status = midi_parser.PushByte(value);
@@ -240,19 +292,22 @@ void MidiTask() {
 void AudioRenderingTask() {
   if (audio_out.writable_block()) {
     engine.Control();
+    uint8_t vca = engine.voice(0).vca();
     if (engine.voice(0).dead()) {
       for (uint8_t i = kAudioBlockSize; i > 0 ; --i) {
-        audio_out.Overwrite(128);
+        audio_out.Overwrite(AudioSample(128, vca));
       }
     } else {
       for (uint8_t i = kAudioBlockSize; i > 0 ; --i) {
         engine.Audio();
-        audio_out.Overwrite(engine.voice(0).signal());
+        audio_out.Overwrite(AudioSample(engine.voice(0).signal(), vca));
       }
     }
     vcf_cutoff_out.Write(engine.voice(0).cutoff());
     vcf_resonance_out.Write(engine.voice(0).resonance());
-    vca_out.Write(engine.voice(0).vca());
+#ifndef HAS_DAC_AUDIO_OUTPUT
+    vca_out.Write(vca);
+#endif  // HAS_DAC_AUDIO_OUTPUT
   }
 }
 
@@ -294,9 +349,19 @@ TIMER_2_TICK {
   audio_out.EmitSample();
 }
 
+#ifdef HAS_DAC_AUDIO_OUTPUT
+SPI_TRANSFER_COMPLETE {
+  StreamingDac<kPinDacSlaveSelect>::OnTransferComplete();
+}
+#endif  // HAS_DAC_AUDIO_OUTPUT
+
 void Init() {
   scheduler.Init();
+#ifdef HAS_FAST_BOOT
+  display.FastInit();
+#else
   display.Init();
+#endif  // HAS_FAST_BOOT
   editor.Init();
   audio_out.Init();
 
@@ -308,7 +373,9 @@ void Init() {
   Timer<2>::Start();
   vcf_cutoff_out.Init();
   vcf_resonance_out.Init();
+#ifndef HAS_DAC_AUDIO_OUTPUT
   vca_out.Init();
+#endif  // HAS_DAC_AUDIO_OUTPUT
   
   display.SetBrightness(29);
   display.SetCustomCharMap(character_table[0], 8);
@@ -321,11 +388,18 @@ void Init() {
   input_mux.Init();
   leds.Init();  
   
+#ifdef HAS_USER_WAVETABLES
+  UserWavetables::Init();
+#endif  // HAS_USER_WAVETABLES
   engine.Init();
+#ifdef HAS_FAST_BOOT
+  editor.RestorePatch();
+#endif  // HAS_FAST_BOOT
 }
 
 int main(void) {
   InitAtmega(false);  // Do not initialize timers 1 & 2.
   Init();
   scheduler.Run();
+  return 0;
 }
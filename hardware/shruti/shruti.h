@@ -23,7 +23,63 @@
 #include "hardware/base/base.h"
 
 #define HAS_GLITCH_MONITORING
+
+// Makes the audio and MIDI available as soon as the chip has booted. This
+// changes two things at startup:
+// - The negotiation of the LCD baud rate is skipped, so a display which has
+//   not been set to 2400 bauds stays blank until the negotiation is done with
+//   a long press on the mod button.
+// - The patch used before a watchdog or bootloader reset is reloaded. After a
+//   power cycle, this is the first patch stored in the EEPROM, instead of the
+//   default patch set by ResetPatch().
+// #define HAS_FAST_BOOT
+
+// Sends the audio, with a 12-bits resolution, to a MCP4921 DAC on the SPI bus,
+// instead of the PWM output on pin 3. This requires a modified board: the SPI
+// bus takes pins 11 (on which the VCA control voltage is normally output) and
+// 13, and the DAC is selected by pin 3. The VCA is then applied digitally.
+// #define HAS_DAC_AUDIO_OUTPUT
+
+// Duophonic mode, selected with the MIDI channel setting (51-67, shown as 'd'):
+// the two most recently played notes are split between the two oscillators.
+// #define HAS_DUOPHONIC
+
+// Band-limited unison saw shape for oscillator 1.
+// #define HAS_UNISON_SAW
+
+// Plays the user wavetables stored in an external I2C EEPROM (see
+// user_wavetables.h), and writes the blocks of wavetable received by SysEx
+// into it. hardware/hal/i2c must then be added to the PACKAGES of the
+// makefile.
+// #define HAS_USER_WAVETABLES
+
+// Morphs between two patches stored in the EEPROM with the third CV input,
+// started from the load/save page.
+// #define HAS_PATCH_MORPHING
+
+// Envelope segments following an exponential, logarithmic or S-shaped curve,
+// and looping multi-stage envelopes. The patches store these settings in any
+// case, but without these options, the envelopes are plain linear ADSRs.
+// #define HAS_ENVELOPE_CURVES
+// #define HAS_MULTI_STAGE_ENVELOPES
+
+// LFO shapes read from a table (sine, exponential ramps, steps), and the
+// user shape received by SysEx.
+// #define HAS_LFO_SHAPES
+
+// LFO retriggered by each note, set by NRPN and used as the MOD_SRC_VOICE_LFO
+// modulation source. Without this option, this source stays at 0.
+// #define HAS_VOICE_LFO
+
+// Holding the play switch for 2 seconds displays the peak occupancy of the MIDI
+// input buffer, and the number of MIDI bytes lost because it was full.
+// #define HAS_MIDI_STATISTICS
+
+// The hand-written assembly versions of the arithmetic ops are only available
+// on the AVR ; builds for the desktop use the portable C code.
+#ifdef __AVR__
 #define USE_OPTIMIZED_OP
+#endif  // __AVR__
 
 namespace hardware_shruti {
 
@@ -70,10 +126,14 @@ static const uint8_t kPinVcoOut = 3;
 static const uint8_t kPinVcaOut = 11;
 static const uint8_t kPinVcfCutoffOut = 9;
 static const uint8_t kPinVcfResonanceOut = 10;
+static const uint8_t kPinDacSlaveSelect = 3;  // With HAS_DAC_AUDIO_OUTPUT.
 
 static const uint8_t kPinAnalogInput = 0;
 static const uint8_t kPinCvInput = 1;
 
+// With HAS_USER_WAVETABLES, the external EEPROM storing the user wavetables is
+// on the I2C bus, on analog pins 4 (SDA) and 5 (SCL).
+
 // ---- LCD display type -------------------------------------------------------
 
 static const uint8_t kLcdWidth = 16;
@@ -83,6 +143,12 @@ static const uint8_t kLcdHeight = 2;
 
 static const uint8_t kSchedulerNumSlots = 32;
 
+// Number of bytes waiting in the MIDI input buffer (32 bytes, 10ms at 31250
+// bauds) above which the MIDI input is considered overloaded. The slots of the
+// LED and LCD refresh tasks are then given to the MIDI task, and the active
+// sensing and unused clock messages are discarded.
+static const uint8_t kMidiBacklogThreshold = 8;
+
 }  // namespace hardware_shruti
 
 #endif  // HARDWARE_SHRUTI_SHRUTI_H_
@@ -21,9 +21,12 @@
 
 #include <string.h>
 
+#include <avr/eeprom.h>
+
 #include "hardware/resources/resources_manager.h"
 #include "hardware/shruti/oscillator.h"
 #include "hardware/shruti/patch_metadata.h"
+#include "hardware/shruti/user_wavetables.h"
 #include "hardware/utils/random.h"
 #include "hardware/utils/op.h"
 
@@ -53,6 +56,11 @@ uint8_t SynthesisEngine::num_lfo_reset_steps_;
 uint8_t SynthesisEngine::lfo_reset_counter_;
 uint8_t SynthesisEngine::lfo_to_reset_;
 uint8_t SynthesisEngine::ignore_note_off_messages_;
+#ifdef HAS_PATCH_MORPHING
+uint8_t SynthesisEngine::morph_slot_[2];
+uint8_t SynthesisEngine::morph_position_source_ = kNoMorph;
+uint8_t SynthesisEngine::morph_parameter_;
+#endif  // HAS_PATCH_MORPHING
 
 /* </static> */
 
@@ -66,51 +74,99 @@ void SynthesisEngine::Init() {
   }
 }
 
-static const prog_char empty_patch[] PROGMEM = {
-    99,
-    WAVEFORM_SAW, WAVEFORM_SQUARE, 0, 24,
-    0, -12, 0, 12,
-    16, 0, 0, WAVEFORM_SQUARE,
-    90, 0, 20, 0,
-    20, 0,
-    60, 40,
-    20, 80,
-    60, 40,
-    LFO_WAVEFORM_TRIANGLE, LFO_WAVEFORM_TRIANGLE, 96, 3,
-    MOD_SRC_LFO_1, MOD_DST_VCO_1, 0,
-    MOD_SRC_LFO_1, MOD_DST_VCO_2, 0,
-    MOD_SRC_LFO_1, MOD_DST_PWM_1, 0,
-    MOD_SRC_LFO_1, MOD_DST_PWM_2, 0,
-    MOD_SRC_LFO_2, MOD_DST_MIX_BALANCE, 0,
-    // By default, the resonance tracks the note. This value was empirically
-    // obtained and it is not clear whether it depends on the positive supply
-    // voltage, and if it varies from chip to chip.
-    MOD_SRC_NOTE, MOD_DST_FILTER_CUTOFF, 58,
-    MOD_SRC_ENV_2, MOD_DST_VCA, 63,
-    MOD_SRC_VELOCITY, MOD_DST_VCA, 16,
-    MOD_SRC_PITCH_BEND, MOD_DST_VCO_1_2_FINE, 32,
-    MOD_SRC_LFO_1, MOD_DST_VCO_1_2_FINE, 16,
-    MOD_SRC_CV_1, MOD_DST_PWM_1, 0,
-    MOD_SRC_CV_2, MOD_DST_PWM_2, 0,
-    MOD_SRC_CV_3, MOD_DST_FILTER_CUTOFF, 0,
-    MOD_SRC_RANDOM, MOD_DST_FILTER_CUTOFF, 0,
-    120, 0, 0, 0,
-    0x00, 0x00, 0xff, 0xff, 0xcc, 0xcc, 0x44, 0x44,
-    0, 0, 0, 1,
-    'n', 'e', 'w', ' ', ' ', ' ', ' ', ' ',
-    16, 0 };
-
 /* static */
 void SynthesisEngine::ResetPatch() {
+#ifdef HAS_PATCH_MORPHING
+  StopMorph();
+#endif  // HAS_PATCH_MORPHING
   ResourcesManager::Load(empty_patch, 0, &patch_);
   TouchPatch();
 }
 
+#ifdef HAS_PATCH_MORPHING
+
+/* static */
+void SynthesisEngine::StartMorph(
+    uint8_t source_slot,
+    uint8_t target_slot,
+    uint8_t position_source) {
+  morph_slot_[0] = source_slot;
+  morph_slot_[1] = target_slot;
+  morph_parameter_ = 0;
+  morph_position_source_ = position_source;
+}
+
+// Reads the value of a morphed parameter directly from a patch saved in the
+// EEPROM, to avoid keeping two more unpacked patches in RAM. See Patch::Pack
+// for the layout.
+static uint8_t ReadMorphedParameter(uint8_t slot, uint8_t parameter_index) {
+  const uint8_t* address = (const uint8_t*)(uintptr_t)(slot * kSerializedPatchSize);
+  if (parameter_index < PRM_MOD_SOURCE) {
+    uint8_t value = eeprom_read_byte(address + parameter_index);
+    // The upper bits of the osc 2 shape store the envelope curves.
+    return parameter_index == PRM_OSC_SHAPE_2 ? value & 0x0f : value;
+  }
+  uint8_t row = (parameter_index - PRM_MOD_SOURCE) / 3;
+  uint8_t field = parameter_index - PRM_MOD_SOURCE - row * 3;
+  address += PRM_MOD_SOURCE + 2 * row;
+  if (field == 0) {
+    return eeprom_read_byte(address) & 0x0f;
+  } else if (field == 1) {
+    return ShiftRight4(eeprom_read_byte(address));
+  } else {
+    return eeprom_read_byte(address + 1);
+  }
+}
+
+/* static */
+void SynthesisEngine::UpdateMorph() {
+  uint8_t position = modulation_sources_[morph_position_source_];
+  for (uint8_t i = 0; i < kNumMorphedParametersPerTick; ++i) {
+    uint8_t parameter_index = morph_parameter_;
+    ++morph_parameter_;
+    if (morph_parameter_ == kNumMorphedParameters) {
+      morph_parameter_ = 0;
+    }
+    uint8_t a = ReadMorphedParameter(morph_slot_[0], parameter_index);
+    uint8_t b = ReadMorphedParameter(morph_slot_[1], parameter_index);
+    uint8_t field = parameter_index >= PRM_MOD_SOURCE ?
+        (parameter_index - PRM_MOD_SOURCE) % 3 : 0xff;
+    uint8_t value;
+    if (parameter_index <= PRM_OSC_SHAPE_2 ||
+        parameter_index == PRM_OSC_OPTION_1 ||
+        parameter_index == PRM_MIX_SUB_OSC_SHAPE ||
+        parameter_index == PRM_LFO_WAVE_1 ||
+        parameter_index == PRM_LFO_WAVE_2 ||
+        field == 0 || field == 1) {
+      value = position < kMorphSwitchThreshold ? a : b;
+    } else {
+      // The interpolation coefficient goes from 0 to 128, so that both ends
+      // of the course give the exact value of the patches.
+      int16_t delta;
+      if (parameter_index == PRM_OSC_RANGE_1 ||
+          parameter_index == PRM_OSC_RANGE_2 ||
+          parameter_index == PRM_FILTER_ENV ||
+          parameter_index == PRM_FILTER_LFO ||
+          field == 2) {
+        delta = static_cast<int8_t>(b) - static_cast<int8_t>(a);
+      } else {
+        delta = b - a;
+      }
+      value = a + ((delta * ((position + 1) >> 1)) >> 7);
+    }
+    if (value != GetParameter(parameter_index)) {
+      SetParameter(parameter_index, value);
+    }
+  }
+}
+
+#endif  // HAS_PATCH_MORPHING
+
 /* static */
 void SynthesisEngine::NoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
   // If the note controller is not active, we are not currently playing a
   // sequence, so we retrigger the LFOs.
-  if (patch_.kbd_midi_channel < 34) {
+  if (patch_.kbd_midi_channel < 34 || patch_.kbd_midi_channel >= 51) {
     if (!controller_.active()) {
       lfo_reset_counter_ = num_lfo_reset_steps_ - 1;
     }
@@ -125,7 +181,7 @@ void SynthesisEngine::NoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
   if (ignore_note_off_messages_) {
     return;
   }
-  if (patch_.kbd_midi_channel < 34) {
+  if (patch_.kbd_midi_channel < 34 || patch_.kbd_midi_channel >= 51) {
     controller_.NoteOff(note);
   } else {
     voice_[0].Release();
@@ -229,21 +285,15 @@ void SynthesisEngine::ResetAllControllers(uint8_t channel) {
 // which this message has been received.
 /* static */
 void SynthesisEngine::OmniModeOff(uint8_t channel) {
-  if (patch_.kbd_midi_channel >= 17) {
-    patch_.kbd_midi_channel = channel + 18;
-  } else {
-    patch_.kbd_midi_channel = channel + 1;
-  }
+  // Preserve the lazy/direct/duophonic mode, encoded by multiples of 17.
+  patch_.kbd_midi_channel -= patch_.kbd_midi_channel % 17;
+  patch_.kbd_midi_channel += channel + 1;
 }
 
 // Enable Omni mode.
 /* static */
 void SynthesisEngine::OmniModeOn(uint8_t channel) {
-  if (patch_.kbd_midi_channel >= 17) {
-    patch_.kbd_midi_channel = 17;
-  } else {
-    patch_.kbd_midi_channel = 0;
-  }
+  patch_.kbd_midi_channel -= patch_.kbd_midi_channel % 17;
 }
 
 /* static */
@@ -259,6 +309,17 @@ void SynthesisEngine::SysExByte(uint8_t sysex_byte) {
 /* static */
 void SynthesisEngine::SysExEnd() {
   patch_.SysExReceive(0xf7);
+#ifdef HAS_USER_WAVETABLES
+  if (patch_.sysex_reception_state() == RECEPTION_OK &&
+      patch_.sysex_command() == SYSEX_COMMAND_USER_WAVETABLE_BLOCK &&
+      !UserWavetables::WriteBlock(
+          patch_.sysex_argument(),
+          patch_.sysex_data())) {
+    // The previous block is still being written. Report a reception error,
+    // so that the block is sent again.
+    patch_.set_sysex_reception_state(RECEPTION_ERROR);
+  }
+#endif  // HAS_USER_WAVETABLES
 }
 
 /* static */
@@ -291,10 +352,19 @@ void SynthesisEngine::Stop() {
 void SynthesisEngine::SetParameter(
     uint8_t parameter_index,
     uint8_t parameter_value) {
-  uint8_t* base = &patch_.keep_me_at_the_top;
+#if defined(HAS_USER_WAVETABLES) && !defined(HAS_UNISON_SAW)
+  // The unison saw is not compiled in, but sits in the range of shapes of
+  // osc 1, just below the user wavetable.
+  if (parameter_index == PRM_OSC_SHAPE_1 &&
+      parameter_value == WAVEFORM_UNISON_SAW) {
+    parameter_value = WAVEFORM_USER_WAVETABLE;
+  }
+#endif  // HAS_USER_WAVETABLES && !HAS_UNISON_SAW
+  uint8_t* base = reinterpret_cast<uint8_t*>(&patch_);
   base[parameter_index + 1] = parameter_value;
-  if (parameter_index >= PRM_ENV_ATTACK_1 &&
-      parameter_index <= PRM_LFO_RATE_2) {
+  if ((parameter_index >= PRM_ENV_ATTACK_1 &&
+       parameter_index <= PRM_LFO_RATE_2) ||
+      (parameter_index >= PRM_ENV_CURVE_1)) {
     UpdateModulationIncrements();
   }
   if ((parameter_index <= PRM_OSC_SHAPE_2) ||
@@ -305,7 +375,8 @@ void SynthesisEngine::SetParameter(
   // so any parameter change must be forwarded to it.
   if ((parameter_index >= PRM_ARP_TEMPO &&
        parameter_index <= PRM_ARP_GROOVE) ||
-      (parameter_index == PRM_ARP_PATTERN_SIZE)) {
+      (parameter_index == PRM_ARP_PATTERN_SIZE) ||
+      (parameter_index == PRM_KBD_MIDI_CHANNEL)) {
     controller_.UpdateArpeggiatorParameters(patch_);
   }
 }
@@ -340,22 +411,48 @@ void SynthesisEngine::UpdateModulationIncrements() {
     lfo_[i].Update(patch_.lfo_wave[i], increment);
 
     for (uint8_t j = 0; j < kNumVoices; ++j) {
+#ifdef HAS_MULTI_STAGE_ENVELOPES
+      if (patch_.env_multistage & _BV(i)) {
+        voice_[j].mutable_envelope(i)->UpdateMultiStage(
+            patch_.mseg_level,
+            patch_.mseg_time,
+            patch_.mseg_loop_start,
+            patch_.mseg_loop_end,
+            patch_.env_release[i]);
+        continue;
+      }
+#endif  // HAS_MULTI_STAGE_ENVELOPES
       voice_[j].mutable_envelope(i)->Update(
           patch_.env_attack[i],
           patch_.env_decay[i],
           patch_.env_sustain[i],
-          patch_.env_release[i]);
+          patch_.env_release[i],
+          patch_.env_curve[i]);
     }
   }
+#ifdef HAS_VOICE_LFO
+  // The voice LFO is not synchronized to the arpeggiator/step sequencer.
+  uint16_t increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
+      lut_res_lfo_increments, patch_.voice_lfo_rate);
+  for (uint8_t j = 0; j < kNumVoices; ++j) {
+    voice_[j].mutable_lfo()->Update(patch_.voice_lfo_wave, increment);
+  }
+#endif  // HAS_VOICE_LFO
 }
 
 /* static */
 void SynthesisEngine::Control() {
+#ifdef HAS_PATCH_MORPHING
+  if (morphing()) {
+    UpdateMorph();
+  }
+#endif  // HAS_PATCH_MORPHING
   for (uint8_t i = 0; i < kNumLfos; ++i) {
     lfo_[i].Increment();
     modulation_sources_[MOD_SRC_LFO_1 + i] = lfo_[i].Render(patch_);
   }
-  modulation_sources_[MOD_SRC_RANDOM] = Random::state_msb();
+  Random::FillNoiseBuffer();
+  modulation_sources_[MOD_SRC_RANDOM] = Random::GetByte();
   modulation_sources_[MOD_SRC_OFFSET] = 255;
 
   // Update the arpeggiator / step sequencer.
@@ -394,9 +491,7 @@ void SynthesisEngine::Control() {
 void SynthesisEngine::Audio() {
   // Tick the noise generator.
   oscillator_decimation_ = (oscillator_decimation_ + 1) & 3;
-  if (!oscillator_decimation_) {
-    Random::Update();
-  }
+  Random::NextNoiseSample();
   for (uint8_t i = 0; i < kNumVoices; ++i) {
     voice_[i].Audio();
   }
@@ -404,10 +499,13 @@ void SynthesisEngine::Audio() {
 
 /* <static> */
 Envelope Voice::envelope_[kNumEnvelopes];
+#ifdef HAS_VOICE_LFO
+Lfo Voice::lfo_;
+#endif  // HAS_VOICE_LFO
 uint8_t Voice::dead_;
-int16_t Voice::pitch_increment_;
-int16_t Voice::pitch_target_;
-int16_t Voice::pitch_value_;
+int16_t Voice::pitch_increment_[kNumOscillators];
+int16_t Voice::pitch_target_[kNumOscillators];
+int16_t Voice::pitch_value_[kNumOscillators];
 uint8_t Voice::modulation_sources_[kNumVoiceModulationSources];
 int8_t Voice::modulation_destinations_[kNumModulationDestinations];
 uint8_t Voice::signal_;
@@ -416,7 +514,9 @@ uint8_t Voice::osc1_phase_msb_;
 
 /* static */
 void Voice::Init() {
-  pitch_value_ = 0;
+  for (uint8_t i = 0; i < kNumOscillators; ++i) {
+    pitch_value_[i] = 0;
+  }
   signal_ = 128;
   for (uint8_t i = 0; i < kNumEnvelopes; ++i) {
     envelope_[i].Init();
@@ -431,45 +531,55 @@ void Voice::TriggerEnvelope(uint8_t stage) {
 }
 
 /* static */
-void Voice::Trigger(uint8_t note, uint8_t velocity, uint8_t legato) {
-  if (engine.patch_.kbd_raga) {
-    int16_t pitch_shift = ResourcesManager::Lookup<int16_t, uint8_t>(
-        ResourceId(LUT_RES_SCALE_JUST + engine.patch_.kbd_raga - 1),
-        note % 12);
-    if (pitch_shift != 32767) {
-      // Some scales/raga settings might have muted notes. Do not trigger
-      // anything in this case!
-      pitch_target_ = (static_cast<uint16_t>(note) << 7) + pitch_shift;
-    } else {
-      if (legato) {
-        legato = 255;
+void Voice::Trigger(uint8_t osc_1_note, uint8_t osc_2_note, uint8_t velocity,
+                    uint8_t legato) {
+  for (uint8_t i = 0; i < kNumOscillators; ++i) {
+    uint8_t note = i == 0 ? osc_1_note : osc_2_note;
+    if (engine.patch_.kbd_raga) {
+      int16_t pitch_shift = ResourcesManager::Lookup<int16_t, uint8_t>(
+          ResourceId(LUT_RES_SCALE_JUST + engine.patch_.kbd_raga - 1),
+          note % 12);
+      if (pitch_shift != 32767) {
+        // Some scales/raga settings might have muted notes. Do not trigger
+        // anything in this case!
+        pitch_target_[i] = (static_cast<uint16_t>(note) << 7) + pitch_shift;
+      } else {
+        if (legato) {
+          legato = 255;
+        }
       }
+    } else {
+      pitch_target_[i] = (static_cast<uint16_t>(note) << 7);
     }
-  } else {
-    pitch_target_ = (static_cast<uint16_t>(note) << 7);
   }
 
   if (!legato || (engine.patch_.kbd_portamento >= 0 && legato != 255)) {
     TriggerEnvelope(ATTACK);
+#ifdef HAS_VOICE_LFO
+    lfo_.Reset();
+#endif  // HAS_VOICE_LFO
     modulation_sources_[MOD_SRC_VELOCITY - kNumGlobalModulationSources] =
         velocity << 1;
   }
-  // At boot up, or when the note is note played legato and the portamento
-  // is in auto mode, do not ramp up the pitch but jump straight to the target
-  // pitch.
-  if (pitch_value_ == 0 || (!legato && engine.patch_.kbd_portamento < 0)) {
-    pitch_value_ = pitch_target_;
-  }
-  int16_t delta = pitch_target_ - pitch_value_;
   int32_t increment = ResourcesManager::Lookup<uint16_t, uint8_t>(
       lut_res_env_portamento_increments,
       abs(engine.patch_.kbd_portamento));
-  pitch_increment_ = (delta * increment) >> 15;
-  if (pitch_increment_ == 0) {
-    if (delta < 0) {
-      pitch_increment_ = -1;
-    } else {
-      pitch_increment_ = 1;
+  for (uint8_t i = 0; i < kNumOscillators; ++i) {
+    // At boot up, or when the note is note played legato and the portamento
+    // is in auto mode, do not ramp up the pitch but jump straight to the
+    // target pitch.
+    if (pitch_value_[i] == 0 ||
+        (!legato && engine.patch_.kbd_portamento < 0)) {
+      pitch_value_[i] = pitch_target_[i];
+    }
+    int16_t delta = pitch_target_[i] - pitch_value_[i];
+    pitch_increment_[i] = (delta * increment) >> 15;
+    if (pitch_increment_[i] == 0) {
+      if (delta < 0) {
+        pitch_increment_[i] = -1;
+      } else {
+        pitch_increment_[i] = 1;
+      }
     }
   }
 }
@@ -482,11 +592,16 @@ void Voice::Control() {
     envelope_[i].Render();
     dead_ = dead_ && envelope_[i].dead();
   }
+#ifdef HAS_VOICE_LFO
+  lfo_.Increment();
+#endif  // HAS_VOICE_LFO
   
-  pitch_value_ += pitch_increment_;
-  if ((pitch_increment_ > 0) ^ (pitch_value_ < pitch_target_)) {
-    pitch_value_ = pitch_target_;
-    pitch_increment_ = 0;
+  for (uint8_t i = 0; i < kNumOscillators; ++i) {
+    pitch_value_[i] += pitch_increment_[i];
+    if ((pitch_increment_[i] > 0) ^ (pitch_value_[i] < pitch_target_[i])) {
+      pitch_value_[i] = pitch_target_[i];
+      pitch_increment_[i] = 0;
+    }
   }
   
   // Used temporarily, then scaled to modulation_destinations_. This does not
@@ -501,9 +616,13 @@ void Voice::Control() {
   modulation_sources_[MOD_SRC_ENV_2 - kNumGlobalModulationSources] = 
       ShiftRight6(envelope_[1].value());
   modulation_sources_[MOD_SRC_NOTE - kNumGlobalModulationSources] =
-      ShiftRight6(pitch_value_);
+      ShiftRight6(pitch_value_[0]);
   modulation_sources_[MOD_SRC_GATE - kNumGlobalModulationSources] =
       envelope_[0].stage() >= RELEASE ? 0 : 255;
+#ifdef HAS_VOICE_LFO
+  modulation_sources_[MOD_SRC_VOICE_LFO - kNumGlobalModulationSources] =
+      lfo_.Render(engine.patch_);
+#endif  // HAS_VOICE_LFO
       
   modulation_destinations_[MOD_DST_VCA] = 255;
 
@@ -548,7 +667,8 @@ void Voice::Control() {
       // For those sources, use relative modulation.
       if (source <= MOD_SRC_LFO_2 ||
           source == MOD_SRC_PITCH_BEND ||
-          source == MOD_SRC_NOTE) {
+          source == MOD_SRC_NOTE ||
+          source == MOD_SRC_VOICE_LFO) {
         modulation -= amount << 7;
       }
       dst[destination] = Clip(modulation, 0, 16383);
@@ -596,7 +716,7 @@ void Voice::Control() {
   
   // Update the oscillator parameters.
   for (uint8_t i = 0; i < kNumOscillators; ++i) {
-    int16_t pitch = pitch_value_;
+    int16_t pitch = pitch_value_[i];
     // -24 / +24 semitones by the range controller.
     if (engine.patch_.osc_shape[i] == WAVEFORM_FM) {
       osc_1.UpdateSecondaryParameter(engine.patch_.osc_range[i] + 12);
@@ -696,7 +816,7 @@ inline void Voice::Audio() {
         modulation_destinations_[MOD_DST_MIX_SUB_OSC]);
     mix = Mix(
         mix,
-        Random::state_msb(),
+        Random::noise_sample(),
         modulation_destinations_[MOD_DST_MIX_NOISE]);
   }
   
@@ -58,13 +58,30 @@ static const uint8_t kNumLfos = 2;
 static const uint8_t kNumEnvelopes = 2;
 static const uint8_t kNumOscillators = 2;
 
+// The morph interpolates the oscillator, mixer, filter, envelope and LFO
+// parameters, and the saved rows of the modulation matrix.
+static const uint8_t kNumMorphedParameters = PRM_MOD_SOURCE +
+    3 * kSavedModulationMatrixSize;
+static const uint8_t kNumMorphedParametersPerTick = 2;
+// Position above which the parameters that cannot be interpolated (waveforms,
+// operators, modulation routing) take their value from the target patch.
+static const uint8_t kMorphSwitchThreshold = 128;
+static const uint8_t kNoMorph = 0xff;
+
 class Voice {
  public:
   Voice() { }
   static void Init();
 
   // Called whenever a new note is played, manually or through the arpeggiator.
-  static void Trigger(uint8_t note, uint8_t velocity, uint8_t legato);
+  static void Trigger(uint8_t note, uint8_t velocity, uint8_t legato) {
+    Trigger(note, note, velocity, legato);
+  }
+
+  // Same as above, in duophonic mode: osc 1 and osc 2 are independently
+  // pitched, and glide independently to their target notes.
+  static void Trigger(uint8_t osc_1_note, uint8_t osc_2_note, uint8_t velocity,
+                      uint8_t legato);
 
   // Move this voice to the release stage.
   static void Release() { TriggerEnvelope(RELEASE); }
@@ -94,22 +111,31 @@ class Voice {
     return modulation_destinations_[i];
   }
   static Envelope* mutable_envelope(uint8_t i) { return &envelope_[i]; }
+#ifdef HAS_VOICE_LFO
+  static Lfo* mutable_lfo() { return &lfo_; }
+#endif  // HAS_VOICE_LFO
   static void TriggerEnvelope(uint8_t stage);
   
  private:
   // Envelope generators.
   static Envelope envelope_[kNumEnvelopes];
+  
+#ifdef HAS_VOICE_LFO
+  // LFO restarted with each note.
+  static Lfo lfo_;
+#endif  // HAS_VOICE_LFO
   static uint8_t dead_;
 
   // Counters/phases for the pitch envelope generator (portamento).
   // Pitches are stored on 14 bits, the 7 highest bits are the MIDI note value,
-  // the 7 lowest bits are used for fine-tuning.
-  static int16_t pitch_increment_;
-  static int16_t pitch_target_;
-  static int16_t pitch_value_;
+  // the 7 lowest bits are used for fine-tuning. There is one of each for each
+  // oscillator, to allow the duophonic mode.
+  static int16_t pitch_increment_[kNumOscillators];
+  static int16_t pitch_target_[kNumOscillators];
+  static int16_t pitch_value_[kNumOscillators];
 
   // The voice-specific modulation sources are from MOD_SRC_ENV_1 to
-  // MOD_SRC_GATE.
+  // MOD_SRC_VOICE_LFO.
   static uint8_t modulation_sources_[kNumVoiceModulationSources];
 
   // Value of all the stuff controlled by the modulators, scaled to the value
@@ -158,7 +184,7 @@ class SynthesisEngine : public hardware_midi::MidiDevice {
   // Patch manipulation stuff.
   static void SetParameter(uint8_t parameter_index, uint8_t parameter_value);
   static inline uint8_t GetParameter(uint8_t parameter_index) {
-    const uint8_t* base = &patch_.keep_me_at_the_top;
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&patch_);
     return base[parameter_index + 1];
   }
   static uint8_t sequence_step(uint8_t step) {
@@ -170,8 +196,27 @@ class SynthesisEngine : public hardware_midi::MidiDevice {
   static void set_cv(uint8_t cv, uint8_t value) {
     modulation_sources_[MOD_SRC_CV_1 + cv] = value;
   }
-  static uint8_t oscillator_decimation() { return oscillator_decimation_; }
+  // Read by the oscillators. All the oscillators share the decimation counter
+  // and the noise source, whatever their id.
+  static uint8_t oscillator_decimation(uint8_t oscillator_id) {
+    return oscillator_decimation_;
+  }
+  static uint8_t noise_sample(uint8_t oscillator_id) {
+    return Random::noise_sample();
+  }
   static void ResetPatch();
+#ifdef HAS_PATCH_MORPHING
+  // Morphs between two patches stored in the EEPROM, the position being given
+  // by one of the global modulation sources (typically a CV input). Only a few
+  // parameters are updated at each control tick, so that the cost of
+  // SetParameter is spread over time.
+  static void StartMorph(uint8_t source_slot, uint8_t target_slot,
+                         uint8_t position_source);
+  static void StopMorph() { morph_position_source_ = kNoMorph; }
+  static inline uint8_t morphing() {
+    return morph_position_source_ != kNoMorph;
+  }
+#endif  // HAS_PATCH_MORPHING
   // Variables dependent on parameters (increments) are recomputed in
   // SetParameter when the related parameter is modified. Sometimes, the patch
   // is modified all at once without any call to SetParameter (for example when
@@ -215,6 +260,11 @@ class SynthesisEngine : public hardware_midi::MidiDevice {
   static uint8_t nrpn_parameter_number_;
   static uint8_t data_entry_msb_;
   static uint8_t ignore_note_off_messages_;
+#ifdef HAS_PATCH_MORPHING
+  static uint8_t morph_slot_[2];
+  static uint8_t morph_position_source_;
+  static uint8_t morph_parameter_;
+#endif  // HAS_PATCH_MORPHING
 
   // Called whenever a parameter related to LFOs/envelopes is modified (for now
   // everytime a parameter is modified by the user).
@@ -222,6 +272,11 @@ class SynthesisEngine : public hardware_midi::MidiDevice {
   
   // Called whenever a parameter related to oscillators is called.
   static void UpdateOscillatorAlgorithms();
+
+#ifdef HAS_PATCH_MORPHING
+  // Moves the next few morphed parameters towards their interpolated value.
+  static void UpdateMorph();
+#endif  // HAS_PATCH_MORPHING
   
   DISALLOW_COPY_AND_ASSIGN(SynthesisEngine);
 };
@@ -0,0 +1,337 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// User wavetables.
+
+#include "hardware/shruti/user_wavetables.h"
+
+#include <avr/pgmspace.h>
+
+#ifdef HAS_USER_WAVETABLES
+#include "hardware/hal/devices/external_eeprom.h"
+#include "hardware/hal/i2c/i2c.h"
+#endif  // HAS_USER_WAVETABLES
+#include "hardware/shruti/resources.h"
+#include "hardware/utils/op.h"
+#include "hardware/utils/string.h"
+
+using namespace hardware_utils_op;
+
+namespace hardware_shruti {
+
+#ifdef HAS_USER_WAVETABLES
+
+using namespace hardware_hal;
+
+// 24LC64 (8k, 32 bytes pages) on a 400kHz bus. The input buffer determines
+// how many bytes are read by each request.
+typedef I2cMaster<16, 64, 400000> UserWavetableBus;
+typedef ExternalEeprom<8192, UserWavetableBus, 0, false> UserWavetableEeprom;
+
+static const uint8_t kEepromPageSize = 32;
+
+// The EEPROM ignores its address for up to 5ms after a page write. There is
+// one attempt for each run of the MIDI task.
+static const uint8_t kMaxWriteAttempts = 255;
+
+#endif  // HAS_USER_WAVETABLES
+
+// Marks a wave of the built-in wavetable stored verbatim, rather than ADPCM
+// encoded.
+static const uint8_t kRawWave = 0xff;
+
+// Number of samples of a built-in wave decoded at each call of RequestBuiltin.
+// A sample takes from 60 to 100 cycles to decode: the two waves at once would
+// take most of the 16384 cycles available for rendering a block, while 16
+// samples take less than 10% of them. A wave is ready after 8 control periods.
+static const uint8_t kBuiltinWaveChunkSize = 16;
+
+/* <static> */
+uint8_t UserWavetables::cache_[2][kUserWaveSize + 1];
+uint8_t UserWavetables::cached_wave_[2] = { kNoUserWave, kNoUserWave };
+uint8_t UserWavetables::requested_wave_[2] = { kNoUserWave, kNoUserWave };
+uint8_t UserWavetables::loading_wave_;
+uint8_t UserWavetables::loading_slot_;
+uint8_t UserWavetables::num_bytes_loaded_;
+uint8_t UserWavetables::loading_state_ = LOADING_IDLE;
+uint8_t UserWavetables::decoding_wave_ = kNoUserWave;
+uint8_t UserWavetables::decoding_slot_;
+uint8_t UserWavetables::decoding_position_;
+const prog_uint8_t* UserWavetables::decoding_data_;
+uint8_t UserWavetables::decoding_step_index_;
+uint8_t UserWavetables::write_buffer_[kUserWavetableBlockSize];
+uint8_t UserWavetables::write_block_;
+uint8_t UserWavetables::num_bytes_to_write_ = 0;
+uint8_t UserWavetables::write_attempts_;
+uint8_t UserWavetables::write_started_ = 0;
+/* </static> */
+
+#ifdef HAS_USER_WAVETABLES
+
+/* static */
+void UserWavetables::Init() {
+  UserWavetableEeprom::Init();
+}
+
+/* static */
+void UserWavetables::Stream() {
+  // Writes take precedence, but a read in progress is completed first.
+  if (num_bytes_to_write_ && loading_state_ != LOADING_RECEIVE) {
+    StreamWrite();
+    return;
+  }
+  
+  // Give up loading a wave which is no longer needed.
+  if (loading_state_ != LOADING_IDLE &&
+      loading_wave_ != requested_wave_[0] &&
+      loading_wave_ != requested_wave_[1] &&
+      !UserWavetableEeprom::busy()) {
+    loading_state_ = LOADING_IDLE;
+  }
+  
+  switch (loading_state_) {
+    case LOADING_IDLE:
+      {
+        uint8_t wave = requested_wave_[0];
+        if (cached_wave(wave)) {
+          wave = requested_wave_[1];
+        }
+        // Built-in waves are decoded by RequestBuiltin().
+        if (wave >= kNumUserWaves || cached_wave(wave)) {
+          break;
+        }
+        // Do not overwrite the other wave being crossfaded.
+        uint8_t other = wave == requested_wave_[0] ?
+            requested_wave_[1] : requested_wave_[0];
+        loading_slot_ = cached_wave_[0] == other ? 1 : 0;
+        cached_wave_[loading_slot_] = kNoUserWave;
+        if (decoding_slot_ == loading_slot_) {
+          decoding_wave_ = kNoUserWave;
+        }
+        loading_wave_ = wave;
+        num_bytes_loaded_ = 0;
+        loading_state_ = LOADING_SET_ADDRESS;
+      }
+      // Fall through!
+      
+    case LOADING_SET_ADDRESS:
+      if (UserWavetableEeprom::BeginSetAddress(
+              loading_wave_ * kUserWaveSize + num_bytes_loaded_)) {
+        loading_state_ = LOADING_REQUEST;
+      }
+      break;
+      
+    case LOADING_REQUEST:
+      if (UserWavetableEeprom::busy()) {
+        break;
+      }
+      // The EEPROM did not acknowledge the address - it is probably busy
+      // writing a page.
+      if (UserWavetableEeprom::error() != I2C_ERROR_NONE) {
+        loading_state_ = LOADING_SET_ADDRESS;
+        break;
+      }
+      if (UserWavetableEeprom::BeginRead(kUserWaveSize - num_bytes_loaded_)) {
+        loading_state_ = LOADING_RECEIVE;
+      }
+      break;
+      
+    case LOADING_RECEIVE:
+      {
+        uint8_t* destination = cache_[loading_slot_];
+        while (UserWavetableEeprom::readable()) {
+          uint8_t value = UserWavetableEeprom::ImmediateRead();
+          // The slot has been taken by a built-in wave - drop the data.
+          if (loading_wave_ != kNoUserWave) {
+            destination[num_bytes_loaded_++] = value;
+          }
+        }
+        if (UserWavetableEeprom::busy()) {
+          break;
+        }
+        if (num_bytes_loaded_ == kUserWaveSize) {
+          destination[kUserWaveSize] = destination[0];
+          cached_wave_[loading_slot_] = loading_wave_;
+          loading_state_ = LOADING_IDLE;
+        } else {
+          // Continue from where the EEPROM stopped.
+          loading_state_ = LOADING_REQUEST;
+        }
+      }
+      break;
+  }
+}
+
+#endif  // HAS_USER_WAVETABLES
+
+/* static */
+void UserWavetables::RequestBuiltin(uint8_t wave_a, uint8_t wave_b) {
+  Request(wave_a, wave_b);
+  if (decoding_wave_ != wave_a && decoding_wave_ != wave_b) {
+    uint8_t wave = cached_wave(wave_a) ? wave_b : wave_a;
+    if (cached_wave(wave)) {
+      return;
+    }
+    // Do not overwrite the other wave being crossfaded.
+    uint8_t other_wave = wave == wave_a ? wave_b : wave_a;
+    decoding_slot_ = cached_wave_[0] == other_wave ? 1 : 0;
+#ifdef HAS_USER_WAVETABLES
+    if (loading_state_ != LOADING_IDLE && loading_slot_ == decoding_slot_) {
+      loading_wave_ = kNoUserWave;
+    }
+#endif  // HAS_USER_WAVETABLES
+    cached_wave_[decoding_slot_] = kNoUserWave;
+    decoding_wave_ = wave;
+    decoding_position_ = 0;
+    decoding_data_ = waveform_table[WAV_RES_WAVETABLE] +
+        ResourcesManager::Lookup<uint16_t, uint8_t>(
+            lut_res_wavetable_offsets, wave - kFirstBuiltinWave);
+    decoding_step_index_ = pgm_read_byte(decoding_data_++);
+  }
+  
+  uint8_t* destination = decoding_slot_ ? cache_[1] : cache_[0];
+  uint8_t i = decoding_position_;
+  uint8_t end = i + kBuiltinWaveChunkSize;
+  if (decoding_step_index_ == kRawWave) {
+    memcpy_P(destination + i, decoding_data_ + i, kBuiltinWaveChunkSize);
+  } else {
+    // Second order prediction, and quantization of the error with an adaptive
+    // step size. The first sample is stored verbatim, followed by the codes.
+    // Apart from the step index, the state of the decoder is made of the two
+    // samples previously decoded.
+    uint8_t step_index = decoding_step_index_;
+    if (i == 0) {
+      destination[0] = pgm_read_byte(decoding_data_);
+      ++i;
+    }
+    uint8_t value = destination[i - 1];
+    uint8_t previous = i == 1 ? value : destination[i - 2];
+    for (; i < end; ++i) {
+      uint8_t codes = pgm_read_byte(decoding_data_ + ((i + 1) >> 1));
+      // Sign extension of the 4-bit code.
+      int8_t code = (i & 1 ? codes >> 4 : codes) << 4;
+      code >>= 4;
+      uint8_t prediction = Clip8(2 * value - previous);
+      uint8_t step = pgm_read_byte(
+          waveform_table[WAV_RES_WAVETABLE_ADPCM_STEPS] + step_index);
+      previous = value;
+      value = Clip8(prediction + code * step);
+      destination[i] = value;
+      
+      if (code < 0) {
+        code = -code;
+      }
+      if (code >= 6) {
+        step_index += 2;
+      } else if (code >= 4) {
+        ++step_index;
+      } else if (code <= 1 && step_index) {
+        --step_index;
+      }
+      if (step_index >= WAV_RES_WAVETABLE_ADPCM_STEPS_SIZE) {
+        step_index = WAV_RES_WAVETABLE_ADPCM_STEPS_SIZE - 1;
+      }
+    }
+    decoding_step_index_ = step_index;
+  }
+  decoding_position_ = end;
+  if (end == kUserWaveSize) {
+    destination[kUserWaveSize] = destination[0];
+    cached_wave_[decoding_slot_] = decoding_wave_;
+    decoding_wave_ = kNoUserWave;
+  }
+}
+
+#ifndef __AVR__
+
+/* static */
+const uint8_t* UserWavetables::decoded_builtin_wave(uint8_t wave) {
+  static uint8_t wavetable[kNumWavesPerUserWavetable][kUserWaveSize + 1];
+  static uint8_t decoded = 0;
+  if (!decoded) {
+    for (uint8_t i = 0; i < kNumWavesPerUserWavetable; ++i) {
+      uint8_t builtin_wave = kFirstBuiltinWave + i;
+      while (!cached_wave(builtin_wave)) {
+        RequestBuiltin(builtin_wave, builtin_wave);
+      }
+      memcpy(wavetable[i], cached_wave(builtin_wave), kUserWaveSize + 1);
+    }
+    decoded = 1;
+  }
+  return wavetable[wave - kFirstBuiltinWave];
+}
+
+#endif  // __AVR__
+
+#ifdef HAS_USER_WAVETABLES
+
+/* static */
+void UserWavetables::StreamWrite() {
+  if (UserWavetableEeprom::busy()) {
+    return;
+  }
+  if (write_started_) {
+    write_started_ = 0;
+    if (UserWavetableEeprom::error() == I2C_ERROR_NONE) {
+      num_bytes_to_write_ -= kEepromPageSize;
+      write_attempts_ = 0;
+    } else if (++write_attempts_ == kMaxWriteAttempts) {
+      // No EEPROM, or a faulty one. Drop the block.
+      num_bytes_to_write_ = 0;
+    }
+    if (!num_bytes_to_write_) {
+      // The cached copy is now stale, and the address pointer of the EEPROM
+      // has been moved by the write.
+      uint8_t wave = write_block_ / (kUserWaveSize / kUserWavetableBlockSize);
+      for (uint8_t i = 0; i < 2; ++i) {
+        if (cached_wave_[i] == wave) {
+          cached_wave_[i] = kNoUserWave;
+        }
+      }
+      if (loading_state_ != LOADING_IDLE) {
+        loading_state_ = loading_wave_ == wave ?
+            LOADING_IDLE : LOADING_SET_ADDRESS;
+      }
+      return;
+    }
+  }
+  uint8_t offset = kUserWavetableBlockSize - num_bytes_to_write_;
+  if (UserWavetableEeprom::BeginWrite(
+          write_block_ * kUserWavetableBlockSize + offset,
+          write_buffer_ + offset,
+          kEepromPageSize)) {
+    write_started_ = 1;
+  }
+}
+
+/* static */
+uint8_t UserWavetables::WriteBlock(uint8_t block, const uint8_t* data) {
+  // This is called while the MIDI input is being parsed: waiting for the
+  // EEPROM here would stall the MIDI task for up to 10ms.
+  if (block >= kNumUserWavetableBlocks || num_bytes_to_write_) {
+    return 0;
+  }
+  memcpy(write_buffer_, data, kUserWavetableBlockSize);
+  write_block_ = block;
+  write_attempts_ = 0;
+  num_bytes_to_write_ = kUserWavetableBlockSize;
+  return 1;
+}
+
+#endif  // HAS_USER_WAVETABLES
+
+}  // namespace hardware_shruti
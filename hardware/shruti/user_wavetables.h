@@ -0,0 +1,157 @@
+// Copyright 2009 Olivier Gillet.
+//
+// Author: Olivier Gillet (ol.gillet@gmail.com)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// User wavetables, uploaded by SysEx into an external I2C EEPROM (24LC64 on
+// analog pins 4 and 5), and streamed from there into a SRAM cache holding the
+// two waves an oscillator is crossfading.
+//
+// Each of the 4 tables has 16 waves of 128 samples - the same layout as the
+// built-in wavetable. The EEPROM is written by blocks of 64 bytes (half a
+// wave), so that a SysEx message carries as much data as a patch dump. The
+// EEPROM needs 5ms to store each of the two pages of a block, during which the
+// MIDI task keeps running. A block received before the previous one is
+// written is refused - the '#' status is displayed, and the sender has to
+// send it again later.
+//
+// Only oscillator 1 can play either of them, so the cache also holds the waves
+// of the built-in wavetable, decoded from their compressed form in flash (see
+// resources/waveforms.py for the format). Without HAS_USER_WAVETABLES, only
+// this part is compiled.
+
+#ifndef HARDWARE_SHRUTI_USER_WAVETABLES_H_
+#define HARDWARE_SHRUTI_USER_WAVETABLES_H_
+
+#include <avr/pgmspace.h>
+
+#include "hardware/base/base.h"
+#include "hardware/shruti/patch.h"
+#include "hardware/shruti/shruti.h"
+
+namespace hardware_shruti {
+
+static const uint8_t kUserWaveSize = 128;
+static const uint8_t kNumWavesPerUserWavetable = 16;
+static const uint8_t kNumUserWavetables = 4;
+static const uint8_t kUserWavetableBlockSize = kSerializedPatchSize;
+static const uint8_t kNumUserWavetableBlocks = kNumUserWavetables *
+    kNumWavesPerUserWavetable * (kUserWaveSize / kUserWavetableBlockSize);
+static const uint8_t kNumUserWaves = kNumUserWavetables *
+    kNumWavesPerUserWavetable;
+static const uint8_t kNoUserWave = 0xff;
+
+// The waves of the built-in wavetable share the cache, and are numbered after
+// the user waves.
+static const uint8_t kFirstBuiltinWave = kNumUserWaves;
+
+enum UserWavetableLoadingState {
+  LOADING_IDLE,
+  LOADING_SET_ADDRESS,
+  LOADING_REQUEST,
+  LOADING_RECEIVE,
+};
+
+class UserWavetables {
+ public:
+  UserWavetables() { }
+  
+#ifdef HAS_USER_WAVETABLES
+  static void Init();
+#endif  // HAS_USER_WAVETABLES
+  
+  // Called by the oscillator whenever its parameter changes, with the two
+  // waves (table * 16 + index) it is crossfading. They will be loaded in the
+  // background.
+  static inline void Request(uint8_t wave_a, uint8_t wave_b) {
+    requested_wave_[0] = wave_a;
+    requested_wave_[1] = wave_b;
+  }
+  
+  // Copy in SRAM of a wave, with the first sample repeated at the end for
+  // interpolation, or NULL if it is not in the cache yet.
+  static inline const uint8_t* cached_wave(uint8_t wave) {
+    if (cached_wave_[0] == wave) {
+      return cache_[0];
+    } else if (cached_wave_[1] == wave) {
+      return cache_[1];
+    } else {
+      return NULL;
+    }
+  }
+  
+  // Same as Request, for two waves of the built-in wavetable. They are
+  // stored compressed in flash, and decoded in the cache one after the other,
+  // a chunk of samples at each call (once per control period), so that the
+  // audio block being rendered does not have to wait for the decoder.
+  static void RequestBuiltin(uint8_t wave_a, uint8_t wave_b);
+  
+#ifndef __AVR__
+  // The polyphonic desktop engine renders several voices sharing the cache,
+  // which would keep evicting each other's waves. It reads them from a copy of
+  // the whole built-in wavetable instead, decoded at the first call.
+  static const uint8_t* decoded_builtin_wave(uint8_t wave);
+#endif  // __AVR__
+  
+#ifdef HAS_USER_WAVETABLES
+  // To be called periodically (from the MIDI task). Moves the requested waves
+  // from the EEPROM to the cache, a few bytes at a time, without waiting for
+  // the I2C bus.
+  static void Stream();
+  
+  // Queues a block received by SysEx for writing into the EEPROM, which is
+  // done by Stream(). Returns 0, without waiting, if the block is refused
+  // because the previous one is not written yet (or if it is out of range).
+  static uint8_t WriteBlock(uint8_t block, const uint8_t* data);
+#endif  // HAS_USER_WAVETABLES
+  
+ private:
+#ifdef HAS_USER_WAVETABLES
+  static void StreamWrite();
+#endif  // HAS_USER_WAVETABLES
+
+  static uint8_t cache_[2][kUserWaveSize + 1];
+  static uint8_t cached_wave_[2];
+  static uint8_t requested_wave_[2];
+  
+  // Wave being loaded, slot of the cache in which it is loaded, and number of
+  // bytes loaded so far.
+  static uint8_t loading_wave_;
+  static uint8_t loading_slot_;
+  static uint8_t num_bytes_loaded_;
+  static uint8_t loading_state_;
+  
+  // Built-in wave being decoded, slot of the cache in which it is decoded,
+  // number of samples decoded so far, and step size index of the ADPCM
+  // decoder.
+  static uint8_t decoding_wave_;
+  static uint8_t decoding_slot_;
+  static uint8_t decoding_position_;
+  static const prog_uint8_t* decoding_data_;
+  static uint8_t decoding_step_index_;
+  
+  // Block being written, and number of bytes of it still to be written.
+  static uint8_t write_buffer_[kUserWavetableBlockSize];
+  static uint8_t write_block_;
+  static uint8_t num_bytes_to_write_;
+  static uint8_t write_attempts_;
+  static uint8_t write_started_;
+  
+  DISALLOW_COPY_AND_ASSIGN(UserWavetables);
+};
+
+}  // namespace hardware_shruti
+
+#endif  // HARDWARE_SHRUTI_USER_WAVETABLES_H_
@@ -49,6 +49,9 @@ int8_t VoiceController::direction_;
 int8_t VoiceController::octave_step_;
 int8_t VoiceController::octaves_;
 uint8_t VoiceController::mode_;
+#ifdef HAS_DUOPHONIC
+uint8_t VoiceController::duophonic_;
+#endif  // HAS_DUOPHONIC
 
 NoteStack VoiceController::notes_;
 Voice* VoiceController::voices_;
@@ -73,6 +76,9 @@ void VoiceController::Init(Voice* voices, uint8_t num_voices) {
   pattern_size_ = 16;
   pattern_ = 0x5555;
   mode_ = 0;
+#ifdef HAS_DUOPHONIC
+  duophonic_ = 0;
+#endif  // HAS_DUOPHONIC
   inactive_steps_ = 0;
   active_ = 0;
   Reset();
@@ -127,6 +133,9 @@ void VoiceController::UpdateArpeggiatorParameters(const Patch& patch) {
   direction_ = mode_ == ARPEGGIO_DIRECTION_DOWN ? -1 : 1;
   octaves_ = patch.arp_octave;
   pattern_size_ = patch.pattern_size;
+#ifdef HAS_DUOPHONIC
+  duophonic_ = patch.kbd_midi_channel >= 51;
+#endif  // HAS_DUOPHONIC
   if (patch.arp_tempo < 40) {
     midi_clock_prescaler_ = ResourcesManager::Lookup<uint8_t, uint8_t>(
         midi_clock_scale, patch.arp_tempo - 35);
@@ -162,6 +171,12 @@ void VoiceController::NoteOn(uint8_t note, uint8_t velocity) {
     Start();
     // Trigger the note.
     if (octaves_ == 0) {
+#ifdef HAS_DUOPHONIC
+      if (duophonic_) {
+        TriggerMostRecentNotes(velocity, notes_.size() > 1);
+        return;
+      }
+#endif  // HAS_DUOPHONIC
       voices_[0].Trigger(note, velocity, notes_.size() > 1);
     }
   }
@@ -181,6 +196,12 @@ void VoiceController::NoteOff(uint8_t note) {
     // do it. No need to retrigger if we just removed notes different from
     // the one currently played.
     if (octaves_ == 0) {
+#ifdef HAS_DUOPHONIC
+      if (duophonic_) {
+        TriggerMostRecentNotes(0, true);
+        return;
+      }
+#endif  // HAS_DUOPHONIC
       if (top_note == note) {
         voices_[0].Trigger(notes_.most_recent_note().note, 0, true);
       }
@@ -188,6 +209,24 @@ void VoiceController::NoteOff(uint8_t note) {
   }
 }
 
+#ifdef HAS_DUOPHONIC
+/* static */
+void VoiceController::TriggerMostRecentNotes(uint8_t velocity,
+                                             uint8_t legato) {
+  // When a single key is held, both oscillators play the same note.
+  uint8_t low_note = notes_.most_recent_note().note;
+  uint8_t high_note = low_note;
+  if (notes_.size() > 1) {
+    high_note = notes_.note(notes_.most_recent_note().next_ptr).note;
+    if (high_note < low_note) {
+      low_note = high_note;
+      high_note = notes_.most_recent_note().note;
+    }
+  }
+  voices_[0].Trigger(low_note, high_note, velocity, legato);
+}
+#endif  // HAS_DUOPHONIC
+
 /* static */
 uint8_t VoiceController::Control() {
   ++step_duration_estimator_num_;
@@ -280,7 +319,7 @@ void VoiceController::ArpeggioStep() {
 void VoiceController::Step() {
   uint8_t num_notes = notes_.size();
   if (mode_ == ARPEGGIO_DIRECTION_RANDOM) {
-    uint8_t random_byte = Random::state_msb();
+    uint8_t random_byte = Random::GetByte();
     octave_step_ = random_byte & 0xf;
     arpeggio_step_ = (random_byte & 0xf0) >> 4;
     while (octave_step_ >= octaves_) {
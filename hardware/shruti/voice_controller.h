@@ -22,6 +22,10 @@
 // the NoteStack instance contained in this class to handle voice stealing for
 // a polyphonic synth.
 //
+// In duophonic mode (HAS_DUOPHONIC), the two most recently played notes are
+// split between the two oscillators of the voice - the lowest one on osc 1,
+// the highest one on osc 2. The filter and VCA are shared.
+//
 // Two instances of this guy will be needed for multitimbrality. Since there is
 // no plan to support multitimbrality, this class is implemented as a "static
 // singleton". This does not yield a code size gain, but this is coherent with
@@ -62,6 +66,10 @@ class VoiceController {
   static inline void ExternalSync() { --midi_clock_counter_; }
   static inline uint8_t step() { return pattern_step_; }
   static inline uint8_t active() { return active_; }
+  // 1 when the MIDI clock messages are used by the arpeggiator.
+  static inline uint8_t synced_to_midi_clock() {
+    return midi_clock_prescaler_ != 0;
+  }
   static inline uint16_t has_arpeggiator_note() {
     return pattern_mask_ & pattern_;
   }
@@ -82,6 +90,9 @@ class VoiceController {
  private:
   static void ArpeggioStep();
   static void ArpeggioStart();
+#ifdef HAS_DUOPHONIC
+  static void TriggerMostRecentNotes(uint8_t velocity, uint8_t legato);
+#endif  // HAS_DUOPHONIC
 
   static int16_t internal_clock_counter_;
   static int8_t midi_clock_counter_;
@@ -105,6 +116,9 @@ class VoiceController {
   // Number of octaves
   static int8_t octaves_;
   static uint8_t mode_;
+#ifdef HAS_DUOPHONIC
+  static uint8_t duophonic_;
+#endif  // HAS_DUOPHONIC
 
   static NoteStack notes_;
   static Voice* voices_;
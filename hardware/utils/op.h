@@ -17,12 +17,21 @@
 //
 // A set of basic operands, especially useful for fixed-point arithmetic, with
 // fast ASM implementations.
+//
+// The *Block variants apply an operation to a whole buffer of samples
+// (typically kAudioBlockSize of them), and are bit-exact with the per-sample
+// operations. They are plain loops over contiguous buffers, which the compiler
+// can vectorize. They are only used by the desktop tools for now, and have no
+// assembly version: one will be written with the first caller in the
+// firmware, and checked by op_test. The size of the block must not be 0.
 
 #ifndef HARDWARE_UTILS_OP_H_
 #define HARDWARE_UTILS_OP_H_
 
 #include "hardware/base/base.h"
 
+#include <avr/pgmspace.h>
+
 namespace hardware_utils_op {
   
 static inline int16_t Clip(int16_t value, int16_t min, int16_t max) {
@@ -272,11 +281,11 @@ static inline int8_t SignedClip8(int16_t value) {
 }
 
 static inline uint8_t Mix(uint8_t a, uint8_t b, uint8_t balance) {
-  return a * (255 - balance) + b * balance >> 8;
+  return (a * (255 - balance) + b * balance) >> 8;
 }
 
 static inline uint8_t Mix4(uint8_t a, uint8_t b, uint8_t balance) {
-  return a * (15 - balance) + b * balance >> 4;
+  return (a * (15 - balance) + b * balance) >> 4;
 }
 
 static inline uint8_t UnscaledMix4(uint8_t a, uint8_t b, uint8_t balance) {
@@ -322,9 +331,53 @@ static inline uint16_t Mul16Scale8(uint16_t a, uint16_t b) {
 static inline uint8_t ShiftRight6(uint16_t value) {
   return value >> 6;
 }
-  
+
 #endif  // USE_OPTIMIZED_OP
 
+static inline void MixBlock(
+    uint8_t* a,
+    const uint8_t* b,
+    uint8_t balance,
+    uint8_t size) {
+  for (uint8_t i = 0; i < size; ++i) {
+    a[i] = Mix(a[i], b[i], balance);
+  }
+}
+
+static inline void ScaleBlock(uint8_t* a, uint8_t scale, uint8_t size) {
+  for (uint8_t i = 0; i < size; ++i) {
+    a[i] = MulScale8(a[i], scale);
+  }
+}
+
+static inline void ClipBlock(
+    const int16_t* source,
+    uint8_t* destination,
+    uint8_t size) {
+  for (uint8_t i = 0; i < size; ++i) {
+    destination[i] = Clip8(source[i]);
+  }
+}
+
+// Reads a block of samples from a 256 (+ 1 guard) samples table, with linear
+// interpolation, while advancing the phase - in the same way as the
+// oscillators' InterpolateSample. Returns the updated phase.
+static inline uint16_t InterpolateTableBlock(
+    const prog_uint8_t* table,
+    uint16_t phase,
+    uint16_t increment,
+    uint8_t* destination,
+    uint8_t size) {
+  for (uint8_t i = 0; i < size; ++i) {
+    phase += increment;
+    destination[i] = Mix(
+        pgm_read_byte(table + (phase >> 8)),
+        pgm_read_byte(table + (phase >> 8) + 1),
+        phase & 0xff);
+  }
+  return phase;
+}
+
 }  // namespace hardware_utils_op
 
 #endif  // HARDWARE_UTILS_OP_H_
\ No newline at end of file
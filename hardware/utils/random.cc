@@ -21,7 +21,31 @@
 
 namespace hardware_utils {
 
-/* static */
+/* <static> */
 uint16_t Random::rng_state_ = 0x21;
+uint32_t Random::noise_state_ = 0x21;
+uint8_t Random::noise_buffer_[kNoiseBufferSize];
+uint8_t Random::noise_index_;
+uint8_t Random::noise_sample_;
+/* </static> */
+
+/* static */
+void Random::FillNoiseBuffer() {
+  // Shifts of 8, 9 and 23 bits: the shifts by a multiple of 8 are just byte
+  // moves on the AVR. Period: 2^32 - 1.
+  uint32_t x = noise_state_;
+  uint8_t* sample = noise_buffer_;
+  for (uint8_t i = kNoiseBufferSize / 4; i > 0; --i) {
+    x ^= x << 8;
+    x ^= x >> 9;
+    x ^= x << 23;
+    *sample++ = x;
+    *sample++ = x >> 8;
+    *sample++ = x >> 16;
+    *sample++ = x >> 24;
+  }
+  noise_state_ = x;
+  noise_index_ = 0;
+}
 
 }  // namespace hardware_utils
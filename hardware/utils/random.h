@@ -15,7 +15,7 @@
 //
 // -----------------------------------------------------------------------------
 //
-// Fast 16-bit pseudo random number generator.
+// Fast 16-bit pseudo random number generator, and block noise source.
 
 #ifndef HARDWARE_UTILS_RANDOM_H_
 #define HARDWARE_UTILS_RANDOM_H_
@@ -24,6 +24,8 @@
 
 namespace hardware_utils {
 
+static const uint8_t kNoiseBufferSize = 32;
+
 class Random {
  public:
   static void Update() {
@@ -32,6 +34,13 @@ class Random {
     rng_state_ = (rng_state_ >> 1) ^ (-(rng_state_ & 1) & 0xb400);    
   }
 
+  // Restarts both generators. seed must not be 0. Only used by the desktop
+  // tools, which render the same patch several times.
+  static void Seed(uint16_t seed) {
+    rng_state_ = seed;
+    noise_state_ = seed;
+  }
+
   static inline uint16_t state() { return rng_state_; }
 
   static inline uint8_t state_msb() {
@@ -42,10 +51,27 @@ class Random {
     Update();
     return state_msb();
   }
+  
+  // Refills the noise buffer. To be called once per block.
+  static void FillNoiseBuffer();
+  
+  // Moves to the next byte of the noise buffer. To be called once per sample.
+  static inline void NextNoiseSample() {
+    noise_sample_ = noise_buffer_[noise_index_];
+    noise_index_ = (noise_index_ + 1) & (kNoiseBufferSize - 1);
+  }
+  
+  static inline uint8_t noise_sample() { return noise_sample_; }
 
  private:
   static uint16_t rng_state_;
   
+  // 32-bit xorshift generator, yielding 4 noise bytes per step.
+  static uint32_t noise_state_;
+  static uint8_t noise_buffer_[kNoiseBufferSize];
+  static uint8_t noise_index_;
+  static uint8_t noise_sample_;
+  
   DISALLOW_COPY_AND_ASSIGN(Random);
 };
 
@@ -103,14 +103,24 @@ class NaiveScheduler {
 
   void Run() {
     while (1) {
-      ++current_slot_;
-      if (current_slot_ >= sizeof(slots_)) {
-        current_slot_ = 0;
-      }
-      if (slots_[current_slot_]) {
-        tasks_[slots_[current_slot_] - 1].code();
-      }
+      Step();
+    }
+  }
+
+  // Moves to the next slot and runs its task. Returns the task which was run,
+  // or NULL for an empty slot. Used directly by the desktop simulator, which
+  // needs to regain control between tasks.
+  static inline const Task* Step() {
+    ++current_slot_;
+    if (current_slot_ >= sizeof(slots_)) {
+      current_slot_ = 0;
+    }
+    if (slots_[current_slot_]) {
+      const Task* task = &tasks_[slots_[current_slot_] - 1];
+      task->code();
+      return task;
     }
+    return NULL;
   }
 
  private: